@@ -44,6 +44,7 @@
 #include <xmlsec/transforms.h>
 #include <xmlsec/xmldsig.h>
 #include <xmlsec/xmlenc.h>
+#include <xmlsec/opc.h>
 #include <xmlsec/parser.h>
 #include <xmlsec/templates.h>
 #include <xmlsec/errors.h>
@@ -225,6 +226,30 @@ static xmlSecAppCmdLineParam transformBinChunkSizeParam = {
     xmlSecAppCmdLineParamFlagNone,
     NULL
 };
+static xmlSecAppCmdLineParam transformAdaptiveChunkSizeParam = {
+    xmlSecAppCmdLineTopicCryptoConfig,
+    "--transform-adaptive-chunk-size",
+    NULL,
+    "--transform-adaptive-chunk-size"
+    "\n\tpick the transforms binary processing chunk size from the input"
+    "\n\tdata size (if known): inputs smaller than the binary chunk size"
+    "\n\tare processed in one chunk sized to the input; the binary chunk"
+    "\n\tsize is used as the maximum",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+static xmlSecAppCmdLineParam transformLibXml2C14NParam = {
+    xmlSecAppCmdLineTopicCryptoConfig,
+    "--transform-libxml2-c14n",
+    NULL,
+    "--transform-libxml2-c14n"
+    "\n\tuse LibXML2 xmlC14NExecute() function for the C14N transforms"
+    "\n\tinstead of the XMLSec canonicalization engine (for testing)",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
 
 static xmlSecAppCmdLineParam verboseParam = {
     xmlSecAppCmdLineTopicGeneral,
@@ -518,6 +543,18 @@ static xmlSecAppCmdLineParam enabledKeyInfoReferenceUrisParam = {
     NULL
 };
 
+static xmlSecAppCmdLineParam retrievalCacheParam = {
+    xmlSecAppCmdLineTopicKeysMngr,
+    "--retrieval-cache",
+    NULL,
+    "--retrieval-cache"
+    "\n\tcache the results of the external URIs in <dsig:RetrievalMethod>"
+    "\n\tand <dsig11:KeyInfoReference> elements in the keys manager",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
 static xmlSecAppCmdLineParam laxKeySearchParam = {
     xmlSecAppCmdLineTopicKeysMngr,
     "--lax-key-search",
@@ -560,6 +597,18 @@ static xmlSecAppCmdLineParam sessionKeyParam = {
     NULL
 };
 
+static xmlSecAppCmdLineParam threadsParam = {
+    xmlSecAppCmdLineTopicDSigSign | xmlSecAppCmdLineTopicDSigVerify |
+    xmlSecAppCmdLineTopicEncEncrypt | xmlSecAppCmdLineTopicEncDecrypt,
+    "--threads",
+    NULL,
+    "--threads <number>"
+    "\n\tuse up to <number> threads to process the data",
+    xmlSecAppCmdLineParamTypeNumber,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
 static xmlSecAppCmdLineParam outputParam = {
     xmlSecAppCmdLineTopicDSigCommon |
     xmlSecAppCmdLineTopicEncCommon,
@@ -760,6 +809,73 @@ static xmlSecAppCmdLineParam enableVisa3DHackParam = {
     NULL
 };
 
+static xmlSecAppCmdLineParam changedIdParam = {
+    xmlSecAppCmdLineTopicDSigSign,
+    "--changed-id",
+    NULL,
+    "--changed-id <id>"
+    "\n\tre-sign the previously signed template and re-calculate only"
+    "\n\tthe digests of the references affected by the changes in"
+    "\n\tthe node with the given ID attribute value; this option can be"
+    "\n\tused multiple times",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagMultipleValues,
+    NULL
+};
+
+static xmlSecAppCmdLineParam signProfileParam = {
+    xmlSecAppCmdLineTopicDSigSign,
+    "--sign-profile",
+    NULL,
+    "--sign-profile"
+    "\n\tprecompile the first signature template into a signing profile"
+    "\n\tand use it for all the following signatures (e.g. with --repeat)",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam signProfileFileParam = {
+    xmlSecAppCmdLineTopicDSigSign,
+    "--sign-profile-file",
+    NULL,
+    "--sign-profile-file <file>"
+    "\n\tprecompile the signature template from <file> into a signing"
+    "\n\tprofile and use it to sign the templates of the same shape; other"
+    "\n\ttemplates are signed as usual",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam verifyProfileParam = {
+    xmlSecAppCmdLineTopicDSigVerify,
+    "--verify-profile",
+    NULL,
+    "--verify-profile <file>"
+    "\n\tprecompile the signature template (or signed sample) from <file>"
+    "\n\tand use it to verify the signatures of the same shape; other"
+    "\n\tsignatures are verified as usual",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam opcPackageParam = {
+    xmlSecAppCmdLineTopicDSigSign | xmlSecAppCmdLineTopicDSigVerify,
+    "--opc-package",
+    NULL,
+    "--opc-package <file>"
+    "\n\tdigest the parts of the OPC package <file> (.docx, .xlsx, etc.)"
+    "\n\treferenced from the <dsig:Manifest> elements by the part names"
+    "\n\t(e.g. \"/word/document.xml?ContentType=...\") directly from the"
+    "\n\tpackage; the input file is the package signature (also check"
+    "\n\t\"--threads\" option)",
+    xmlSecAppCmdLineParamTypeString,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
 #endif /* XMLSEC_NO_XMLDSIG */
 
 /****************************************************************
@@ -781,6 +897,61 @@ static xmlSecAppCmdLineParam enabledCipherRefUrisParam = {
     NULL
 };
 
+static xmlSecAppCmdLineParam decryptAllParam = {
+    xmlSecAppCmdLineTopicEncDecrypt,
+    "--decrypt-all",
+    NULL,
+    "--decrypt-all"
+    "\n\tdecrypt all <enc:EncryptedData> nodes with Element or Content type"
+    "\n\tin the document; the keys are resolved once for the nodes with"
+    "\n\tthe same <dsig:KeyInfo> node (also check \"--threads\" option)",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam encryptAllParam = {
+    xmlSecAppCmdLineTopicEncEncrypt,
+    "--encrypt-all",
+    NULL,
+    "--encrypt-all"
+    "\n\tencrypt all the nodes in the XML data file with the same name"
+    "\n\tand namespace as the start node (see \"--node-id\", \"--node-name\""
+    "\n\tand \"--node-xpath\" options) using the same key; the template's"
+    "\n\t<dsig:KeyInfo> node is written only once (also check \"--threads\" option);"
+    "\n\tthe nodes can't be nested",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam streamOutputParam = {
+    xmlSecAppCmdLineTopicEncDecrypt,
+    "--stream-output",
+    NULL,
+    "--stream-output"
+    "\n\twrite the decrypted data directly to the output file instead of"
+    "\n\tkeeping it in memory; the <enc:EncryptedData> node is not replaced"
+    "\n\tand the output file is removed if decryption fails",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
+static xmlSecAppCmdLineParam aeadStreamingParam = {
+    xmlSecAppCmdLineTopicEncDecrypt,
+    "--aead-streaming",
+    NULL,
+    "--aead-streaming"
+    "\n\tdecrypt AEAD (e.g. AES GCM) data as it arrives instead of collecting"
+    "\n\tthe whole ciphertext in memory first (if supported by the crypto library);"
+    "\n\tthe data is written before it is authenticated, use it with"
+    "\n\t\"--stream-output\" and an output file that is removed on failure",
+    xmlSecAppCmdLineParamTypeFlag,
+    xmlSecAppCmdLineParamFlagNone,
+    NULL
+};
+
 static xmlSecAppCmdLineParam binaryDataParam = {
     xmlSecAppCmdLineTopicEncEncrypt,
     "--binary-data",
@@ -987,6 +1158,11 @@ static xmlSecAppCmdLineParamPtr parameters[] = {
     &storeSignaturesParam,
     &enabledRefUrisParam,
     &enableVisa3DHackParam,
+    &changedIdParam,
+    &signProfileParam,
+    &signProfileFileParam,
+    &verifyProfileParam,
+    &opcPackageParam,
 
 #ifndef XMLSEC_NO_HMAC
     &hmacMinOutputLenParam,
@@ -999,10 +1175,15 @@ static xmlSecAppCmdLineParamPtr parameters[] = {
     &binaryDataParam,
     &xmlDataParam,
     &enabledCipherRefUrisParam,
+    &decryptAllParam,
+    &streamOutputParam,
+    &aeadStreamingParam,
+    &encryptAllParam,
 #endif /* XMLSEC_NO_XMLENC */
 
     /* common dsig and enc parameters */
     &sessionKeyParam,
+    &threadsParam,
     &outputParam,
     &printDebugParam,
     &printXmlDebugParam,
@@ -1016,6 +1197,7 @@ static xmlSecAppCmdLineParamPtr parameters[] = {
     &enabledKeyDataParam,
     &enabledRetrievalMethodUrisParam,
     &enabledKeyInfoReferenceUrisParam,
+    &retrievalCacheParam,
     &genKeyParam,
     &keysFileParam,
     &privkeyParam,
@@ -1078,6 +1260,8 @@ static xmlSecAppCmdLineParamPtr parameters[] = {
     &repeatParam,
     &base64LineSizeParam,
     &transformBinChunkSizeParam,
+    &transformAdaptiveChunkSizeParam,
+    &transformLibXml2C14NParam,
     &xxeParam,
     &urlMapParam,
     &helpParam,
@@ -1142,6 +1326,9 @@ static void                     xmlSecAppPrintDSigCtx           (xmlSecDSigCtxPt
 #ifndef XMLSEC_NO_XMLENC
 static int                      xmlSecAppEncryptFile            (const char* inputFileName,
                                                                  const char* outputFileNameTmpl);
+static int                      xmlSecAppFindSameNodes          (xmlNodePtr cur,
+                                                                 xmlNodePtr node,
+                                                                 xmlNodeSetPtr nodes);
 static int                      xmlSecAppDecryptFile            (const char* inputFileName,
                                                                  const char* outputFileNameTmpl);
 #ifndef XMLSEC_NO_TMPL_TEST
@@ -1158,6 +1345,8 @@ static int                      xmlSecAppCheckTransform     (const char * name);
 
 static xmlSecTransformUriType   xmlSecAppGetUriType             (const char* string);
 static xmlOutputBufferPtr       xmlSecAppOpenFile               (const char* filename, const char* encoding);
+static char*                    xmlSecAppGetOutputFilename      (const char* inputFileName,
+                                                                 const char* outputFileNameTmpl);
 static int                      xmlSecAppWriteResult            (const char* inputFileName,
                                                                  const char* outputFileNameTmpl,
                                                                  xmlDocPtr doc,
@@ -1186,6 +1375,10 @@ int wmain(int argc, wchar_t* argv[]);
 #endif /* defined(XMLSEC_WINDOWS) && defined(UNICODE) && defined(__MINGW32__) */
 
 xmlSecKeysMngrPtr g_keysManager = NULL;
+#ifndef XMLSEC_NO_XMLDSIG
+xmlSecDSigSignProfilePtr g_signProfile = NULL;
+xmlSecDSigSignProfilePtr g_verifyProfile = NULL;
+#endif /* XMLSEC_NO_XMLDSIG */
 int g_repeats = 1;
 int g_printDebug = 0;
 int g_printVerboseDebug = 0;
@@ -1518,6 +1711,16 @@ xmlSecAppExecute(xmlSecAppCommand command, const char** utf8_argv, int argc) {
     res = 0;
 
 done:
+#ifndef XMLSEC_NO_XMLDSIG
+    if(g_signProfile != NULL) {
+        xmlSecDSigSignProfileDestroy(g_signProfile);
+        g_signProfile = NULL;
+    }
+    if(g_verifyProfile != NULL) {
+        xmlSecDSigSignProfileDestroy(g_verifyProfile);
+        g_verifyProfile = NULL;
+    }
+#endif /* XMLSEC_NO_XMLDSIG */
     if(g_keysManager != NULL) {
         xmlSecKeysMngrDestroy(g_keysManager);
         g_keysManager = NULL;
@@ -1530,6 +1733,8 @@ done:
 static int
 xmlSecAppSignFile(const char* inputFileName, const char* outputFileNameTmpl) {
     xmlSecAppXmlDataPtr data = NULL;
+    xmlNodeSetPtr changedNodes = NULL;
+    xmlSecOpcPackagePtr pkg = NULL;
     xmlSecDSigCtx dsigCtx;
     clock_t start_time;
     int res = -1;
@@ -1557,9 +1762,105 @@ xmlSecAppSignFile(const char* inputFileName, const char* outputFileNameTmpl) {
     }
 
 
+    /* collect changed nodes for incremental signing */
+    if(xmlSecAppCmdLineParamIsSet(&changedIdParam)) {
+        xmlSecAppCmdLineValuePtr value;
+        xmlAttrPtr attr;
+
+        changedNodes = xmlXPathNodeSetCreate(NULL);
+        if(changedNodes == NULL) {
+            fprintf(stderr, "Error: failed to create changed nodes set\n");
+            goto done;
+        }
+        for(value = changedIdParam.value; value != NULL; value = value->next) {
+            if(value->strValue == NULL) {
+                fprintf(stderr, "Error: invalid value for option \"%s\".\n",
+                        changedIdParam.fullName);
+                goto done;
+            }
+            attr = xmlGetID(data->doc, BAD_CAST value->strValue);
+            if((attr == NULL) || (attr->parent == NULL)) {
+                fprintf(stderr, "Error: failed to find node with id=\"%s\"\n", value->strValue);
+                goto done;
+            }
+            if(xmlXPathNodeSetAdd(changedNodes, attr->parent) < 0) {
+                fprintf(stderr, "Error: failed to add node with id=\"%s\"\n", value->strValue);
+                goto done;
+            }
+        }
+    }
+
+    /* replace the template with the precompiled one */
+    if(xmlSecAppCmdLineParamIsSet(&signProfileParam)) {
+        xmlNodePtr signNode;
+
+        if(g_signProfile == NULL) {
+            g_signProfile = xmlSecDSigSignProfileCreate(data->startNode);
+            if(g_signProfile == NULL) {
+                fprintf(stderr, "Error: failed to create signing profile\n");
+                goto done;
+            }
+        }
+        if(data->startNode->parent == NULL) {
+            fprintf(stderr, "Error: signature template must have a parent node\n");
+            goto done;
+        }
+        signNode = xmlSecDSigSignProfileInstantiate(g_signProfile, data->startNode->parent);
+        if(signNode == NULL) {
+            fprintf(stderr, "Error: failed to instantiate signing profile\n");
+            goto done;
+        }
+        xmlReplaceNode(data->startNode, signNode);
+        xmlFreeNode(data->startNode);
+        data->startNode = signNode;
+    } else if((g_signProfile == NULL) && (xmlSecAppCmdLineParamGetString(&signProfileFileParam) != NULL)) {
+        xmlSecAppXmlDataPtr profileData;
+
+        profileData = xmlSecAppXmlDataCreate(xmlSecAppCmdLineParamGetString(&signProfileFileParam),
+                                             xmlSecNodeSignature, xmlSecDSigNs);
+        if(profileData == NULL) {
+            fprintf(stderr, "Error: failed to load signing profile \"%s\"\n",
+                    xmlSecAppCmdLineParamGetString(&signProfileFileParam));
+            goto done;
+        }
+        g_signProfile = xmlSecDSigSignProfileCreate(profileData->startNode);
+        xmlSecAppXmlDataDestroy(profileData);
+        if(g_signProfile == NULL) {
+            fprintf(stderr, "Error: failed to create signing profile\n");
+            goto done;
+        }
+    }
+
+    /* open the package if the template describes the package signature */
+    if(xmlSecAppCmdLineParamGetString(&opcPackageParam) != NULL) {
+        pkg = xmlSecOpcPackageOpen(xmlSecAppCmdLineParamGetString(&opcPackageParam));
+        if(pkg == NULL) {
+            fprintf(stderr, "Error: failed to open package \"%s\"\n",
+                    xmlSecAppCmdLineParamGetString(&opcPackageParam));
+            goto done;
+        }
+    }
+
     /* sign */
     start_time = clock();
-    if(xmlSecDSigCtxSign(&dsigCtx, data->startNode) < 0) {
+    if(pkg != NULL) {
+        int threadsNum = xmlSecAppCmdLineParamGetInt(&threadsParam, 1);
+
+        if(xmlSecOpcPackageSign(pkg, &dsigCtx, data->startNode, (threadsNum > 0) ? (xmlSecSize)threadsNum : 1) < 0) {
+            /* caller will print the error */
+            goto done;
+        }
+    } else if(g_signProfile != NULL) {
+        if(xmlSecDSigCtxSignWithProfile(&dsigCtx, g_signProfile, data->startNode) < 0) {
+            /* caller will print the error */
+            goto done;
+        }
+    } else if(changedNodes != NULL) {
+        if(xmlSecDSigCtxSignIncremental(&dsigCtx, data->startNode, changedNodes) < 0) {
+            /* caller will print the error */
+            goto done;
+        }
+    } else if(xmlSecDSigCtxSign(&dsigCtx, data->startNode) < 0) {
         /* caller will print the error */
         goto done;
     }
@@ -1593,6 +1894,12 @@ done:
         xmlSecAppPrintDSigCtx(&dsigCtx);
     }
     xmlSecDSigCtxFinalize(&dsigCtx);
+    if(changedNodes != NULL) {
+        xmlXPathFreeNodeSet(changedNodes);
+    }
+    if(pkg != NULL) {
+        xmlSecOpcPackageClose(pkg);
+    }
     if(data != NULL) {
         xmlSecAppXmlDataDestroy(data);
     }
@@ -1602,6 +1909,7 @@ done:
 static int
 xmlSecAppVerifyFile(const char* inputFileName) {
     xmlSecAppXmlDataPtr data = NULL;
+    xmlSecOpcPackagePtr pkg = NULL;
     xmlSecDSigCtx dsigCtx;
     clock_t start_time;
     int res = -1;
@@ -1627,9 +1935,50 @@ xmlSecAppVerifyFile(const char* inputFileName) {
         goto done;
     }
 
+    /* load verification profile once */
+    if((g_verifyProfile == NULL) && (xmlSecAppCmdLineParamGetString(&verifyProfileParam) != NULL)) {
+        xmlSecAppXmlDataPtr profileData;
+
+        profileData = xmlSecAppXmlDataCreate(xmlSecAppCmdLineParamGetString(&verifyProfileParam),
+                                             xmlSecNodeSignature, xmlSecDSigNs);
+        if(profileData == NULL) {
+            fprintf(stderr, "Error: failed to load verification profile \"%s\"\n",
+                    xmlSecAppCmdLineParamGetString(&verifyProfileParam));
+            goto done;
+        }
+        g_verifyProfile = xmlSecDSigSignProfileCreate(profileData->startNode);
+        xmlSecAppXmlDataDestroy(profileData);
+        if(g_verifyProfile == NULL) {
+            fprintf(stderr, "Error: failed to create verification profile\n");
+            goto done;
+        }
+    }
+
+    /* open the package if the document is the package signature */
+    if(xmlSecAppCmdLineParamGetString(&opcPackageParam) != NULL) {
+        pkg = xmlSecOpcPackageOpen(xmlSecAppCmdLineParamGetString(&opcPackageParam));
+        if(pkg == NULL) {
+            fprintf(stderr, "Error: failed to open package \"%s\"\n",
+                    xmlSecAppCmdLineParamGetString(&opcPackageParam));
+            goto done;
+        }
+    }
+
     /* sign */
     start_time = clock();
-    if(xmlSecDSigCtxVerify(&dsigCtx, data->startNode) < 0) {
+    if(pkg != NULL) {
+        int threadsNum = xmlSecAppCmdLineParamGetInt(&threadsParam, 1);
+
+        if(xmlSecOpcPackageVerify(pkg, &dsigCtx, data->startNode, (threadsNum > 0) ? (xmlSecSize)threadsNum : 1) < 0) {
+            /* caller will print the error */
+            goto done;
+        }
+    } else if(g_verifyProfile != NULL) {
+        if(xmlSecDSigCtxVerifyWithProfile(&dsigCtx, g_verifyProfile, data->startNode) < 0) {
+            /* caller will print the error */
+            goto done;
+        }
+    } else if(xmlSecDSigCtxVerify(&dsigCtx, data->startNode) < 0) {
         /* caller will print the error */
         goto done;
     }
@@ -1686,6 +2035,9 @@ done:
         xmlSecAppPrintDSigCtx(&dsigCtx);
     }
     xmlSecDSigCtxFinalize(&dsigCtx);
+    if(pkg != NULL) {
+        xmlSecOpcPackageClose(pkg);
+    }
     if(data != NULL) {
         xmlSecAppXmlDataDestroy(data);
     }
@@ -1861,6 +2213,12 @@ xmlSecAppPrepareDSigCtx(xmlSecDSigCtxPtr dsigCtx) {
     if(xmlSecAppCmdLineParamIsSet(&enableVisa3DHackParam)) {
         dsigCtx->flags |= XMLSEC_DSIG_FLAGS_USE_VISA3D_HACK;
     }
+    if(xmlSecAppCmdLineParamIsSet(&transformAdaptiveChunkSizeParam)) {
+        dsigCtx->transformCtx.flags |= XMLSEC_TRANSFORMCTX_FLAGS_ADAPTIVE_CHUNK_SIZE;
+    }
+    if(xmlSecAppCmdLineParamIsSet(&transformLibXml2C14NParam)) {
+        dsigCtx->transformCtx.flags |= XMLSEC_TRANSFORMCTX_FLAGS_USE_LIBXML2_C14N;
+    }
 
 #ifndef XMLSEC_NO_HMAC
     if(xmlSecAppCmdLineParamIsSet(&hmacMinOutputLenParam)) {
@@ -1908,6 +2266,7 @@ xmlSecAppEncryptFile(const char* inputFileName, const char* outputFileNameTmpl)
     xmlSecAppXmlDataPtr data = NULL;
     xmlSecEncCtx encCtx;
     xmlDocPtr doc = NULL;
+    xmlNodeSetPtr nodes = NULL;
     xmlNodePtr startTmplNode;
     clock_t start_time;
     int res = -1;
@@ -1958,14 +2317,37 @@ xmlSecAppEncryptFile(const char* inputFileName, const char* outputFileNameTmpl)
             goto done;
         }
 
-        /* encrypt */
-        start_time = clock();
-        if(xmlSecEncCtxXmlEncrypt(&encCtx, startTmplNode, data->startNode) < 0) {
-            fprintf(stderr, "Error: failed to encrypt xml file \"%s\"\n",
-                    xmlSecAppCmdLineParamGetString(&xmlDataParam));
-            goto done;
+        if(xmlSecAppCmdLineParamIsSet(&encryptAllParam)) {
+            int threadsNum = xmlSecAppCmdLineParamGetInt(&threadsParam, 1);
+
+            nodes = xmlXPathNodeSetCreate(NULL);
+            if(nodes == NULL) {
+                fprintf(stderr, "Error: failed to create nodes set\n");
+                goto done;
+            }
+            if(xmlSecAppFindSameNodes(xmlDocGetRootElement(data->doc), data->startNode, nodes) < 0) {
+                fprintf(stderr, "Error: failed to find nodes for encryption\n");
+                goto done;
+            }
+
+            /* encrypt */
+            start_time = clock();
+            if(xmlSecEncCtxXmlEncryptAll(&encCtx, startTmplNode, nodes, (threadsNum > 0) ? (xmlSecSize)threadsNum : 1) < 0) {
+                fprintf(stderr, "Error: failed to encrypt xml file \"%s\"\n",
+                        xmlSecAppCmdLineParamGetString(&xmlDataParam));
+                goto done;
+            }
+            g_totalTime += clock() - start_time;
+        } else {
+            /* encrypt */
+            start_time = clock();
+            if(xmlSecEncCtxXmlEncrypt(&encCtx, startTmplNode, data->startNode) < 0) {
+                fprintf(stderr, "Error: failed to encrypt xml file \"%s\"\n",
+                        xmlSecAppCmdLineParamGetString(&xmlDataParam));
+                goto done;
+            }
+            g_totalTime += clock() - start_time;
         }
-        g_totalTime += clock() - start_time;
     } else {
         fprintf(stderr, "Error: encryption data not specified (use \"--xml-data\" or \"--binary-data\" options)\n");
         goto done;
@@ -1996,6 +2378,9 @@ done:
     }
     xmlSecEncCtxFinalize(&encCtx);
 
+    if(nodes != NULL) {
+        xmlXPathFreeNodeSet(nodes);
+    }
     if(data != NULL) {
         xmlSecAppXmlDataDestroy(data);
     }
@@ -2005,6 +2390,73 @@ done:
     return(res);
 }
 
+/* finds all the nodes with the same name and namespace as @node, the found nodes are not searched */
+static int
+xmlSecAppFindSameNodes(xmlNodePtr cur, xmlNodePtr node, xmlNodeSetPtr nodes) {
+    for(; cur != NULL; cur = xmlSecGetNextElementNode(cur->next)) {
+        if(xmlSecCheckNodeName(cur, node->name, xmlSecGetNodeNsHref(node))) {
+            if(xmlXPathNodeSetAdd(nodes, cur) < 0) {
+                return(-1);
+            }
+        }
+        /* the nested nodes are added too: the library rejects the overlapping nodes */
+        if(xmlSecAppFindSameNodes(xmlSecGetNextElementNode(cur->children), node, nodes) < 0) {
+            return(-1);
+        }
+    }
+    return(0);
+}
+
+static int
+xmlSecAppDecryptToOutputFile(xmlSecEncCtxPtr encCtx, xmlNodePtr node, const char* inputFileName, const char* outputFileNameTmpl) {
+    char* outputFileName = NULL;
+    const char* fileName;
+    xmlOutputBufferPtr outBuffer = NULL;
+    int res = -1;
+
+    /* get output filename by replacing '{inputfile}' with input file name */
+    if((inputFileName != NULL) && (outputFileNameTmpl != NULL)) {
+        outputFileName = xmlSecAppGetOutputFilename(inputFileName, outputFileNameTmpl);
+        if(outputFileName == NULL) {
+            fprintf(stderr, "Error: can't create output filename\n");
+            return(-1);
+        }
+    }
+    fileName = (outputFileName != NULL) ? outputFileName : outputFileNameTmpl;
+
+    /* the not yet authenticated AEAD data written to stdout can't be rolled back */
+    if(((encCtx->transformCtx.flags & XMLSEC_TRANSFORMCTX_FLAGS_AEAD_STREAMING) != 0) &&
+       ((fileName == NULL) || (strcmp(fileName, XMLSEC_STDOUT_FILENAME) == 0)))
+    {
+        fprintf(stderr, "Error: \"--aead-streaming\" and \"--stream-output\" options require an output file\n");
+        goto done;
+    }
+
+    outBuffer = xmlSecAppOpenFile(fileName, NULL);
+    if(outBuffer == NULL) {
+        goto done;
+    }
+    if(xmlSecEncCtxDecryptToOutputBuffer(encCtx, node, outBuffer) < 0) {
+        (void)xmlOutputBufferClose(outBuffer);
+        goto done;
+    }
+    if(xmlOutputBufferClose(outBuffer) < 0) {
+        fprintf(stderr, "Error: failed to write binary output\n");
+        goto done;
+    }
+    res = 0;
+
+done:
+    /* don't leave partially decrypted (and possibly not authenticated) data around */
+    if((res < 0) && (outBuffer != NULL) && (fileName != NULL) && (strcmp(fileName, XMLSEC_STDOUT_FILENAME) != 0)) {
+        (void)remove(fileName);
+    }
+    if((outputFileName != NULL) && (outputFileName != outputFileNameTmpl)) {
+        xmlFree(outputFileName);
+    }
+    return(res);
+}
+
 static int
 xmlSecAppDecryptFile(const char* inputFileName, const char* outputFileNameTmpl) {
     xmlSecAppXmlDataPtr data = NULL;
@@ -2034,15 +2486,27 @@ xmlSecAppDecryptFile(const char* inputFileName, const char* outputFileNameTmpl)
     }
 
     start_time = clock();
-    if(xmlSecEncCtxDecrypt(&encCtx, data->startNode) < 0) {
+    if(xmlSecAppCmdLineParamIsSet(&decryptAllParam)) {
+        int threadsNum = xmlSecAppCmdLineParamGetInt(&threadsParam, 1);
+
+        if(xmlSecEncCtxDecryptAll(&encCtx, xmlDocGetRootElement(data->doc), (threadsNum > 0) ? (xmlSecSize)threadsNum : 1) < 0) {
+            fprintf(stderr, "Error: failed to decrypt file\n");
+            goto done;
+        }
+    } else if(xmlSecAppCmdLineParamIsSet(&streamOutputParam)) {
+        if(xmlSecAppDecryptToOutputFile(&encCtx, data->startNode, inputFileName, outputFileNameTmpl) < 0) {
+            fprintf(stderr, "Error: failed to decrypt file\n");
+            goto done;
+        }
+    } else if(xmlSecEncCtxDecrypt(&encCtx, data->startNode) < 0) {
         fprintf(stderr, "Error: failed to decrypt file\n");
         goto done;
     }
     g_totalTime += clock() - start_time;
 
-    /* print out result only once per execution */
-    if(g_repeats <= 1) {
-        if(encCtx.resultReplaced) {
+    /* print out result only once per execution (the streamed output is already written) */
+    if((g_repeats <= 1) && !xmlSecAppCmdLineParamIsSet(&streamOutputParam)) {
+        if(encCtx.resultReplaced || xmlSecAppCmdLineParamIsSet(&decryptAllParam)) {
             if(xmlSecAppWriteResult(inputFileName, outputFileNameTmpl, data->doc, NULL, data->doc->encoding) < 0) {
                 goto done;
             }
@@ -2197,6 +2661,16 @@ xmlSecAppPrepareEncCtx(xmlSecEncCtxPtr encCtx) {
             return(-1);
         }
     }
+
+    if(xmlSecAppCmdLineParamIsSet(&aeadStreamingParam)) {
+        encCtx->transformCtx.flags |= XMLSEC_TRANSFORMCTX_FLAGS_AEAD_STREAMING;
+    }
+    if(xmlSecAppCmdLineParamIsSet(&transformAdaptiveChunkSizeParam)) {
+        encCtx->transformCtx.flags |= XMLSEC_TRANSFORMCTX_FLAGS_ADAPTIVE_CHUNK_SIZE;
+    }
+    if(xmlSecAppCmdLineParamIsSet(&transformLibXml2C14NParam)) {
+        encCtx->transformCtx.flags |= XMLSEC_TRANSFORMCTX_FLAGS_USE_LIBXML2_C14N;
+    }
     return(0);
 }
 
@@ -2350,6 +2824,22 @@ xmlSecAppLoadKeys(void) {
         return(-1);
     }
 
+    /* add RetrievalMethod / KeyInfoReference results cache */
+    if(xmlSecAppCmdLineParamIsSet(&retrievalCacheParam)) {
+        xmlSecKeyDataStorePtr cacheStore;
+
+        cacheStore = xmlSecKeyDataStoreCreate(xmlSecKeyDataStoreRetrievalCacheId);
+        if(cacheStore == NULL) {
+            fprintf(stderr, "Error: failed to create retrieval cache.\n");
+            return(-1);
+        }
+        if(xmlSecKeysMngrAdoptDataStore(g_keysManager, cacheStore) < 0) {
+            fprintf(stderr, "Error: failed to add retrieval cache to keys manager.\n");
+            xmlSecKeyDataStoreDestroy(cacheStore);
+            return(-1);
+        }
+    }
+
     /* create and initialize key info ctx */
     keyInfoCtx = xmlSecKeyInfoCtxCreate(g_keysManager);
     if(keyInfoCtx == NULL) {
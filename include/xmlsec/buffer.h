@@ -104,6 +104,8 @@ XMLSEC_EXPORT int               xmlSecBufferHexRead             (xmlSecBufferPtr
                                                                  const xmlChar* hexStr);
 
 XMLSEC_EXPORT xmlOutputBufferPtr xmlSecBufferCreateOutputBuffer (xmlSecBufferPtr buf);
+XMLSEC_EXPORT xmlOutputBufferPtr xmlSecBufferCreateOutputBufferWithSizeHint(xmlSecBufferPtr buf,
+                                                                 xmlSecSize sizeHint);
 
 
 
@@ -26,6 +26,7 @@ extern "C" {
  ********************************************************************/
 XMLSEC_CRYPTO_EXPORT int        xmlSecGCryptAppInit                     (const char* config);
 XMLSEC_CRYPTO_EXPORT int        xmlSecGCryptAppShutdown                 (void);
+XMLSEC_CRYPTO_EXPORT int        xmlSecGCryptAppSetSecureMemorySize      (xmlSecSize size);
 
 /********************************************************************
  *
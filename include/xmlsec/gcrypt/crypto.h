@@ -35,6 +35,45 @@ XMLSEC_CRYPTO_EXPORT int                xmlSecGCryptKeysMngrInit        (xmlSecK
 XMLSEC_CRYPTO_EXPORT int                xmlSecGCryptGenerateRandom      (xmlSecBufferPtr buffer,
                                                                          xmlSecSize size);
 
+/********************************************************************
+ *
+ * Secure memory
+ *
+ ********************************************************************/
+/**
+ * xmlSecGCryptSecureMemoryPolicy:
+ * @xmlSecGCryptSecureMemoryPolicySecretsOnly: only contexts that hold key material or
+ *                                              plaintext (ciphers, key wraps, HMAC) are
+ *                                              allocated from the secure memory pool (default).
+ * @xmlSecGCryptSecureMemoryPolicyAll:          every gcrypt context, including digests of
+ *                                              public data, uses the secure memory pool.
+ *
+ * The secure memory allocation policy.
+ */
+typedef enum {
+    xmlSecGCryptSecureMemoryPolicySecretsOnly = 0,
+    xmlSecGCryptSecureMemoryPolicyAll
+} xmlSecGCryptSecureMemoryPolicy;
+
+/**
+ * xmlSecGCryptSecureMemoryStats:
+ * @poolSize:           the size of the secure memory pool allocated by @xmlSecGCryptAppInit
+ *                      (0 if the pool was not initialized by xmlsec).
+ * @secureContexts:     the number of contexts allocated from the secure memory pool.
+ * @publicContexts:     the number of contexts allocated from the regular heap.
+ *
+ * The secure memory usage statistics.
+ */
+typedef struct _xmlSecGCryptSecureMemoryStats {
+    xmlSecSize          poolSize;
+    xmlSecSize          secureContexts;
+    xmlSecSize          publicContexts;
+} xmlSecGCryptSecureMemoryStats, *xmlSecGCryptSecureMemoryStatsPtr;
+
+XMLSEC_CRYPTO_EXPORT void               xmlSecGCryptSetSecureMemoryPolicy(xmlSecGCryptSecureMemoryPolicy policy);
+XMLSEC_CRYPTO_EXPORT xmlSecGCryptSecureMemoryPolicy xmlSecGCryptGetSecureMemoryPolicy(void);
+XMLSEC_CRYPTO_EXPORT int                xmlSecGCryptGetSecureMemoryStats(xmlSecGCryptSecureMemoryStatsPtr stats);
+
 
 /********************************************************************
  *
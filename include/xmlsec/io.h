@@ -47,6 +47,7 @@ XMLSEC_EXPORT xmlSecTransformId xmlSecTransformInputURIGetKlass (void);
 XMLSEC_EXPORT int       xmlSecTransformInputURIOpen             (xmlSecTransformPtr transform,
                                                                  const xmlChar* uri);
 XMLSEC_EXPORT int       xmlSecTransformInputURIClose            (xmlSecTransformPtr transform);
+XMLSEC_EXPORT xmlSecSize xmlSecTransformInputURIGetSizeHint     (xmlSecTransformPtr transform);
 
 #ifdef __cplusplus
 }
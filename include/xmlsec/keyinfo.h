@@ -300,6 +300,21 @@ XMLSEC_EXPORT xmlSecKeyDataId           xmlSecKeyDataRetrievalMethodGetKlass(voi
 #define xmlSecKeyDataKeyInfoReferenceId xmlSecKeyDataKeyInfoReferenceGetKlass()
 XMLSEC_EXPORT xmlSecKeyDataId           xmlSecKeyDataKeyInfoReferenceGetKlass(void);
 
+/**
+ * xmlSecKeyDataStoreRetrievalCacheId:
+ *
+ * The &lt;dsig:RetrievalMethod/&gt; and &lt;dsig11:KeyInfoReference/&gt; results
+ * cache store. If this store is added to the keys manager then the results of
+ * the external URIs dereferencing and transforms are cached and re-used.
+ */
+#define xmlSecKeyDataStoreRetrievalCacheId xmlSecKeyDataStoreRetrievalCacheGetKlass()
+XMLSEC_EXPORT xmlSecKeyDataStoreId      xmlSecKeyDataStoreRetrievalCacheGetKlass(void);
+XMLSEC_EXPORT int                       xmlSecKeyDataStoreRetrievalCacheSetLimits(xmlSecKeyDataStorePtr store,
+                                                                 xmlSecSize maxEntries,
+                                                                 xmlSecSize maxSize,
+                                                                 time_t ttl);
+XMLSEC_EXPORT void                      xmlSecKeyDataStoreRetrievalCacheEmpty(xmlSecKeyDataStorePtr store);
+
 #ifndef XMLSEC_NO_XMLENC
 /**
  * xmlSecKeyDataEncryptedKeyId
@@ -12,6 +12,7 @@
 #define __XMLSEC_MEMBUF_H__
 
 #include <libxml/tree.h>
+#include <libxml/xmlIO.h>
 
 #include <xmlsec/exports.h>
 #include <xmlsec/xmlsec.h>
@@ -37,6 +38,22 @@ extern "C" {
 XMLSEC_EXPORT xmlSecTransformId xmlSecTransformMemBufGetKlass           (void);
 XMLSEC_EXPORT xmlSecBufferPtr   xmlSecTransformMemBufGetBuffer          (xmlSecTransformPtr transform);
 
+/********************************************************************
+ *
+ * Output Buffer transform
+ *
+ *******************************************************************/
+/**
+ * xmlSecTransformOutputBufId:
+ *
+ * The Output Buffer transform klass.
+ */
+#define xmlSecTransformOutputBufId \
+        xmlSecTransformOutputBufGetKlass()
+XMLSEC_EXPORT xmlSecTransformId xmlSecTransformOutputBufGetKlass        (void);
+XMLSEC_EXPORT int               xmlSecTransformOutputBufSetOutput       (xmlSecTransformPtr transform,
+                                                                         xmlOutputBufferPtr output);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -120,6 +120,8 @@ XMLSEC_EXPORT xmlSecNodeSetPtr  xmlSecNodeSetAdd        (xmlSecNodeSetPtr nset,
 XMLSEC_EXPORT xmlSecNodeSetPtr  xmlSecNodeSetAddList    (xmlSecNodeSetPtr nset,
                                                          xmlSecNodeSetPtr newNSet,
                                                          xmlSecNodeSetOp op);
+XMLSEC_EXPORT int               xmlSecNodeSetNumberNodes(xmlSecNodeSetPtr nset);
+XMLSEC_EXPORT int               xmlSecNodeSetMaterialize(xmlSecNodeSetPtr nset);
 XMLSEC_EXPORT xmlSecNodeSetPtr  xmlSecNodeSetGetChildren(xmlDocPtr doc,
                                                          const xmlNodePtr parent,
                                                          int withComments,
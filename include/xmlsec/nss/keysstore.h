@@ -38,6 +38,7 @@ XMLSEC_CRYPTO_EXPORT int                xmlSecNssKeysStoreLoad  (xmlSecKeyStoreP
 XMLSEC_CRYPTO_EXPORT int                xmlSecNssKeysStoreSave  (xmlSecKeyStorePtr store,
                                                                  const char *filename,
                                                                  xmlSecKeyDataType type);
+XMLSEC_CRYPTO_EXPORT void               xmlSecNssKeysStoreFlushCache    (xmlSecKeyStorePtr store);
 
 #ifdef __cplusplus
 }
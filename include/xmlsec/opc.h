@@ -0,0 +1,70 @@
+/*
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * Open Packaging Conventions (OPC) packages (.docx, .xlsx, ...) support
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2024 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#ifndef __XMLSEC_OPC_H__
+#define __XMLSEC_OPC_H__
+
+#include <libxml/tree.h>
+
+#include <xmlsec/exports.h>
+#include <xmlsec/xmlsec.h>
+#include <xmlsec/buffer.h>
+#include <xmlsec/xmldsig.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct _xmlSecOpcPackage                xmlSecOpcPackage,
+                                                *xmlSecOpcPackagePtr;
+
+/**************************************************************************
+ *
+ * xmlSecOpcPackage
+ *
+ *************************************************************************/
+XMLSEC_EXPORT xmlSecOpcPackagePtr xmlSecOpcPackageOpen          (const char* filename);
+XMLSEC_EXPORT void              xmlSecOpcPackageClose           (xmlSecOpcPackagePtr pkg);
+XMLSEC_EXPORT xmlSecSize        xmlSecOpcPackageGetPartsNumber  (xmlSecOpcPackagePtr pkg);
+XMLSEC_EXPORT const xmlChar*    xmlSecOpcPackageGetPartName     (xmlSecOpcPackagePtr pkg,
+                                                                 xmlSecSize pos);
+XMLSEC_EXPORT const xmlChar*    xmlSecOpcPackageGetPartContentType(xmlSecOpcPackagePtr pkg,
+                                                                 const xmlChar* partName);
+XMLSEC_EXPORT int               xmlSecOpcPackageReadPart        (xmlSecOpcPackagePtr pkg,
+                                                                 const xmlChar* partName,
+                                                                 xmlSecBufferPtr buffer);
+
+/*
+ * The package parts are digested on up to @threadsNum threads at the same
+ * time: each part has its own transforms chain and digest context, the keys
+ * and the document are used only from the caller's thread. This requires the
+ * crypto library to support different digest contexts used from different
+ * threads: OpenSSL, GnuTLS and NSS do; GCrypt does since version 1.6.0 (the
+ * older versions require the threads callbacks set with
+ * gcry_control(GCRYCTL_SET_THREAD_CBS) before the library initialization).
+ * Use 1 for @threadsNum with other crypto libraries (or the custom digest
+ * transforms) that are not known to be thread-safe.
+ */
+#ifndef XMLSEC_NO_XMLDSIG
+XMLSEC_EXPORT int               xmlSecOpcPackageSign            (xmlSecOpcPackagePtr pkg,
+                                                                 xmlSecDSigCtxPtr dsigCtx,
+                                                                 xmlNodePtr tmpl,
+                                                                 xmlSecSize threadsNum);
+XMLSEC_EXPORT int               xmlSecOpcPackageVerify          (xmlSecOpcPackagePtr pkg,
+                                                                 xmlSecDSigCtxPtr dsigCtx,
+                                                                 xmlNodePtr node,
+                                                                 xmlSecSize threadsNum);
+#endif /* XMLSEC_NO_XMLDSIG */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __XMLSEC_OPC_H__ */
@@ -454,6 +454,7 @@ XMLSEC_EXPORT_VAR const xmlChar xmlSecNodeKeyValue[];
  *
  ************************************************************************/
 XMLSEC_EXPORT_VAR const xmlChar xmlSecNameMemBuf[];
+XMLSEC_EXPORT_VAR const xmlChar xmlSecNameOutputBuf[];
 
 /*************************************************************************
  *
@@ -487,6 +488,7 @@ XMLSEC_EXPORT_VAR const xmlChar xmlSecNodePbkdf2PRF[];
  *
  ************************************************************************/
 XMLSEC_EXPORT_VAR const xmlChar xmlSecNameRetrievalMethod[];
+XMLSEC_EXPORT_VAR const xmlChar xmlSecNameRetrievalCacheStore[];
 XMLSEC_EXPORT_VAR const xmlChar xmlSecNodeRetrievalMethod[];
 
 /*************************************************************************
@@ -714,6 +716,21 @@ XMLSEC_EXPORT_VAR const xmlChar xmlSecRelationshipAttrId[];
 XMLSEC_EXPORT_VAR const xmlChar xmlSecRelationshipAttrSourceId[];
 XMLSEC_EXPORT_VAR const xmlChar xmlSecRelationshipAttrTargetMode[];
 
+/*************************************************************************
+ *
+ * OPC package strings
+ *
+ ************************************************************************/
+XMLSEC_EXPORT_VAR const xmlChar xmlSecOpcContentTypesPartName[];
+XMLSEC_EXPORT_VAR const xmlChar xmlSecOpcContentTypesNs[];
+XMLSEC_EXPORT_VAR const xmlChar xmlSecOpcNodeTypes[];
+XMLSEC_EXPORT_VAR const xmlChar xmlSecOpcNodeDefault[];
+XMLSEC_EXPORT_VAR const xmlChar xmlSecOpcNodeOverride[];
+XMLSEC_EXPORT_VAR const xmlChar xmlSecOpcAttrExtension[];
+XMLSEC_EXPORT_VAR const xmlChar xmlSecOpcAttrPartName[];
+XMLSEC_EXPORT_VAR const xmlChar xmlSecOpcAttrContentType[];
+XMLSEC_EXPORT_VAR const xmlChar xmlSecOpcUriContentType[];
+
 /*************************************************************************
  *
  * Xslt strings
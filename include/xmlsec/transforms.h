@@ -99,6 +99,18 @@ typedef enum  {
     xmlSecTransformOperationDecrypt
 } xmlSecTransformOperation;
 
+/**
+ * xmlSecTransformIOVec:
+ * @data:                       the pointer to the data fragment.
+ * @size:                       the data fragment size.
+ *
+ * One fragment of the binary data pushed with #xmlSecTransformPushBinV.
+ */
+typedef struct _xmlSecTransformIOVec {
+    const xmlSecByte*           data;
+    xmlSecSize                  size;
+} xmlSecTransformIOVec;
+
 /**************************************************************************
  *
  * xmlSecTransformUriType:
@@ -291,6 +303,40 @@ typedef int             (*xmlSecTransformCtxPreExecuteCallback)         (xmlSecT
  */
 #define XMLSEC_TRANSFORMCTX_FLAGS_USE_VISA3D_HACK               0x00000001
 
+/**
+ * XMLSEC_TRANSFORMCTX_FLAGS_USE_LIBXML2_C14N:
+ *
+ * If this flag is set then the C14N transforms use LibXML2 xmlC14NExecute()
+ * function instead of the XMLSec canonicalization engine. Both produce
+ * the same output, the flag is provided for testing and troubleshooting.
+ */
+#define XMLSEC_TRANSFORMCTX_FLAGS_USE_LIBXML2_C14N              0x00000002
+
+/**
+ * XMLSEC_TRANSFORMCTX_FLAGS_AEAD_STREAMING:
+ *
+ * If this flag is set then the AEAD (e.g. AES GCM) decryption transforms
+ * process the data as it arrives and keep only the authentication tag
+ * instead of collecting the whole ciphertext. The decrypted data is passed
+ * to the next transform BEFORE the tag is verified: if the tag doesn't match
+ * then the transform fails at the end of the data, and the caller MUST
+ * discard (or roll back) everything the output sink received (e.g. see
+ * xmlSecEncCtxDecryptToOutputBuffer()). Without this flag, the AEAD
+ * decryption transforms of some crypto libraries (e.g. GnuTLS) collect
+ * the whole ciphertext in memory first; the OpenSSL ones always stream.
+ */
+#define XMLSEC_TRANSFORMCTX_FLAGS_AEAD_STREAMING                0x00000004
+
+/**
+ * XMLSEC_TRANSFORMCTX_FLAGS_ADAPTIVE_CHUNK_SIZE:
+ *
+ * If this flag is set then the inputs smaller than @binaryChunkSize
+ * (see #xmlSecTransformCtxSetInputSizeHint) are processed in a single
+ * chunk sized to the input instead of allocating @binaryChunkSize buffers
+ * (see #xmlSecTransformCtxGetBinaryChunkSize).
+ */
+#define XMLSEC_TRANSFORMCTX_FLAGS_ADAPTIVE_CHUNK_SIZE           0x00000008
+
 /**
  * xmlSecTransformCtx:
  * @userData:           the pointer to user data (xmlsec and xmlsec-crypto never
@@ -316,7 +362,7 @@ typedef int             (*xmlSecTransformCtxPreExecuteCallback)         (xmlSecT
  * @xptrExpr:           the xpointer expression from data source URI (if any).
  * @first:              the first transform in the chain.
  * @last:               the last transform in the chain.
- * @reserved0:          reserved for the future.
+ * @reserved0:          reserved for the future (used internally).
  * @reserved1:          reserved for the future.
  *
  * The transform execution context.
@@ -390,6 +436,10 @@ XMLSEC_EXPORT void                      xmlSecTransformCtxDebugXmlDump  (xmlSecT
 
 XMLSEC_EXPORT xmlSecSize                xmlSecTransformCtxGetDefaultBinaryChunkSize(void);
 XMLSEC_EXPORT void                      xmlSecTransformCtxSetDefaultBinaryChunkSize(xmlSecSize binaryChunkSize);
+XMLSEC_EXPORT xmlSecSize                xmlSecTransformCtxGetBinaryChunkSize(xmlSecTransformCtxPtr ctx);
+XMLSEC_EXPORT xmlSecSize                xmlSecTransformCtxGetInputSizeHint(xmlSecTransformCtxPtr ctx);
+XMLSEC_EXPORT void                      xmlSecTransformCtxSetInputSizeHint(xmlSecTransformCtxPtr ctx,
+                                                                         xmlSecSize inputSizeHint);
 
 
 /**************************************************************************
@@ -460,6 +510,8 @@ XMLSEC_EXPORT int                       xmlSecTransformVerify   (xmlSecTransform
 XMLSEC_EXPORT int                       xmlSecTransformVerifyNodeContent(xmlSecTransformPtr transform,
                                                                  xmlNodePtr node,
                                                                  xmlSecTransformCtxPtr transformCtx);
+XMLSEC_EXPORT int                       xmlSecTransformCopyState(xmlSecTransformPtr dst,
+                                                                 xmlSecTransformPtr src);
 XMLSEC_EXPORT xmlSecTransformDataType   xmlSecTransformGetDataType(xmlSecTransformPtr transform,
                                                                  xmlSecTransformMode mode,
                                                                  xmlSecTransformCtxPtr transformCtx);
@@ -468,6 +520,11 @@ XMLSEC_EXPORT int                       xmlSecTransformPushBin  (xmlSecTransform
                                                                  xmlSecSize dataSize,
                                                                  int final,
                                                                  xmlSecTransformCtxPtr transformCtx);
+XMLSEC_EXPORT int                       xmlSecTransformPushBinV (xmlSecTransformPtr transform,
+                                                                 const xmlSecTransformIOVec* vec,
+                                                                 xmlSecSize vecSize,
+                                                                 int final,
+                                                                 xmlSecTransformCtxPtr transformCtx);
 XMLSEC_EXPORT int                       xmlSecTransformPopBin   (xmlSecTransformPtr transform,
                                                                  xmlSecByte* data,
                                                                  xmlSecSize maxDataSize,
@@ -557,6 +614,11 @@ XMLSEC_EXPORT int                       xmlSecTransformDefaultPushBin(xmlSecTran
                                                                  xmlSecSize dataSize,
                                                                  int final,
                                                                  xmlSecTransformCtxPtr transformCtx);
+XMLSEC_EXPORT int                       xmlSecTransformDefaultPushBinV(xmlSecTransformPtr transform,
+                                                                 const xmlSecTransformIOVec* vec,
+                                                                 xmlSecSize vecSize,
+                                                                 int final,
+                                                                 xmlSecTransformCtxPtr transformCtx);
 XMLSEC_EXPORT int                       xmlSecTransformDefaultPopBin(xmlSecTransformPtr transform,
                                                                  xmlSecByte* data,
                                                                  xmlSecSize maxDataSize,
@@ -768,6 +830,41 @@ typedef int             (*xmlSecTransformExecuteMethod)         (xmlSecTransform
                                                                  int last,
                                                                  xmlSecTransformCtxPtr transformCtx);
 
+/**
+ * xmlSecTransformCopyStateMethod:
+ * @dst:                        the pointer to destination transform object.
+ * @src:                        the pointer to source transform object (same klass as @dst).
+ *
+ * Transform specific method to copy the processing state (e.g. the digest
+ * state of the data processed so far) from @src to @dst, so that both
+ * transforms can continue independently.
+ *
+ * Returns: 0 on success or a negative value otherwise.
+ */
+typedef int             (*xmlSecTransformCopyStateMethod)       (xmlSecTransformPtr dst,
+                                                                 xmlSecTransformPtr src);
+
+/**
+ * xmlSecTransformPushBinVMethod:
+ * @transform:                  the pointer to transform object.
+ * @vec:                        the input binary data fragments.
+ * @vecSize:                    the number of fragments in @vec.
+ * @final:                      the flag: if set to 1 then it's the last
+ *                              data chunk.
+ * @transformCtx:               the pointer to transform context object.
+ *
+ * The optional transform specific method to process the data fragments
+ * from @vec (in order) without joining them first and push result to the
+ * next transform in the chain.
+ *
+ * Returns: 0 on success or a negative value otherwise.
+ */
+typedef int             (*xmlSecTransformPushBinVMethod)        (xmlSecTransformPtr transform,
+                                                                 const xmlSecTransformIOVec* vec,
+                                                                 xmlSecSize vecSize,
+                                                                 int final,
+                                                                 xmlSecTransformCtxPtr transformCtx);
+
 /**
  * xmlSecTransformKlass:
  * @klassSize:                  the transform klass structure size.
@@ -789,8 +886,8 @@ typedef int             (*xmlSecTransformExecuteMethod)         (xmlSecTransform
  * @popXml:                     the XML data "pop from chain" procesing method.
  * @execute:                    the low level data processing method used  by default
  *                              implementations of @pushBin, @popBin, @pushXml and @popXml.
- * @reserved0:                  reserved for the future.
- * @reserved1:                  reserved for the future.
+ * @copyState:                  the optional processing state copy method (for digest transforms).
+ * @pushBinV:                   the optional binary data fragments "push thru chain" processing method.
  *
  * The transform klass description structure.
  */
@@ -822,9 +919,11 @@ struct _xmlSecTransformKlass {
     /* low level method */
     xmlSecTransformExecuteMethod        execute;
 
-    /* reserved for future */
-    void*                               reserved0;
-    void*                               reserved1;
+    /* optional state cloning */
+    xmlSecTransformCopyStateMethod      copyState;
+
+    /* optional vectored binary push */
+    xmlSecTransformPushBinVMethod       pushBinV;
 };
 
 /**
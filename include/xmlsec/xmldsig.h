@@ -33,6 +33,8 @@ extern "C" {
 
 typedef struct _xmlSecDSigReferenceCtx          xmlSecDSigReferenceCtx,
                                                 *xmlSecDSigReferenceCtxPtr;
+typedef struct _xmlSecDSigSignProfile           xmlSecDSigSignProfile,
+                                                *xmlSecDSigSignProfilePtr;
 
 /**
  * xmlSecDSigStatus:
@@ -189,6 +191,9 @@ XMLSEC_EXPORT int               xmlSecDSigCtxInitialize         (xmlSecDSigCtxPt
 XMLSEC_EXPORT void              xmlSecDSigCtxFinalize           (xmlSecDSigCtxPtr dsigCtx);
 XMLSEC_EXPORT int               xmlSecDSigCtxSign               (xmlSecDSigCtxPtr dsigCtx,
                                                                  xmlNodePtr tmpl);
+XMLSEC_EXPORT int               xmlSecDSigCtxSignIncremental    (xmlSecDSigCtxPtr dsigCtx,
+                                                                 xmlNodePtr tmpl,
+                                                                 xmlNodeSetPtr changedNodes);
 XMLSEC_EXPORT int               xmlSecDSigCtxVerify             (xmlSecDSigCtxPtr dsigCtx,
                                                                  xmlNodePtr node);
 XMLSEC_EXPORT int               xmlSecDSigCtxEnableReferenceTransform(xmlSecDSigCtxPtr dsigCtx,
@@ -295,6 +300,22 @@ XMLSEC_EXPORT void              xmlSecDSigReferenceCtxDebugXmlDump(xmlSecDSigRef
         xmlSecDSigReferenceCtxListGetKlass()
 XMLSEC_EXPORT xmlSecPtrListId   xmlSecDSigReferenceCtxListGetKlass(void);
 
+/**************************************************************************
+ *
+ * xmlSecDSigSignProfile
+ *
+ *************************************************************************/
+XMLSEC_EXPORT xmlSecDSigSignProfilePtr xmlSecDSigSignProfileCreate      (xmlNodePtr tmpl);
+XMLSEC_EXPORT void              xmlSecDSigSignProfileDestroy    (xmlSecDSigSignProfilePtr profile);
+XMLSEC_EXPORT xmlNodePtr        xmlSecDSigSignProfileInstantiate(xmlSecDSigSignProfilePtr profile,
+                                                                 xmlNodePtr parent);
+XMLSEC_EXPORT int               xmlSecDSigCtxSignWithProfile    (xmlSecDSigCtxPtr dsigCtx,
+                                                                 xmlSecDSigSignProfilePtr profile,
+                                                                 xmlNodePtr tmpl);
+XMLSEC_EXPORT int               xmlSecDSigCtxVerifyWithProfile  (xmlSecDSigCtxPtr dsigCtx,
+                                                                 xmlSecDSigSignProfilePtr profile,
+                                                                 xmlNodePtr node);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
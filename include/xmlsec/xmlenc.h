@@ -158,6 +158,10 @@ XMLSEC_EXPORT int               xmlSecEncCtxBinaryEncrypt       (xmlSecEncCtxPtr
 XMLSEC_EXPORT int               xmlSecEncCtxXmlEncrypt          (xmlSecEncCtxPtr encCtx,
                                                                  xmlNodePtr tmpl,
                                                                  xmlNodePtr node);
+XMLSEC_EXPORT int               xmlSecEncCtxXmlEncryptAll       (xmlSecEncCtxPtr encCtx,
+                                                                 xmlNodePtr tmpl,
+                                                                 xmlNodeSetPtr nodes,
+                                                                 xmlSecSize threadsNum);
 XMLSEC_EXPORT int               xmlSecEncCtxUriEncrypt          (xmlSecEncCtxPtr encCtx,
                                                                  xmlNodePtr tmpl,
                                                                  const xmlChar *uri);
@@ -165,6 +169,12 @@ XMLSEC_EXPORT int               xmlSecEncCtxDecrypt             (xmlSecEncCtxPtr
                                                                  xmlNodePtr node);
 XMLSEC_EXPORT xmlSecBufferPtr   xmlSecEncCtxDecryptToBuffer     (xmlSecEncCtxPtr encCtx,
                                                                  xmlNodePtr node);
+XMLSEC_EXPORT int               xmlSecEncCtxDecryptToOutputBuffer(xmlSecEncCtxPtr encCtx,
+                                                                 xmlNodePtr node,
+                                                                 xmlOutputBufferPtr output);
+XMLSEC_EXPORT int               xmlSecEncCtxDecryptAll          (xmlSecEncCtxPtr encCtx,
+                                                                 xmlNodePtr node,
+                                                                 xmlSecSize threadsNum);
 XMLSEC_EXPORT void              xmlSecEncCtxDebugDump           (xmlSecEncCtxPtr encCtx,
                                                                  FILE* output);
 XMLSEC_EXPORT void              xmlSecEncCtxDebugXmlDump        (xmlSecEncCtxPtr encCtx,
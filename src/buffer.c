@@ -732,6 +732,36 @@ xmlSecBufferCreateOutputBuffer(xmlSecBufferPtr buf) {
                                      NULL));
 }
 
+/**
+ * xmlSecBufferCreateOutputBufferWithSizeHint:
+ * @buf:                the pointer to buffer.
+ * @sizeHint:           the expected size of the data to be written.
+ *
+ * Same as #xmlSecBufferCreateOutputBuffer but also reserves space for
+ * @sizeHint more bytes in the @buf so the writer doesn't need to grow
+ * (and copy) the buffer when the output size is known in advance. Caller
+ * is responsible for destroying @buf when processing is done.
+ *
+ * Returns: pointer to newly allocated output buffer or NULL if an error
+ * occurs.
+ */
+xmlOutputBufferPtr
+xmlSecBufferCreateOutputBufferWithSizeHint(xmlSecBufferPtr buf, xmlSecSize sizeHint) {
+    int ret;
+
+    xmlSecAssert2(buf != NULL, NULL);
+
+    if(sizeHint > 0) {
+        ret = xmlSecBufferSetMaxSize(buf, buf->size + sizeHint);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecBufferSetMaxSize", NULL,
+                "size=" XMLSEC_SIZE_FMT, (buf->size + sizeHint));
+            return(NULL);
+        }
+    }
+    return(xmlSecBufferCreateOutputBuffer(buf));
+}
+
 static int
 xmlSecBufferIOWrite(xmlSecBufferPtr buf, const xmlSecByte *data, int len) {
     xmlSecSize size;
@@ -742,6 +772,24 @@ xmlSecBufferIOWrite(xmlSecBufferPtr buf, const xmlSecByte *data, int len) {
     xmlSecAssert2(len >= 0, -1);
 
     XMLSEC_SAFE_CAST_INT_TO_SIZE(len, size, return(-1), NULL);
+
+    /* LibXML2 writes the output in small chunks: always grow geometrically,
+     * otherwise with xmlSecAllocModeExact every chunk would copy the whole
+     * buffer again */
+    if((buf->size + size > buf->maxSize) && (buf->allocMode == xmlSecAllocModeExact)) {
+        xmlSecSize newSize = buf->size + size;
+
+        if(newSize < 2 * buf->maxSize) {
+            newSize = 2 * buf->maxSize;
+        }
+        ret = xmlSecBufferSetMaxSize(buf, newSize);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecBufferSetMaxSize", NULL,
+                "size=" XMLSEC_SIZE_FMT, newSize);
+            return(-1);
+        }
+    }
+
     ret = xmlSecBufferAppend(buf, data, size);
     if(ret < 0) {
         xmlSecInternalError2("xmlSecBufferAppend", NULL, "size=" XMLSEC_SIZE_FMT, size);
@@ -19,6 +19,8 @@
 
 #include <libxml/tree.h>
 #include <libxml/c14n.h>
+#include <libxml/uri.h>
+#include <libxml/xpathInternals.h>
 
 #include <xmlsec/xmlsec.h>
 #include <xmlsec/keys.h>
@@ -29,6 +31,20 @@
 
 #include "cast_helpers.h"
 
+/* SSE2 is always available on x86-64, AVX2 is checked at runtime */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define XMLSEC_C14N_ESCAPE_SSE2                 1
+#include <emmintrin.h>
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define XMLSEC_C14N_ESCAPE_AVX2                 1
+#include <immintrin.h>
+#endif /* (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)) */
+#endif /* defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) */
+
+/* the nodes sets with more explicit nodes are numbered before c14n to avoid
+ * linear scans over the nodes for each document node */
+#define XMLSEC_C14N_NUMBER_NODES_MIN            16
+
 /******************************************************************************
  *
  * C14N transforms
@@ -71,10 +87,101 @@ static int              xmlSecTransformC14NPopBin       (xmlSecTransformPtr tran
                                                          xmlSecSize maxDataSize,
                                                          xmlSecSize* dataSize,
                                                          xmlSecTransformCtxPtr transformCtx);
-static int              xmlSecTransformC14NExecute      (xmlSecTransformId id,
+static int              xmlSecTransformC14NExecute      (xmlSecTransformPtr transform,
+                                                         xmlSecNodeSetPtr nodes,
+                                                         int pushToNext,
+                                                         xmlSecTransformCtxPtr transformCtx);
+static int              xmlSecTransformC14NOutputBufferExecute(xmlSecTransformId id,
                                                          xmlSecNodeSetPtr nodes,
                                                          xmlSecPtrListPtr nsList,
                                                          xmlOutputBufferPtr buf);
+
+/******************************************************************************
+ *
+ * C14N engine
+ *
+ * Produces exactly the same output as LibXML2 xmlC14NExecute() function
+ * but writes directly into the transforms chain buffers, tracks in-scope
+ * and rendered namespaces in flat stacks (instead of walking the ancestors
+ * with xmlSearchNs() for every namespace node), reuses the namespaces and
+ * attributes sort lists between elements, and escapes text and attribute
+ * values with a lookup table.
+ *
+ *****************************************************************************/
+typedef enum {
+    xmlSecC14NModeInclusive10 = 0,
+    xmlSecC14NModeInclusive11,
+    xmlSecC14NModeExclusive10
+} xmlSecC14NMode;
+
+typedef enum {
+    xmlSecC14NPosBeforeDocumentElement = 0,
+    xmlSecC14NPosInsideDocumentElement,
+    xmlSecC14NPosAfterDocumentElement
+} xmlSecC14NPos;
+
+/* returns the position of the first char in @str that needs escaping for @mask or @size */
+typedef xmlSecSize (*xmlSecC14NEngineEscapeScanMethod)  (const xmlSecByte* str,
+                                                         xmlSecSize size,
+                                                         xmlSecByte mask);
+
+typedef struct _xmlSecC14NEngine                xmlSecC14NEngine,
+                                                *xmlSecC14NEnginePtr;
+struct _xmlSecC14NEngine {
+    xmlSecC14NMode              mode;
+    int                         withComments;
+    xmlSecNodeSetPtr            nodes;
+    int                         allVisible;
+    int                         subtreesVisible;
+    int                         hideComments;
+    xmlSecPtrList               excludedRoots;
+    xmlSecPtrList               includedRoots;
+    xmlDocPtr                   doc;
+    xmlSecPtrListPtr            inclusiveNsList;
+    const xmlChar*              errorObject;
+    xmlSecC14NEngineEscapeScanMethod escapeScan;
+
+    /* output: our own buffer, flushed to the next transform (if any) */
+    xmlSecBufferPtr             out;
+    xmlSecTransformPtr          next;
+    xmlSecTransformCtxPtr       transformCtx;
+    xmlSecSize                  chunkSize;
+
+    /* the element which children, attributes and namespaces are processed
+     * and the number of the included subtrees roots among its ancestors-or-self */
+    xmlNodePtr                  curElement;
+    xmlSecSize                  includedDepth;
+
+    /* position relative to the document element */
+    xmlSecC14NPos               pos;
+    int                         parentIsDoc;
+
+    /* rendered namespaces stack */
+    xmlSecPtrList               renderedNs;
+    xmlSecPtrList               renderedNodes;
+    xmlSecSize                  renderedPrevStart;
+    xmlSecSize                  renderedPrevEnd;
+
+    /* in-scope namespaces stack: for each ancestor, element's ns followed
+     * by element's ns definitions (in reverse order) */
+    xmlSecPtrList               scopeNs;
+    xmlSecSize                  scopeOwnNsPos;
+
+    /* sort lists, reused for every element */
+    xmlSecPtrList               sortedNs;
+    xmlSecPtrList               sortedAttrs;
+};
+
+static int              xmlSecC14NEngineInitialize      (xmlSecC14NEnginePtr engine,
+                                                         xmlSecTransformPtr transform,
+                                                         xmlSecNodeSetPtr nodes,
+                                                         xmlSecTransformPtr next,
+                                                         xmlSecTransformCtxPtr transformCtx);
+static void             xmlSecC14NEngineFinalize        (xmlSecC14NEnginePtr engine);
+static int              xmlSecC14NEngineExecute         (xmlSecC14NEnginePtr engine);
+static xmlSecSize       xmlSecC14NCountNodes            (xmlSecNodeSetPtr nodes);
+
+
 static int
 xmlSecTransformC14NInitialize(xmlSecTransformPtr transform) {
     xmlSecPtrListPtr nsList;
@@ -188,7 +295,6 @@ xmlSecTransformC14NNodeRead(xmlSecTransformPtr transform, xmlNodePtr node, xmlSe
 static int
 xmlSecTransformC14NPushXml(xmlSecTransformPtr transform, xmlSecNodeSetPtr nodes,
                             xmlSecTransformCtxPtr transformCtx) {
-    xmlOutputBufferPtr buf;
     int ret;
 
     xmlSecAssert2(xmlSecTransformC14NCheckId(transform), -1);
@@ -210,35 +316,11 @@ xmlSecTransformC14NPushXml(xmlSecTransformPtr transform, xmlSecNodeSetPtr nodes,
     }
     xmlSecAssert2(transform->status == xmlSecTransformStatusWorking, -1);
 
-    /* prepare output buffer: next transform or ourselves */
-    if(transform->next != NULL) {
-        buf = xmlSecTransformCreateOutputBuffer(transform->next, transformCtx);
-        if(buf == NULL) {
-            xmlSecInternalError("xmlSecTransformCreateOutputBuffer",
-                                xmlSecTransformGetName(transform));
-            return(-1);
-        }
-    } else {
-        buf = xmlSecBufferCreateOutputBuffer(&(transform->outBuf));
-        if(buf == NULL) {
-            xmlSecInternalError("xmlSecBufferCreateOutputBuffer",
-                                xmlSecTransformGetName(transform));
-            return(-1);
-        }
-    }
-
-    ret = xmlSecTransformC14NExecute(transform->id, nodes,
-            xmlSecC14NGetCtx(transform), buf);
+    /* canonicalize directly to the next transform or to ourselves */
+    ret = xmlSecTransformC14NExecute(transform, nodes, 1, transformCtx);
     if(ret < 0) {
         xmlSecInternalError("xmlSecTransformC14NExecute",
                             xmlSecTransformGetName(transform));
-        (void)xmlOutputBufferClose(buf);
-        return(-1);
-    }
-
-    ret = xmlOutputBufferClose(buf);
-    if(ret < 0) {
-        xmlSecXmlError("xmlOutputBufferClose", xmlSecTransformGetName(transform));
         return(-1);
     }
     transform->status = xmlSecTransformStatusFinished;
@@ -259,8 +341,6 @@ xmlSecTransformC14NPopBin(xmlSecTransformPtr transform, xmlSecByte* data,
 
     out = &(transform->outBuf);
     if(transform->status == xmlSecTransformStatusNone) {
-        xmlOutputBufferPtr buf;
-
         xmlSecAssert2(transform->inNodes == NULL, -1);
 
         /* todo: isn't it an error? */
@@ -279,41 +359,26 @@ xmlSecTransformC14NPopBin(xmlSecTransformPtr transform, xmlSecByte* data,
         }
 
         /* dump everything to internal buffer */
-        buf = xmlSecBufferCreateOutputBuffer(out);
-        if(buf == NULL) {
-            xmlSecInternalError("xmlSecBufferCreateOutputBuffer",
-                                xmlSecTransformGetName(transform));
-            return(-1);
-        }
-
-        /* we are using a semi-hack here: we know that xmlSecPtrList keeps
-         * all pointers in the big array */
-        ret = xmlSecTransformC14NExecute(transform->id, transform->inNodes,
-                xmlSecC14NGetCtx(transform), buf);
+        ret = xmlSecTransformC14NExecute(transform, transform->inNodes, 0, transformCtx);
         if(ret < 0) {
             xmlSecInternalError("xmlSecTransformC14NExecute",
                                 xmlSecTransformGetName(transform));
-            (void)xmlOutputBufferClose(buf);
-            return(-1);
-        }
-        ret = xmlOutputBufferClose(buf);
-        if(ret < 0) {
-            xmlSecXmlError("xmlOutputBufferClose", xmlSecTransformGetName(transform));
             return(-1);
         }
         transform->status = xmlSecTransformStatusWorking;
     }
 
     if(transform->status == xmlSecTransformStatusWorking) {
-        xmlSecSize outSize;
+        xmlSecSize outSize, chunkSize;
 
         /* return chunk after chunk */
         outSize = xmlSecBufferGetSize(out);
         if(outSize > maxDataSize) {
             outSize = maxDataSize;
         }
-        if(outSize > transformCtx->binaryChunkSize) {
-            outSize = transformCtx->binaryChunkSize;
+        chunkSize = xmlSecTransformCtxGetBinaryChunkSize(transformCtx);
+        if(outSize > chunkSize) {
+            outSize = chunkSize;
         }
         if(outSize > 0) {
             xmlSecAssert2(xmlSecBufferGetData(&(transform->outBuf)), -1);
@@ -342,8 +407,113 @@ xmlSecTransformC14NPopBin(xmlSecTransformPtr transform, xmlSecByte* data,
 }
 
 static int
-xmlSecTransformC14NExecute(xmlSecTransformId id, xmlSecNodeSetPtr nodes, xmlSecPtrListPtr nsList,
-                           xmlOutputBufferPtr buf) {
+xmlSecTransformC14NExecute(xmlSecTransformPtr transform, xmlSecNodeSetPtr nodes,
+                           int pushToNext, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecC14NEngine engine;
+    xmlSecTransformPtr next;
+    int ret;
+
+    xmlSecAssert2(xmlSecTransformC14NCheckId(transform), -1);
+    xmlSecAssert2(nodes != NULL, -1);
+    xmlSecAssert2(nodes->doc != NULL, -1);
+    xmlSecAssert2(transformCtx != NULL, -1);
+
+    next = (pushToNext != 0) ? transform->next : NULL;
+
+    /* both c14n engines check every document node against the nodes set */
+    if(xmlSecC14NCountNodes(nodes) >= XMLSEC_C14N_NUMBER_NODES_MIN) {
+        ret = xmlSecNodeSetNumberNodes(nodes);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecNodeSetNumberNodes",
+                                xmlSecTransformGetName(transform));
+            return(-1);
+        }
+    }
+
+    /* RemoveXmlTags transform and LibXML2 c14n engine write into the output buffer */
+    if(xmlSecTransformCheckId(transform, xmlSecTransformRemoveXmlTagsC14NId) ||
+       ((transformCtx->flags & XMLSEC_TRANSFORMCTX_FLAGS_USE_LIBXML2_C14N) != 0)
+    ) {
+        xmlOutputBufferPtr buf;
+
+        /* prepare output buffer: next transform or ourselves */
+        if(next != NULL) {
+            buf = xmlSecTransformCreateOutputBuffer(next, transformCtx);
+            if(buf == NULL) {
+                xmlSecInternalError("xmlSecTransformCreateOutputBuffer",
+                                    xmlSecTransformGetName(transform));
+                return(-1);
+            }
+        } else {
+            buf = xmlSecBufferCreateOutputBuffer(&(transform->outBuf));
+            if(buf == NULL) {
+                xmlSecInternalError("xmlSecBufferCreateOutputBuffer",
+                                    xmlSecTransformGetName(transform));
+                return(-1);
+            }
+        }
+
+        ret = xmlSecTransformC14NOutputBufferExecute(transform->id, nodes,
+                xmlSecC14NGetCtx(transform), buf);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformC14NOutputBufferExecute",
+                                xmlSecTransformGetName(transform));
+            (void)xmlOutputBufferClose(buf);
+            return(-1);
+        }
+
+        ret = xmlOutputBufferClose(buf);
+        if(ret < 0) {
+            xmlSecXmlError("xmlOutputBufferClose", xmlSecTransformGetName(transform));
+            return(-1);
+        }
+        return(0);
+    }
+
+    /* use our own c14n engine */
+    ret = xmlSecC14NEngineInitialize(&engine, transform, nodes, next, transformCtx);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecC14NEngineInitialize",
+                            xmlSecTransformGetName(transform));
+        return(-1);
+    }
+
+    ret = xmlSecC14NEngineExecute(&engine);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecC14NEngineExecute",
+                            xmlSecTransformGetName(transform));
+        xmlSecC14NEngineFinalize(&engine);
+        return(-1);
+    }
+
+    /* done */
+    xmlSecC14NEngineFinalize(&engine);
+    return(0);
+}
+
+/* counts the explicit nodes in all the nodes sets in the list */
+static xmlSecSize
+xmlSecC14NCountNodes(xmlSecNodeSetPtr nodes) {
+    xmlSecNodeSetPtr cur;
+    xmlSecSize res = 0;
+
+    xmlSecAssert2(nodes != NULL, 0);
+
+    cur = nodes;
+    do {
+        if(cur->type == xmlSecNodeSetList) {
+            res += xmlSecC14NCountNodes(cur->children);
+        } else if(cur->nodes != NULL) {
+            res += (xmlSecSize)xmlXPathNodeSetGetLength(cur->nodes);
+        }
+        cur = cur->next;
+    } while(cur != nodes);
+    return(res);
+}
+
+static int
+xmlSecTransformC14NOutputBufferExecute(xmlSecTransformId id, xmlSecNodeSetPtr nodes,
+                                       xmlSecPtrListPtr nsList, xmlOutputBufferPtr buf) {
     int ret;
 
     xmlSecAssert2(id != xmlSecTransformIdUnknown, -1);
@@ -732,3 +902,1889 @@ xmlSecTransformId
 xmlSecTransformRemoveXmlTagsC14NGetKlass(void) {
     return(&xmlSecTransformRemoveXmlTagsC14NKlass);
 }
+
+/***************************************************************************
+ *
+ * C14N engine implementation
+ *
+ ***************************************************************************/
+#define XMLSEC_C14N_ESCAPE_TEXT                 0x01
+#define XMLSEC_C14N_ESCAPE_ATTR                 0x02
+#define XMLSEC_C14N_ESCAPE_CR                   0x04
+
+/* characters that need to be escaped in text nodes, attribute values, comments and PIs */
+static const xmlSecByte xmlSecC14NEscapeTable[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 0, 0, 7, 0, 0, /* 0x00 - 0x0F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x10 - 0x1F */
+    0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x20 - 0x2F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 0, 1, 0, /* 0x30 - 0x3F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x40 - 0x4F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x50 - 0x5F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x60 - 0x6F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x70 - 0x7F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x80 - 0x8F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0x90 - 0x9F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0xA0 - 0xAF */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0xB0 - 0xBF */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0xC0 - 0xCF */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0xD0 - 0xDF */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 0xE0 - 0xEF */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0  /* 0xF0 - 0xFF */
+};
+
+/* all the chars from xmlSecC14NEscapeTable */
+static const xmlSecByte xmlSecC14NEscapeChars[] = { '&', '<', '>', '"', '\x09', '\x0A', '\x0D' };
+
+/* fills @chars with the chars that need escaping for @mask */
+static xmlSecSize
+xmlSecC14NEscapeCharsGet(xmlSecByte mask, xmlSecByte chars[sizeof(xmlSecC14NEscapeChars)]) {
+    xmlSecSize ii, res;
+
+    for(ii = res = 0; ii < sizeof(xmlSecC14NEscapeChars); ++ii) {
+        if((xmlSecC14NEscapeTable[xmlSecC14NEscapeChars[ii]] & mask) != 0) {
+            chars[res++] = xmlSecC14NEscapeChars[ii];
+        }
+    }
+    return(res);
+}
+
+static xmlSecSize
+xmlSecC14NEscapeScanDefault(const xmlSecByte* str, xmlSecSize size, xmlSecByte mask) {
+    xmlSecSize ii;
+
+    for(ii = 0; ii < size; ++ii) {
+        if((xmlSecC14NEscapeTable[str[ii]] & mask) != 0) {
+            break;
+        }
+    }
+    return(ii);
+}
+
+#ifdef XMLSEC_C14N_ESCAPE_SSE2
+/* 16 bytes at a time, the block with a match (and the tail) are checked with the table */
+static xmlSecSize
+xmlSecC14NEscapeScanSse2(const xmlSecByte* str, xmlSecSize size, xmlSecByte mask) {
+    xmlSecByte chars[sizeof(xmlSecC14NEscapeChars)];
+    __m128i needles[sizeof(xmlSecC14NEscapeChars)];
+    __m128i data, found;
+    xmlSecSize charsNum, ii, jj;
+
+    charsNum = xmlSecC14NEscapeCharsGet(mask, chars);
+    for(jj = 0; jj < charsNum; ++jj) {
+        needles[jj] = _mm_set1_epi8((char)chars[jj]);
+    }
+
+    for(ii = 0; ii + 16 <= size; ii += 16) {
+        data = _mm_loadu_si128((const __m128i*)(const void*)(str + ii));
+        found = _mm_setzero_si128();
+        for(jj = 0; jj < charsNum; ++jj) {
+            found = _mm_or_si128(found, _mm_cmpeq_epi8(data, needles[jj]));
+        }
+        if(_mm_movemask_epi8(found) != 0) {
+            break;
+        }
+    }
+    return(ii + xmlSecC14NEscapeScanDefault(str + ii, size - ii, mask));
+}
+#endif /* XMLSEC_C14N_ESCAPE_SSE2 */
+
+#ifdef XMLSEC_C14N_ESCAPE_AVX2
+/* same as SSE2 but 32 bytes at a time */
+__attribute__((target("avx2")))
+static xmlSecSize
+xmlSecC14NEscapeScanAvx2(const xmlSecByte* str, xmlSecSize size, xmlSecByte mask) {
+    xmlSecByte chars[sizeof(xmlSecC14NEscapeChars)];
+    __m256i needles[sizeof(xmlSecC14NEscapeChars)];
+    __m256i data, found;
+    xmlSecSize charsNum, ii, jj;
+
+    charsNum = xmlSecC14NEscapeCharsGet(mask, chars);
+    for(jj = 0; jj < charsNum; ++jj) {
+        needles[jj] = _mm256_set1_epi8((char)chars[jj]);
+    }
+
+    for(ii = 0; ii + 32 <= size; ii += 32) {
+        data = _mm256_loadu_si256((const __m256i*)(const void*)(str + ii));
+        found = _mm256_setzero_si256();
+        for(jj = 0; jj < charsNum; ++jj) {
+            found = _mm256_or_si256(found, _mm256_cmpeq_epi8(data, needles[jj]));
+        }
+        if(_mm256_movemask_epi8(found) != 0) {
+            break;
+        }
+    }
+    return(ii + xmlSecC14NEscapeScanSse2(str + ii, size - ii, mask));
+}
+#endif /* XMLSEC_C14N_ESCAPE_AVX2 */
+
+static xmlSecC14NEngineEscapeScanMethod
+xmlSecC14NEscapeScanGetMethod(void) {
+#ifdef XMLSEC_C14N_ESCAPE_AVX2
+    if(__builtin_cpu_supports("avx2")) {
+        return(xmlSecC14NEscapeScanAvx2);
+    }
+#endif /* XMLSEC_C14N_ESCAPE_AVX2 */
+
+#ifdef XMLSEC_C14N_ESCAPE_SSE2
+    return(xmlSecC14NEscapeScanSse2);
+#else  /* XMLSEC_C14N_ESCAPE_SSE2 */
+    return(xmlSecC14NEscapeScanDefault);
+#endif /* XMLSEC_C14N_ESCAPE_SSE2 */
+}
+
+#define xmlSecC14NEngineIsXmlNs(ns) \
+    (((ns) != NULL) && \
+     xmlStrEqual((ns)->prefix, BAD_CAST "xml") && \
+     xmlStrEqual((ns)->href, XML_XML_NAMESPACE))
+
+#define xmlSecC14NEngineIsXmlAttr(attr) \
+    (((attr)->ns != NULL) && xmlSecC14NEngineIsXmlNs((attr)->ns))
+
+typedef int (*xmlSecC14NEngineCompareMethod)                    (const void* item1,
+                                                                 const void* item2);
+
+static int              xmlSecC14NEngineProcessNodeList         (xmlSecC14NEnginePtr engine,
+                                                                 xmlNodePtr cur);
+static int              xmlSecC14NEngineFindSubtrees            (xmlSecC14NEnginePtr engine);
+static int              xmlSecC14NEngineIsIncludedRoot          (xmlSecC14NEnginePtr engine,
+                                                                 xmlNodePtr cur);
+
+static xmlSecPtrListKlass xmlSecC14NEnginePtrListKlass = {
+    BAD_CAST "c14n-engine-list",
+    NULL,                                       /* xmlSecPtrDuplicateItemMethod duplicateItem; */
+    NULL,                                       /* xmlSecPtrDestroyItemMethod destroyItem; */
+    NULL,                                       /* xmlSecPtrDebugDumpItemMethod debugDumpItem; */
+    NULL,                                       /* xmlSecPtrDebugDumpItemMethod debugXmlDumpItem; */
+};
+#define xmlSecC14NEnginePtrListId       (&xmlSecC14NEnginePtrListKlass)
+
+static void
+xmlSecC14NEngineListTruncate(xmlSecPtrListPtr list, xmlSecSize size) {
+    xmlSecAssert(list != NULL);
+
+    /* we are using a semi-hack here: the engine's lists don't own
+     * the items thus we can simply drop the tail */
+    if(list->use > size) {
+        list->use = size;
+    }
+}
+
+static int
+xmlSecC14NEngineInitialize(xmlSecC14NEnginePtr engine, xmlSecTransformPtr transform,
+                           xmlSecNodeSetPtr nodes, xmlSecTransformPtr next,
+                           xmlSecTransformCtxPtr transformCtx) {
+    int ret;
+
+    xmlSecAssert2(engine != NULL, -1);
+    xmlSecAssert2(transform != NULL, -1);
+    xmlSecAssert2(nodes != NULL, -1);
+    xmlSecAssert2(nodes->doc != NULL, -1);
+    xmlSecAssert2(transformCtx != NULL, -1);
+
+    memset(engine, 0, sizeof(xmlSecC14NEngine));
+    engine->escapeScan = xmlSecC14NEscapeScanGetMethod();
+
+    if(xmlSecTransformCheckId(transform, xmlSecTransformInclC14NId)) {
+        engine->mode = xmlSecC14NModeInclusive10;
+        engine->withComments = 0;
+    } else if(xmlSecTransformCheckId(transform, xmlSecTransformInclC14NWithCommentsId)) {
+        engine->mode = xmlSecC14NModeInclusive10;
+        engine->withComments = 1;
+    } else if(xmlSecTransformCheckId(transform, xmlSecTransformInclC14N11Id)) {
+        engine->mode = xmlSecC14NModeInclusive11;
+        engine->withComments = 0;
+    } else if(xmlSecTransformCheckId(transform, xmlSecTransformInclC14N11WithCommentsId)) {
+        engine->mode = xmlSecC14NModeInclusive11;
+        engine->withComments = 1;
+    } else if(xmlSecTransformCheckId(transform, xmlSecTransformExclC14NId)) {
+        engine->mode = xmlSecC14NModeExclusive10;
+        engine->withComments = 0;
+        engine->inclusiveNsList = xmlSecC14NGetCtx(transform);
+    } else if(xmlSecTransformCheckId(transform, xmlSecTransformExclC14NWithCommentsId)) {
+        engine->mode = xmlSecC14NModeExclusive10;
+        engine->withComments = 1;
+        engine->inclusiveNsList = xmlSecC14NGetCtx(transform);
+    } else {
+        xmlSecInvalidTransfromError(transform);
+        return(-1);
+    }
+
+    engine->nodes           = nodes;
+    engine->doc             = nodes->doc;
+    engine->errorObject     = xmlSecTransformGetName(transform);
+    engine->out             = &(transform->outBuf);
+    engine->next            = next;
+    engine->transformCtx    = transformCtx;
+    engine->chunkSize       = xmlSecTransformCtxGetBinaryChunkSize(transformCtx);
+    engine->pos             = xmlSecC14NPosBeforeDocumentElement;
+    engine->parentIsDoc     = 1;
+    engine->curElement      = (xmlNodePtr)engine->doc;
+
+    ret = xmlSecPtrListInitialize(&(engine->renderedNs), xmlSecC14NEnginePtrListId);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInitialize(renderedNs)", engine->errorObject);
+        return(-1);
+    }
+    ret = xmlSecPtrListInitialize(&(engine->renderedNodes), xmlSecC14NEnginePtrListId);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInitialize(renderedNodes)", engine->errorObject);
+        return(-1);
+    }
+    ret = xmlSecPtrListInitialize(&(engine->scopeNs), xmlSecC14NEnginePtrListId);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInitialize(scopeNs)", engine->errorObject);
+        return(-1);
+    }
+    ret = xmlSecPtrListInitialize(&(engine->sortedNs), xmlSecC14NEnginePtrListId);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInitialize(sortedNs)", engine->errorObject);
+        return(-1);
+    }
+    ret = xmlSecPtrListInitialize(&(engine->sortedAttrs), xmlSecC14NEnginePtrListId);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInitialize(sortedAttrs)", engine->errorObject);
+        return(-1);
+    }
+    ret = xmlSecPtrListInitialize(&(engine->excludedRoots), xmlSecC14NEnginePtrListId);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInitialize(excludedRoots)", engine->errorObject);
+        return(-1);
+    }
+    ret = xmlSecPtrListInitialize(&(engine->includedRoots), xmlSecC14NEnginePtrListId);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInitialize(includedRoots)", engine->errorObject);
+        return(-1);
+    }
+
+    ret = xmlSecC14NEngineFindSubtrees(engine);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecC14NEngineFindSubtrees", engine->errorObject);
+        return(-1);
+    }
+
+    /* done */
+    return(0);
+}
+
+static void
+xmlSecC14NEngineFinalize(xmlSecC14NEnginePtr engine) {
+    xmlSecAssert(engine != NULL);
+
+    if(engine->renderedNs.id != NULL) {
+        xmlSecPtrListFinalize(&(engine->renderedNs));
+    }
+    if(engine->renderedNodes.id != NULL) {
+        xmlSecPtrListFinalize(&(engine->renderedNodes));
+    }
+    if(engine->scopeNs.id != NULL) {
+        xmlSecPtrListFinalize(&(engine->scopeNs));
+    }
+    if(engine->sortedNs.id != NULL) {
+        xmlSecPtrListFinalize(&(engine->sortedNs));
+    }
+    if(engine->sortedAttrs.id != NULL) {
+        xmlSecPtrListFinalize(&(engine->sortedAttrs));
+    }
+    if(engine->excludedRoots.id != NULL) {
+        xmlSecPtrListFinalize(&(engine->excludedRoots));
+    }
+    if(engine->includedRoots.id != NULL) {
+        xmlSecPtrListFinalize(&(engine->includedRoots));
+    }
+    memset(engine, 0, sizeof(xmlSecC14NEngine));
+}
+
+static int
+xmlSecC14NEngineIsVisible(xmlSecC14NEnginePtr engine, xmlNodePtr node, xmlNodePtr parent) {
+    xmlSecAssert2(engine != NULL, 0);
+    xmlSecAssert2(node != NULL, 0);
+
+    /* the document node itself is only checked when walking up the ancestors */
+    if(node == (xmlNodePtr)engine->doc) {
+        return((xmlSecNodeSetContains(engine->nodes, node, parent) != 0) ? 1 : 0);
+    }
+    if(engine->allVisible != 0) {
+        return(((engine->hideComments == 0) || (node->type != XML_COMMENT_NODE)) ? 1 : 0);
+    }
+    /* a child, an attribute or a namespace node of the current element is
+     * visible if the current element is in one of the included subtrees */
+    if((engine->subtreesVisible != 0) && (parent == engine->curElement)) {
+        if((engine->hideComments != 0) && (node->type == XML_COMMENT_NODE)) {
+            return(0);
+        }
+        if(engine->includedDepth > 0) {
+            return(1);
+        }
+        return(xmlSecC14NEngineIsIncludedRoot(engine, node));
+    }
+    /* same as LibXML2: anything but 0 (including errors) means visible */
+    return((xmlSecNodeSetContains(engine->nodes, node, parent) != 0) ? 1 : 0);
+}
+
+/***************************************************************************
+ *
+ * Output
+ *
+ ***************************************************************************/
+static int
+xmlSecC14NEngineFlush(xmlSecC14NEnginePtr engine, int final) {
+    int ret;
+
+    xmlSecAssert2(engine != NULL, -1);
+    xmlSecAssert2(engine->out != NULL, -1);
+
+    /* without next transform, everything stays in our buffer */
+    if(engine->next == NULL) {
+        return(0);
+    }
+
+    ret = xmlSecTransformPushBin(engine->next, xmlSecBufferGetData(engine->out),
+        xmlSecBufferGetSize(engine->out), final, engine->transformCtx);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecTransformPushBin", engine->errorObject,
+            "size=" XMLSEC_SIZE_FMT, xmlSecBufferGetSize(engine->out));
+        return(-1);
+    }
+
+    ret = xmlSecBufferSetSize(engine->out, 0);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecBufferSetSize", engine->errorObject);
+        return(-1);
+    }
+    return(0);
+}
+
+static int
+xmlSecC14NEngineWrite(xmlSecC14NEnginePtr engine, const xmlSecByte* data, xmlSecSize size) {
+    int ret;
+
+    xmlSecAssert2(engine != NULL, -1);
+    xmlSecAssert2(engine->out != NULL, -1);
+
+    if(size == 0) {
+        return(0);
+    }
+
+    /* large runs (e.g. big text nodes) are pushed directly from the document
+     * together with the pending output instead of copying them into our buffer */
+    if((engine->next != NULL) && (size >= engine->chunkSize)) {
+        xmlSecTransformIOVec vec[2];
+
+        vec[0].data = xmlSecBufferGetData(engine->out);
+        vec[0].size = xmlSecBufferGetSize(engine->out);
+        vec[1].data = data;
+        vec[1].size = size;
+        ret = xmlSecTransformPushBinV(engine->next, vec, 2, 0, engine->transformCtx);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecTransformPushBinV", engine->errorObject,
+                "size=" XMLSEC_SIZE_FMT, size);
+            return(-1);
+        }
+        ret = xmlSecBufferSetSize(engine->out, 0);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecBufferSetSize", engine->errorObject);
+            return(-1);
+        }
+        return(0);
+    }
+
+    ret = xmlSecBufferAppend(engine->out, data, size);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecBufferAppend", engine->errorObject,
+            "size=" XMLSEC_SIZE_FMT, size);
+        return(-1);
+    }
+
+    if((engine->next != NULL) && (xmlSecBufferGetSize(engine->out) >= engine->chunkSize)) {
+        ret = xmlSecC14NEngineFlush(engine, 0);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecC14NEngineFlush", engine->errorObject);
+            return(-1);
+        }
+    }
+    return(0);
+}
+
+static int
+xmlSecC14NEngineWriteString(xmlSecC14NEnginePtr engine, const xmlChar* str) {
+    xmlSecAssert2(engine != NULL, -1);
+
+    if(str == NULL) {
+        return(0);
+    }
+    return(xmlSecC14NEngineWrite(engine, str, xmlSecStrlen(str)));
+}
+
+static int
+xmlSecC14NEngineWriteEscaped(xmlSecC14NEnginePtr engine, const xmlChar* str, xmlSecByte mask) {
+    const char* repl;
+    xmlSecSize size, start, ii;
+    int ret;
+
+    xmlSecAssert2(engine != NULL, -1);
+    xmlSecAssert2(engine->escapeScan != NULL, -1);
+
+    if(str == NULL) {
+        return(0);
+    }
+
+    size = xmlSecStrlen(str);
+    for(start = 0; start < size; start = ii + 1) {
+        /* copy the clean run as is */
+        ii = start + engine->escapeScan(str + start, size - start, mask);
+        if(ii >= size) {
+            break;
+        }
+
+        switch(str[ii]) {
+        case '&':
+            repl = "&amp;";
+            break;
+        case '<':
+            repl = "&lt;";
+            break;
+        case '>':
+            repl = "&gt;";
+            break;
+        case '"':
+            repl = "&quot;";
+            break;
+        case '\x09':
+            repl = "&#x9;";
+            break;
+        case '\x0A':
+            repl = "&#xA;";
+            break;
+        case '\x0D':
+            repl = "&#xD;";
+            break;
+        default:
+            xmlSecInvalidIntegerDataError("char", str[ii], "escapable character", engine->errorObject);
+            return(-1);
+        }
+
+        ret = xmlSecC14NEngineWrite(engine, str + start, ii - start);
+        if(ret < 0) {
+            return(-1);
+        }
+        ret = xmlSecC14NEngineWriteString(engine, BAD_CAST repl);
+        if(ret < 0) {
+            return(-1);
+        }
+    }
+
+    if(start >= size) {
+        return(0);
+    }
+    return(xmlSecC14NEngineWrite(engine, str + start, size - start));
+}
+
+/* same rules as xmlOutputBufferWriteQuotedString() */
+static int
+xmlSecC14NEngineWriteQuoted(xmlSecC14NEnginePtr engine, const xmlChar* str) {
+    xmlSecSize start, ii;
+    int ret;
+
+    xmlSecAssert2(engine != NULL, -1);
+    xmlSecAssert2(str != NULL, -1);
+
+    if(xmlStrchr(str, '"') == NULL) {
+        if((xmlSecC14NEngineWriteString(engine, BAD_CAST "\"") < 0) ||
+           (xmlSecC14NEngineWriteString(engine, str) < 0) ||
+           (xmlSecC14NEngineWriteString(engine, BAD_CAST "\"") < 0)
+        ) {
+            return(-1);
+        }
+        return(0);
+    }
+    if(xmlStrchr(str, '\'') == NULL) {
+        if((xmlSecC14NEngineWriteString(engine, BAD_CAST "'") < 0) ||
+           (xmlSecC14NEngineWriteString(engine, str) < 0) ||
+           (xmlSecC14NEngineWriteString(engine, BAD_CAST "'") < 0)
+        ) {
+            return(-1);
+        }
+        return(0);
+    }
+
+    /* both quotes are present: use '"' and escape it */
+    ret = xmlSecC14NEngineWriteString(engine, BAD_CAST "\"");
+    if(ret < 0) {
+        return(-1);
+    }
+    for(start = ii = 0; str[ii] != '\0'; ++ii) {
+        if(str[ii] != '"') {
+            continue;
+        }
+        if((xmlSecC14NEngineWrite(engine, str + start, ii - start) < 0) ||
+           (xmlSecC14NEngineWriteString(engine, BAD_CAST "&quot;") < 0)
+        ) {
+            return(-1);
+        }
+        start = ii + 1;
+    }
+    if((xmlSecC14NEngineWrite(engine, str + start, ii - start) < 0) ||
+       (xmlSecC14NEngineWriteString(engine, BAD_CAST "\"") < 0)
+    ) {
+        return(-1);
+    }
+    return(0);
+}
+
+static int
+xmlSecC14NEngineWriteQName(xmlSecC14NEnginePtr engine, xmlNsPtr ns, const xmlChar* name) {
+    xmlSecAssert2(engine != NULL, -1);
+    xmlSecAssert2(name != NULL, -1);
+
+    if((ns != NULL) && (ns->prefix != NULL) && (ns->prefix[0] != '\0')) {
+        if((xmlSecC14NEngineWriteString(engine, ns->prefix) < 0) ||
+           (xmlSecC14NEngineWriteString(engine, BAD_CAST ":") < 0)
+        ) {
+            return(-1);
+        }
+    }
+    return(xmlSecC14NEngineWriteString(engine, name));
+}
+
+static int
+xmlSecC14NEngineWriteNs(xmlSecC14NEnginePtr engine, xmlNsPtr ns) {
+    int ret;
+
+    xmlSecAssert2(engine != NULL, -1);
+    xmlSecAssert2(ns != NULL, -1);
+
+    if(ns->prefix != NULL) {
+        if((xmlSecC14NEngineWriteString(engine, BAD_CAST " xmlns:") < 0) ||
+           (xmlSecC14NEngineWriteString(engine, ns->prefix) < 0) ||
+           (xmlSecC14NEngineWriteString(engine, BAD_CAST "=") < 0)
+        ) {
+            return(-1);
+        }
+    } else {
+        ret = xmlSecC14NEngineWriteString(engine, BAD_CAST " xmlns=");
+        if(ret < 0) {
+            return(-1);
+        }
+    }
+
+    if(ns->href != NULL) {
+        ret = xmlSecC14NEngineWriteQuoted(engine, ns->href);
+    } else {
+        ret = xmlSecC14NEngineWriteString(engine, BAD_CAST "\"\"");
+    }
+    if(ret < 0) {
+        return(-1);
+    }
+    return(0);
+}
+
+static int
+xmlSecC14NEngineWriteAttr(xmlSecC14NEnginePtr engine, xmlAttrPtr attr) {
+    xmlChar* value;
+    int ret;
+
+    xmlSecAssert2(engine != NULL, -1);
+    xmlSecAssert2(attr != NULL, -1);
+
+    if((xmlSecC14NEngineWriteString(engine, BAD_CAST " ") < 0) ||
+       (xmlSecC14NEngineWriteQName(engine, attr->ns, attr->name) < 0) ||
+       (xmlSecC14NEngineWriteString(engine, BAD_CAST "=\"") < 0)
+    ) {
+        return(-1);
+    }
+
+    if((attr->children != NULL) && (attr->children->next == NULL) &&
+       (attr->children->type == XML_TEXT_NODE)
+    ) {
+        /* fast path: single text node, no need to copy the value */
+        ret = xmlSecC14NEngineWriteEscaped(engine, attr->children->content, XMLSEC_C14N_ESCAPE_ATTR);
+        if(ret < 0) {
+            return(-1);
+        }
+    } else if(attr->children != NULL) {
+        value = xmlNodeListGetString(engine->doc, attr->children, 1);
+        if(value != NULL) {
+            ret = xmlSecC14NEngineWriteEscaped(engine, value, XMLSEC_C14N_ESCAPE_ATTR);
+            xmlFree(value);
+            if(ret < 0) {
+                return(-1);
+            }
+        }
+    }
+
+    return(xmlSecC14NEngineWriteString(engine, BAD_CAST "\""));
+}
+
+/***************************************************************************
+ *
+ * Sorted lists: same order as LibXML2 xmlListInsert(), i.e. the new item
+ * is inserted before the first item that is greater or equal.
+ *
+ ***************************************************************************/
+static int
+xmlSecC14NEngineNsCompare(const void* item1, const void* item2) {
+    const xmlNs* ns1 = (const xmlNs*)item1;
+    const xmlNs* ns2 = (const xmlNs*)item2;
+
+    if(ns1 == ns2) {
+        return(0);
+    }
+    if(ns1 == NULL) {
+        return(-1);
+    }
+    if(ns2 == NULL) {
+        return(1);
+    }
+    return(xmlStrcmp(ns1->prefix, ns2->prefix));
+}
+
+static int
+xmlSecC14NEngineAttrsCompare(const void* item1, const void* item2) {
+    const xmlAttr* attr1 = (const xmlAttr*)item1;
+    const xmlAttr* attr2 = (const xmlAttr*)item2;
+    int ret;
+
+    if(attr1 == attr2) {
+        return(0);
+    }
+    if(attr1 == NULL) {
+        return(-1);
+    }
+    if(attr2 == NULL) {
+        return(1);
+    }
+    if(attr1->ns == attr2->ns) {
+        return(xmlStrcmp(attr1->name, attr2->name));
+    }
+
+    /* attributes in the default namespace are first */
+    if(attr1->ns == NULL) {
+        return(-1);
+    }
+    if(attr2->ns == NULL) {
+        return(1);
+    }
+    if(attr1->ns->prefix == NULL) {
+        return(-1);
+    }
+    if(attr2->ns->prefix == NULL) {
+        return(1);
+    }
+
+    ret = xmlStrcmp(attr1->ns->href, attr2->ns->href);
+    if(ret == 0) {
+        ret = xmlStrcmp(attr1->name, attr2->name);
+    }
+    return(ret);
+}
+
+static xmlSecSize
+xmlSecC14NEngineSortedLowerBound(xmlSecPtrListPtr list, const void* item,
+                                 xmlSecC14NEngineCompareMethod compare) {
+    xmlSecSize ii, size;
+
+    xmlSecAssert2(list != NULL, 0);
+    xmlSecAssert2(compare != NULL, 0);
+
+    /* binary search for the first item that is not less than @item */
+    ii = 0;
+    size = xmlSecPtrListGetSize(list);
+    while(size > 0) {
+        xmlSecSize half = size / 2;
+        if(compare(xmlSecPtrListGetItem(list, ii + half), item) < 0) {
+            ii += half + 1;
+            size -= half + 1;
+        } else {
+            size = half;
+        }
+    }
+    return(ii);
+}
+
+static int
+xmlSecC14NEngineSortedInsert(xmlSecC14NEnginePtr engine, xmlSecPtrListPtr list, void* item,
+                             xmlSecC14NEngineCompareMethod compare) {
+    int ret;
+
+    xmlSecAssert2(engine != NULL, -1);
+
+    ret = xmlSecPtrListInsert(list, item, xmlSecC14NEngineSortedLowerBound(list, item, compare));
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInsert", engine->errorObject);
+        return(-1);
+    }
+    return(0);
+}
+
+static int
+xmlSecC14NEngineSortedContains(xmlSecPtrListPtr list, const void* item,
+                               xmlSecC14NEngineCompareMethod compare) {
+    xmlSecSize pos;
+
+    xmlSecAssert2(list != NULL, 0);
+    xmlSecAssert2(compare != NULL, 0);
+
+    pos = xmlSecC14NEngineSortedLowerBound(list, item, compare);
+    if(pos >= xmlSecPtrListGetSize(list)) {
+        return(0);
+    }
+    return((compare(xmlSecPtrListGetItem(list, pos), item) == 0) ? 1 : 0);
+}
+
+/***************************************************************************
+ *
+ * Included and excluded subtrees
+ *
+ ***************************************************************************/
+static int
+xmlSecC14NEngineNodeCompare(const void* item1, const void* item2) {
+    if(item1 == item2) {
+        return(0);
+    }
+    return((item1 < item2) ? -1 : 1);
+}
+
+/* checks if the nodes set member selects all the document nodes (except comments) */
+static int
+xmlSecC14NEngineIsWholeDoc(xmlSecC14NEnginePtr engine, xmlSecNodeSetPtr nset) {
+    xmlNodePtr cur;
+
+    xmlSecAssert2(engine != NULL, 0);
+    xmlSecAssert2(engine->doc != NULL, 0);
+    xmlSecAssert2(nset != NULL, 0);
+
+    if(nset->op != xmlSecNodeSetIntersection) {
+        return(0);
+    }
+    switch(nset->type) {
+    case xmlSecNodeSetNormal:
+        return((nset->nodes == NULL) ? 1 : 0);
+    case xmlSecNodeSetTree:
+    case xmlSecNodeSetTreeWithoutComments:
+        /* the tree of all the document children (see xmlSecNodeSetGetChildren) */
+        if(nset->nodes == NULL) {
+            return(1);
+        }
+        for(cur = engine->doc->children; cur != NULL; cur = cur->next) {
+            if((nset->type == xmlSecNodeSetTreeWithoutComments) && (cur->type == XML_COMMENT_NODE)) {
+                continue;
+            }
+            if(xmlXPathNodeSetContains(nset->nodes, cur) == 0) {
+                return(0);
+            }
+        }
+        return(1);
+    default:
+        return(0);
+    }
+}
+
+/* checks if the nodes set member removes the subtrees of its nodes from the result */
+static int
+xmlSecC14NEngineIsExclusion(xmlSecNodeSetPtr nset) {
+    xmlSecAssert2(nset != NULL, 0);
+
+    if(nset->nodes == NULL) {
+        return(0);
+    }
+    if(nset->op == xmlSecNodeSetIntersection) {
+        return(((nset->type == xmlSecNodeSetTreeInvert) ||
+                (nset->type == xmlSecNodeSetTreeWithoutCommentsInvert)) ? 1 : 0);
+    } else if(nset->op == xmlSecNodeSetSubtraction) {
+        return((nset->type == xmlSecNodeSetTree) ? 1 : 0);
+    }
+    return(0);
+}
+
+/* checks if the nodes set member selects the subtrees of its elements */
+static int
+xmlSecC14NEngineIsInclusion(xmlSecNodeSetPtr nset) {
+    xmlNodePtr node;
+    int ii, size;
+
+    xmlSecAssert2(nset != NULL, 0);
+
+    if((nset->nodes == NULL) || (nset->op != xmlSecNodeSetIntersection)) {
+        return(0);
+    }
+    if((nset->type != xmlSecNodeSetTree) && (nset->type != xmlSecNodeSetTreeWithoutComments)) {
+        return(0);
+    }
+    size = xmlXPathNodeSetGetLength(nset->nodes);
+    for(ii = 0; ii < size; ++ii) {
+        node = xmlXPathNodeSetItem(nset->nodes, ii);
+        if((node == NULL) || (node->type != XML_ELEMENT_NODE)) {
+            return(0);
+        }
+    }
+    return(1);
+}
+
+/* adds the nodes set elements to @roots, returns the number of other nodes or -1 on error */
+static int
+xmlSecC14NEngineAddRoots(xmlSecC14NEnginePtr engine, xmlSecPtrListPtr roots, xmlSecNodeSetPtr nset) {
+    xmlNodePtr node;
+    int ii, size;
+    int res = 0;
+    int ret;
+
+    xmlSecAssert2(engine != NULL, -1);
+    xmlSecAssert2(roots != NULL, -1);
+    xmlSecAssert2(nset != NULL, -1);
+    xmlSecAssert2(nset->nodes != NULL, -1);
+
+    size = xmlXPathNodeSetGetLength(nset->nodes);
+    for(ii = 0; ii < size; ++ii) {
+        node = xmlXPathNodeSetItem(nset->nodes, ii);
+        if((node == NULL) || (node->type != XML_ELEMENT_NODE)) {
+            ++res;
+            continue;
+        }
+        if(xmlSecC14NEngineSortedContains(roots, node, xmlSecC14NEngineNodeCompare)) {
+            continue;
+        }
+        ret = xmlSecC14NEngineSortedInsert(engine, roots, node, xmlSecC14NEngineNodeCompare);
+        if(ret < 0) {
+            return(-1);
+        }
+    }
+    return(res);
+}
+
+/*
+ * Finds the elements which subtrees (including the elements themselves, their
+ * attributes and namespace nodes) are not in the nodes set: e.g. the Signature
+ * node for the enveloped signature transform. The engine skips these subtrees
+ * instead of checking every node in them. If the rest of the nodes set selects
+ * the whole document or the subtrees of a few elements (e.g. the same document
+ * or the element id reference), then the visibility of the remaining nodes is
+ * known from the traversal itself.
+ */
+static int
+xmlSecC14NEngineFindSubtrees(xmlSecC14NEnginePtr engine) {
+    xmlSecNodeSetPtr cur;
+    int allVisible = 1;
+    int hideComments = 0;
+    int inclusionsNum = 0;
+    int ret;
+
+    xmlSecAssert2(engine != NULL, -1);
+    xmlSecAssert2(engine->nodes != NULL, -1);
+
+    cur = engine->nodes;
+    do {
+        if(xmlSecC14NEngineIsExclusion(cur)) {
+            ret = xmlSecC14NEngineAddRoots(engine, &(engine->excludedRoots), cur);
+            if(ret < 0) {
+                return(-1);
+            } else if(ret > 0) {
+                /* we can only skip elements, other nodes need to be checked */
+                allVisible = 0;
+            }
+            if(cur->type == xmlSecNodeSetTreeWithoutCommentsInvert) {
+                hideComments = 1;
+            }
+        } else if(xmlSecC14NEngineIsWholeDoc(engine, cur)) {
+            if(cur->type == xmlSecNodeSetTreeWithoutComments) {
+                hideComments = 1;
+            }
+        } else if(xmlSecC14NEngineIsInclusion(cur)) {
+            ret = xmlSecC14NEngineAddRoots(engine, &(engine->includedRoots), cur);
+            if(ret < 0) {
+                return(-1);
+            }
+            if(cur->type == xmlSecNodeSetTreeWithoutComments) {
+                hideComments = 1;
+            }
+            ++inclusionsNum;
+        } else {
+            allVisible = 0;
+            if(cur->op == xmlSecNodeSetUnion) {
+                /* union might add back the nodes excluded before */
+                xmlSecC14NEngineListTruncate(&(engine->excludedRoots), 0);
+            }
+        }
+        cur = cur->next;
+    } while(cur != engine->nodes);
+
+    if((allVisible != 0) && (inclusionsNum == 0)) {
+        engine->allVisible = 1;
+        engine->hideComments = hideComments;
+    } else if((allVisible != 0) && (inclusionsNum == 1)) {
+        engine->subtreesVisible = 1;
+        engine->hideComments = hideComments;
+    } else {
+        xmlSecC14NEngineListTruncate(&(engine->includedRoots), 0);
+    }
+    return(0);
+}
+
+static int
+xmlSecC14NEngineIsExcludedRoot(xmlSecC14NEnginePtr engine, xmlNodePtr cur) {
+    xmlSecAssert2(engine != NULL, 0);
+    xmlSecAssert2(cur != NULL, 0);
+
+    if((cur->type != XML_ELEMENT_NODE) || (xmlSecPtrListGetSize(&(engine->excludedRoots)) == 0)) {
+        return(0);
+    }
+    return(xmlSecC14NEngineSortedContains(&(engine->excludedRoots), cur, xmlSecC14NEngineNodeCompare));
+}
+
+static int
+xmlSecC14NEngineIsIncludedRoot(xmlSecC14NEnginePtr engine, xmlNodePtr cur) {
+    xmlSecAssert2(engine != NULL, 0);
+    xmlSecAssert2(cur != NULL, 0);
+
+    if((cur->type != XML_ELEMENT_NODE) || (xmlSecPtrListGetSize(&(engine->includedRoots)) == 0)) {
+        return(0);
+    }
+    return(xmlSecC14NEngineSortedContains(&(engine->includedRoots), cur, xmlSecC14NEngineNodeCompare));
+}
+
+/***************************************************************************
+ *
+ * Namespaces
+ *
+ ***************************************************************************/
+static int
+xmlSecC14NEngineStrEqual(const xmlChar* str1, const xmlChar* str2) {
+    if(str1 == str2) {
+        return(1);
+    }
+    if(str1 == NULL) {
+        return(((*str2) == '\0') ? 1 : 0);
+    }
+    if(str2 == NULL) {
+        return(((*str1) == '\0') ? 1 : 0);
+    }
+    return(xmlStrEqual(str1, str2));
+}
+
+static int
+xmlSecC14NEngineScopePush(xmlSecC14NEnginePtr engine, xmlNodePtr cur) {
+    xmlSecSize pos;
+    xmlNsPtr ns;
+    int ret;
+
+    xmlSecAssert2(engine != NULL, -1);
+    xmlSecAssert2(cur != NULL, -1);
+
+    /* element's ns is in scope only for the descendants */
+    pos = xmlSecPtrListGetSize(&(engine->scopeNs));
+    ret = xmlSecPtrListAdd(&(engine->scopeNs), cur->ns);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListAdd", engine->errorObject);
+        return(-1);
+    }
+    engine->scopeOwnNsPos = pos;
+
+    /* namespace definitions are searched in the document order */
+    for(ns = cur->nsDef; ns != NULL; ns = ns->next) {
+        ret = xmlSecPtrListInsert(&(engine->scopeNs), ns, pos + 1);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecPtrListInsert", engine->errorObject);
+            return(-1);
+        }
+    }
+    return(0);
+}
+
+/* same as xmlSearchNs(doc, cur, prefix) for the element on top of the scope stack */
+static xmlNsPtr
+xmlSecC14NEngineSearchNs(xmlSecC14NEnginePtr engine, xmlNodePtr cur, const xmlChar* prefix) {
+    xmlNsPtr ns;
+    xmlSecSize ii;
+
+    xmlSecAssert2(engine != NULL, NULL);
+    xmlSecAssert2(cur != NULL, NULL);
+
+    if((prefix != NULL) && xmlStrEqual(prefix, BAD_CAST "xml")) {
+        return(xmlSearchNs(engine->doc, cur, prefix));
+    }
+
+    for(ii = xmlSecPtrListGetSize(&(engine->scopeNs)); ii > 0; --ii) {
+        if((ii - 1) == engine->scopeOwnNsPos) {
+            continue;
+        }
+        ns = (xmlNsPtr)xmlSecPtrListGetItem(&(engine->scopeNs), ii - 1);
+        if((ns != NULL) && (ns->href != NULL) && xmlStrEqual(ns->prefix, prefix)) {
+            return(ns);
+        }
+    }
+    return(NULL);
+}
+
+static int
+xmlSecC14NEngineRenderedNsAdd(xmlSecC14NEnginePtr engine, xmlNsPtr ns, xmlNodePtr node) {
+    int ret;
+
+    xmlSecAssert2(engine != NULL, -1);
+
+    ret = xmlSecPtrListAdd(&(engine->renderedNs), ns);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListAdd(renderedNs)", engine->errorObject);
+        return(-1);
+    }
+    ret = xmlSecPtrListAdd(&(engine->renderedNodes), node);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListAdd(renderedNodes)", engine->errorObject);
+        return(-1);
+    }
+    return(0);
+}
+
+/*
+ * Returns 1 if the namespace was already rendered by the nearest visible ancestor
+ * (or it is the empty default namespace that was never re-defined).
+ */
+static int
+xmlSecC14NEngineRenderedNsFind(xmlSecC14NEnginePtr engine, xmlNsPtr ns, int exclusive) {
+    const xmlChar* prefix;
+    const xmlChar* href;
+    xmlNsPtr ns1;
+    xmlSecSize ii, start;
+    int hasEmptyNs;
+
+    xmlSecAssert2(engine != NULL, 0);
+
+    prefix = ((ns == NULL) || (ns->prefix == NULL)) ? BAD_CAST "" : ns->prefix;
+    href = ((ns == NULL) || (ns->href == NULL)) ? BAD_CAST "" : ns->href;
+    hasEmptyNs = (xmlSecC14NEngineStrEqual(prefix, NULL) && xmlSecC14NEngineStrEqual(href, NULL)) ? 1 : 0;
+
+    start = ((exclusive != 0) || (hasEmptyNs != 0)) ? 0 : engine->renderedPrevStart;
+    for(ii = xmlSecPtrListGetSize(&(engine->renderedNs)); ii > start; --ii) {
+        ns1 = (xmlNsPtr)xmlSecPtrListGetItem(&(engine->renderedNs), ii - 1);
+        if(!xmlSecC14NEngineStrEqual(prefix, (ns1 != NULL) ? ns1->prefix : NULL)) {
+            continue;
+        }
+        if(!xmlSecC14NEngineStrEqual(href, (ns1 != NULL) ? ns1->href : NULL)) {
+            return(0);
+        }
+        if(exclusive == 0) {
+            return(1);
+        }
+        return(xmlSecC14NEngineIsVisible(engine, (xmlNodePtr)ns1,
+            (xmlNodePtr)xmlSecPtrListGetItem(&(engine->renderedNodes), ii - 1)));
+    }
+    return(hasEmptyNs);
+}
+
+static int
+xmlSecC14NEngineCheckRelativeNs(xmlSecC14NEnginePtr engine, xmlNodePtr cur) {
+    xmlURIPtr uri;
+    xmlNsPtr ns;
+
+    xmlSecAssert2(engine != NULL, -1);
+    xmlSecAssert2(cur != NULL, -1);
+
+    /* implementations of XML canonicalization MUST report an operation
+     * failure on documents containing relative namespace URIs */
+    for(ns = cur->nsDef; ns != NULL; ns = ns->next) {
+        if((ns->href == NULL) || (ns->href[0] == '\0')) {
+            continue;
+        }
+
+        uri = xmlParseURI((const char*)ns->href);
+        if(uri == NULL) {
+            xmlSecXmlError2("xmlParseURI", engine->errorObject,
+                "uri=%s", xmlSecErrorsSafeString(ns->href));
+            return(-1);
+        }
+        if((uri->scheme == NULL) || (uri->scheme[0] == '\0')) {
+            xmlSecInvalidNodeContentError2(cur, engine->errorObject,
+                "relative namespace uri=%s", xmlSecErrorsSafeString(ns->href));
+            xmlFreeURI(uri);
+            return(-1);
+        }
+        xmlFreeURI(uri);
+    }
+    return(0);
+}
+
+static int
+xmlSecC14NEngineWriteSortedNs(xmlSecC14NEnginePtr engine) {
+    xmlSecSize ii, size;
+    int ret;
+
+    xmlSecAssert2(engine != NULL, -1);
+
+    size = xmlSecPtrListGetSize(&(engine->sortedNs));
+    for(ii = 0; ii < size; ++ii) {
+        ret = xmlSecC14NEngineWriteNs(engine, (xmlNsPtr)xmlSecPtrListGetItem(&(engine->sortedNs), ii));
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecC14NEngineWriteNs", engine->errorObject);
+            return(-1);
+        }
+    }
+    return(0);
+}
+
+static int
+xmlSecC14NEngineProcessNsAxis(xmlSecC14NEnginePtr engine, xmlNodePtr cur, int visible) {
+    xmlNs nsDefault;
+    xmlNodePtr node;
+    xmlNsPtr ns;
+    int alreadyRendered;
+    int hasEmptyNs = 0;
+    int ret;
+
+    xmlSecAssert2(engine != NULL, -1);
+    xmlSecAssert2(cur != NULL, -1);
+
+    xmlSecC14NEngineListTruncate(&(engine->sortedNs), 0);
+
+    /* check all namespaces in scope */
+    for(node = cur; node != NULL; node = node->parent) {
+        if(node->type != XML_ELEMENT_NODE) {
+            continue;
+        }
+        for(ns = node->nsDef; ns != NULL; ns = ns->next) {
+            if((xmlSecC14NEngineSearchNs(engine, cur, ns->prefix) != ns) ||
+               xmlSecC14NEngineIsXmlNs(ns) ||
+               !xmlSecC14NEngineIsVisible(engine, (xmlNodePtr)ns, cur)
+            ) {
+                continue;
+            }
+
+            alreadyRendered = xmlSecC14NEngineRenderedNsFind(engine, ns, 0);
+            if(visible) {
+                ret = xmlSecC14NEngineRenderedNsAdd(engine, ns, cur);
+                if(ret < 0) {
+                    return(-1);
+                }
+            }
+            if(!alreadyRendered) {
+                ret = xmlSecC14NEngineSortedInsert(engine, &(engine->sortedNs), ns, xmlSecC14NEngineNsCompare);
+                if(ret < 0) {
+                    return(-1);
+                }
+            }
+            if((ns->prefix == NULL) || (ns->prefix[0] == '\0')) {
+                hasEmptyNs = 1;
+            }
+        }
+    }
+
+    /* generate xmlns="" if the nearest rendered default namespace is not empty */
+    if(visible && !hasEmptyNs) {
+        memset(&nsDefault, 0, sizeof(nsDefault));
+        if(!xmlSecC14NEngineRenderedNsFind(engine, &nsDefault, 0)) {
+            ret = xmlSecC14NEngineWriteNs(engine, &nsDefault);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecC14NEngineWriteNs", engine->errorObject);
+                return(-1);
+            }
+        }
+    }
+
+    return(xmlSecC14NEngineWriteSortedNs(engine));
+}
+
+static int
+xmlSecC14NEngineProcessExcNsAxis(xmlSecC14NEnginePtr engine, xmlNodePtr cur, int visible) {
+    xmlNs nsDefault;
+    xmlNsPtr ns;
+    xmlAttrPtr attr;
+    const xmlChar* prefix;
+    xmlSecSize ii, size;
+    int alreadyRendered;
+    int hasEmptyNs = 0;
+    int hasVisiblyUtilizedEmptyNs = 0;
+    int hasEmptyNsInInclusiveList = 0;
+    int ret;
+
+    xmlSecAssert2(engine != NULL, -1);
+    xmlSecAssert2(cur != NULL, -1);
+
+    xmlSecC14NEngineListTruncate(&(engine->sortedNs), 0);
+
+    /* namespaces from the inclusive list are handled as in Canonical XML */
+    size = (engine->inclusiveNsList != NULL) ? xmlSecPtrListGetSize(engine->inclusiveNsList) : 0;
+    for(ii = 0; ii < size; ++ii) {
+        prefix = (const xmlChar*)xmlSecPtrListGetItem(engine->inclusiveNsList, ii);
+        if(prefix == NULL) {
+            break;
+        }
+        if(xmlStrEqual(prefix, BAD_CAST "#default") || xmlStrEqual(prefix, BAD_CAST "")) {
+            prefix = NULL;
+            hasEmptyNsInInclusiveList = 1;
+        }
+
+        ns = xmlSecC14NEngineSearchNs(engine, cur, prefix);
+        if((ns == NULL) || xmlSecC14NEngineIsXmlNs(ns) ||
+           !xmlSecC14NEngineIsVisible(engine, (xmlNodePtr)ns, cur)
+        ) {
+            continue;
+        }
+
+        alreadyRendered = xmlSecC14NEngineRenderedNsFind(engine, ns, 0);
+        if(visible) {
+            ret = xmlSecC14NEngineRenderedNsAdd(engine, ns, cur);
+            if(ret < 0) {
+                return(-1);
+            }
+        }
+        if(!alreadyRendered) {
+            ret = xmlSecC14NEngineSortedInsert(engine, &(engine->sortedNs), ns, xmlSecC14NEngineNsCompare);
+            if(ret < 0) {
+                return(-1);
+            }
+        }
+        if((ns->prefix == NULL) || (ns->prefix[0] == '\0')) {
+            hasEmptyNs = 1;
+        }
+    }
+
+    /* element's namespace */
+    if(cur->ns != NULL) {
+        ns = cur->ns;
+    } else {
+        ns = xmlSecC14NEngineSearchNs(engine, cur, NULL);
+        hasVisiblyUtilizedEmptyNs = 1;
+    }
+    if((ns != NULL) && !xmlSecC14NEngineIsXmlNs(ns)) {
+        if(visible && xmlSecC14NEngineIsVisible(engine, (xmlNodePtr)ns, cur)) {
+            if(!xmlSecC14NEngineRenderedNsFind(engine, ns, 1)) {
+                ret = xmlSecC14NEngineSortedInsert(engine, &(engine->sortedNs), ns, xmlSecC14NEngineNsCompare);
+                if(ret < 0) {
+                    return(-1);
+                }
+            }
+        }
+        if(visible) {
+            ret = xmlSecC14NEngineRenderedNsAdd(engine, ns, cur);
+            if(ret < 0) {
+                return(-1);
+            }
+        }
+        if((ns->prefix == NULL) || (ns->prefix[0] == '\0')) {
+            hasEmptyNs = 1;
+        }
+    }
+
+    /* attributes' namespaces (default namespace doesn't apply to attributes) */
+    for(attr = cur->properties; attr != NULL; attr = attr->next) {
+        if((attr->ns != NULL) && !xmlSecC14NEngineIsXmlNs(attr->ns) &&
+           xmlSecC14NEngineIsVisible(engine, (xmlNodePtr)attr, cur)
+        ) {
+            alreadyRendered = xmlSecC14NEngineRenderedNsFind(engine, attr->ns, 1);
+            ret = xmlSecC14NEngineRenderedNsAdd(engine, attr->ns, cur);
+            if(ret < 0) {
+                return(-1);
+            }
+            if(!alreadyRendered && visible) {
+                ret = xmlSecC14NEngineSortedInsert(engine, &(engine->sortedNs), attr->ns, xmlSecC14NEngineNsCompare);
+                if(ret < 0) {
+                    return(-1);
+                }
+            }
+            if((attr->ns->prefix == NULL) || (attr->ns->prefix[0] == '\0')) {
+                hasEmptyNs = 1;
+            }
+        } else if((attr->ns != NULL) &&
+                  ((attr->ns->prefix == NULL) || (attr->ns->prefix[0] == '\0')) &&
+                  ((attr->ns->href == NULL) || (attr->ns->href[0] == '\0'))
+        ) {
+            hasVisiblyUtilizedEmptyNs = 1;
+        }
+    }
+
+    /* xmlns="" */
+    memset(&nsDefault, 0, sizeof(nsDefault));
+    if(visible && hasVisiblyUtilizedEmptyNs && !hasEmptyNs && !hasEmptyNsInInclusiveList) {
+        if(!xmlSecC14NEngineRenderedNsFind(engine, &nsDefault, 1)) {
+            ret = xmlSecC14NEngineWriteNs(engine, &nsDefault);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecC14NEngineWriteNs", engine->errorObject);
+                return(-1);
+            }
+        }
+    } else if(visible && !hasEmptyNs && hasEmptyNsInInclusiveList) {
+        if(!xmlSecC14NEngineRenderedNsFind(engine, &nsDefault, 0)) {
+            ret = xmlSecC14NEngineWriteNs(engine, &nsDefault);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecC14NEngineWriteNs", engine->errorObject);
+                return(-1);
+            }
+        }
+    }
+
+    return(xmlSecC14NEngineWriteSortedNs(engine));
+}
+
+/***************************************************************************
+ *
+ * Attributes
+ *
+ ***************************************************************************/
+static xmlAttrPtr
+xmlSecC14NEngineFindHiddenParentAttr(xmlSecC14NEnginePtr engine, xmlNodePtr cur, const xmlChar* name) {
+    xmlAttrPtr res;
+
+    xmlSecAssert2(engine != NULL, NULL);
+    xmlSecAssert2(name != NULL, NULL);
+
+    while((cur != NULL) && !xmlSecC14NEngineIsVisible(engine, cur, cur->parent)) {
+        res = xmlHasNsProp(cur, name, XML_XML_NAMESPACE);
+        if(res != NULL) {
+            return(res);
+        }
+        cur = cur->parent;
+    }
+    return(NULL);
+}
+
+/*
+ * Combines xml:base attribute value with the values from the hidden ancestors.
+ * Returns the new attribute (must be freed with xmlFreeProp()) or NULL if the
+ * result is empty or an error occurs (in which case @err is set to -1).
+ */
+static xmlAttrPtr
+xmlSecC14NEngineFixupBaseAttr(xmlSecC14NEnginePtr engine, xmlAttrPtr baseAttr, int* err) {
+    xmlChar* res;
+    xmlChar* value;
+    xmlChar* tmp;
+    xmlAttrPtr attr;
+    xmlNodePtr cur;
+    xmlSecSize valueLen;
+
+    xmlSecAssert2(engine != NULL, NULL);
+    xmlSecAssert2(baseAttr != NULL, NULL);
+    xmlSecAssert2(baseAttr->parent != NULL, NULL);
+    xmlSecAssert2(err != NULL, NULL);
+
+    (*err) = 0;
+
+    /* start from current value: same as LibXML2, skip the empty value */
+    res = xmlNodeListGetString(engine->doc, baseAttr->children, 1);
+    if(res == NULL) {
+        return(NULL);
+    }
+
+    /* go up the stack until we find a node that we rendered already */
+    for(cur = baseAttr->parent->parent; (cur != NULL) && !xmlSecC14NEngineIsVisible(engine, cur, cur->parent); cur = cur->parent) {
+        attr = xmlHasNsProp(cur, BAD_CAST "base", XML_XML_NAMESPACE);
+        if(attr == NULL) {
+            continue;
+        }
+
+        value = xmlNodeListGetString(engine->doc, attr->children, 1);
+        if(value == NULL) {
+            xmlSecXmlError("xmlNodeListGetString", engine->errorObject);
+            xmlFree(res);
+            (*err) = -1;
+            return(NULL);
+        }
+
+        /* add '/' if the base uri ends with '..' or '.' to ensure that we are forced to go "up" */
+        valueLen = xmlSecStrlen(value);
+        if((valueLen > 1) && (value[valueLen - 2] == '.')) {
+            tmp = xmlStrcat(value, BAD_CAST "/");
+            if(tmp == NULL) {
+                xmlSecXmlError("xmlStrcat", engine->errorObject);
+                xmlFree(value);
+                xmlFree(res);
+                (*err) = -1;
+                return(NULL);
+            }
+            value = tmp;
+        }
+
+        /* same as LibXML2: the attribute is skipped if we can't build the uri */
+        tmp = xmlBuildURI(res, value);
+        xmlFree(value);
+        xmlFree(res);
+        if(tmp == NULL) {
+            return(NULL);
+        }
+        res = tmp;
+    }
+
+    /* check if result uri is empty or not */
+    if(res[0] == '\0') {
+        xmlFree(res);
+        return(NULL);
+    }
+
+    attr = xmlNewNsProp(NULL, baseAttr->ns, BAD_CAST "base", res);
+    if(attr == NULL) {
+        xmlSecXmlError("xmlNewNsProp", engine->errorObject);
+        xmlFree(res);
+        (*err) = -1;
+        return(NULL);
+    }
+    xmlFree(res);
+    return(attr);
+}
+
+static int
+xmlSecC14NEngineProcessAttrsAxis(xmlSecC14NEnginePtr engine, xmlNodePtr cur, int visible) {
+    xmlAttrPtr attr;
+    xmlAttrPtr xmlLangAttr = NULL;
+    xmlAttrPtr xmlSpaceAttr = NULL;
+    xmlAttrPtr xmlBaseAttr = NULL;
+    xmlAttrPtr fixedBaseAttr = NULL;
+    xmlNodePtr node;
+    xmlSecSize ii, size;
+    int matched;
+    int res = -1;
+    int ret;
+
+    xmlSecAssert2(engine != NULL, -1);
+    xmlSecAssert2(cur != NULL, -1);
+
+    xmlSecC14NEngineListTruncate(&(engine->sortedAttrs), 0);
+
+    switch(engine->mode) {
+    case xmlSecC14NModeInclusive10:
+        /* all visible attributes from current node */
+        for(attr = cur->properties; attr != NULL; attr = attr->next) {
+            if(xmlSecC14NEngineIsVisible(engine, (xmlNodePtr)attr, cur)) {
+                ret = xmlSecC14NEngineSortedInsert(engine, &(engine->sortedAttrs), attr, xmlSecC14NEngineAttrsCompare);
+                if(ret < 0) {
+                    goto done;
+                }
+            }
+        }
+
+        /* nearest xml:* attributes from the ancestors if parent is not in the node set */
+        if(visible && (cur->parent != NULL) && !xmlSecC14NEngineIsVisible(engine, cur->parent, cur->parent->parent)) {
+            for(node = cur->parent; node != NULL; node = node->parent) {
+                if(node->type != XML_ELEMENT_NODE) {
+                    continue;
+                }
+                for(attr = node->properties; attr != NULL; attr = attr->next) {
+                    if(!xmlSecC14NEngineIsXmlAttr(attr)) {
+                        continue;
+                    }
+                    if(xmlSecC14NEngineSortedContains(&(engine->sortedAttrs), attr, xmlSecC14NEngineAttrsCompare)) {
+                        continue;
+                    }
+                    ret = xmlSecC14NEngineSortedInsert(engine, &(engine->sortedAttrs), attr, xmlSecC14NEngineAttrsCompare);
+                    if(ret < 0) {
+                        goto done;
+                    }
+                }
+            }
+        }
+        break;
+    case xmlSecC14NModeExclusive10:
+        /* xml:* attributes are not imported into orphan nodes */
+        for(attr = cur->properties; attr != NULL; attr = attr->next) {
+            if(xmlSecC14NEngineIsVisible(engine, (xmlNodePtr)attr, cur)) {
+                ret = xmlSecC14NEngineSortedInsert(engine, &(engine->sortedAttrs), attr, xmlSecC14NEngineAttrsCompare);
+                if(ret < 0) {
+                    goto done;
+                }
+            }
+        }
+        break;
+    case xmlSecC14NModeInclusive11:
+        for(attr = cur->properties; attr != NULL; attr = attr->next) {
+            matched = 0;
+            if(visible && xmlSecC14NEngineIsXmlAttr(attr)) {
+                /* simple inheritable attributes and xml:base */
+                if((xmlLangAttr == NULL) && xmlStrEqual(attr->name, BAD_CAST "lang")) {
+                    xmlLangAttr = attr;
+                    matched = 1;
+                } else if((xmlSpaceAttr == NULL) && xmlStrEqual(attr->name, BAD_CAST "space")) {
+                    xmlSpaceAttr = attr;
+                    matched = 1;
+                } else if((xmlBaseAttr == NULL) && xmlStrEqual(attr->name, BAD_CAST "base")) {
+                    xmlBaseAttr = attr;
+                    matched = 1;
+                }
+            }
+            if(!matched && xmlSecC14NEngineIsVisible(engine, (xmlNodePtr)attr, cur)) {
+                ret = xmlSecC14NEngineSortedInsert(engine, &(engine->sortedAttrs), attr, xmlSecC14NEngineAttrsCompare);
+                if(ret < 0) {
+                    goto done;
+                }
+            }
+        }
+
+        /* special processing for xml:* attributes kicks in only when we have invisible parents */
+        if(visible) {
+            if(xmlLangAttr == NULL) {
+                xmlLangAttr = xmlSecC14NEngineFindHiddenParentAttr(engine, cur->parent, BAD_CAST "lang");
+            }
+            if(xmlLangAttr != NULL) {
+                ret = xmlSecC14NEngineSortedInsert(engine, &(engine->sortedAttrs), xmlLangAttr, xmlSecC14NEngineAttrsCompare);
+                if(ret < 0) {
+                    goto done;
+                }
+            }
+            if(xmlSpaceAttr == NULL) {
+                xmlSpaceAttr = xmlSecC14NEngineFindHiddenParentAttr(engine, cur->parent, BAD_CAST "space");
+            }
+            if(xmlSpaceAttr != NULL) {
+                ret = xmlSecC14NEngineSortedInsert(engine, &(engine->sortedAttrs), xmlSpaceAttr, xmlSecC14NEngineAttrsCompare);
+                if(ret < 0) {
+                    goto done;
+                }
+            }
+
+            /* base uri attribute requires fix up */
+            if(xmlBaseAttr == NULL) {
+                xmlBaseAttr = xmlSecC14NEngineFindHiddenParentAttr(engine, cur->parent, BAD_CAST "base");
+            }
+            if(xmlBaseAttr != NULL) {
+                fixedBaseAttr = xmlSecC14NEngineFixupBaseAttr(engine, xmlBaseAttr, &ret);
+                if(ret < 0) {
+                    xmlSecInternalError("xmlSecC14NEngineFixupBaseAttr", engine->errorObject);
+                    goto done;
+                }
+                if(fixedBaseAttr != NULL) {
+                    ret = xmlSecC14NEngineSortedInsert(engine, &(engine->sortedAttrs), fixedBaseAttr, xmlSecC14NEngineAttrsCompare);
+                    if(ret < 0) {
+                        goto done;
+                    }
+                }
+            }
+        }
+        break;
+    }
+
+    /* write all attributes */
+    size = xmlSecPtrListGetSize(&(engine->sortedAttrs));
+    for(ii = 0; ii < size; ++ii) {
+        ret = xmlSecC14NEngineWriteAttr(engine, (xmlAttrPtr)xmlSecPtrListGetItem(&(engine->sortedAttrs), ii));
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecC14NEngineWriteAttr", engine->errorObject);
+            goto done;
+        }
+    }
+
+    /* success */
+    res = 0;
+
+done:
+    if(fixedBaseAttr != NULL) {
+        xmlFreeProp(fixedBaseAttr);
+    }
+    return(res);
+}
+
+/***************************************************************************
+ *
+ * Nodes
+ *
+ ***************************************************************************/
+static int
+xmlSecC14NEngineProcessElement(xmlSecC14NEnginePtr engine, xmlNodePtr cur, int visible) {
+    xmlSecSize renderedCurEnd, renderedPrevStart, renderedPrevEnd;
+    xmlSecSize scopeSize, scopeOwnNsPos;
+    xmlNodePtr curElement;
+    xmlSecSize includedDepth;
+    int parentIsDoc = 0;
+    int ret;
+
+    xmlSecAssert2(engine != NULL, -1);
+    xmlSecAssert2(cur != NULL, -1);
+    xmlSecAssert2(cur->type == XML_ELEMENT_NODE, -1);
+
+    ret = xmlSecC14NEngineCheckRelativeNs(engine, cur);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecC14NEngineCheckRelativeNs", engine->errorObject);
+        return(-1);
+    }
+
+    /* save namespaces stacks */
+    renderedCurEnd = xmlSecPtrListGetSize(&(engine->renderedNs));
+    renderedPrevStart = engine->renderedPrevStart;
+    renderedPrevEnd = engine->renderedPrevEnd;
+    scopeSize = xmlSecPtrListGetSize(&(engine->scopeNs));
+    scopeOwnNsPos = engine->scopeOwnNsPos;
+
+    /* save the current element and make it this one */
+    curElement = engine->curElement;
+    includedDepth = engine->includedDepth;
+    engine->curElement = cur;
+    if(xmlSecC14NEngineIsIncludedRoot(engine, cur)) {
+        ++engine->includedDepth;
+    }
+
+    ret = xmlSecC14NEngineScopePush(engine, cur);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecC14NEngineScopePush", engine->errorObject);
+        return(-1);
+    }
+
+    if(visible) {
+        if(engine->parentIsDoc) {
+            /* save this flag into the stack */
+            parentIsDoc = engine->parentIsDoc;
+            engine->parentIsDoc = 0;
+            engine->pos = xmlSecC14NPosInsideDocumentElement;
+        }
+        if((xmlSecC14NEngineWriteString(engine, BAD_CAST "<") < 0) ||
+           (xmlSecC14NEngineWriteQName(engine, cur->ns, cur->name) < 0)
+        ) {
+            return(-1);
+        }
+    }
+
+    if(engine->mode != xmlSecC14NModeExclusive10) {
+        ret = xmlSecC14NEngineProcessNsAxis(engine, cur, visible);
+    } else {
+        ret = xmlSecC14NEngineProcessExcNsAxis(engine, cur, visible);
+    }
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecC14NEngineProcessNsAxis", engine->errorObject);
+        return(-1);
+    }
+    if(visible) {
+        engine->renderedPrevStart = engine->renderedPrevEnd;
+        engine->renderedPrevEnd = xmlSecPtrListGetSize(&(engine->renderedNs));
+    }
+
+    ret = xmlSecC14NEngineProcessAttrsAxis(engine, cur, visible);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecC14NEngineProcessAttrsAxis", engine->errorObject);
+        return(-1);
+    }
+
+    if(visible) {
+        ret = xmlSecC14NEngineWriteString(engine, BAD_CAST ">");
+        if(ret < 0) {
+            return(-1);
+        }
+    }
+
+    if(cur->children != NULL) {
+        ret = xmlSecC14NEngineProcessNodeList(engine, cur->children);
+        if(ret < 0) {
+            return(-1);
+        }
+    }
+
+    if(visible) {
+        if((xmlSecC14NEngineWriteString(engine, BAD_CAST "</") < 0) ||
+           (xmlSecC14NEngineWriteQName(engine, cur->ns, cur->name) < 0) ||
+           (xmlSecC14NEngineWriteString(engine, BAD_CAST ">") < 0)
+        ) {
+            return(-1);
+        }
+        if(parentIsDoc) {
+            /* restore this flag from the stack for next node */
+            engine->parentIsDoc = parentIsDoc;
+            engine->pos = xmlSecC14NPosAfterDocumentElement;
+        }
+    }
+
+    /* restore namespaces stacks */
+    xmlSecC14NEngineListTruncate(&(engine->renderedNs), renderedCurEnd);
+    xmlSecC14NEngineListTruncate(&(engine->renderedNodes), renderedCurEnd);
+    engine->renderedPrevStart = renderedPrevStart;
+    engine->renderedPrevEnd = renderedPrevEnd;
+    xmlSecC14NEngineListTruncate(&(engine->scopeNs), scopeSize);
+    engine->scopeOwnNsPos = scopeOwnNsPos;
+    engine->curElement = curElement;
+    engine->includedDepth = includedDepth;
+    return(0);
+}
+
+static int
+xmlSecC14NEngineProcessNode(xmlSecC14NEnginePtr engine, xmlNodePtr cur) {
+    int visible;
+    int ret;
+
+    xmlSecAssert2(engine != NULL, -1);
+    xmlSecAssert2(cur != NULL, -1);
+
+    visible = xmlSecC14NEngineIsVisible(engine, cur, cur->parent);
+    switch(cur->type) {
+    case XML_ELEMENT_NODE:
+        ret = xmlSecC14NEngineProcessElement(engine, cur, visible);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecC14NEngineProcessElement", engine->errorObject);
+            return(-1);
+        }
+        break;
+    case XML_TEXT_NODE:
+    case XML_CDATA_SECTION_NODE:
+        /* cdata sections are processed as text nodes */
+        if(visible && (cur->content != NULL)) {
+            ret = xmlSecC14NEngineWriteEscaped(engine, cur->content, XMLSEC_C14N_ESCAPE_TEXT);
+            if(ret < 0) {
+                return(-1);
+            }
+        }
+        break;
+    case XML_PI_NODE:
+        if(!visible) {
+            break;
+        }
+        ret = xmlSecC14NEngineWriteString(engine,
+            (engine->pos == xmlSecC14NPosAfterDocumentElement) ? BAD_CAST "\x0A<?" : BAD_CAST "<?");
+        if(ret < 0) {
+            return(-1);
+        }
+        ret = xmlSecC14NEngineWriteString(engine, cur->name);
+        if(ret < 0) {
+            return(-1);
+        }
+        if((cur->content != NULL) && (cur->content[0] != '\0')) {
+            if((xmlSecC14NEngineWriteString(engine, BAD_CAST " ") < 0) ||
+               (xmlSecC14NEngineWriteEscaped(engine, cur->content, XMLSEC_C14N_ESCAPE_CR) < 0)
+            ) {
+                return(-1);
+            }
+        }
+        ret = xmlSecC14NEngineWriteString(engine,
+            (engine->pos == xmlSecC14NPosBeforeDocumentElement) ? BAD_CAST "?>\x0A" : BAD_CAST "?>");
+        if(ret < 0) {
+            return(-1);
+        }
+        break;
+    case XML_COMMENT_NODE:
+        if(!visible || !engine->withComments) {
+            break;
+        }
+        ret = xmlSecC14NEngineWriteString(engine,
+            (engine->pos == xmlSecC14NPosAfterDocumentElement) ? BAD_CAST "\x0A<!--" : BAD_CAST "<!--");
+        if(ret < 0) {
+            return(-1);
+        }
+        ret = xmlSecC14NEngineWriteEscaped(engine, cur->content, XMLSEC_C14N_ESCAPE_CR);
+        if(ret < 0) {
+            return(-1);
+        }
+        ret = xmlSecC14NEngineWriteString(engine,
+            (engine->pos == xmlSecC14NPosBeforeDocumentElement) ? BAD_CAST "-->\x0A" : BAD_CAST "-->");
+        if(ret < 0) {
+            return(-1);
+        }
+        break;
+    case XML_DOCUMENT_NODE:
+    case XML_DOCUMENT_FRAG_NODE:
+#ifdef LIBXML_HTML_ENABLED
+    case XML_HTML_DOCUMENT_NODE:
+#endif /* LIBXML_HTML_ENABLED */
+        if(cur->children != NULL) {
+            engine->pos = xmlSecC14NPosBeforeDocumentElement;
+            engine->parentIsDoc = 1;
+            ret = xmlSecC14NEngineProcessNodeList(engine, cur->children);
+            if(ret < 0) {
+                return(-1);
+            }
+        }
+        break;
+    case XML_ATTRIBUTE_NODE:
+    case XML_NAMESPACE_DECL:
+    case XML_ENTITY_REF_NODE:
+    case XML_ENTITY_NODE:
+        xmlSecUnexpectedNodeError(cur, engine->errorObject);
+        return(-1);
+    case XML_DOCUMENT_TYPE_NODE:
+    case XML_NOTATION_NODE:
+    case XML_DTD_NODE:
+    case XML_ELEMENT_DECL:
+    case XML_ATTRIBUTE_DECL:
+    case XML_ENTITY_DECL:
+    case XML_XINCLUDE_START:
+    case XML_XINCLUDE_END:
+        /* should be ignored according to "W3C Canonical XML" */
+        break;
+    default:
+        xmlSecUnsupportedEnumValueError("node type", cur->type, engine->errorObject);
+        return(-1);
+    }
+
+    return(0);
+}
+
+/* the excluded subtree produces no output but it still has to be a valid c14n input */
+static int
+xmlSecC14NEngineCheckExcluded(xmlSecC14NEnginePtr engine, xmlNodePtr root) {
+    xmlNodePtr cur;
+    int ret;
+
+    xmlSecAssert2(engine != NULL, -1);
+    xmlSecAssert2(root != NULL, -1);
+
+    cur = root;
+    while(cur != NULL) {
+        switch(cur->type) {
+        case XML_ELEMENT_NODE:
+            ret = xmlSecC14NEngineCheckRelativeNs(engine, cur);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecC14NEngineCheckRelativeNs", engine->errorObject);
+                return(-1);
+            }
+            break;
+        case XML_ATTRIBUTE_NODE:
+        case XML_NAMESPACE_DECL:
+        case XML_ENTITY_REF_NODE:
+        case XML_ENTITY_NODE:
+            xmlSecUnexpectedNodeError(cur, engine->errorObject);
+            return(-1);
+        default:
+            break;
+        }
+
+        /* next node in the subtree in document order */
+        if((cur->type == XML_ELEMENT_NODE) && (cur->children != NULL)) {
+            cur = cur->children;
+            continue;
+        }
+        while((cur != root) && (cur->next == NULL)) {
+            cur = cur->parent;
+        }
+        cur = (cur != root) ? cur->next : NULL;
+    }
+    return(0);
+}
+
+static int
+xmlSecC14NEngineProcessNodeList(xmlSecC14NEnginePtr engine, xmlNodePtr cur) {
+    int ret;
+
+    xmlSecAssert2(engine != NULL, -1);
+
+    for(; cur != NULL; cur = cur->next) {
+        /* nothing is visible in the excluded subtree, skip it */
+        if(xmlSecC14NEngineIsExcludedRoot(engine, cur)) {
+            ret = xmlSecC14NEngineCheckExcluded(engine, cur);
+            if(ret < 0) {
+                return(-1);
+            }
+            continue;
+        }
+        ret = xmlSecC14NEngineProcessNode(engine, cur);
+        if(ret < 0) {
+            return(-1);
+        }
+    }
+    return(0);
+}
+
+static int
+xmlSecC14NEngineExecute(xmlSecC14NEnginePtr engine) {
+    int ret;
+
+    xmlSecAssert2(engine != NULL, -1);
+    xmlSecAssert2(engine->doc != NULL, -1);
+
+    /* same as LibXML2: we only support UTF8 documents */
+    if(engine->doc->charset != XML_CHAR_ENCODING_UTF8) {
+        xmlSecInvalidIntegerDataError("document charset", engine->doc->charset,
+            "XML_CHAR_ENCODING_UTF8", engine->errorObject);
+        return(-1);
+    }
+
+    /* the root node is the parent of the top-level document element, process
+     * each of its child nodes in document order */
+    ret = xmlSecC14NEngineProcessNodeList(engine, engine->doc->children);
+    if(ret < 0) {
+        return(-1);
+    }
+
+    /* write everything out */
+    ret = xmlSecC14NEngineFlush(engine, 1);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecC14NEngineFlush", engine->errorObject);
+        return(-1);
+    }
+    return(0);
+}
@@ -30,8 +30,31 @@
 #include <xmlsec/gcrypt/crypto.h>
 
 #include "asn1.h"
+#include "private.h"
 #include "../cast_helpers.h"
 
+#define XMLSEC_GCRYPT_DEFAULT_SECURE_MEMORY_SIZE        32768
+
+static xmlSecSize gXmlSecGCryptAppSecureMemorySize = XMLSEC_GCRYPT_DEFAULT_SECURE_MEMORY_SIZE;
+
+/**
+ * xmlSecGCryptAppSetSecureMemorySize:
+ * @size:               the secure memory pool size in bytes.
+ *
+ * Sets the size of the libgcrypt secure memory pool allocated by
+ * @xmlSecGCryptAppInit (default is 32K). Must be called before
+ * @xmlSecGCryptAppInit.
+ *
+ * Returns: 0 on success or a negative value otherwise.
+ */
+int
+xmlSecGCryptAppSetSecureMemorySize(xmlSecSize size) {
+    xmlSecAssert2(size > 0, -1);
+
+    gXmlSecGCryptAppSecureMemorySize = size;
+    return(0);
+}
+
 /**
  * xmlSecGCryptAppInit:
  * @config:             the path to GCrypt configuration (unused).
@@ -44,6 +67,7 @@
  */
 int
 xmlSecGCryptAppInit(const char* config ATTRIBUTE_UNUSED) {
+    unsigned int secMemSize;
     gcry_error_t err;
     /* Secure memory initialisation based on documentation from:
          http://www.gnupg.org/documentation/manuals/gcrypt/Initializing-the-library.html
@@ -94,13 +118,16 @@ Noteworthy changes in version 1.4.3 (2008-09-18)
        process might still be running with increased privileges and that
        the secure memory has not been initialized.  */
 
-    /* Allocate a pool of 32k secure memory.  This make the secure memory
+    /* Allocate a pool of secure memory (32k by default).  This make the secure memory
        available and also drops privileges where needed.  */
-    err = gcry_control(GCRYCTL_INIT_SECMEM, 32768, 0);
+    XMLSEC_SAFE_CAST_SIZE_TO_UINT(gXmlSecGCryptAppSecureMemorySize, secMemSize, return(-1), NULL);
+    err = gcry_control(GCRYCTL_INIT_SECMEM, secMemSize, 0);
     if(err != GPG_ERR_NO_ERROR) {
         xmlSecGCryptError("gcry_control(GCRYCTL_INIT_SECMEM)", err, NULL);
         /* ignore this error because of libgrcypt bug in allocating memory,
         see https://github.com/lsh123/xmlsec/issues/415 for more details */
+    } else {
+        xmlSecGCryptSecureMemorySetPoolSize(gXmlSecGCryptAppSecureMemorySize);
     }
 
     /* It is now okay to let Libgcrypt complain when there was/is
@@ -142,6 +169,7 @@ xmlSecGCryptAppShutdown(void) {
         xmlSecGCryptError("gcry_control(GCRYCTL_TERM_SECMEM)", err, NULL);
         return(-1);
     }
+    xmlSecGCryptSecureMemorySetPoolSize(0);
 
     /* done */
     return(0);
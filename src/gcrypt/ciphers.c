@@ -25,6 +25,7 @@
 
 #include <xmlsec/gcrypt/crypto.h>
 
+#include "private.h"
 #include "../cast_helpers.h"
 #include "../keysdata_helpers.h"
 
@@ -420,9 +421,9 @@ xmlSecGCryptBlockCipherInitialize(xmlSecTransformPtr transform) {
         return(-1);
     }
 
-    err = gcry_cipher_open(&ctx->cipherCtx, ctx->cipher, ctx->mode, GCRY_CIPHER_SECURE); /* we are paranoid */
+    err = xmlSecGCryptCipherOpen(&ctx->cipherCtx, ctx->cipher, ctx->mode, 0, xmlSecGCryptDataSecret);
     if(err != GPG_ERR_NO_ERROR) {
-        xmlSecGCryptError("gcry_cipher_open", err,
+        xmlSecGCryptError("xmlSecGCryptCipherOpen", err,
                           xmlSecTransformGetName(transform));
         return(-1);
     }
@@ -22,6 +22,8 @@
 
 #include <gcrypt.h>
 
+#include <libxml/threads.h>
+
 #include <xmlsec/xmlsec.h>
 #include <xmlsec/keys.h>
 #include <xmlsec/transforms.h>
@@ -32,8 +34,14 @@
 #include <xmlsec/gcrypt/app.h>
 #include <xmlsec/gcrypt/crypto.h>
 
+#include "private.h"
+
 static xmlSecCryptoDLFunctionsPtr gXmlSecGCryptFunctions = NULL;
 
+static xmlSecGCryptSecureMemoryPolicy gXmlSecGCryptSecureMemoryPolicy = xmlSecGCryptSecureMemoryPolicySecretsOnly;
+static xmlSecGCryptSecureMemoryStats gXmlSecGCryptSecureMemoryStats = { 0, 0, 0 };
+static xmlMutexPtr gXmlSecGCryptSecureMemoryStatsMutex = NULL;
+
 /**
  * xmlSecCryptoGetFunctions_gcrypt:
  *
@@ -326,6 +334,15 @@ xmlSecGCryptInit (void)  {
         return(-1);
     }
 
+    /* secure memory stats are updated from transforms that might run in parallel */
+    if(gXmlSecGCryptSecureMemoryStatsMutex == NULL) {
+        gXmlSecGCryptSecureMemoryStatsMutex = xmlNewMutex();
+        if(gXmlSecGCryptSecureMemoryStatsMutex == NULL) {
+            xmlSecXmlError("xmlNewMutex", NULL);
+            return(-1);
+        }
+    }
+
     return(0);
 }
 
@@ -338,6 +355,10 @@ xmlSecGCryptInit (void)  {
  */
 int
 xmlSecGCryptShutdown(void) {
+    if(gXmlSecGCryptSecureMemoryStatsMutex != NULL) {
+        xmlFreeMutex(gXmlSecGCryptSecureMemoryStatsMutex);
+        gXmlSecGCryptSecureMemoryStatsMutex = NULL;
+    }
     return(0);
 }
 
@@ -384,3 +405,100 @@ xmlSecGCryptGenerateRandom(xmlSecBufferPtr buffer, xmlSecSize size) {
     gcry_randomize(xmlSecBufferGetData(buffer), size, GCRY_STRONG_RANDOM);
     return(0);
 }
+
+/**
+ * xmlSecGCryptSetSecureMemoryPolicy:
+ * @policy:             the new secure memory policy.
+ *
+ * Sets the policy deciding which gcrypt contexts are allocated from the
+ * libgcrypt secure memory pool. By default only contexts that hold secrets
+ * (ciphers, key wraps and HMAC) use it: digests of public data (references,
+ * SignedInfo) go to the regular heap so that large or parallel signature
+ * workloads do not exhaust the (small) secure pool. The policy should be set
+ * before any transforms are created.
+ */
+void
+xmlSecGCryptSetSecureMemoryPolicy(xmlSecGCryptSecureMemoryPolicy policy) {
+    gXmlSecGCryptSecureMemoryPolicy = policy;
+}
+
+/**
+ * xmlSecGCryptGetSecureMemoryPolicy:
+ *
+ * Gets the current secure memory policy.
+ *
+ * Returns: the current secure memory policy.
+ */
+xmlSecGCryptSecureMemoryPolicy
+xmlSecGCryptGetSecureMemoryPolicy(void) {
+    return(gXmlSecGCryptSecureMemoryPolicy);
+}
+
+/**
+ * xmlSecGCryptGetSecureMemoryStats:
+ * @stats:              the pointer to the stats structure to fill.
+ *
+ * Gets the secure memory pool size and the number of gcrypt contexts
+ * allocated from the secure and the regular memory so far.
+ *
+ * Returns: 0 on success or a negative value otherwise.
+ */
+int
+xmlSecGCryptGetSecureMemoryStats(xmlSecGCryptSecureMemoryStatsPtr stats) {
+    xmlSecAssert2(stats != NULL, -1);
+
+    if(gXmlSecGCryptSecureMemoryStatsMutex != NULL) {
+        xmlMutexLock(gXmlSecGCryptSecureMemoryStatsMutex);
+    }
+    (*stats) = gXmlSecGCryptSecureMemoryStats;
+    if(gXmlSecGCryptSecureMemoryStatsMutex != NULL) {
+        xmlMutexUnlock(gXmlSecGCryptSecureMemoryStatsMutex);
+    }
+    return(0);
+}
+
+void
+xmlSecGCryptSecureMemorySetPoolSize(xmlSecSize size) {
+    gXmlSecGCryptSecureMemoryStats.poolSize = size;
+}
+
+static int
+xmlSecGCryptSecureMemoryUse(xmlSecGCryptDataSensitivity sensitivity) {
+    int secure;
+
+    secure = (sensitivity == xmlSecGCryptDataSecret) ||
+        (gXmlSecGCryptSecureMemoryPolicy == xmlSecGCryptSecureMemoryPolicyAll);
+
+    if(gXmlSecGCryptSecureMemoryStatsMutex != NULL) {
+        xmlMutexLock(gXmlSecGCryptSecureMemoryStatsMutex);
+    }
+    if(secure != 0) {
+        ++gXmlSecGCryptSecureMemoryStats.secureContexts;
+    } else {
+        ++gXmlSecGCryptSecureMemoryStats.publicContexts;
+    }
+    if(gXmlSecGCryptSecureMemoryStatsMutex != NULL) {
+        xmlMutexUnlock(gXmlSecGCryptSecureMemoryStatsMutex);
+    }
+    return(secure);
+}
+
+gcry_error_t
+xmlSecGCryptMdOpen(gcry_md_hd_t* hd, int algo, unsigned int flags, xmlSecGCryptDataSensitivity sensitivity) {
+    xmlSecAssert2(hd != NULL, (gcry_error_t)GPG_ERR_INV_ARG);
+
+    if(xmlSecGCryptSecureMemoryUse(sensitivity) != 0) {
+        flags |= GCRY_MD_FLAG_SECURE;
+    }
+    return(gcry_md_open(hd, algo, flags));
+}
+
+gcry_error_t
+xmlSecGCryptCipherOpen(gcry_cipher_hd_t* hd, int algo, int mode, unsigned int flags, xmlSecGCryptDataSensitivity sensitivity) {
+    xmlSecAssert2(hd != NULL, (gcry_error_t)GPG_ERR_INV_ARG);
+
+    if(xmlSecGCryptSecureMemoryUse(sensitivity) != 0) {
+        flags |= GCRY_CIPHER_SECURE;
+    }
+    return(gcry_cipher_open(hd, algo, mode, flags));
+}
@@ -26,7 +26,9 @@
 #include <xmlsec/gcrypt/app.h>
 #include <xmlsec/gcrypt/crypto.h>
 
+#include "private.h"
 #include "../cast_helpers.h"
+#include "../transform_helpers.h"
 
 /**************************************************************************
  *
@@ -53,13 +55,23 @@ XMLSEC_TRANSFORM_DECLARE(GCryptDigest, xmlSecGCryptDigestCtx)
 
 static int      xmlSecGCryptDigestInitialize            (xmlSecTransformPtr transform);
 static void     xmlSecGCryptDigestFinalize              (xmlSecTransformPtr transform);
+static int      xmlSecGCryptDigestCopyState             (xmlSecTransformPtr dst,
+                                                         xmlSecTransformPtr src);
 static int      xmlSecGCryptDigestVerify                (xmlSecTransformPtr transform,
                                                          const xmlSecByte* data,
                                                          xmlSecSize dataSize,
                                                          xmlSecTransformCtxPtr transformCtx);
+static int      xmlSecGCryptDigestUpdate                (xmlSecTransformPtr transform,
+                                                         const xmlSecByte* data,
+                                                         xmlSecSize dataSize);
 static int      xmlSecGCryptDigestExecute               (xmlSecTransformPtr transform,
                                                          int last,
                                                          xmlSecTransformCtxPtr transformCtx);
+static int      xmlSecGCryptDigestPushBinV              (xmlSecTransformPtr transform,
+                                                         const xmlSecTransformIOVec* vec,
+                                                         xmlSecSize vecSize,
+                                                         int final,
+                                                         xmlSecTransformCtxPtr transformCtx);
 static int      xmlSecGCryptDigestCheckId               (xmlSecTransformPtr transform);
 
 static int
@@ -192,9 +204,9 @@ xmlSecGCryptDigestInitialize(xmlSecTransformPtr transform) {
     }
 
     /* create digest ctx */
-    err = gcry_md_open(&ctx->digestCtx, ctx->digest, GCRY_MD_FLAG_SECURE); /* we are paranoid */
+    err = xmlSecGCryptMdOpen(&ctx->digestCtx, ctx->digest, 0, xmlSecGCryptDataPublic);
     if(err != GPG_ERR_NO_ERROR) {
-        xmlSecGCryptError("gcry_md_open", err,
+        xmlSecGCryptError("xmlSecGCryptMdOpen", err,
                           xmlSecTransformGetName(transform));
         return(-1);
     }
@@ -217,6 +229,42 @@ xmlSecGCryptDigestFinalize(xmlSecTransformPtr transform) {
     memset(ctx, 0, sizeof(xmlSecGCryptDigestCtx));
 }
 
+static int
+xmlSecGCryptDigestCopyState(xmlSecTransformPtr dst, xmlSecTransformPtr src) {
+    xmlSecGCryptDigestCtxPtr dstCtx, srcCtx;
+
+    xmlSecAssert2(xmlSecGCryptDigestCheckId(dst), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(dst, xmlSecGCryptDigestSize), -1);
+    xmlSecAssert2(xmlSecTransformCheckId(src, dst->id), -1);
+
+    dstCtx = xmlSecGCryptDigestGetCtx(dst);
+    xmlSecAssert2(dstCtx != NULL, -1);
+    xmlSecAssert2(dstCtx->digestCtx != NULL, -1);
+    srcCtx = xmlSecGCryptDigestGetCtx(src);
+    xmlSecAssert2(srcCtx != NULL, -1);
+    xmlSecAssert2(srcCtx->digestCtx != NULL, -1);
+    xmlSecAssert2(srcCtx->dgstSize <= sizeof(dstCtx->dgst), -1);
+
+    /* the hash state is only needed while the data is processed,
+     * the finished transforms only have the digest value */
+    if(src->status == xmlSecTransformStatusWorking) {
+        gcry_md_hd_t digestCtx = NULL;
+        gcry_error_t err;
+
+        err = gcry_md_copy(&digestCtx, srcCtx->digestCtx);
+        if(err != GPG_ERR_NO_ERROR) {
+            xmlSecGCryptError("gcry_md_copy", err, xmlSecTransformGetName(dst));
+            return(-1);
+        }
+        gcry_md_close(dstCtx->digestCtx);
+        dstCtx->digestCtx = digestCtx;
+    }
+
+    memcpy(dstCtx->dgst, srcCtx->dgst, srcCtx->dgstSize);
+    dstCtx->dgstSize = srcCtx->dgstSize;
+    return(0);
+}
+
 static int
 xmlSecGCryptDigestVerify(xmlSecTransformPtr transform,
                         const xmlSecByte* data, xmlSecSize dataSize,
@@ -252,6 +300,23 @@ xmlSecGCryptDigestVerify(xmlSecTransformPtr transform,
     return(0);
 }
 
+static int
+xmlSecGCryptDigestUpdate(xmlSecTransformPtr transform, const xmlSecByte* data, xmlSecSize dataSize) {
+    xmlSecGCryptDigestCtxPtr ctx;
+
+    xmlSecAssert2(xmlSecGCryptDigestCheckId(transform), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(transform, xmlSecGCryptDigestSize), -1);
+    xmlSecAssert2(transform->status == xmlSecTransformStatusWorking, -1);
+    xmlSecAssert2(data != NULL, -1);
+
+    ctx = xmlSecGCryptDigestGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->digestCtx != NULL, -1);
+
+    gcry_md_write(ctx->digestCtx, data, dataSize);
+    return(0);
+}
+
 static int
 xmlSecGCryptDigestExecute(xmlSecTransformPtr transform, int last, xmlSecTransformCtxPtr transformCtx) {
     xmlSecGCryptDigestCtxPtr ctx;
@@ -280,7 +345,11 @@ xmlSecGCryptDigestExecute(xmlSecTransformPtr transform, int last, xmlSecTransfor
 
         inSize = xmlSecBufferGetSize(in);
         if(inSize > 0) {
-            gcry_md_write(ctx->digestCtx, xmlSecBufferGetData(in), inSize);
+            ret = xmlSecGCryptDigestUpdate(transform, xmlSecBufferGetData(in), inSize);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecGCryptDigestUpdate", xmlSecTransformGetName(transform));
+                return(-1);
+            }
 
             ret = xmlSecBufferRemoveHead(in, inSize);
             if(ret < 0) {
@@ -330,6 +399,16 @@ xmlSecGCryptDigestExecute(xmlSecTransformPtr transform, int last, xmlSecTransfor
     return(0);
 }
 
+static int
+xmlSecGCryptDigestPushBinV(xmlSecTransformPtr transform, const xmlSecTransformIOVec* vec,
+                        xmlSecSize vecSize, int final, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecAssert2(xmlSecGCryptDigestCheckId(transform), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(transform, xmlSecGCryptDigestSize), -1);
+
+    return(xmlSecTransformUpdatePushBinV(transform, vec, vecSize, final, transformCtx,
+        xmlSecGCryptDigestUpdate));
+}
+
 
 #ifndef XMLSEC_NO_MD5
 /******************************************************************************
@@ -362,8 +441,8 @@ static xmlSecTransformKlass xmlSecGCryptMd5Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecGCryptDigestCopyState,                /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGCryptDigestPushBinV,                 /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -410,8 +489,8 @@ static xmlSecTransformKlass xmlSecGCryptRipemd160Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecGCryptDigestCopyState,                /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGCryptDigestPushBinV,                 /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -459,8 +538,8 @@ static xmlSecTransformKlass xmlSecGCryptSha1Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecGCryptDigestCopyState,                /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGCryptDigestPushBinV,                 /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -508,8 +587,8 @@ static xmlSecTransformKlass xmlSecGCryptSha256Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecGCryptDigestCopyState,                /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGCryptDigestPushBinV,                 /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -556,8 +635,8 @@ static xmlSecTransformKlass xmlSecGCryptSha384Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecGCryptDigestCopyState,                /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGCryptDigestPushBinV,                 /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -604,8 +683,8 @@ static xmlSecTransformKlass xmlSecGCryptSha512Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecGCryptDigestCopyState,                /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGCryptDigestPushBinV,                 /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -653,8 +732,8 @@ static xmlSecTransformKlass xmlSecGCryptSha3_256Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecGCryptDigestCopyState,                /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGCryptDigestPushBinV,                 /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -699,8 +778,8 @@ static xmlSecTransformKlass xmlSecGCryptSha3_384Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecGCryptDigestCopyState,                /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGCryptDigestPushBinV,                 /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -745,8 +824,8 @@ static xmlSecTransformKlass xmlSecGCryptSha3_512Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecGCryptDigestCopyState,                /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGCryptDigestPushBinV,                 /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
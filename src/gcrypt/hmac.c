@@ -27,6 +27,7 @@
 #include <xmlsec/gcrypt/app.h>
 #include <xmlsec/gcrypt/crypto.h>
 
+#include "private.h"
 #include "../cast_helpers.h"
 #include "../keysdata_helpers.h"
 #include "../transform_helpers.h"
@@ -68,9 +69,17 @@ static int      xmlSecGCryptHmacVerify                  (xmlSecTransformPtr tran
                                                          const xmlSecByte* data,
                                                          xmlSecSize dataSize,
                                                          xmlSecTransformCtxPtr transformCtx);
+static int      xmlSecGCryptHmacUpdate                  (xmlSecTransformPtr transform,
+                                                         const xmlSecByte* data,
+                                                         xmlSecSize dataSize);
 static int      xmlSecGCryptHmacExecute                 (xmlSecTransformPtr transform,
                                                          int last,
                                                          xmlSecTransformCtxPtr transformCtx);
+static int      xmlSecGCryptHmacPushBinV                (xmlSecTransformPtr transform,
+                                                         const xmlSecTransformIOVec* vec,
+                                                         xmlSecSize vecSize,
+                                                         int final,
+                                                         xmlSecTransformCtxPtr transformCtx);
 
 static int
 xmlSecGCryptHmacCheckId(xmlSecTransformPtr transform) {
@@ -183,9 +192,9 @@ xmlSecGCryptHmacInitialize(xmlSecTransformPtr transform) {
     ctx->dgstSizeInBits = 8 * hmacSize;
 
     /* open context */
-    err = gcry_md_open(&ctx->digestCtx, ctx->digest, GCRY_MD_FLAG_HMAC | GCRY_MD_FLAG_SECURE); /* we are paranoid */
+    err = xmlSecGCryptMdOpen(&ctx->digestCtx, ctx->digest, GCRY_MD_FLAG_HMAC, xmlSecGCryptDataSecret);
     if(err != GPG_ERR_NO_ERROR) {
-        xmlSecGCryptError("gcry_md_open", err,
+        xmlSecGCryptError("xmlSecGCryptMdOpen", err,
                           xmlSecTransformGetName(transform));
         return(-1);
     }
@@ -331,6 +340,23 @@ xmlSecGCryptHmacVerify(xmlSecTransformPtr transform,
     return(0);
 }
 
+static int
+xmlSecGCryptHmacUpdate(xmlSecTransformPtr transform, const xmlSecByte* data, xmlSecSize dataSize) {
+    xmlSecGCryptHmacCtxPtr ctx;
+
+    xmlSecAssert2(xmlSecGCryptHmacCheckId(transform), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(transform, xmlSecGCryptHmacSize), -1);
+    xmlSecAssert2(transform->status == xmlSecTransformStatusWorking, -1);
+    xmlSecAssert2(data != NULL, -1);
+
+    ctx = xmlSecGCryptHmacGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->digestCtx != NULL, -1);
+
+    gcry_md_write(ctx->digestCtx, data, dataSize);
+    return(0);
+}
+
 static int
 xmlSecGCryptHmacExecute(xmlSecTransformPtr transform, int last, xmlSecTransformCtxPtr transformCtx) {
     xmlSecGCryptHmacCtxPtr ctx;
@@ -359,7 +385,11 @@ xmlSecGCryptHmacExecute(xmlSecTransformPtr transform, int last, xmlSecTransformC
 
         inSize = xmlSecBufferGetSize(in);
         if(inSize > 0) {
-            gcry_md_write(ctx->digestCtx, xmlSecBufferGetData(in), inSize);
+            ret = xmlSecGCryptHmacUpdate(transform, xmlSecBufferGetData(in), inSize);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecGCryptHmacUpdate", xmlSecTransformGetName(transform));
+                return(-1);
+            }
 
             ret = xmlSecBufferRemoveHead(in, inSize);
             if(ret < 0) {
@@ -401,6 +431,16 @@ xmlSecGCryptHmacExecute(xmlSecTransformPtr transform, int last, xmlSecTransformC
     return(0);
 }
 
+static int
+xmlSecGCryptHmacPushBinV(xmlSecTransformPtr transform, const xmlSecTransformIOVec* vec,
+                         xmlSecSize vecSize, int final, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecAssert2(xmlSecGCryptHmacCheckId(transform), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(transform, xmlSecGCryptHmacSize), -1);
+
+    return(xmlSecTransformUpdatePushBinV(transform, vec, vecSize, final, transformCtx,
+        xmlSecGCryptHmacUpdate));
+}
+
 #ifndef XMLSEC_NO_SHA1
 /******************************************************************************
  *
@@ -430,8 +470,8 @@ static xmlSecTransformKlass xmlSecGCryptHmacSha1Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptHmacExecute,                    /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGCryptHmacPushBinV,                   /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -476,8 +516,8 @@ static xmlSecTransformKlass xmlSecGCryptHmacSha256Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptHmacExecute,                    /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGCryptHmacPushBinV,                   /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -522,8 +562,8 @@ static xmlSecTransformKlass xmlSecGCryptHmacSha384Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptHmacExecute,                    /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGCryptHmacPushBinV,                   /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -568,8 +608,8 @@ static xmlSecTransformKlass xmlSecGCryptHmacSha512Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptHmacExecute,                    /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGCryptHmacPushBinV,                   /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -615,8 +655,8 @@ static xmlSecTransformKlass xmlSecGCryptHmacRipemd160Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptHmacExecute,                    /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGCryptHmacPushBinV,                   /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -661,8 +701,8 @@ static xmlSecTransformKlass xmlSecGCryptHmacMd5Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGCryptHmacExecute,                    /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGCryptHmacPushBinV,                   /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
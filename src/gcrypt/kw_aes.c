@@ -29,6 +29,7 @@
 #include <xmlsec/gcrypt/crypto.h>
 
 #include "../kw_aes_des.h"
+#include "private.h"
 #include "../cast_helpers.h"
 
 /*********************************************************************
@@ -145,7 +146,7 @@ xmlSecGCryptKWAesInitialize(xmlSecTransformPtr transform) {
     }
 
     ctx->mode           = GCRY_CIPHER_MODE_CBC;
-    ctx->flags          = GCRY_CIPHER_SECURE; /* we are paranoid */
+    ctx->flags          = 0;
     XMLSEC_SAFE_CAST_SIZE_T_TO_SIZE(blockSize, ctx->blockSize, return(-1), NULL);
 
     return(0);
@@ -377,9 +378,9 @@ xmlSecGCryptKWAesBlockEncrypt(xmlSecTransformPtr transform, const xmlSecByte * i
     xmlSecAssert2(keySize > 0, -1);
     xmlSecAssert2(ctx->parentCtx.keyExpectedSize == keySize, -1);
 
-    err = gcry_cipher_open(&cipherCtx, ctx->cipher, ctx->mode, ctx->flags);
+    err = xmlSecGCryptCipherOpen(&cipherCtx, ctx->cipher, ctx->mode, ctx->flags, xmlSecGCryptDataSecret);
     if(err != GPG_ERR_NO_ERROR) {
-        xmlSecGCryptError("gcry_cipher_open", err, NULL);
+        xmlSecGCryptError("xmlSecGCryptCipherOpen", err, NULL);
         return(-1);
     }
 
@@ -439,9 +440,9 @@ xmlSecGCryptKWAesBlockDecrypt(xmlSecTransformPtr transform, const xmlSecByte * i
     xmlSecAssert2(keySize > 0, -1);
     xmlSecAssert2(ctx->parentCtx.keyExpectedSize == keySize, -1);
 
-    err = gcry_cipher_open(&cipherCtx, ctx->cipher, ctx->mode, ctx->flags);
+    err = xmlSecGCryptCipherOpen(&cipherCtx, ctx->cipher, ctx->mode, ctx->flags, xmlSecGCryptDataSecret);
     if(err != GPG_ERR_NO_ERROR) {
-        xmlSecGCryptError("gcry_cipher_open", err, NULL);
+        xmlSecGCryptError("xmlSecGCryptCipherOpen", err, NULL);
         return(-1);
     }
 
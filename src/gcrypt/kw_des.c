@@ -30,6 +30,7 @@
 #include <xmlsec/gcrypt/crypto.h>
 
 #include "../kw_aes_des.h"
+#include "private.h"
 #include "../cast_helpers.h"
 
 /*********************************************************************
@@ -278,9 +279,10 @@ xmlSecGCryptKWDes3Sha1(xmlSecTransformPtr transform,
     outBufSize = gcry_md_get_algo_dlen(GCRY_MD_SHA1);
     xmlSecAssert2(outSize >= outBufSize, -1);
 
-    err = gcry_md_open(&digestCtx, GCRY_MD_SHA1, GCRY_MD_FLAG_SECURE); /* we are paranoid */
+    /* CMS key checksum: the digest sees the key being wrapped */
+    err = xmlSecGCryptMdOpen(&digestCtx, GCRY_MD_SHA1, 0, xmlSecGCryptDataSecret);
     if(err != GPG_ERR_NO_ERROR) {
-        xmlSecGCryptError("gcry_md_open(GCRY_MD_SHA1)", err, NULL);
+        xmlSecGCryptError("xmlSecGCryptMdOpen(GCRY_MD_SHA1)", err, NULL);
         return(-1);
     }
 
@@ -418,9 +420,9 @@ xmlSecGCryptKWDes3Encrypt(const xmlSecByte *key, xmlSecSize keySize,
     xmlSecAssert2(outSize >= inSize, -1);
     xmlSecAssert2(outWritten != NULL, -1);
 
-    err = gcry_cipher_open(&cipherCtx, GCRY_CIPHER_3DES, GCRY_CIPHER_MODE_CBC, GCRY_CIPHER_SECURE); /* we are paranoid */
+    err = xmlSecGCryptCipherOpen(&cipherCtx, GCRY_CIPHER_3DES, GCRY_CIPHER_MODE_CBC, 0, xmlSecGCryptDataSecret);
     if(err != GPG_ERR_NO_ERROR) {
-        xmlSecGCryptError("gcry_cipher_open(GCRY_CIPHER_3DES)", err, NULL);
+        xmlSecGCryptError("xmlSecGCryptCipherOpen(GCRY_CIPHER_3DES)", err, NULL);
         return(-1);
     }
 
@@ -0,0 +1,59 @@
+/*
+ * XML Security Library
+ *
+ * THIS IS A PRIVATE XMLSEC HEADER FILE
+ * DON'T USE IT IN YOUR APPLICATION
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2024 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#ifndef __XMLSEC_GCRYPT_PRIVATE_H__
+#define __XMLSEC_GCRYPT_PRIVATE_H__
+
+#ifndef XMLSEC_PRIVATE
+#error "gcrypt/private.h file contains private xmlsec definitions and should not be used outside xmlsec or xmlsec-$crypto libraries"
+#endif /* XMLSEC_PRIVATE */
+
+#include <gcrypt.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**************************************************************************
+ *
+ * Secure memory
+ *
+ *****************************************************************************/
+/**
+ * xmlSecGCryptDataSensitivity:
+ * @xmlSecGCryptDataPublic:     the context only ever sees public data (e.g.
+ *                              the digest of a reference or of SignedInfo).
+ * @xmlSecGCryptDataSecret:     the context holds key material or plaintext.
+ *
+ * What a gcrypt md or cipher context is going to process; decides whether
+ * the context is allocated from the secure memory pool.
+ */
+typedef enum {
+    xmlSecGCryptDataPublic = 0,
+    xmlSecGCryptDataSecret
+} xmlSecGCryptDataSensitivity;
+
+gcry_error_t            xmlSecGCryptMdOpen                      (gcry_md_hd_t* hd,
+                                                                 int algo,
+                                                                 unsigned int flags,
+                                                                 xmlSecGCryptDataSensitivity sensitivity);
+gcry_error_t            xmlSecGCryptCipherOpen                  (gcry_cipher_hd_t* hd,
+                                                                 int algo,
+                                                                 int mode,
+                                                                 unsigned int flags,
+                                                                 xmlSecGCryptDataSensitivity sensitivity);
+void                    xmlSecGCryptSecureMemorySetPoolSize     (xmlSecSize size);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ! __XMLSEC_GCRYPT_PRIVATE_H__ */
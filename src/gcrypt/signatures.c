@@ -25,6 +25,7 @@
 
 #include <xmlsec/gcrypt/crypto.h>
 
+#include "private.h"
 #include "../cast_helpers.h"
 
 /**************************************************************************
@@ -500,9 +501,10 @@ xmlSecGCryptPkSignatureInitialize(xmlSecTransformPtr transform) {
     }
 
     /* create digest ctx */
-    err = gcry_md_open(&ctx->digestCtx, ctx->digest, GCRY_MD_FLAG_SECURE); /* we are paranoid */
+    /* only the (public) data to be signed or verified goes through the digest */
+    err = xmlSecGCryptMdOpen(&ctx->digestCtx, ctx->digest, 0, xmlSecGCryptDataPublic);
     if(err != GPG_ERR_NO_ERROR) {
-        xmlSecGCryptError("gcry_md_open", err, xmlSecTransformGetName(transform));
+        xmlSecGCryptError("xmlSecGCryptMdOpen", err, xmlSecTransformGetName(transform));
         return(-1);
     }
 
@@ -836,7 +838,6 @@ xmlSecGCryptDsaSign(int digest ATTRIBUTE_UNUSED, xmlSecKeyDataPtr key_data,
     gcry_mpi_t m_r = NULL;
     gcry_mpi_t m_s = NULL;
     gcry_sexp_t s_key;
-    gcry_sexp_t s_tmp;
     gpg_error_t err;
     int ret;
     int res = -1;
@@ -872,22 +873,8 @@ xmlSecGCryptDsaSign(int digest ATTRIBUTE_UNUSED, xmlSecKeyDataPtr key_data,
         goto done;
     }
 
-    /* find signature value */
-    s_tmp = gcry_sexp_find_token(s_sig, "sig-val", 0);
-    if(s_tmp == NULL) {
-        xmlSecGCryptError("gcry_sexp_find_token(sig-val)", (gcry_error_t)GPG_ERR_NO_ERROR, NULL);
-        goto done;
-    }
-    gcry_sexp_release(s_sig);
-    s_sig = s_tmp;
-
-    s_tmp = gcry_sexp_find_token(s_sig, "dsa", 0);
-    if(s_tmp == NULL) {
-        xmlSecGCryptError("gcry_sexp_find_token(dsa)", (gcry_error_t)GPG_ERR_NO_ERROR, NULL);
-        goto done;
-    }
-    gcry_sexp_release(s_sig);
-    s_sig = s_tmp;
+    /* find signature value: the tokens are searched in the whole
+     * (sig-val(dsa ...)) expression, no need to copy the sub-lists */
 
     /* r */
     s_r = gcry_sexp_find_token(s_sig, "r", 0);
@@ -966,8 +953,6 @@ xmlSecGCryptDsaVerify(int digest ATTRIBUTE_UNUSED, xmlSecKeyDataPtr key_data,
                         const xmlSecByte* data, xmlSecSize dataSize) {
     gcry_mpi_t m_hash = NULL;
     gcry_sexp_t s_data = NULL;
-    gcry_mpi_t m_sig_r = NULL;
-    gcry_mpi_t m_sig_s = NULL;
     gcry_sexp_t s_sig = NULL;
     gcry_sexp_t s_key;
     gpg_error_t err;
@@ -998,21 +983,11 @@ xmlSecGCryptDsaVerify(int digest ATTRIBUTE_UNUSED, xmlSecKeyDataPtr key_data,
         goto done;
     }
 
-    /* get the existing signature */
-    err = gcry_mpi_scan(&m_sig_r, GCRYMPI_FMT_USG, data, XMLSEC_GCRYPT_DSA_SIG_SIZE, NULL);
-    if((err != GPG_ERR_NO_ERROR) || (m_sig_r == NULL)) {
-        xmlSecGCryptError("gcry_mpi_scan(r)", err, NULL);
-        goto done;
-    }
-    err = gcry_mpi_scan(&m_sig_s, GCRYMPI_FMT_USG, data + XMLSEC_GCRYPT_DSA_SIG_SIZE, XMLSEC_GCRYPT_DSA_SIG_SIZE, NULL);
-    if((err != GPG_ERR_NO_ERROR) || (m_sig_s == NULL)) {
-        xmlSecGCryptError("gcry_mpi_scan(s)", err, NULL);
-        goto done;
-    }
-
+    /* get the existing signature (gcrypt reads r and s as unsigned integers) */
     err = gcry_sexp_build (&s_sig, NULL,
-                           "(sig-val(dsa(r %m)(s %m)))",
-                           m_sig_r, m_sig_s);
+                           "(sig-val(dsa(r %b)(s %b)))",
+                           XMLSEC_GCRYPT_DSA_SIG_SIZE, data,
+                           XMLSEC_GCRYPT_DSA_SIG_SIZE, data + XMLSEC_GCRYPT_DSA_SIG_SIZE);
     if((err != GPG_ERR_NO_ERROR) || (s_sig == NULL)) {
         xmlSecGCryptError("gcry_sexp_build(sig-val)", err, NULL);
         goto done;
@@ -1034,12 +1009,6 @@ done:
     if(m_hash != NULL) {
         gcry_mpi_release(m_hash);
     }
-    if(m_sig_r != NULL) {
-        gcry_mpi_release(m_sig_r);
-    }
-    if(m_sig_s != NULL) {
-        gcry_mpi_release(m_sig_s);
-    }
 
     if(s_data != NULL) {
         gcry_sexp_release(s_data);
@@ -1172,23 +1141,8 @@ xmlSecGCryptRsaPkcs1Sign(int digest, xmlSecKeyDataPtr key_data,
         goto done;
     }
 
-    /* find signature value */
-    s_tmp = gcry_sexp_find_token(s_sig, "sig-val", 0);
-    if(s_tmp == NULL) {
-        xmlSecGCryptError("gcry_sexp_find_token(sig-val)", (gcry_error_t)GPG_ERR_NO_ERROR, NULL);
-        goto done;
-    }
-    gcry_sexp_release(s_sig);
-    s_sig = s_tmp;
-
-    s_tmp = gcry_sexp_find_token(s_sig, "rsa", 0);
-    if(s_tmp == NULL) {
-        xmlSecGCryptError("gcry_sexp_find_token(rsa)", (gcry_error_t)GPG_ERR_NO_ERROR, NULL);
-        goto done;
-    }
-    gcry_sexp_release(s_sig);
-    s_sig = s_tmp;
-
+    /* find signature value: the tokens are searched in the whole
+     * (sig-val(rsa ...)) expression, no need to copy the sub-lists */
     s_tmp = gcry_sexp_find_token(s_sig, "s", 0);
     if(s_tmp == NULL) {
         xmlSecGCryptError("gcry_sexp_find_token(s)", (gcry_error_t)GPG_ERR_NO_ERROR, NULL);
@@ -1233,11 +1187,10 @@ xmlSecGCryptRsaPkcs1Verify(int digest, xmlSecKeyDataPtr key_data,
                              const xmlSecByte* dgst, xmlSecSize dgstSize,
                              const xmlSecByte* data, xmlSecSize dataSize) {
     gcry_sexp_t s_data = NULL;
-    gcry_mpi_t m_sig = NULL;
     gcry_sexp_t s_sig = NULL;
     gcry_sexp_t s_key;
     gpg_error_t err;
-    int dgstLen;
+    int dgstLen, sigLen;
     int res = -1;
 
     xmlSecAssert2(key_data != NULL, -1);
@@ -1260,16 +1213,11 @@ xmlSecGCryptRsaPkcs1Verify(int digest, xmlSecKeyDataPtr key_data,
         goto done;
     }
 
-    /* get the existing signature */
-    err = gcry_mpi_scan(&m_sig, GCRYMPI_FMT_USG, data, dataSize, NULL);
-    if((err != GPG_ERR_NO_ERROR) || (m_sig == NULL)) {
-        xmlSecGCryptError("gcry_mpi_scan", err, NULL);
-        goto done;
-    }
-
+    /* get the existing signature (gcrypt reads it as unsigned integer) */
+    XMLSEC_SAFE_CAST_SIZE_TO_INT(dataSize, sigLen, goto done, NULL);
     err = gcry_sexp_build (&s_sig, NULL,
-                           "(sig-val(rsa(s %m)))",
-                           m_sig);
+                           "(sig-val(rsa(s %b)))",
+                           sigLen, data);
     if((err != GPG_ERR_NO_ERROR) || (s_sig == NULL)) {
         xmlSecGCryptError("gcry_sexp_build(sig-val)", err, NULL);
         goto done;
@@ -1288,10 +1236,6 @@ xmlSecGCryptRsaPkcs1Verify(int digest, xmlSecKeyDataPtr key_data,
 
     /* done */
 done:
-    if(m_sig != NULL) {
-        gcry_mpi_release(m_sig);
-    }
-
     if(s_data != NULL) {
         gcry_sexp_release(s_data);
     }
@@ -1351,23 +1295,8 @@ xmlSecGCryptRsaPssSign(int digest, xmlSecKeyDataPtr key_data,
         goto done;
     }
 
-    /* find signature value */
-    s_tmp = gcry_sexp_find_token(s_sig, "sig-val", 0);
-    if(s_tmp == NULL) {
-        xmlSecGCryptError("gcry_sexp_find_token(sig-val)", (gcry_error_t)GPG_ERR_NO_ERROR, NULL);
-        goto done;
-    }
-    gcry_sexp_release(s_sig);
-    s_sig = s_tmp;
-
-    s_tmp = gcry_sexp_find_token(s_sig, "rsa", 0);
-    if(s_tmp == NULL) {
-        xmlSecGCryptError("gcry_sexp_find_token(rsa)", (gcry_error_t)GPG_ERR_NO_ERROR, NULL);
-        goto done;
-    }
-    gcry_sexp_release(s_sig);
-    s_sig = s_tmp;
-
+    /* find signature value: the tokens are searched in the whole
+     * (sig-val(rsa ...)) expression, no need to copy the sub-lists */
     s_tmp = gcry_sexp_find_token(s_sig, "s", 0);
     if(s_tmp == NULL) {
         xmlSecGCryptError("gcry_sexp_find_token(s)", (gcry_error_t)GPG_ERR_NO_ERROR, NULL);
@@ -1412,11 +1341,10 @@ xmlSecGCryptRsaPssVerify(int digest, xmlSecKeyDataPtr key_data,
                              const xmlSecByte* dgst, xmlSecSize dgstSize,
                              const xmlSecByte* data, xmlSecSize dataSize) {
     gcry_sexp_t s_data = NULL;
-    gcry_mpi_t m_sig = NULL;
     gcry_sexp_t s_sig = NULL;
     gcry_sexp_t s_key;
     gpg_error_t err;
-    int dgstLen;
+    int dgstLen, sigLen;
     int res = -1;
 
     xmlSecAssert2(key_data != NULL, -1);
@@ -1442,16 +1370,11 @@ xmlSecGCryptRsaPssVerify(int digest, xmlSecKeyDataPtr key_data,
         goto done;
     }
 
-    /* get the existing signature */
-    err = gcry_mpi_scan(&m_sig, GCRYMPI_FMT_USG, data, dataSize, NULL);
-    if((err != GPG_ERR_NO_ERROR) || (m_sig == NULL)) {
-        xmlSecGCryptError("gcry_mpi_scan", err, NULL);
-        goto done;
-    }
-
+    /* get the existing signature (gcrypt reads it as unsigned integer) */
+    XMLSEC_SAFE_CAST_SIZE_TO_INT(dataSize, sigLen, goto done, NULL);
     err = gcry_sexp_build (&s_sig, NULL,
-                           "(sig-val(rsa(s %m)))",
-                           m_sig);
+                           "(sig-val(rsa(s %b)))",
+                           sigLen, data);
     if((err != GPG_ERR_NO_ERROR) || (s_sig == NULL)) {
         xmlSecGCryptError("gcry_sexp_build(sig-val)", err, NULL);
         goto done;
@@ -1470,10 +1393,6 @@ xmlSecGCryptRsaPssVerify(int digest, xmlSecKeyDataPtr key_data,
 
     /* done */
 done:
-    if(m_sig != NULL) {
-        gcry_mpi_release(m_sig);
-    }
-
     if(s_data != NULL) {
         gcry_sexp_release(s_data);
     }
@@ -2121,7 +2040,6 @@ xmlSecGCryptEcdsaSign(int digest, xmlSecKeyDataPtr key_data,
     gcry_mpi_t m_r = NULL;
     gcry_mpi_t m_s = NULL;
     gcry_sexp_t s_key;
-    gcry_sexp_t s_tmp;
     gpg_error_t err;
     const char * algo_name;
     xmlSecSize keySize;
@@ -2170,22 +2088,8 @@ xmlSecGCryptEcdsaSign(int digest, xmlSecKeyDataPtr key_data,
         goto done;
     }
 
-    /* find signature value */
-    s_tmp = gcry_sexp_find_token(s_sig, "sig-val", 0);
-    if(s_tmp == NULL) {
-        xmlSecGCryptError("gcry_sexp_find_token(sig-val)", (gcry_error_t)GPG_ERR_NO_ERROR, NULL);
-        goto done;
-    }
-    gcry_sexp_release(s_sig);
-    s_sig = s_tmp;
-
-    s_tmp = gcry_sexp_find_token(s_sig, "ecdsa", 0);
-    if(s_tmp == NULL) {
-        xmlSecGCryptError("gcry_sexp_find_token(ecdsa)", (gcry_error_t)GPG_ERR_NO_ERROR, NULL);
-        goto done;
-    }
-    gcry_sexp_release(s_sig);
-    s_sig = s_tmp;
+    /* find signature value: the tokens are searched in the whole
+     * (sig-val(ecdsa ...)) expression, no need to copy the sub-lists */
 
     /* r */
     s_r = gcry_sexp_find_token(s_sig, "r", 0);
@@ -2265,12 +2169,11 @@ xmlSecGCryptEcdsaVerify(int digest, xmlSecKeyDataPtr key_data,
 {
     gcry_mpi_t m_hash = NULL;
     gcry_sexp_t s_data = NULL;
-    gcry_mpi_t m_sig_r = NULL;
-    gcry_mpi_t m_sig_s = NULL;
     gcry_sexp_t s_sig = NULL;
     gcry_sexp_t s_key;
     const char * algo_name;
     xmlSecSize keySize;
+    int keyLen;
     gpg_error_t err;
     int res = -1;
 
@@ -2316,21 +2219,12 @@ xmlSecGCryptEcdsaVerify(int digest, xmlSecKeyDataPtr key_data,
         goto done;
     }
 
-    /* get the existing signature */
-    err = gcry_mpi_scan(&m_sig_r, GCRYMPI_FMT_USG, data, keySize, NULL);
-    if((err != GPG_ERR_NO_ERROR) || (m_sig_r == NULL)) {
-        xmlSecGCryptError("gcry_mpi_scan(r)", err, NULL);
-        goto done;
-    }
-    err = gcry_mpi_scan(&m_sig_s, GCRYMPI_FMT_USG, data + keySize, keySize, NULL);
-    if((err != GPG_ERR_NO_ERROR) || (m_sig_s == NULL)) {
-        xmlSecGCryptError("gcry_mpi_scan(s)", err, NULL);
-        goto done;
-    }
-
+    /* get the existing signature (gcrypt reads r and s as unsigned integers) */
+    XMLSEC_SAFE_CAST_SIZE_TO_INT(keySize, keyLen, goto done, NULL);
     err = gcry_sexp_build (&s_sig, NULL,
-                           "(sig-val(ecdsa(r %m)(s %m)))",
-                           m_sig_r, m_sig_s);
+                           "(sig-val(ecdsa(r %b)(s %b)))",
+                           keyLen, data,
+                           keyLen, data + keySize);
     if((err != GPG_ERR_NO_ERROR) || (s_sig == NULL)) {
         xmlSecGCryptError("gcry_sexp_build(sig-val)", err, NULL);
         goto done;
@@ -2352,12 +2246,6 @@ done:
     if(m_hash != NULL) {
         gcry_mpi_release(m_hash);
     }
-    if(m_sig_r != NULL) {
-        gcry_mpi_release(m_sig_r);
-    }
-    if(m_sig_s != NULL) {
-        gcry_mpi_release(m_sig_s);
-    }
 
     if(s_data != NULL) {
         gcry_sexp_release(s_data);
@@ -38,6 +38,8 @@
 #define XMLSEC_GNUTLS_GCM_CIPHER_MAX_BLOCK_SIZE             32
 #define XMLSEC_GNUTLS_GCM_CIPHER_IV_SIZE                    12
 #define XMLSEC_GNUTLS_GCM_CIPHER_TAG_SIZE                   16
+#define XMLSEC_GNUTLS_GCM_CIPHER_BLOCK_SIZE                 16
+#define XMLSEC_GNUTLS_GCM_CIPHER_MAX_KEY_SIZE               32
 
 /**************************************************************************
  *
@@ -52,6 +54,10 @@ struct _xmlSecGnuTLSGcmCipherCtx {
     xmlSecKeyDataId             keyId;
     gnutls_cipher_algorithm_t   algorithm;
     xmlSecSize                  keySize;
+
+    /* streaming decryption (see XMLSEC_TRANSFORMCTX_FLAGS_AEAD_STREAMING) */
+    gnutls_cipher_hd_t          streamCipher;
+    xmlSecByte                  key[XMLSEC_GNUTLS_GCM_CIPHER_MAX_KEY_SIZE];
 };
 
 /******************************************************************************
@@ -139,6 +145,9 @@ xmlSecGnuTLSGcmCipherFinalize(xmlSecTransformPtr transform) {
     if(ctx->cipher != NULL) {
         gnutls_aead_cipher_deinit(ctx->cipher);
     }
+    if(ctx->streamCipher != NULL) {
+        gnutls_cipher_deinit(ctx->streamCipher);
+    }
     memset(ctx, 0, sizeof(xmlSecGnuTLSGcmCipherCtx));
 }
 
@@ -201,6 +210,10 @@ xmlSecGnuTLSGcmCipherSetKey(xmlSecTransformPtr transform, xmlSecKeyPtr key) {
         return(-1);
     }
     keySize = ctx->keySize;
+    xmlSecAssert2(keySize <= sizeof(ctx->key), -1);
+
+    /* the streaming decryption cipher is created once we get the iv */
+    memcpy(ctx->key, xmlSecBufferGetData(keyBuf), keySize);
 
     gnutlsKey.data = xmlSecBufferGetData(keyBuf);
     XMLSEC_SAFE_CAST_SIZE_TO_UINT(keySize, gnutlsKey.size, return(-1), xmlSecTransformGetName(transform));
@@ -334,6 +347,130 @@ xmlSecGnuTLSGcmCipherDecrypt(xmlSecGnuTLSGcmCipherCtxPtr ctx, xmlSecBufferPtr in
     return(0);
 }
 
+/* streaming decryption: the data is decrypted as it arrives, only the tag
+ * (the last 16 bytes) and the incomplete block are kept in the input buffer.
+ * The decrypted data is released to the next transform BEFORE the tag is
+ * verified, the caller discards it if the tag doesn't match (see
+ * XMLSEC_TRANSFORMCTX_FLAGS_AEAD_STREAMING) */
+static int
+xmlSecGnuTLSGcmCipherDecryptUpdate(xmlSecGnuTLSGcmCipherCtxPtr ctx, xmlSecBufferPtr in,
+    xmlSecBufferPtr out, int last
+) {
+    xmlSecSize inSize, outSize, size;
+    xmlSecByte *inData, *outData;
+    xmlSecByte tag[XMLSEC_GNUTLS_GCM_CIPHER_TAG_SIZE];
+    gnutls_datum_t gnutlsKey, gnutlsIv;
+    int ret;
+    int err;
+
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(in != NULL, -1);
+    xmlSecAssert2(out != NULL, -1);
+
+    /* iv is prepended */
+    if(ctx->streamCipher == NULL) {
+        inSize = xmlSecBufferGetSize(in);
+        if(inSize < XMLSEC_GNUTLS_GCM_CIPHER_IV_SIZE) {
+            if(last != 0) {
+                xmlSecInvalidSizeLessThanError("Input data", inSize,
+                    (xmlSecSize)XMLSEC_GNUTLS_GCM_CIPHER_IV_SIZE, NULL);
+                return(-1);
+            }
+            /* wait for more data */
+            return(0);
+        }
+
+        gnutlsKey.data = ctx->key;
+        XMLSEC_SAFE_CAST_SIZE_TO_UINT(ctx->keySize, gnutlsKey.size, return(-1), NULL);
+        gnutlsIv.data = xmlSecBufferGetData(in);
+        gnutlsIv.size = XMLSEC_GNUTLS_GCM_CIPHER_IV_SIZE;
+        xmlSecAssert2(gnutlsIv.data != NULL, -1);
+
+        err = gnutls_cipher_init(&(ctx->streamCipher), ctx->algorithm, &gnutlsKey, &gnutlsIv);
+        if(err != GNUTLS_E_SUCCESS) {
+            xmlSecGnuTLSError("gnutls_cipher_init", err, NULL);
+            return(-1);
+        }
+
+        ret = xmlSecBufferRemoveHead(in, XMLSEC_GNUTLS_GCM_CIPHER_IV_SIZE);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecBufferRemoveHead", NULL,
+                "size=%d", XMLSEC_GNUTLS_GCM_CIPHER_IV_SIZE);
+            return(-1);
+        }
+    }
+
+    inSize = xmlSecBufferGetSize(in);
+    if(last == 0) {
+        /* keep the tag and process only full blocks until we get all the data */
+        if(inSize <= XMLSEC_GNUTLS_GCM_CIPHER_TAG_SIZE) {
+            return(0);
+        }
+        size = XMLSEC_GNUTLS_GCM_CIPHER_BLOCK_SIZE *
+            ((inSize - XMLSEC_GNUTLS_GCM_CIPHER_TAG_SIZE) / XMLSEC_GNUTLS_GCM_CIPHER_BLOCK_SIZE);
+        if(size == 0) {
+            return(0);
+        }
+    } else {
+        if(inSize < XMLSEC_GNUTLS_GCM_CIPHER_TAG_SIZE) {
+            xmlSecInvalidSizeLessThanError("Input data", inSize,
+                (xmlSecSize)XMLSEC_GNUTLS_GCM_CIPHER_TAG_SIZE, NULL);
+            return(-1);
+        }
+        size = inSize - XMLSEC_GNUTLS_GCM_CIPHER_TAG_SIZE;
+    }
+    inData = xmlSecBufferGetData(in);
+    xmlSecAssert2(inData != NULL, -1);
+
+    if(size > 0) {
+        outSize = xmlSecBufferGetSize(out);
+        ret = xmlSecBufferSetMaxSize(out, outSize + size);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecBufferSetMaxSize", NULL,
+                "size=" XMLSEC_SIZE_FMT, (outSize + size));
+            return(-1);
+        }
+        outData = xmlSecBufferGetData(out);
+        xmlSecAssert2(outData != NULL, -1);
+
+        err = gnutls_cipher_decrypt2(ctx->streamCipher, inData, size, outData + outSize, size);
+        if(err != GNUTLS_E_SUCCESS) {
+            xmlSecGnuTLSError("gnutls_cipher_decrypt2", err, NULL);
+            return(-1);
+        }
+
+        ret = xmlSecBufferSetSize(out, outSize + size);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecBufferSetSize", NULL,
+                "size=" XMLSEC_SIZE_FMT, (outSize + size));
+            return(-1);
+        }
+    }
+
+    if(last != 0) {
+        err = gnutls_cipher_tag(ctx->streamCipher, tag, sizeof(tag));
+        if(err != GNUTLS_E_SUCCESS) {
+            xmlSecGnuTLSError("gnutls_cipher_tag", err, NULL);
+            return(-1);
+        }
+        if(gnutls_memcmp(tag, inData + size, XMLSEC_GNUTLS_GCM_CIPHER_TAG_SIZE) != 0) {
+            xmlSecOtherError(XMLSEC_ERRORS_R_DATA_NOT_MATCH, NULL, "GCM tag doesn't match");
+            return(-1);
+        }
+        size = inSize;
+    }
+
+    ret = xmlSecBufferRemoveHead(in, size);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecBufferRemoveHead", NULL,
+            "size=" XMLSEC_SIZE_FMT, size);
+        return(-1);
+    }
+
+    /* success */
+    return(0);
+}
+
 static int
 xmlSecGnuTLSGcmCipherExecute(xmlSecTransformPtr transform, int last, xmlSecTransformCtxPtr transformCtx) {
     xmlSecGnuTLSGcmCipherCtxPtr ctx;
@@ -355,6 +492,21 @@ xmlSecGnuTLSGcmCipherExecute(xmlSecTransformPtr transform, int last, xmlSecTrans
         transform->status = xmlSecTransformStatusWorking;
     }
 
+    if((transform->status == xmlSecTransformStatusWorking) &&
+       (transform->operation == xmlSecTransformOperationDecrypt) &&
+       ((transformCtx->flags & XMLSEC_TRANSFORMCTX_FLAGS_AEAD_STREAMING) != 0))
+    {
+        ret = xmlSecGnuTLSGcmCipherDecryptUpdate(ctx, in, out, last);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecGnuTLSGcmCipherDecryptUpdate", xmlSecTransformGetName(transform));
+            return(-1);
+        }
+        if(last != 0) {
+            transform->status = xmlSecTransformStatusFinished;
+        }
+        return(0);
+    }
+
     if((transform->status == xmlSecTransformStatusWorking) && (last == 0)) {
         /* we need the full input buffer, just wait */
         return(0);
@@ -30,6 +30,7 @@
 
 
 #include "../cast_helpers.h"
+#include "../transform_helpers.h"
 
 /**************************************************************************
  *
@@ -57,13 +58,23 @@ XMLSEC_TRANSFORM_DECLARE(GnuTLSDigest, xmlSecGnuTLSDigestCtx)
 static int      xmlSecGnuTLSDigestCheckId               (xmlSecTransformPtr transform);
 static int      xmlSecGnuTLSDigestInitialize            (xmlSecTransformPtr transform);
 static void     xmlSecGnuTLSDigestFinalize              (xmlSecTransformPtr transform);
+static int      xmlSecGnuTLSDigestCopyState             (xmlSecTransformPtr dst,
+                                                         xmlSecTransformPtr src);
 static int      xmlSecGnuTLSDigestVerify                (xmlSecTransformPtr transform,
                                                          const xmlSecByte* data,
                                                          xmlSecSize dataSize,
                                                          xmlSecTransformCtxPtr transformCtx);
+static int      xmlSecGnuTLSDigestUpdate                (xmlSecTransformPtr transform,
+                                                         const xmlSecByte* data,
+                                                         xmlSecSize dataSize);
 static int      xmlSecGnuTLSDigestExecute               (xmlSecTransformPtr transform,
                                                          int last,
                                                          xmlSecTransformCtxPtr transformCtx);
+static int      xmlSecGnuTLSDigestPushBinV              (xmlSecTransformPtr transform,
+                                                         const xmlSecTransformIOVec* vec,
+                                                         xmlSecSize vecSize,
+                                                         int final,
+                                                         xmlSecTransformCtxPtr transformCtx);
 
 static int
 xmlSecGnuTLSDigestCheckId(xmlSecTransformPtr transform) {
@@ -231,6 +242,41 @@ xmlSecGnuTLSDigestFinalize(xmlSecTransformPtr transform) {
     memset(ctx, 0, sizeof(xmlSecGnuTLSDigestCtx));
 }
 
+static int
+xmlSecGnuTLSDigestCopyState(xmlSecTransformPtr dst, xmlSecTransformPtr src) {
+    xmlSecGnuTLSDigestCtxPtr dstCtx, srcCtx;
+
+    xmlSecAssert2(xmlSecGnuTLSDigestCheckId(dst), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(dst, xmlSecGnuTLSDigestSize), -1);
+    xmlSecAssert2(xmlSecTransformCheckId(src, dst->id), -1);
+
+    dstCtx = xmlSecGnuTLSDigestGetCtx(dst);
+    xmlSecAssert2(dstCtx != NULL, -1);
+    xmlSecAssert2(dstCtx->hash != NULL, -1);
+    srcCtx = xmlSecGnuTLSDigestGetCtx(src);
+    xmlSecAssert2(srcCtx != NULL, -1);
+    xmlSecAssert2(srcCtx->hash != NULL, -1);
+    xmlSecAssert2(srcCtx->dgstSize <= sizeof(dstCtx->dgst), -1);
+
+    /* the hash state is only needed while the data is processed,
+     * the finished transforms only have the digest value */
+    if(src->status == xmlSecTransformStatusWorking) {
+        gnutls_hash_hd_t hash;
+
+        hash = gnutls_hash_copy(srcCtx->hash);
+        if(hash == NULL) {
+            xmlSecGnuTLSError("gnutls_hash_copy", 0, xmlSecTransformGetName(dst));
+            return(-1);
+        }
+        gnutls_hash_deinit(dstCtx->hash, NULL);
+        dstCtx->hash = hash;
+    }
+
+    memcpy(dstCtx->dgst, srcCtx->dgst, srcCtx->dgstSize);
+    dstCtx->dgstSize = srcCtx->dgstSize;
+    return(0);
+}
+
 static int
 xmlSecGnuTLSDigestVerify(xmlSecTransformPtr transform,
                         const xmlSecByte* data, xmlSecSize dataSize,
@@ -267,13 +313,34 @@ xmlSecGnuTLSDigestVerify(xmlSecTransformPtr transform,
     return(0);
 }
 
+static int
+xmlSecGnuTLSDigestUpdate(xmlSecTransformPtr transform, const xmlSecByte* data, xmlSecSize dataSize) {
+    xmlSecGnuTLSDigestCtxPtr ctx;
+    int err;
+
+    xmlSecAssert2(xmlSecGnuTLSDigestCheckId(transform), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(transform, xmlSecGnuTLSDigestSize), -1);
+    xmlSecAssert2(transform->status == xmlSecTransformStatusWorking, -1);
+    xmlSecAssert2(data != NULL, -1);
+
+    ctx = xmlSecGnuTLSDigestGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->hash != NULL, -1);
+
+    err = gnutls_hash(ctx->hash, data, dataSize);
+    if(err != GNUTLS_E_SUCCESS) {
+        xmlSecGnuTLSError("gnutls_hash", err, xmlSecTransformGetName(transform));
+        return(-1);
+    }
+    return(0);
+}
+
 static int
 xmlSecGnuTLSDigestExecute(xmlSecTransformPtr transform, int last, xmlSecTransformCtxPtr transformCtx) {
     xmlSecGnuTLSDigestCtxPtr ctx;
     xmlSecBufferPtr in, out;
     xmlSecSize inSize, outSize;
     int ret;
-    int err;
 
     xmlSecAssert2(xmlSecGnuTLSDigestCheckId(transform), -1);
     xmlSecAssert2((transform->operation == xmlSecTransformOperationSign) || (transform->operation == xmlSecTransformOperationVerify), -1);
@@ -298,9 +365,9 @@ xmlSecGnuTLSDigestExecute(xmlSecTransformPtr transform, int last, xmlSecTransfor
         xmlSecAssert2(outSize == 0, -1);
 
         /* update hash */
-        err = gnutls_hash(ctx->hash, xmlSecBufferGetData(in), inSize);
-        if(err != GNUTLS_E_SUCCESS) {
-            xmlSecGnuTLSError("gnutls_hash", err, xmlSecTransformGetName(transform));
+        ret = xmlSecGnuTLSDigestUpdate(transform, xmlSecBufferGetData(in), inSize);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecGnuTLSDigestUpdate", xmlSecTransformGetName(transform));
             return(-1);
         }
 
@@ -336,6 +403,16 @@ xmlSecGnuTLSDigestExecute(xmlSecTransformPtr transform, int last, xmlSecTransfor
     return(0);
 }
 
+static int
+xmlSecGnuTLSDigestPushBinV(xmlSecTransformPtr transform, const xmlSecTransformIOVec* vec,
+                        xmlSecSize vecSize, int final, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecAssert2(xmlSecGnuTLSDigestCheckId(transform), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(transform, xmlSecGnuTLSDigestSize), -1);
+
+    return(xmlSecTransformUpdatePushBinV(transform, vec, vecSize, final, transformCtx,
+        xmlSecGnuTLSDigestUpdate));
+}
+
 
 #ifndef XMLSEC_NO_SHA1
 /******************************************************************************
@@ -368,8 +445,8 @@ static xmlSecTransformKlass xmlSecGnuTLSSha1Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGnuTLSDigestExecute,                     /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecGnuTLSDigestCopyState,                /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGnuTLSDigestPushBinV,                 /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -416,8 +493,8 @@ static xmlSecTransformKlass xmlSecGnuTLSSha256Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGnuTLSDigestExecute,                     /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecGnuTLSDigestCopyState,                /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGnuTLSDigestPushBinV,                 /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -465,8 +542,8 @@ static xmlSecTransformKlass xmlSecGnuTLSSha384Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGnuTLSDigestExecute,                     /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecGnuTLSDigestCopyState,                /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGnuTLSDigestPushBinV,                 /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -513,8 +590,8 @@ static xmlSecTransformKlass xmlSecGnuTLSSha512Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGnuTLSDigestExecute,                     /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecGnuTLSDigestCopyState,                /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGnuTLSDigestPushBinV,                 /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -562,8 +639,8 @@ static xmlSecTransformKlass xmlSecGnuTLSSha3_256Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGnuTLSDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecGnuTLSDigestCopyState,                /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGnuTLSDigestPushBinV,                 /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -608,8 +685,8 @@ static xmlSecTransformKlass xmlSecGnuTLSSha3_384Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGnuTLSDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecGnuTLSDigestCopyState,                /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGnuTLSDigestPushBinV,                 /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -654,8 +731,8 @@ static xmlSecTransformKlass xmlSecGnuTLSSha3_512Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGnuTLSDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecGnuTLSDigestCopyState,                /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGnuTLSDigestPushBinV,                 /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -702,8 +779,8 @@ static xmlSecTransformKlass xmlSecGnuTLSGostR3411_94Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGnuTLSDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecGnuTLSDigestCopyState,                /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGnuTLSDigestPushBinV,                 /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -751,8 +828,8 @@ static xmlSecTransformKlass xmlSecGnuTLSGostR3411_2012_256Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGnuTLSDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecGnuTLSDigestCopyState,                /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGnuTLSDigestPushBinV,                 /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -797,8 +874,8 @@ static xmlSecTransformKlass xmlSecGnuTLSGostR3411_2012_512Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGnuTLSDigestExecute,                  /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecGnuTLSDigestCopyState,                /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGnuTLSDigestPushBinV,                 /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
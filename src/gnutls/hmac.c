@@ -71,9 +71,17 @@ static int      xmlSecGnuTLSHmacVerify                  (xmlSecTransformPtr tran
                                                          const xmlSecByte* data,
                                                          xmlSecSize dataSize,
                                                          xmlSecTransformCtxPtr transformCtx);
+static int      xmlSecGnuTLSHmacUpdate                  (xmlSecTransformPtr transform,
+                                                         const xmlSecByte* data,
+                                                         xmlSecSize dataSize);
 static int      xmlSecGnuTLSHmacExecute                 (xmlSecTransformPtr transform,
                                                          int last,
                                                          xmlSecTransformCtxPtr transformCtx);
+static int      xmlSecGnuTLSHmacPushBinV                (xmlSecTransformPtr transform,
+                                                         const xmlSecTransformIOVec* vec,
+                                                         xmlSecSize vecSize,
+                                                         int final,
+                                                         xmlSecTransformCtxPtr transformCtx);
 
 
 static int
@@ -302,13 +310,34 @@ xmlSecGnuTLSHmacVerify(xmlSecTransformPtr transform,
     return(0);
 }
 
+static int
+xmlSecGnuTLSHmacUpdate(xmlSecTransformPtr transform, const xmlSecByte* data, xmlSecSize dataSize) {
+    xmlSecGnuTLSHmacCtxPtr ctx;
+    int err;
+
+    xmlSecAssert2(xmlSecGnuTLSHmacCheckId(transform), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(transform, xmlSecGnuTLSHmacSize), -1);
+    xmlSecAssert2(transform->status == xmlSecTransformStatusWorking, -1);
+    xmlSecAssert2(data != NULL, -1);
+
+    ctx = xmlSecGnuTLSHmacGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->hmac != NULL, -1);
+
+    err = gnutls_hmac(ctx->hmac, data, dataSize);
+    if(err != GNUTLS_E_SUCCESS) {
+        xmlSecGnuTLSError("gnutls_hmac", err, xmlSecTransformGetName(transform));
+        return(-1);
+    }
+    return(0);
+}
+
 static int
 xmlSecGnuTLSHmacExecute(xmlSecTransformPtr transform, int last, xmlSecTransformCtxPtr transformCtx) {
     xmlSecGnuTLSHmacCtxPtr ctx;
     xmlSecBufferPtr in, out;
     xmlSecSize inSize, outSize;
     int ret;
-    int err;
 
     xmlSecAssert2(xmlSecGnuTLSHmacCheckId(transform), -1);
     xmlSecAssert2((transform->operation == xmlSecTransformOperationSign) || (transform->operation == xmlSecTransformOperationVerify), -1);
@@ -333,9 +362,9 @@ xmlSecGnuTLSHmacExecute(xmlSecTransformPtr transform, int last, xmlSecTransformC
         xmlSecAssert2(outSize == 0, -1);
 
         /* update hmac */
-        err = gnutls_hmac(ctx->hmac, xmlSecBufferGetData(in), inSize);
-        if(err != GNUTLS_E_SUCCESS) {
-            xmlSecGnuTLSError("gnutls_hmac", err, xmlSecTransformGetName(transform));
+        ret = xmlSecGnuTLSHmacUpdate(transform, xmlSecBufferGetData(in), inSize);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecGnuTLSHmacUpdate", xmlSecTransformGetName(transform));
             return(-1);
         }
 
@@ -372,6 +401,16 @@ xmlSecGnuTLSHmacExecute(xmlSecTransformPtr transform, int last, xmlSecTransformC
     return(0);
 }
 
+static int
+xmlSecGnuTLSHmacPushBinV(xmlSecTransformPtr transform, const xmlSecTransformIOVec* vec,
+                         xmlSecSize vecSize, int final, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecAssert2(xmlSecGnuTLSHmacCheckId(transform), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(transform, xmlSecGnuTLSHmacSize), -1);
+
+    return(xmlSecTransformUpdatePushBinV(transform, vec, vecSize, final, transformCtx,
+        xmlSecGnuTLSHmacUpdate));
+}
+
 
 #ifndef XMLSEC_NO_SHA1
 /******************************************************************************
@@ -402,8 +441,8 @@ static xmlSecTransformKlass xmlSecGnuTLSHmacSha1Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGnuTLSHmacExecute,                       /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGnuTLSHmacPushBinV,                   /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -448,8 +487,8 @@ static xmlSecTransformKlass xmlSecGnuTLSHmacSha256Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGnuTLSHmacExecute,                       /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGnuTLSHmacPushBinV,                   /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -494,8 +533,8 @@ static xmlSecTransformKlass xmlSecGnuTLSHmacSha384Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGnuTLSHmacExecute,                       /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGnuTLSHmacPushBinV,                   /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -540,8 +579,8 @@ static xmlSecTransformKlass xmlSecGnuTLSHmacSha512Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecGnuTLSHmacExecute,                       /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecGnuTLSHmacPushBinV,                   /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -47,6 +47,9 @@ struct _xmlSecGnuTLSX509StoreCtx {
     xmlSecPtrList certsTrusted;
     xmlSecPtrList certsUntrusted;
     xmlSecPtrList crls;
+
+    /* copies of the trusted certs and crls, used unless there are extra crls */
+    gnutls_x509_trust_list_t trustList;
 };
 
 /****************************************************************************
@@ -379,6 +382,7 @@ xmlSecGnuTLSX509StoreGetCertsChain(xmlSecGnuTLSX509StoreCtxPtr ctx, gnutls_x509_
 static int
 xmlSecGnuTLSX509StoreVerifyCert(xmlSecGnuTLSX509StoreCtxPtr ctx,
     gnutls_x509_crt_t* certs_chain, xmlSecSize certs_chain_size,
+    gnutls_x509_trust_list_t trust_list,
     gnutls_x509_crt_t* trusted,  xmlSecSize trusted_size,
     gnutls_x509_crl_t* crls, xmlSecSize crls_size,
     const xmlSecKeyInfoCtx* keyInfoCtx
@@ -418,24 +422,36 @@ xmlSecGnuTLSX509StoreVerifyCert(xmlSecGnuTLSX509StoreCtxPtr ctx,
     }
 
     XMLSEC_SAFE_CAST_SIZE_TO_UINT(certs_chain_size, certs_chain_len, return(1), NULL);
-    XMLSEC_SAFE_CAST_SIZE_TO_UINT(trusted_size, trusted_len, return(1), NULL);
-    XMLSEC_SAFE_CAST_SIZE_TO_UINT(crls_size, crls_len, return(1), NULL);
-    err = gnutls_x509_crt_list_verify(
-            certs_chain, certs_chain_len,
-            trusted, trusted_len,
-            crls, crls_len,
-            flags,
-            &verify);
-    if(err != GNUTLS_E_SUCCESS) {
-        xmlSecGnuTLSError("gnutls_x509_crt_list_verify", err, NULL);
-        return(-1);
+    if(trust_list != NULL) {
+        err = gnutls_x509_trust_list_verify_crt(trust_list,
+                certs_chain, certs_chain_len,
+                flags,
+                &verify,
+                NULL);
+        if(err != GNUTLS_E_SUCCESS) {
+            xmlSecGnuTLSError("gnutls_x509_trust_list_verify_crt", err, NULL);
+            return(-1);
+        }
+    } else {
+        XMLSEC_SAFE_CAST_SIZE_TO_UINT(trusted_size, trusted_len, return(1), NULL);
+        XMLSEC_SAFE_CAST_SIZE_TO_UINT(crls_size, crls_len, return(1), NULL);
+        err = gnutls_x509_crt_list_verify(
+                certs_chain, certs_chain_len,
+                trusted, trusted_len,
+                crls, crls_len,
+                flags,
+                &verify);
+        if(err != GNUTLS_E_SUCCESS) {
+            xmlSecGnuTLSError("gnutls_x509_crt_list_verify", err, NULL);
+            return(-1);
+        }
     }
 
     /* The certificate verification output will be put in verify and will be one or more of the
      * gnutls_certificate_status_t enumerated elements bitwise or'd. */
     if(verify != 0) {
         xmlSecOtherError2(XMLSEC_ERRORS_R_CERT_VERIFY_FAILED, NULL,
-            "gnutls_x509_crt_list_verify: verification failed: status=%u", verify);
+            "certificate verification failed: status=%u", verify);
         return(0);
     }
 
@@ -483,6 +499,7 @@ xmlSecGnuTLSX509StoreVerifyKey(xmlSecKeyDataStorePtr store, xmlSecKeyPtr key, xm
     xmlSecSize trusted_size = 0;
     gnutls_x509_crl_t* crls = NULL;
     xmlSecSize crls_size = 0;
+    gnutls_x509_trust_list_t trust_list;
     int ret;
     int res = -1;
 
@@ -517,17 +534,23 @@ xmlSecGnuTLSX509StoreVerifyKey(xmlSecKeyDataStorePtr store, xmlSecKeyPtr key, xm
         goto done;
     }
 
-    /* get trusted certs and crls lists */
-    ret = xmlSecGnuTLSX509StoreGetTrustedCerts(ctx, &trusted, &trusted_size);
-    if(ret< 0) {
-        xmlSecInternalError("xmlSecGnuTLSX509StoreGetTrustedCerts", xmlSecKeyDataStoreGetName(store));
-        goto done;
-    }
+    /* the persistent trust list has all the trusted certs and crls from the store,
+     * extra crls from the key require creating the lists for this verification */
+    if(xmlSecPtrListGetSize(key_crls) > 0) {
+        ret = xmlSecGnuTLSX509StoreGetTrustedCerts(ctx, &trusted, &trusted_size);
+        if(ret< 0) {
+            xmlSecInternalError("xmlSecGnuTLSX509StoreGetTrustedCerts", xmlSecKeyDataStoreGetName(store));
+            goto done;
+        }
 
-    ret = xmlSecGnuTLSX509StoreGetCrls(ctx, key_crls, &crls, &crls_size);
-    if(ret< 0) {
-        xmlSecInternalError("xmlSecGnuTLSX509StoreGetCrls", xmlSecKeyDataStoreGetName(store));
-        goto done;
+        ret = xmlSecGnuTLSX509StoreGetCrls(ctx, key_crls, &crls, &crls_size);
+        if(ret< 0) {
+            xmlSecInternalError("xmlSecGnuTLSX509StoreGetCrls", xmlSecKeyDataStoreGetName(store));
+            goto done;
+        }
+        trust_list = NULL;
+    } else {
+        trust_list = ctx->trustList;
     }
 
     /* prepare buffer for the certs chain */
@@ -550,6 +573,7 @@ xmlSecGnuTLSX509StoreVerifyKey(xmlSecKeyDataStorePtr store, xmlSecKeyPtr key, xm
     /* try to verify */
     ret = xmlSecGnuTLSX509StoreVerifyCert(ctx,
         certs_chain, certs_chain_cur_size,
+        trust_list,
         trusted, trusted_size,
         crls, crls_size,
         keyInfoCtx);
@@ -605,6 +629,7 @@ xmlSecGnuTLSX509StoreVerify(xmlSecKeyDataStorePtr store,
     xmlSecSize trusted_size = 0;
     gnutls_x509_crl_t * all_crls = NULL;
     xmlSecSize all_crls_size = 0;
+    gnutls_x509_trust_list_t trust_list;
     xmlSecSize ii;
     int ret;
 
@@ -622,16 +647,22 @@ xmlSecGnuTLSX509StoreVerify(xmlSecKeyDataStorePtr store,
     ctx = xmlSecGnuTLSX509StoreGetCtx(store);
     xmlSecAssert2(ctx != NULL, NULL);
 
-    /* get trusted certs and crls lists */
-    ret = xmlSecGnuTLSX509StoreGetTrustedCerts(ctx, &trusted, &trusted_size);
-    if(ret< 0) {
-        xmlSecInternalError("xmlSecGnuTLSX509StoreGetTrustedCerts", xmlSecKeyDataStoreGetName(store));
-        goto done;
-    }
-    ret = xmlSecGnuTLSX509StoreGetCrls(ctx, crls, &all_crls, &all_crls_size);
-    if(ret< 0) {
-        xmlSecInternalError("xmlSecGnuTLSX509StoreGetCrls", xmlSecKeyDataStoreGetName(store));
-        goto done;
+    /* the persistent trust list has all the trusted certs and crls from the store,
+     * extra crls require creating the lists for this verification */
+    if(xmlSecPtrListGetSize(crls) > 0) {
+        ret = xmlSecGnuTLSX509StoreGetTrustedCerts(ctx, &trusted, &trusted_size);
+        if(ret< 0) {
+            xmlSecInternalError("xmlSecGnuTLSX509StoreGetTrustedCerts", xmlSecKeyDataStoreGetName(store));
+            goto done;
+        }
+        ret = xmlSecGnuTLSX509StoreGetCrls(ctx, crls, &all_crls, &all_crls_size);
+        if(ret< 0) {
+            xmlSecInternalError("xmlSecGnuTLSX509StoreGetCrls", xmlSecKeyDataStoreGetName(store));
+            goto done;
+        }
+        trust_list = NULL;
+    } else {
+        trust_list = ctx->trustList;
     }
 
     /* prepare buffer for the certs chain */
@@ -679,6 +710,7 @@ xmlSecGnuTLSX509StoreVerify(xmlSecKeyDataStorePtr store,
         /* try to verify */
         ret = xmlSecGnuTLSX509StoreVerifyCert(ctx,
             certs_chain, certs_chain_cur_size,
+            trust_list,
             trusted, trusted_size,
             all_crls, all_crls_size,
             keyInfoCtx);
@@ -731,6 +763,25 @@ xmlSecGnuTLSX509StoreAdoptCert(xmlSecKeyDataStorePtr store, gnutls_x509_crt_t ce
     xmlSecAssert2(ctx != NULL, -1);
 
     if((type & xmlSecKeyDataTypeTrusted) != 0) {
+        gnutls_x509_crt_t trust_cert;
+
+        xmlSecAssert2(ctx->trustList != NULL, -1);
+
+        /* the trust list owns its certs */
+        trust_cert = xmlSecGnuTLSX509CertDup(cert);
+        if(trust_cert == NULL) {
+            xmlSecInternalError("xmlSecGnuTLSX509CertDup",
+                                xmlSecKeyDataStoreGetName(store));
+            return(-1);
+        }
+        ret = gnutls_x509_trust_list_add_cas(ctx->trustList, &trust_cert, 1, 0);
+        if(ret != 1) {
+            xmlSecGnuTLSError("gnutls_x509_trust_list_add_cas", ret,
+                              xmlSecKeyDataStoreGetName(store));
+            gnutls_x509_crt_deinit(trust_cert);
+            return(-1);
+        }
+
         ret = xmlSecPtrListAdd(&(ctx->certsTrusted), cert);
         if(ret < 0) {
             xmlSecInternalError("xmlSecPtrListAdd(trusted)",
@@ -763,6 +814,7 @@ xmlSecGnuTLSX509StoreAdoptCert(xmlSecKeyDataStorePtr store, gnutls_x509_crt_t ce
 int
 xmlSecGnuTLSX509StoreAdoptCrl(xmlSecKeyDataStorePtr store, gnutls_x509_crl_t crl) {
     xmlSecGnuTLSX509StoreCtxPtr ctx;
+    gnutls_x509_crl_t trust_crl;
     int ret;
 
     xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecGnuTLSX509StoreId), -1);
@@ -770,8 +822,22 @@ xmlSecGnuTLSX509StoreAdoptCrl(xmlSecKeyDataStorePtr store, gnutls_x509_crl_t crl
 
     ctx = xmlSecGnuTLSX509StoreGetCtx(store);
     xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->trustList != NULL, -1);
+
+    /* the trust list owns its crls */
+    trust_crl = xmlSecGnuTLSX509CrlDup(crl);
+    if(trust_crl == NULL) {
+        xmlSecInternalError("xmlSecGnuTLSX509CrlDup", xmlSecKeyDataStoreGetName(store));
+        return(-1);
+    }
+    ret = gnutls_x509_trust_list_add_crls(ctx->trustList, &trust_crl, 1, 0, 0);
+    if(ret != 1) {
+        xmlSecGnuTLSError("gnutls_x509_trust_list_add_crls", ret, xmlSecKeyDataStoreGetName(store));
+        gnutls_x509_crl_deinit(trust_crl);
+        return(-1);
+    }
 
-   ret = xmlSecPtrListAdd(&(ctx->crls), crl);
+    ret = xmlSecPtrListAdd(&(ctx->crls), crl);
     if(ret < 0) {
         xmlSecInternalError("xmlSecPtrListAdd(crls)", xmlSecKeyDataStoreGetName(store));
         return(-1);
@@ -815,6 +881,13 @@ xmlSecGnuTLSX509StoreInitialize(xmlSecKeyDataStorePtr store) {
         return(-1);
     }
 
+    ret = gnutls_x509_trust_list_init(&(ctx->trustList), 0);
+    if(ret != GNUTLS_E_SUCCESS) {
+        xmlSecGnuTLSError("gnutls_x509_trust_list_init", ret,
+                          xmlSecKeyDataStoreGetName(store));
+        return(-1);
+    }
+
     return(0);
 }
 
@@ -829,6 +902,9 @@ xmlSecGnuTLSX509StoreFinalize(xmlSecKeyDataStorePtr store) {
     xmlSecPtrListFinalize(&(ctx->certsTrusted));
     xmlSecPtrListFinalize(&(ctx->certsUntrusted));
     xmlSecPtrListFinalize(&(ctx->crls));
+    if(ctx->trustList != NULL) {
+        gnutls_x509_trust_list_deinit(ctx->trustList, 1);
+    }
 
     memset(ctx, 0, sizeof(xmlSecGnuTLSX509StoreCtx));
 }
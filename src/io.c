@@ -460,12 +460,15 @@ typedef struct _xmlSecInputURICtx                               xmlSecInputURICt
 struct _xmlSecInputURICtx {
     xmlSecIOCallbackPtr         clbks;
     void*                       clbksCtx;
+    xmlSecSize                  sizeHint;
 };
 
 XMLSEC_TRANSFORM_DECLARE(InputUri, xmlSecInputURICtx)
 #define xmlSecInputUriSize XMLSEC_TRANSFORM_SIZE(InputUri)
 
 static int              xmlSecTransformInputURIInitialize       (xmlSecTransformPtr transform);
+static int              xmlSecTransformInputURIGetSize          (xmlSecInputURICtxPtr ctx,
+                                                                 xmlSecSize* size);
 static void             xmlSecTransformInputURIFinalize         (xmlSecTransformPtr transform);
 static int              xmlSecTransformInputURIPopBin           (xmlSecTransformPtr transform,
                                                                  xmlSecByte* data,
@@ -524,6 +527,7 @@ xmlSecTransformInputURIGetKlass(void) {
 int
 xmlSecTransformInputURIOpen(xmlSecTransformPtr transform, const xmlChar *uri) {
     xmlSecInputURICtxPtr ctx;
+    int ret;
 
     xmlSecAssert2(xmlSecTransformCheckId(transform, xmlSecTransformInputURIId), -1);
     xmlSecAssert2(uri != NULL, -1);
@@ -568,6 +572,61 @@ xmlSecTransformInputURIOpen(xmlSecTransformPtr transform, const xmlChar *uri) {
         return(-1);
     }
 
+    /* the data size (if known) is used to pick the binary chunk size */
+    ret = xmlSecTransformInputURIGetSize(ctx, &(ctx->sizeHint));
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecTransformInputURIGetSize", xmlSecTransformGetName(transform),
+                            "uri=%s", xmlSecErrorsSafeString(uri));
+        return(-1);
+    }
+    return(0);
+}
+
+/* gets the input data size (or 0 if unknown) */
+static int
+xmlSecTransformInputURIGetSize(xmlSecInputURICtxPtr ctx, xmlSecSize* size) {
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->clbks != NULL, -1);
+    xmlSecAssert2(ctx->clbksCtx != NULL, -1);
+    xmlSecAssert2(size != NULL, -1);
+
+    (*size) = 0;
+
+#ifndef XMLSEC_NO_FILES
+    if(ctx->clbks->opencallback == xmlSecIOFileOpen) {
+        FILE* fd = (FILE*)ctx->clbksCtx;
+        long pos;
+
+        /* not seekable (e.g. pipe) means unknown size */
+        if(fseek(fd, 0, SEEK_END) != 0) {
+            clearerr(fd);
+            return(0);
+        }
+        pos = ftell(fd);
+        if(fseek(fd, 0, SEEK_SET) != 0) {
+            xmlSecIOError("fseek", NULL, NULL);
+            return(-1);
+        }
+        if(pos > 0) {
+            XMLSEC_SAFE_CAST_LONG_TO_SIZE(pos, (*size), return(-1), NULL);
+        }
+        return(0);
+    }
+#endif /* XMLSEC_NO_FILES */
+
+#ifndef XMLSEC_NO_HTTP
+    if(ctx->clbks->opencallback == xmlIOHTTPOpen) {
+        int len;
+
+        /* Content-Length header */
+        len = xmlNanoHTTPContentLength(ctx->clbksCtx);
+        if(len > 0) {
+            XMLSEC_SAFE_CAST_INT_TO_SIZE(len, (*size), return(-1), NULL);
+        }
+        return(0);
+    }
+#endif /* XMLSEC_NO_HTTP */
+
     return(0);
 }
 
@@ -595,11 +654,33 @@ xmlSecTransformInputURIClose(xmlSecTransformPtr transform) {
         ctx->clbksCtx = NULL;
         ctx->clbks = NULL;
     }
+    ctx->sizeHint = 0;
 
     /* done */
     return(0);
 }
 
+/**
+ * xmlSecTransformInputURIGetSizeHint:
+ * @transform:          the pointer to IO transform.
+ *
+ * Gets the size of the data opened by #xmlSecTransformInputURIOpen if it
+ * is known (e.g. the file size or the HTTP Content-Length header).
+ *
+ * Returns: the data size or 0 if it is unknown or an error occurs.
+ */
+xmlSecSize
+xmlSecTransformInputURIGetSizeHint(xmlSecTransformPtr transform) {
+    xmlSecInputURICtxPtr ctx;
+
+    xmlSecAssert2(xmlSecTransformCheckId(transform, xmlSecTransformInputURIId), 0);
+
+    ctx = xmlSecInputUriGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, 0);
+
+    return(ctx->sizeHint);
+}
+
 static int
 xmlSecTransformInputURIInitialize(xmlSecTransformPtr transform) {
     xmlSecInputURICtxPtr ctx;
@@ -54,6 +54,8 @@
 #include <string.h>
 
 #include <libxml/tree.h>
+#include <libxml/threads.h>
+#include <libxml/uri.h>
 
 #include <xmlsec/xmlsec.h>
 #include <xmlsec/xmltree.h>
@@ -957,6 +959,611 @@ xmlSecKeyDataValueXmlWrite(xmlSecKeyDataId id, xmlSecKeyPtr key, xmlNodePtr node
     return(0);
 }
 
+/**************************************************************************
+ *
+ * &lt;dsig:RetrievalMethod/&gt; and &lt;dsig11:KeyInfoReference/&gt; results cache
+ *
+ *************************************************************************/
+#define XMLSEC_RETRIEVAL_CACHE_DEFAULT_MAX_ENTRIES      64
+#define XMLSEC_RETRIEVAL_CACHE_DEFAULT_MAX_SIZE         (1024 * 1024)
+#define XMLSEC_RETRIEVAL_CACHE_DEFAULT_TTL              300
+
+typedef struct _xmlSecRetrievalCacheEntry               xmlSecRetrievalCacheEntry,
+                                                        *xmlSecRetrievalCacheEntryPtr;
+struct _xmlSecRetrievalCacheEntry {
+    xmlChar*            key;            /* element + type + uri + transforms */
+    xmlSecBuffer        result;         /* transforms result */
+    xmlDocPtr           doc;            /* parsed result for XML data */
+    time_t              created;
+    xmlSecSize          lastUsed;
+    xmlSecSize          refs;
+    int                 cached;
+};
+
+typedef struct _xmlSecRetrievalCacheCtx                 xmlSecRetrievalCacheCtx,
+                                                        *xmlSecRetrievalCacheCtxPtr;
+struct _xmlSecRetrievalCacheCtx {
+    xmlSecPtrList       entries;
+    xmlSecSize          totalSize;
+    xmlSecSize          usageCounter;
+    xmlMutexPtr         mutex;
+
+    /* limits */
+    xmlSecSize          maxEntries;
+    xmlSecSize          maxSize;
+    time_t              ttl;
+};
+
+XMLSEC_KEY_DATA_STORE_DECLARE(RetrievalCache, xmlSecRetrievalCacheCtx)
+#define xmlSecRetrievalCacheSize XMLSEC_KEY_DATA_STORE_SIZE(RetrievalCache)
+
+static int              xmlSecRetrievalCacheInitialize          (xmlSecKeyDataStorePtr store);
+static void             xmlSecRetrievalCacheFinalize            (xmlSecKeyDataStorePtr store);
+
+static xmlSecKeyDataStoreKlass xmlSecRetrievalCacheKlass = {
+    sizeof(xmlSecKeyDataStoreKlass),
+    xmlSecRetrievalCacheSize,
+
+    /* data */
+    xmlSecNameRetrievalCacheStore,              /* const xmlChar* name; */
+
+    /* constructors/destructor */
+    xmlSecRetrievalCacheInitialize,             /* xmlSecKeyDataStoreInitializeMethod initialize; */
+    xmlSecRetrievalCacheFinalize,               /* xmlSecKeyDataStoreFinalizeMethod finalize; */
+
+    /* reserved for the future */
+    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* void* reserved1; */
+};
+
+static void             xmlSecRetrievalCacheEntryDestroy        (xmlSecRetrievalCacheEntryPtr entry);
+
+static xmlSecPtrListKlass xmlSecRetrievalCacheEntriesListKlass = {
+    BAD_CAST "retrieval-cache-entries-list",
+    NULL,                                                       /* xmlSecPtrDuplicateItemMethod duplicateItem; */
+    (xmlSecPtrDestroyItemMethod)xmlSecRetrievalCacheEntryDestroy,/* xmlSecPtrDestroyItemMethod destroyItem; */
+    NULL,                                                       /* xmlSecPtrDebugDumpItemMethod debugDumpItem; */
+    NULL,                                                       /* xmlSecPtrDebugDumpItemMethod debugXmlDumpItem; */
+};
+
+/**
+ * xmlSecKeyDataStoreRetrievalCacheGetKlass:
+ *
+ * The &lt;dsig:RetrievalMethod/&gt; and &lt;dsig11:KeyInfoReference/&gt; results
+ * cache store klass. The store caches the results of dereferencing external
+ * (i.e. not same document) URIs after applying the transforms together with
+ * the parsed XML documents. The cache entries are keyed by the element, the
+ * retrieval type, the absolute URI (resolved against the document URL) and
+ * the &lt;dsig:Transforms/&gt; element content. Same document references and
+ * the URIs that can't be resolved to an absolute URI (e.g. a relative URI in
+ * a document without URL) are never cached because they depend on
+ * the document being processed.
+ *
+ * To enable the cache, create the store and add it to the keys manager
+ * with #xmlSecKeysMngrAdoptDataStore function. The cache is protected by
+ * a mutex and can be shared between threads together with the keys manager.
+ *
+ * Returns: the retrieval results cache store klass.
+ */
+xmlSecKeyDataStoreId
+xmlSecKeyDataStoreRetrievalCacheGetKlass(void) {
+    return(&xmlSecRetrievalCacheKlass);
+}
+
+/**
+ * xmlSecKeyDataStoreRetrievalCacheSetLimits:
+ * @store:              the pointer to retrieval results cache store.
+ * @maxEntries:         the max number of entries in the cache (0 for no limit).
+ * @maxSize:            the max total size of the cached results in bytes (0 for no limit).
+ * @ttl:                the time to live for the cache entries in seconds (0 for no limit).
+ *
+ * Sets the cache limits. The least recently used entries are removed when
+ * the cache is full, the expired entries are removed on lookup. By default,
+ * the cache holds up to 64 entries with total size up to 1MB for 5 minutes.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecKeyDataStoreRetrievalCacheSetLimits(xmlSecKeyDataStorePtr store, xmlSecSize maxEntries,
+                                          xmlSecSize maxSize, time_t ttl) {
+    xmlSecRetrievalCacheCtxPtr ctx;
+
+    xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecKeyDataStoreRetrievalCacheId), -1);
+    xmlSecAssert2(ttl >= 0, -1);
+
+    ctx = xmlSecRetrievalCacheGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    xmlMutexLock(ctx->mutex);
+    ctx->maxEntries = maxEntries;
+    ctx->maxSize    = maxSize;
+    ctx->ttl        = ttl;
+    xmlMutexUnlock(ctx->mutex);
+    return(0);
+}
+
+/**
+ * xmlSecKeyDataStoreRetrievalCacheEmpty:
+ * @store:              the pointer to retrieval results cache store.
+ *
+ * Removes all the entries from the cache.
+ */
+void
+xmlSecKeyDataStoreRetrievalCacheEmpty(xmlSecKeyDataStorePtr store) {
+    xmlSecRetrievalCacheCtxPtr ctx;
+    xmlSecRetrievalCacheEntryPtr entry;
+    xmlSecSize pos, size;
+
+    xmlSecAssert(xmlSecKeyDataStoreCheckId(store, xmlSecKeyDataStoreRetrievalCacheId));
+
+    ctx = xmlSecRetrievalCacheGetCtx(store);
+    xmlSecAssert(ctx != NULL);
+
+    xmlMutexLock(ctx->mutex);
+    size = xmlSecPtrListGetSize(&(ctx->entries));
+    for(pos = 0; pos < size; ++pos) {
+        entry = (xmlSecRetrievalCacheEntryPtr)xmlSecPtrListRemoveAndReturn(&(ctx->entries), pos);
+        if(entry == NULL) {
+            continue;
+        }
+        /* the entry in use is destroyed when released */
+        entry->cached = 0;
+        if(entry->refs == 0) {
+            xmlSecRetrievalCacheEntryDestroy(entry);
+        }
+    }
+    ctx->totalSize = 0;
+    xmlMutexUnlock(ctx->mutex);
+}
+
+static int
+xmlSecRetrievalCacheInitialize(xmlSecKeyDataStorePtr store) {
+    xmlSecRetrievalCacheCtxPtr ctx;
+    int ret;
+
+    xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecKeyDataStoreRetrievalCacheId), -1);
+
+    ctx = xmlSecRetrievalCacheGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+    memset(ctx, 0, sizeof(xmlSecRetrievalCacheCtx));
+
+    ret = xmlSecPtrListInitialize(&(ctx->entries), &xmlSecRetrievalCacheEntriesListKlass);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInitialize", xmlSecKeyDataStoreGetName(store));
+        return(-1);
+    }
+
+    ctx->mutex = xmlNewMutex();
+    if(ctx->mutex == NULL) {
+        xmlSecXmlError("xmlNewMutex", xmlSecKeyDataStoreGetName(store));
+        return(-1);
+    }
+
+    ctx->maxEntries = XMLSEC_RETRIEVAL_CACHE_DEFAULT_MAX_ENTRIES;
+    ctx->maxSize    = XMLSEC_RETRIEVAL_CACHE_DEFAULT_MAX_SIZE;
+    ctx->ttl        = XMLSEC_RETRIEVAL_CACHE_DEFAULT_TTL;
+    return(0);
+}
+
+static void
+xmlSecRetrievalCacheFinalize(xmlSecKeyDataStorePtr store) {
+    xmlSecRetrievalCacheCtxPtr ctx;
+
+    xmlSecAssert(xmlSecKeyDataStoreCheckId(store, xmlSecKeyDataStoreRetrievalCacheId));
+
+    ctx = xmlSecRetrievalCacheGetCtx(store);
+    xmlSecAssert(ctx != NULL);
+
+    if(xmlSecPtrListIsValid(&(ctx->entries))) {
+        xmlSecPtrListFinalize(&(ctx->entries));
+    }
+    if(ctx->mutex != NULL) {
+        xmlFreeMutex(ctx->mutex);
+    }
+    memset(ctx, 0, sizeof(xmlSecRetrievalCacheCtx));
+}
+
+static xmlSecRetrievalCacheEntryPtr
+xmlSecRetrievalCacheEntryCreate(const xmlSecByte* data, xmlSecSize dataSize, int parseXml) {
+    xmlSecRetrievalCacheEntryPtr entry;
+    int dataLen;
+    int ret;
+
+    xmlSecAssert2(data != NULL, NULL);
+
+    entry = (xmlSecRetrievalCacheEntryPtr)xmlMalloc(sizeof(xmlSecRetrievalCacheEntry));
+    if(entry == NULL) {
+        xmlSecMallocError(sizeof(xmlSecRetrievalCacheEntry), NULL);
+        return(NULL);
+    }
+    memset(entry, 0, sizeof(xmlSecRetrievalCacheEntry));
+
+    ret = xmlSecBufferInitialize(&(entry->result), 0);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecBufferInitialize", NULL);
+        xmlFree(entry);
+        return(NULL);
+    }
+    ret = xmlSecBufferSetData(&(entry->result), data, dataSize);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecBufferSetData", NULL,
+            "size=" XMLSEC_SIZE_FMT, dataSize);
+        xmlSecRetrievalCacheEntryDestroy(entry);
+        return(NULL);
+    }
+
+    if(parseXml != 0) {
+        XMLSEC_SAFE_CAST_SIZE_TO_INT(dataSize, dataLen, xmlSecRetrievalCacheEntryDestroy(entry); return(NULL), NULL);
+        entry->doc = xmlReadMemory((const char*)data, dataLen, NULL, NULL,
+            xmlSecParserGetDefaultOptions() | XML_PARSE_RECOVER);
+        if(entry->doc == NULL) {
+            xmlSecXmlError("xmlReadMemory", NULL);
+            xmlSecRetrievalCacheEntryDestroy(entry);
+            return(NULL);
+        }
+    }
+
+    entry->created = time(NULL);
+    entry->refs = 1;
+    return(entry);
+}
+
+static void
+xmlSecRetrievalCacheEntryDestroy(xmlSecRetrievalCacheEntryPtr entry) {
+    xmlSecAssert(entry != NULL);
+
+    if(entry->key != NULL) {
+        xmlFree(entry->key);
+    }
+    if(entry->doc != NULL) {
+        xmlFreeDoc(entry->doc);
+    }
+    xmlSecBufferFinalize(&(entry->result));
+    memset(entry, 0, sizeof(xmlSecRetrievalCacheEntry));
+    xmlFree(entry);
+}
+
+/* resolves @uri against the @doc URL, returns NULL if the result is not an absolute URI */
+static xmlChar*
+xmlSecRetrievalCacheResolveUri(const xmlChar* uri, xmlDocPtr doc) {
+    xmlURIPtr parsed;
+    xmlChar* res;
+    int absolute;
+
+    xmlSecAssert2(uri != NULL, NULL);
+    xmlSecAssert2(doc != NULL, NULL);
+
+    if(doc->URL != NULL) {
+        res = xmlBuildURI(uri, doc->URL);
+    } else {
+        res = xmlStrdup(uri);
+    }
+    if(res == NULL) {
+        return(NULL);
+    }
+
+    parsed = xmlParseURI((const char*)res);
+    if(parsed == NULL) {
+        xmlFree(res);
+        return(NULL);
+    }
+    absolute = ((parsed->scheme != NULL) || ((parsed->path != NULL) && (parsed->path[0] == '/'))) ? 1 : 0;
+    xmlFreeURI(parsed);
+
+    if(absolute == 0) {
+        xmlFree(res);
+        return(NULL);
+    }
+    return(res);
+}
+
+/* builds the cache key from the element name, type, absolute uri and Transforms node */
+static xmlChar*
+xmlSecRetrievalCacheGetKey(xmlSecKeyDataId id, const xmlChar* type, const xmlChar* absUri,
+                           xmlNodePtr transformsNode) {
+    xmlBufferPtr buffer;
+    xmlChar* res;
+
+    xmlSecAssert2(id != NULL, NULL);
+    xmlSecAssert2(absUri != NULL, NULL);
+
+    buffer = xmlBufferCreate();
+    if(buffer == NULL) {
+        xmlSecXmlError("xmlBufferCreate", xmlSecKeyDataKlassGetName(id));
+        return(NULL);
+    }
+    xmlBufferCat(buffer, xmlSecKeyDataKlassGetName(id));
+    xmlBufferCCat(buffer, "\n");
+    if(type != NULL) {
+        xmlBufferCat(buffer, type);
+    }
+    xmlBufferCCat(buffer, "\n");
+    xmlBufferCat(buffer, absUri);
+    xmlBufferCCat(buffer, "\n");
+    if(transformsNode != NULL) {
+        xmlNodeDump(buffer, transformsNode->doc, transformsNode, 0, 0);
+    }
+
+    res = xmlStrdup(xmlBufferContent(buffer));
+    if(res == NULL) {
+        xmlSecStrdupError(xmlBufferContent(buffer), xmlSecKeyDataKlassGetName(id));
+        xmlBufferFree(buffer);
+        return(NULL);
+    }
+    xmlBufferFree(buffer);
+    return(res);
+}
+
+/* removes the entry at @pos from the cache, the caller should hold the mutex */
+static void
+xmlSecRetrievalCacheRemove(xmlSecRetrievalCacheCtxPtr ctx, xmlSecSize pos) {
+    xmlSecRetrievalCacheEntryPtr entry;
+
+    xmlSecAssert(ctx != NULL);
+
+    entry = (xmlSecRetrievalCacheEntryPtr)xmlSecPtrListRemoveAndReturn(&(ctx->entries), pos);
+    if(entry == NULL) {
+        return;
+    }
+    xmlSecAssert(ctx->totalSize >= xmlSecBufferGetSize(&(entry->result)));
+    ctx->totalSize -= xmlSecBufferGetSize(&(entry->result));
+
+    /* the entry in use is destroyed when released */
+    entry->cached = 0;
+    if(entry->refs == 0) {
+        xmlSecRetrievalCacheEntryDestroy(entry);
+    }
+}
+
+/* returns the entry for @key (the caller must release it) or NULL if not found */
+static xmlSecRetrievalCacheEntryPtr
+xmlSecRetrievalCacheFind(xmlSecKeyDataStorePtr store, const xmlChar* key) {
+    xmlSecRetrievalCacheCtxPtr ctx;
+    xmlSecRetrievalCacheEntryPtr entry;
+    xmlSecRetrievalCacheEntryPtr res = NULL;
+    xmlSecSize pos, size;
+    time_t now;
+
+    xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecKeyDataStoreRetrievalCacheId), NULL);
+    xmlSecAssert2(key != NULL, NULL);
+
+    ctx = xmlSecRetrievalCacheGetCtx(store);
+    xmlSecAssert2(ctx != NULL, NULL);
+
+    now = time(NULL);
+    xmlMutexLock(ctx->mutex);
+    size = xmlSecPtrListGetSize(&(ctx->entries));
+    for(pos = 0; pos < size; ++pos) {
+        entry = (xmlSecRetrievalCacheEntryPtr)xmlSecPtrListGetItem(&(ctx->entries), pos);
+        if((entry == NULL) || (!xmlStrEqual(entry->key, key))) {
+            continue;
+        }
+
+        /* expired? */
+        if((ctx->ttl > 0) && ((now < entry->created) || (now - entry->created >= ctx->ttl))) {
+            xmlSecRetrievalCacheRemove(ctx, pos);
+            break;
+        }
+
+        entry->lastUsed = ++ctx->usageCounter;
+        ++entry->refs;
+        res = entry;
+        break;
+    }
+    xmlMutexUnlock(ctx->mutex);
+    return(res);
+}
+
+/* adds the @entry to the cache replacing the one with the same key and removing
+ * the least recently used entries to fit the cache limits */
+static int
+xmlSecRetrievalCacheAdd(xmlSecKeyDataStorePtr store, xmlSecRetrievalCacheEntryPtr entry) {
+    xmlSecRetrievalCacheCtxPtr ctx;
+    xmlSecRetrievalCacheEntryPtr cur, lru;
+    xmlSecSize pos, size, freePos, entrySize, entriesNum, lruPos;
+    int ret;
+    int res = -1;
+
+    xmlSecAssert2(xmlSecKeyDataStoreCheckId(store, xmlSecKeyDataStoreRetrievalCacheId), -1);
+    xmlSecAssert2(entry != NULL, -1);
+    xmlSecAssert2(entry->key != NULL, -1);
+    xmlSecAssert2(entry->cached == 0, -1);
+
+    ctx = xmlSecRetrievalCacheGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    entrySize = xmlSecBufferGetSize(&(entry->result));
+
+    xmlMutexLock(ctx->mutex);
+
+    /* too big to be cached */
+    if((ctx->maxSize > 0) && (entrySize > ctx->maxSize)) {
+        res = 0;
+        goto done;
+    }
+
+    /* remove the old entry with the same key */
+    size = xmlSecPtrListGetSize(&(ctx->entries));
+    for(pos = 0; pos < size; ++pos) {
+        cur = (xmlSecRetrievalCacheEntryPtr)xmlSecPtrListGetItem(&(ctx->entries), pos);
+        if((cur != NULL) && (xmlStrEqual(cur->key, entry->key))) {
+            xmlSecRetrievalCacheRemove(ctx, pos);
+            break;
+        }
+    }
+
+    /* evict the least recently used entries until the new one fits */
+    while(1) {
+        entriesNum = 0;
+        lru = NULL;
+        lruPos = freePos = size = xmlSecPtrListGetSize(&(ctx->entries));
+        for(pos = 0; pos < size; ++pos) {
+            cur = (xmlSecRetrievalCacheEntryPtr)xmlSecPtrListGetItem(&(ctx->entries), pos);
+            if(cur == NULL) {
+                if(freePos >= size) {
+                    freePos = pos;
+                }
+                continue;
+            }
+            ++entriesNum;
+            if((lru == NULL) || (cur->lastUsed < lru->lastUsed)) {
+                lru = cur;
+                lruPos = pos;
+            }
+        }
+        if(((ctx->maxEntries == 0) || (entriesNum < ctx->maxEntries)) &&
+           ((ctx->maxSize == 0) || (ctx->totalSize + entrySize <= ctx->maxSize))) {
+            break;
+        }
+        if(lru == NULL) {
+            break;
+        }
+        xmlSecRetrievalCacheRemove(ctx, lruPos);
+    }
+
+    /* re-use an empty slot if any */
+    if(freePos < size) {
+        ret = xmlSecPtrListSet(&(ctx->entries), entry, freePos);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecPtrListSet", xmlSecKeyDataStoreGetName(store));
+            goto done;
+        }
+    } else {
+        ret = xmlSecPtrListAdd(&(ctx->entries), entry);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecPtrListAdd", xmlSecKeyDataStoreGetName(store));
+            goto done;
+        }
+    }
+    ctx->totalSize += entrySize;
+    entry->lastUsed = ++ctx->usageCounter;
+    entry->cached = 1;
+
+    /* success */
+    res = 0;
+
+done:
+    xmlMutexUnlock(ctx->mutex);
+    return(res);
+}
+
+/* releases the @entry returned by xmlSecKeyInfoRetrieve(), @store might be NULL */
+static void
+xmlSecKeyDataStoreRetrievalCacheRelease(xmlSecKeyDataStorePtr store, xmlSecRetrievalCacheEntryPtr entry) {
+    xmlSecRetrievalCacheCtxPtr ctx;
+
+    xmlSecAssert(entry != NULL);
+    xmlSecAssert(entry->refs > 0);
+
+    if(store == NULL) {
+        xmlSecAssert(entry->cached == 0);
+        xmlSecRetrievalCacheEntryDestroy(entry);
+        return;
+    }
+
+    ctx = xmlSecRetrievalCacheGetCtx(store);
+    xmlSecAssert(ctx != NULL);
+
+    xmlMutexLock(ctx->mutex);
+    --entry->refs;
+    if((entry->refs == 0) && (entry->cached == 0)) {
+        xmlSecRetrievalCacheEntryDestroy(entry);
+    }
+    xmlMutexUnlock(ctx->mutex);
+}
+
+/* returns the results cache store if the @uri results can be cached */
+static xmlSecKeyDataStorePtr
+xmlSecKeyInfoCtxGetRetrievalCache(xmlSecKeyInfoCtxPtr keyInfoCtx, const xmlChar* uri) {
+    xmlSecAssert2(keyInfoCtx != NULL, NULL);
+
+    /* same document references depend on the current document */
+    if((keyInfoCtx->keysMngr == NULL) || (uri == NULL) || (uri[0] == '\0') || (uri[0] == '#')) {
+        return(NULL);
+    }
+    return(xmlSecKeysMngrGetDataStore(keyInfoCtx->keysMngr, xmlSecKeyDataStoreRetrievalCacheId));
+}
+
+/* dereferences the URI and executes the transforms or finds the results in the
+ * @cacheStore (might be NULL); the returned entry should be released with
+ * xmlSecKeyDataStoreRetrievalCacheRelease() */
+static xmlSecRetrievalCacheEntryPtr
+xmlSecKeyInfoRetrieve(xmlSecKeyDataId id, xmlSecTransformCtxPtr transformCtx, xmlNodePtr node,
+                      const xmlChar* type, const xmlChar* uri, xmlNodePtr transformsNode,
+                      int parseXml, xmlSecKeyDataStorePtr cacheStore) {
+    xmlSecRetrievalCacheEntryPtr entry = NULL;
+    xmlChar* key = NULL;
+    int ret;
+
+    xmlSecAssert2(id != NULL, NULL);
+    xmlSecAssert2(transformCtx != NULL, NULL);
+    xmlSecAssert2(node != NULL, NULL);
+    xmlSecAssert2(node->doc != NULL, NULL);
+
+    /* try the cache first (the same relative URI in different documents
+     * might point to different resources, don't cache if we can't resolve it) */
+    if(cacheStore != NULL) {
+        xmlChar* absUri;
+
+        xmlSecAssert2(uri != NULL, NULL);
+
+        absUri = xmlSecRetrievalCacheResolveUri(uri, node->doc);
+        if(absUri != NULL) {
+            key = xmlSecRetrievalCacheGetKey(id, type, absUri, transformsNode);
+            xmlFree(absUri);
+            if(key == NULL) {
+                xmlSecInternalError("xmlSecRetrievalCacheGetKey", xmlSecKeyDataKlassGetName(id));
+                return(NULL);
+            }
+            entry = xmlSecRetrievalCacheFind(cacheStore, key);
+            if(entry != NULL) {
+                xmlFree(key);
+                return(entry);
+            }
+        } else {
+            cacheStore = NULL;
+        }
+    }
+
+    /* get transforms results */
+    ret = xmlSecTransformCtxExecute(transformCtx, node->doc);
+    if((ret < 0) || (transformCtx->result == NULL) || (xmlSecBufferGetData(transformCtx->result) == NULL)) {
+        xmlSecInternalError("xmlSecTransformCtxExecute", xmlSecKeyDataKlassGetName(id));
+        goto error;
+    }
+
+    entry = xmlSecRetrievalCacheEntryCreate(xmlSecBufferGetData(transformCtx->result),
+        xmlSecBufferGetSize(transformCtx->result), parseXml);
+    if(entry == NULL) {
+        xmlSecInternalError("xmlSecRetrievalCacheEntryCreate", xmlSecKeyDataKlassGetName(id));
+        goto error;
+    }
+
+    /* and store it in the cache */
+    if(cacheStore != NULL) {
+        entry->key = key;
+        key = NULL;
+
+        ret = xmlSecRetrievalCacheAdd(cacheStore, entry);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecRetrievalCacheAdd", xmlSecKeyDataKlassGetName(id));
+            goto error;
+        }
+    }
+
+    /* done */
+    return(entry);
+
+error:
+    if(entry != NULL) {
+        xmlSecRetrievalCacheEntryDestroy(entry);
+    }
+    if(key != NULL) {
+        xmlFree(key);
+    }
+    return(NULL);
+}
+
 /**************************************************************************
  *
  * &lt;dsig:RetrievalMethod/&gt; processing
@@ -1012,8 +1619,7 @@ static xmlSecKeyDataKlass xmlSecKeyDataRetrievalMethodKlass = {
 
 static int                      xmlSecKeyDataRetrievalMethodReadXmlResult(xmlSecKeyDataId typeId,
                                                                  xmlSecKeyPtr key,
-                                                                 const xmlChar* buffer,
-                                                                 xmlSecSize bufferSize,
+                                                                 xmlDocPtr doc,
                                                                  xmlSecKeyInfoCtxPtr keyInfoCtx);
 
 /**
@@ -1042,9 +1648,13 @@ xmlSecKeyDataRetrievalMethodGetKlass(void) {
 static int
 xmlSecKeyDataRetrievalMethodXmlRead(xmlSecKeyDataId id, xmlSecKeyPtr key, xmlNodePtr node, xmlSecKeyInfoCtxPtr keyInfoCtx) {
     xmlSecKeyDataId dataId = xmlSecKeyDataIdUnknown;
+    xmlSecKeyDataStorePtr cacheStore = NULL;
+    xmlSecRetrievalCacheEntryPtr entry = NULL;
     xmlChar *retrType = NULL;
     xmlChar *uri = NULL;
+    xmlNodePtr transformsNode = NULL;
     xmlNodePtr cur;
+    int isXml;
     int res = -1;
     int ret;
 
@@ -1103,6 +1713,7 @@ xmlSecKeyDataRetrievalMethodXmlRead(xmlSecKeyDataId id, xmlSecKeyPtr key, xmlNod
     /* the only one node is optional Transforms node */
     cur = xmlSecGetNextElementNode(node->children);
     if((cur != NULL) && (xmlSecCheckNodeName(cur, xmlSecNodeTransforms, xmlSecDSigNs))) {
+        transformsNode = cur;
         ret = xmlSecTransformCtxNodesListRead(&(keyInfoCtx->retrievalMethodCtx),
                                             cur, xmlSecTransformUsageDSigTransform);
         if(ret < 0) {
@@ -1120,26 +1731,24 @@ xmlSecKeyDataRetrievalMethodXmlRead(xmlSecKeyDataId id, xmlSecKeyPtr key, xmlNod
         goto done;
     }
 
-    /* finally get transforms results */
-    ret = xmlSecTransformCtxExecute(&(keyInfoCtx->retrievalMethodCtx), node->doc);
-    if((ret < 0) ||
-       (keyInfoCtx->retrievalMethodCtx.result == NULL) ||
-       (xmlSecBufferGetData(keyInfoCtx->retrievalMethodCtx.result) == NULL)) {
-
-        xmlSecInternalError("xmlSecTransformCtxExecute",
+    /* assume that the data is in XML if we could not find id */
+    isXml = ((dataId == xmlSecKeyDataIdUnknown) ||
+             ((dataId->usage & xmlSecKeyDataUsageRetrievalMethodNodeXml) != 0)) ? 1 : 0;
+
+    /* finally get transforms results (or the cached ones) */
+    cacheStore = xmlSecKeyInfoCtxGetRetrievalCache(keyInfoCtx, uri);
+    entry = xmlSecKeyInfoRetrieve(id, &(keyInfoCtx->retrievalMethodCtx), node,
+                    retrType, uri, transformsNode, isXml, cacheStore);
+    if(entry == NULL) {
+        xmlSecInternalError("xmlSecKeyInfoRetrieve",
                             xmlSecKeyDataKlassGetName(id));
         goto done;
     }
 
+    if(isXml != 0) {
+        xmlSecAssert2(entry->doc != NULL, -1);
 
-    /* assume that the data is in XML if we could not find id */
-    if((dataId == xmlSecKeyDataIdUnknown) ||
-       ((dataId->usage & xmlSecKeyDataUsageRetrievalMethodNodeXml) != 0)) {
-
-        ret = xmlSecKeyDataRetrievalMethodReadXmlResult(dataId, key,
-                    xmlSecBufferGetData(keyInfoCtx->retrievalMethodCtx.result),
-                    xmlSecBufferGetSize(keyInfoCtx->retrievalMethodCtx.result),
-                    keyInfoCtx);
+        ret = xmlSecKeyDataRetrievalMethodReadXmlResult(dataId, key, entry->doc, keyInfoCtx);
         if(ret < 0) {
             xmlSecInternalError("xmlSecKeyDataRetrievalMethodReadXmlResult",
                                 xmlSecKeyDataKlassGetName(id));
@@ -1147,8 +1756,8 @@ xmlSecKeyDataRetrievalMethodXmlRead(xmlSecKeyDataId id, xmlSecKeyPtr key, xmlNod
         }
     } else {
         ret = xmlSecKeyDataBinRead(dataId, key,
-                    xmlSecBufferGetData(keyInfoCtx->retrievalMethodCtx.result),
-                    xmlSecBufferGetSize(keyInfoCtx->retrievalMethodCtx.result),
+                    xmlSecBufferGetData(&(entry->result)),
+                    xmlSecBufferGetSize(&(entry->result)),
                     keyInfoCtx);
         if(ret < 0) {
             xmlSecInternalError("xmlSecKeyDataBinRead",
@@ -1160,6 +1769,9 @@ xmlSecKeyDataRetrievalMethodXmlRead(xmlSecKeyDataId id, xmlSecKeyPtr key, xmlNod
 
     res = 0;
 done:
+    if(entry != NULL) {
+        xmlSecKeyDataStoreRetrievalCacheRelease(cacheStore, entry);
+    }
     if(uri != NULL) {
         xmlFree(uri);
     }
@@ -1183,33 +1795,21 @@ xmlSecKeyDataRetrievalMethodXmlWrite(xmlSecKeyDataId id, xmlSecKeyPtr key, xmlNo
 
 static int
 xmlSecKeyDataRetrievalMethodReadXmlResult(xmlSecKeyDataId typeId, xmlSecKeyPtr key,
-                                          const xmlChar* buffer, xmlSecSize bufferSize,
-                                          xmlSecKeyInfoCtxPtr keyInfoCtx) {
-    xmlDocPtr doc;
+                                          xmlDocPtr doc, xmlSecKeyInfoCtxPtr keyInfoCtx) {
     xmlNodePtr cur;
     const xmlChar* nodeName;
     const xmlChar* nodeNs;
     xmlSecKeyDataId dataId;
-    int bufferLen;
     int ret;
 
     xmlSecAssert2(key != NULL, -1);
-    xmlSecAssert2(buffer != NULL, -1);
-    xmlSecAssert2(bufferSize > 0, -1);
+    xmlSecAssert2(doc != NULL, -1);
     xmlSecAssert2(keyInfoCtx != NULL, -1);
     xmlSecAssert2(keyInfoCtx->mode == xmlSecKeyInfoModeRead, -1);
 
-    XMLSEC_SAFE_CAST_SIZE_TO_INT(bufferSize, bufferLen, return(-1), NULL);
-    doc = xmlReadMemory((const char*)buffer, bufferLen, NULL, NULL, xmlSecParserGetDefaultOptions() | XML_PARSE_RECOVER);
-    if(doc == NULL) {
-        xmlSecXmlError("xmlReadMemory", xmlSecKeyDataKlassGetName(typeId));
-        return(-1);
-    }
-
     cur = xmlDocGetRootElement(doc);
     if(cur == NULL) {
         xmlSecXmlError("xmlDocGetRootElement", xmlSecKeyDataKlassGetName(typeId));
-        xmlFreeDoc(doc);
         return(-1);
     }
 
@@ -1225,8 +1825,6 @@ xmlSecKeyDataRetrievalMethodReadXmlResult(xmlSecKeyDataId typeId, xmlSecKeyPtr k
                             nodeName, nodeNs, xmlSecKeyDataUsageRetrievalMethodNodeXml);
     }
     if(dataId == xmlSecKeyDataIdUnknown) {
-        xmlFreeDoc(doc);
-
         /* laxi schema validation but application can disable it */
         if((keyInfoCtx->flags & XMLSEC_KEYINFO_FLAGS_KEYVALUE_STOP_ON_UNKNOWN_CHILD) != 0) {
             xmlSecUnexpectedNodeError(cur, xmlSecKeyDataKlassGetName(typeId));
@@ -1239,7 +1837,6 @@ xmlSecKeyDataRetrievalMethodReadXmlResult(xmlSecKeyDataId typeId, xmlSecKeyPtr k
         xmlSecOtherError2(XMLSEC_ERRORS_R_MAX_RETRIEVAL_TYPE_MISMATCH,
                           xmlSecKeyDataKlassGetName(dataId),
                           "typeId=%s", xmlSecErrorsSafeString(xmlSecKeyDataKlassGetName(typeId)));
-        xmlFreeDoc(doc);
         return(-1);
     }
 
@@ -1250,11 +1847,9 @@ xmlSecKeyDataRetrievalMethodReadXmlResult(xmlSecKeyDataId typeId, xmlSecKeyPtr k
                              xmlSecKeyDataKlassGetName(typeId),
                              "node=%s",
                              xmlSecErrorsSafeString(xmlSecNodeGetName(cur)));
-        xmlFreeDoc(doc);
         return(-1);
     }
 
-    xmlFreeDoc(doc);
     return(0);
 }
 
@@ -1314,8 +1909,7 @@ static xmlSecKeyDataKlass xmlSecKeyDataKeyInfoReferenceKlass = {
 
 static int                      xmlSecKeyDataKeyInfoReferenceReadXmlResult(xmlSecKeyDataId typeId,
                                                                  xmlSecKeyPtr key,
-                                                                 const xmlChar* buffer,
-                                                                 xmlSecSize bufferSize,
+                                                                 xmlDocPtr doc,
                                                                  xmlSecKeyInfoCtxPtr keyInfoCtx);
 
 /**
@@ -1350,6 +1944,8 @@ xmlSecKeyDataKeyInfoReferenceGetKlass(void) {
 static int
 xmlSecKeyDataKeyInfoReferenceXmlRead(xmlSecKeyDataId id, xmlSecKeyPtr key, xmlNodePtr node, xmlSecKeyInfoCtxPtr keyInfoCtx) {
     xmlSecKeyDataId dataId = xmlSecKeyDataIdUnknown;
+    xmlSecKeyDataStorePtr cacheStore = NULL;
+    xmlSecRetrievalCacheEntryPtr entry = NULL;
     xmlChar *uri = NULL;
     xmlNodePtr cur;
     int res = -1;
@@ -1393,24 +1989,19 @@ xmlSecKeyDataKeyInfoReferenceXmlRead(xmlSecKeyDataId id, xmlSecKeyPtr key, xmlNo
         goto done;
     }
 
-    /* get transforms results */
-    ret = xmlSecTransformCtxExecute(&(keyInfoCtx->keyInfoReferenceCtx), node->doc);
-    if(
-        (ret < 0) ||
-        (keyInfoCtx->keyInfoReferenceCtx.result == NULL) ||
-        (xmlSecBufferGetData(keyInfoCtx->keyInfoReferenceCtx.result) == NULL)
-    ) {
-
-        xmlSecInternalError("xmlSecTransformCtxExecute", xmlSecKeyDataKlassGetName(id));
+    /* get transforms results (or the cached ones) */
+    cacheStore = xmlSecKeyInfoCtxGetRetrievalCache(keyInfoCtx, uri);
+    entry = xmlSecKeyInfoRetrieve(id, &(keyInfoCtx->keyInfoReferenceCtx), node,
+                    NULL, uri, NULL, 1, cacheStore);
+    if(entry == NULL) {
+        xmlSecInternalError("xmlSecKeyInfoRetrieve", xmlSecKeyDataKlassGetName(id));
         goto done;
     }
+    xmlSecAssert2(entry->doc != NULL, -1);
 
     /* The result of dereferencing a KeyInfoReference MUST be a KeyInfo element,
      * or an XML document with a KeyInfo element as the root */
-    ret = xmlSecKeyDataKeyInfoReferenceReadXmlResult(dataId, key,
-                    xmlSecBufferGetData(keyInfoCtx->keyInfoReferenceCtx.result),
-                    xmlSecBufferGetSize(keyInfoCtx->keyInfoReferenceCtx.result),
-                    keyInfoCtx);
+    ret = xmlSecKeyDataKeyInfoReferenceReadXmlResult(dataId, key, entry->doc, keyInfoCtx);
     if(ret < 0) {
         xmlSecInternalError("xmlSecKeyDataKeyInfoReferenceReadXmlResult", xmlSecKeyDataKlassGetName(id));
         goto done;
@@ -1420,6 +2011,9 @@ xmlSecKeyDataKeyInfoReferenceXmlRead(xmlSecKeyDataId id, xmlSecKeyPtr key, xmlNo
     res = 0;
 
 done:
+    if(entry != NULL) {
+        xmlSecKeyDataStoreRetrievalCacheRelease(cacheStore, entry);
+    }
     if(uri != NULL) {
         xmlFree(uri);
     }
@@ -1440,31 +2034,18 @@ xmlSecKeyDataKeyInfoReferenceXmlWrite(xmlSecKeyDataId id, xmlSecKeyPtr key, xmlN
 
 static int
 xmlSecKeyDataKeyInfoReferenceReadXmlResult(xmlSecKeyDataId typeId, xmlSecKeyPtr key,
-                                          const xmlChar* buffer, xmlSecSize bufferSize,
-                                          xmlSecKeyInfoCtxPtr keyInfoCtx) {
-    xmlDocPtr doc;
+                                          xmlDocPtr doc, xmlSecKeyInfoCtxPtr keyInfoCtx) {
     xmlNodePtr cur;
-    int bufferLen;
     int ret;
 
     xmlSecAssert2(key != NULL, -1);
-    xmlSecAssert2(buffer != NULL, -1);
-    xmlSecAssert2(bufferSize > 0, -1);
+    xmlSecAssert2(doc != NULL, -1);
     xmlSecAssert2(keyInfoCtx != NULL, -1);
     xmlSecAssert2(keyInfoCtx->mode == xmlSecKeyInfoModeRead, -1);
 
-
-    XMLSEC_SAFE_CAST_SIZE_TO_INT(bufferSize, bufferLen, return(-1), NULL);
-    doc = xmlReadMemory((const char*)buffer, bufferLen, NULL, NULL, xmlSecParserGetDefaultOptions() | XML_PARSE_RECOVER);
-    if(doc == NULL) {
-        xmlSecXmlError("xmlReadMemory", xmlSecKeyDataKlassGetName(typeId));
-        return(-1);
-    }
-
     cur = xmlDocGetRootElement(doc);
     if(cur == NULL) {
         xmlSecXmlError("xmlDocGetRootElement", xmlSecKeyDataKlassGetName(typeId));
-        xmlFreeDoc(doc);
         return(-1);
     }
 
@@ -1472,19 +2053,16 @@ xmlSecKeyDataKeyInfoReferenceReadXmlResult(xmlSecKeyDataId typeId, xmlSecKeyPtr
      * an XML document with a KeyInfo element as the root */
     if(!xmlSecCheckNodeName(cur, xmlSecNodeKeyInfo, xmlSecDSigNs)) {
         xmlSecInvalidNodeError(cur, xmlSecNodeKeyInfo, xmlSecKeyDataKlassGetName(typeId));
-        xmlFreeDoc(doc);
         return(-1);
     }
 
     ret = xmlSecKeyInfoNodeRead(cur, key, keyInfoCtx);
     if(ret < 0) {
         xmlSecInternalError("xmlSecKeyInfoNodeRead", xmlSecKeyDataKlassGetName(typeId));
-        xmlFreeDoc(doc);
         return(-1);
     }
 
     /* success */
-    xmlFreeDoc(doc);
     return(0);
 }
 
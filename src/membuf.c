@@ -197,3 +197,172 @@ xmlSecTransformMemBufExecute(xmlSecTransformPtr transform, int last, xmlSecTrans
     return(0);
 }
 
+
+/*****************************************************************************
+ *
+ * Output Buffer Transform
+ *
+ * xmlSecTransform + xmlOutputBufferPtr (the output buffer is owned by the caller)
+ *
+ ****************************************************************************/
+XMLSEC_TRANSFORM_DECLARE(OutputBuf, xmlOutputBufferPtr)
+#define xmlSecOutputBufSize XMLSEC_TRANSFORM_SIZE(OutputBuf)
+
+static int              xmlSecTransformOutputBufInitialize      (xmlSecTransformPtr transform);
+static void             xmlSecTransformOutputBufFinalize        (xmlSecTransformPtr transform);
+static int              xmlSecTransformOutputBufExecute         (xmlSecTransformPtr transform,
+                                                                 int last,
+                                                                 xmlSecTransformCtxPtr transformCtx);
+static xmlSecTransformKlass xmlSecTransformOutputBufKlass = {
+    /* klass/object sizes */
+    sizeof(xmlSecTransformKlass),               /* xmlSecSize klassSize */
+    xmlSecOutputBufSize,                        /* xmlSecSize objSize */
+
+    xmlSecNameOutputBuf,                        /* const xmlChar* name; */
+    NULL,                                       /* const xmlChar* href; */
+    0,                                          /* xmlSecAlgorithmUsage usage; */
+
+    xmlSecTransformOutputBufInitialize,         /* xmlSecTransformInitializeMethod initialize; */
+    xmlSecTransformOutputBufFinalize,           /* xmlSecTransformFianlizeMethod finalize; */
+    NULL,                                       /* xmlSecTransformNodeReadMethod readNode; */
+    NULL,                                       /* xmlSecTransformNodeWriteMethod writeNode; */
+    NULL,                                       /* xmlSecTransformSetKeyReqMethod setKeyReq; */
+    NULL,                                       /* xmlSecTransformSetKeyMethod setKey; */
+    NULL,                                       /* xmlSecTransformValidateMethod validate; */
+    xmlSecTransformDefaultGetDataType,          /* xmlSecTransformGetDataTypeMethod getDataType; */
+    xmlSecTransformDefaultPushBin,              /* xmlSecTransformPushBinMethod pushBin; */
+    xmlSecTransformDefaultPopBin,               /* xmlSecTransformPopBinMethod popBin; */
+    NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
+    NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
+    xmlSecTransformOutputBufExecute,            /* xmlSecTransformExecuteMethod execute; */
+
+    NULL,                                       /* void* reserved0; */
+    NULL,                                       /* void* reserved1; */
+};
+
+/**
+ * xmlSecTransformOutputBufGetKlass:
+ *
+ * The output buffer transform: writes all the data that go through it
+ * to a LibXML2 output buffer (e.g. file, file descriptor or IO callbacks)
+ * and doesn't pass anything to the next transform. This allows one to
+ * process large data without keeping the result in memory.
+ *
+ * Returns: output buffer transform klass.
+ */
+xmlSecTransformId
+xmlSecTransformOutputBufGetKlass(void) {
+    return(&xmlSecTransformOutputBufKlass);
+}
+
+/**
+ * xmlSecTransformOutputBufSetOutput:
+ * @transform:          the pointer to output buffer transform.
+ * @output:             the LibXML2 output buffer.
+ *
+ * Sets the output buffer for the transform. The caller owns @output
+ * and is responsible for closing it after the transforms chain is
+ * executed.
+ *
+ * Returns: 0 on success or a negative value otherwise.
+ */
+int
+xmlSecTransformOutputBufSetOutput(xmlSecTransformPtr transform, xmlOutputBufferPtr output) {
+    xmlOutputBufferPtr* ctx;
+
+    xmlSecAssert2(xmlSecTransformCheckId(transform, xmlSecTransformOutputBufId), -1);
+    xmlSecAssert2(output != NULL, -1);
+
+    ctx = xmlSecOutputBufGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2((*ctx) == NULL, -1);
+
+    (*ctx) = output;
+    return(0);
+}
+
+static int
+xmlSecTransformOutputBufInitialize(xmlSecTransformPtr transform) {
+    xmlOutputBufferPtr* ctx;
+
+    xmlSecAssert2(xmlSecTransformCheckId(transform, xmlSecTransformOutputBufId), -1);
+
+    ctx = xmlSecOutputBufGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    (*ctx) = NULL;
+    return(0);
+}
+
+static void
+xmlSecTransformOutputBufFinalize(xmlSecTransformPtr transform) {
+    xmlOutputBufferPtr* ctx;
+
+    xmlSecAssert(xmlSecTransformCheckId(transform, xmlSecTransformOutputBufId));
+
+    ctx = xmlSecOutputBufGetCtx(transform);
+    xmlSecAssert(ctx != NULL);
+
+    /* we don't own the output buffer */
+    (*ctx) = NULL;
+}
+
+static int
+xmlSecTransformOutputBufExecute(xmlSecTransformPtr transform, int last, xmlSecTransformCtxPtr transformCtx) {
+    xmlOutputBufferPtr* ctx;
+    xmlSecBufferPtr in;
+    xmlSecSize inSize;
+    int inLen;
+    int ret;
+
+    xmlSecAssert2(xmlSecTransformCheckId(transform, xmlSecTransformOutputBufId), -1);
+    xmlSecAssert2(transformCtx != NULL, -1);
+
+    ctx = xmlSecOutputBufGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2((*ctx) != NULL, -1);
+
+    in = &(transform->inBuf);
+    inSize = xmlSecBufferGetSize(in);
+
+    if(transform->status == xmlSecTransformStatusNone) {
+        transform->status = xmlSecTransformStatusWorking;
+    }
+
+    if(transform->status == xmlSecTransformStatusWorking) {
+        /* write everything from in to the output buffer, nothing goes to out */
+        if(inSize > 0) {
+            XMLSEC_SAFE_CAST_SIZE_TO_INT(inSize, inLen, return(-1), xmlSecTransformGetName(transform));
+            ret = xmlOutputBufferWrite((*ctx), inLen, (const char*)xmlSecBufferGetData(in));
+            if(ret < 0) {
+                xmlSecXmlError2("xmlOutputBufferWrite", xmlSecTransformGetName(transform),
+                                "size=%d", inLen);
+                return(-1);
+            }
+
+            ret = xmlSecBufferRemoveHead(in, inSize);
+            if(ret < 0) {
+                xmlSecInternalError2("xmlSecBufferRemoveHead",
+                                     xmlSecTransformGetName(transform),
+                                     "size=" XMLSEC_SIZE_FMT, inSize);
+                return(-1);
+            }
+        }
+
+        if(last != 0) {
+            ret = xmlOutputBufferFlush(*ctx);
+            if(ret < 0) {
+                xmlSecXmlError("xmlOutputBufferFlush", xmlSecTransformGetName(transform));
+                return(-1);
+            }
+            transform->status = xmlSecTransformStatusFinished;
+        }
+    } else if(transform->status == xmlSecTransformStatusFinished) {
+        /* the only way we can get here is if there is no input */
+        xmlSecAssert2(inSize == 0, -1);
+    } else {
+        xmlSecInvalidTransfromStatusError(transform);
+        return(-1);
+    }
+    return(0);
+}
@@ -0,0 +1,397 @@
+/*
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * Document order nodes numbering.
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2024 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#include "globals.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libxml/tree.h>
+
+#include <xmlsec/xmlsec.h>
+#include <xmlsec/errors.h>
+#include <xmlsec/private.h>
+
+#include "nodeorder_helpers.h"
+
+/**************************************************************************
+ *
+ * Document walk: both passes (count and number) visit the nodes in the
+ * same order.
+ *
+ *************************************************************************/
+typedef struct _xmlSecNodeOrderCtx {
+    xmlSecNodeOrderPtr  order;          /* NULL for the count pass */
+    xmlSecSize          pos;
+
+    /* the current element in-scope namespaces */
+    xmlNsPtr*           nsList;
+    xmlSecSize          nsListSize;
+    xmlSecSize          nsListMax;
+} xmlSecNodeOrderCtx, *xmlSecNodeOrderCtxPtr;
+
+static xmlSecSize
+xmlSecNodeOrderHash(const void* node, const xmlChar* prefix, int isNs) {
+    xmlSecSize hash;
+
+    hash = (xmlSecSize)((uintptr_t)node >> 3);
+    hash *= (xmlSecSize)0x9E3779B1U;
+    if(isNs) {
+        hash ^= 0x5bd1e995U;
+        if(prefix != NULL) {
+            for(; (*prefix) != '\0'; ++prefix) {
+                hash = hash * 31 + (*prefix);
+            }
+        }
+    }
+    return(hash ^ (hash >> 15));
+}
+
+/* returns either the matching entry or the empty slot to insert it */
+static xmlSecNodeOrderEntryPtr
+xmlSecNodeOrderFindEntry(xmlSecNodeOrderPtr order, xmlNodePtr node, xmlNodePtr parent) {
+    xmlSecNodeOrderEntryPtr entry;
+    const void* key;
+    const xmlChar* prefix = NULL;
+    int isNs = 0;
+    xmlSecSize ii;
+
+    xmlSecAssert2(order != NULL, NULL);
+    xmlSecAssert2(order->entries != NULL, NULL);
+    xmlSecAssert2(node != NULL, NULL);
+
+    if(node->type != XML_NAMESPACE_DECL) {
+        key = node;
+    } else {
+        /* namespace nodes are identified by the parent element and the prefix,
+         * this is a libxml hack! check xpath.c for details */
+        if((parent != NULL) && (parent->type == XML_ATTRIBUTE_NODE)) {
+            parent = parent->parent;
+        }
+        if(parent == NULL) {
+            return(NULL);
+        }
+        key = parent;
+        prefix = ((xmlNsPtr)node)->prefix;
+        isNs = 1;
+    }
+
+    ii = xmlSecNodeOrderHash(key, prefix, isNs) & order->entriesMask;
+    while(1) {
+        entry = &(order->entries[ii]);
+        if(entry->node == NULL) {
+            return(entry);
+        }
+        if((entry->node == key) && (entry->isNs == isNs) &&
+           ((isNs == 0) || xmlStrEqual(entry->prefix, prefix)))
+        {
+            return(entry);
+        }
+        ii = (ii + 1) & order->entriesMask;
+    }
+}
+
+static int
+xmlSecNodeOrderCollectNs(xmlSecNodeOrderCtxPtr ctx, xmlNodePtr cur) {
+    xmlNodePtr node;
+    xmlNsPtr ns;
+    xmlSecSize ii;
+
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(cur != NULL, -1);
+
+    ctx->nsListSize = 0;
+    for(node = cur; (node != NULL) && (node->type == XML_ELEMENT_NODE); node = node->parent) {
+        for(ns = node->nsDef; ns != NULL; ns = ns->next) {
+            /* skip namespaces redefined by descendants */
+            for(ii = 0; ii < ctx->nsListSize; ++ii) {
+                if(xmlStrEqual(ctx->nsList[ii]->prefix, ns->prefix)) {
+                    break;
+                }
+            }
+            if(ii < ctx->nsListSize) {
+                continue;
+            }
+
+            if(ctx->nsListSize >= ctx->nsListMax) {
+                xmlSecSize newMax = (ctx->nsListMax > 0) ? 2 * ctx->nsListMax : 16;
+                xmlNsPtr* newList;
+
+                newList = (xmlNsPtr*)xmlRealloc(ctx->nsList, newMax * sizeof(xmlNsPtr));
+                if(newList == NULL) {
+                    xmlSecMallocError(newMax * sizeof(xmlNsPtr), NULL);
+                    return(-1);
+                }
+                ctx->nsList = newList;
+                ctx->nsListMax = newMax;
+            }
+            ctx->nsList[ctx->nsListSize++] = ns;
+        }
+    }
+    return(0);
+}
+
+static int
+xmlSecNodeOrderAdd(xmlSecNodeOrderCtxPtr ctx, xmlNodePtr cur, xmlNodePtr parent) {
+    xmlSecNodeOrderEntryPtr entry;
+
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(cur != NULL, -1);
+
+    if(ctx->order == NULL) {
+        ++ctx->pos;
+        return(0);
+    }
+    xmlSecAssert2(ctx->pos < ctx->order->size, -1);
+
+    entry = xmlSecNodeOrderFindEntry(ctx->order, cur, parent);
+    if((entry == NULL) || (entry->node != NULL)) {
+        xmlSecInvalidDataError("duplicate node in the document walk", NULL);
+        return(-1);
+    }
+    if(cur->type != XML_NAMESPACE_DECL) {
+        entry->node = cur;
+    } else {
+        entry->node = parent;
+        entry->prefix = ((xmlNsPtr)cur)->prefix;
+        entry->isNs = 1;
+    }
+    entry->pos = ctx->pos;
+
+    ctx->order->nodes[ctx->pos] = cur;
+    ctx->order->ends[ctx->pos] = ctx->pos;
+    ++ctx->pos;
+    return(0);
+}
+
+static int
+xmlSecNodeOrderWalk(xmlSecNodeOrderCtxPtr ctx, xmlNodePtr cur, xmlNodePtr parent) {
+    xmlSecSize start;
+    int ret;
+
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(cur != NULL, -1);
+
+    start = ctx->pos;
+    ret = xmlSecNodeOrderAdd(ctx, cur, parent);
+    if(ret < 0) {
+        return(-1);
+    }
+
+    /* element node has namespaces and attributes */
+    if(cur->type == XML_ELEMENT_NODE) {
+        xmlAttrPtr attr;
+        xmlSecSize ii;
+
+        ret = xmlSecNodeOrderCollectNs(ctx, cur);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecNodeOrderCollectNs", NULL);
+            return(-1);
+        }
+        for(ii = 0; ii < ctx->nsListSize; ++ii) {
+            ret = xmlSecNodeOrderAdd(ctx, (xmlNodePtr)ctx->nsList[ii], cur);
+            if(ret < 0) {
+                return(-1);
+            }
+        }
+        for(attr = cur->properties; attr != NULL; attr = attr->next) {
+            ret = xmlSecNodeOrderAdd(ctx, (xmlNodePtr)attr, cur);
+            if(ret < 0) {
+                return(-1);
+            }
+        }
+    }
+
+    /* element and document nodes have children */
+    if((cur->type == XML_ELEMENT_NODE) || (cur->type == XML_DOCUMENT_NODE)) {
+        xmlNodePtr node;
+
+        for(node = cur->children; node != NULL; node = node->next) {
+            ret = xmlSecNodeOrderWalk(ctx, node, cur);
+            if(ret < 0) {
+                return(-1);
+            }
+        }
+    }
+
+    if(ctx->order != NULL) {
+        ctx->order->ends[start] = ctx->pos - 1;
+    }
+    return(0);
+}
+
+/**
+ * xmlSecNodeOrderCreate:
+ * @doc:                the pointer to XML document.
+ *
+ * Numbers all the @doc nodes in the document order. The numbering is
+ * valid as long as the document is not modified. Caller is responsible
+ * for freeing returned object with #xmlSecNodeOrderDestroy function.
+ *
+ * Returns: pointer to newly created nodes numbering or NULL if an error occurs.
+ */
+xmlSecNodeOrderPtr
+xmlSecNodeOrderCreate(xmlDocPtr doc) {
+    xmlSecNodeOrderPtr order = NULL;
+    xmlSecNodeOrderPtr res = NULL;
+    xmlSecNodeOrderCtx ctx;
+    xmlSecSize entriesNum;
+    int ret;
+
+    xmlSecAssert2(doc != NULL, NULL);
+
+    memset(&ctx, 0, sizeof(ctx));
+
+    /* count nodes */
+    ret = xmlSecNodeOrderWalk(&ctx, (xmlNodePtr)doc, NULL);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecNodeOrderWalk(count)", NULL);
+        goto done;
+    }
+
+    order = (xmlSecNodeOrderPtr)xmlMalloc(sizeof(xmlSecNodeOrder));
+    if(order == NULL) {
+        xmlSecMallocError(sizeof(xmlSecNodeOrder), NULL);
+        goto done;
+    }
+    memset(order, 0, sizeof(xmlSecNodeOrder));
+    order->doc = doc;
+    order->refs = 1;
+    order->size = ctx.pos;
+
+    /* keep the hash table at most half full */
+    for(entriesNum = 16; entriesNum < 2 * order->size; entriesNum *= 2) {
+        if(entriesNum > XMLSEC_SIZE_MAX / (4 * sizeof(xmlSecNodeOrderEntry))) {
+            xmlSecInvalidSizeDataError("entriesNum", entriesNum, "too many nodes", NULL);
+            goto done;
+        }
+    }
+    order->entries = (xmlSecNodeOrderEntryPtr)xmlMalloc(entriesNum * sizeof(xmlSecNodeOrderEntry));
+    if(order->entries == NULL) {
+        xmlSecMallocError(entriesNum * sizeof(xmlSecNodeOrderEntry), NULL);
+        goto done;
+    }
+    memset(order->entries, 0, entriesNum * sizeof(xmlSecNodeOrderEntry));
+    order->entriesMask = entriesNum - 1;
+
+    order->nodes = (xmlNodePtr*)xmlMalloc(order->size * sizeof(xmlNodePtr));
+    if(order->nodes == NULL) {
+        xmlSecMallocError(order->size * sizeof(xmlNodePtr), NULL);
+        goto done;
+    }
+    order->ends = (xmlSecSize*)xmlMalloc(order->size * sizeof(xmlSecSize));
+    if(order->ends == NULL) {
+        xmlSecMallocError(order->size * sizeof(xmlSecSize), NULL);
+        goto done;
+    }
+
+    /* number nodes */
+    ctx.order = order;
+    ctx.pos = 0;
+    ret = xmlSecNodeOrderWalk(&ctx, (xmlNodePtr)doc, NULL);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecNodeOrderWalk(number)", NULL);
+        goto done;
+    }
+    if(ctx.pos != order->size) {
+        xmlSecInvalidSizeError("nodes number", ctx.pos, order->size, NULL);
+        goto done;
+    }
+
+    /* success */
+    res = order;
+    order = NULL;
+
+done:
+    if(order != NULL) {
+        xmlSecNodeOrderDestroy(order);
+    }
+    if(ctx.nsList != NULL) {
+        xmlFree(ctx.nsList);
+    }
+    return(res);
+}
+
+/**
+ * xmlSecNodeOrderRef:
+ * @order:              the pointer to nodes numbering.
+ *
+ * Adds a reference to @order.
+ *
+ * Returns: the @order.
+ */
+xmlSecNodeOrderPtr
+xmlSecNodeOrderRef(xmlSecNodeOrderPtr order) {
+    xmlSecAssert2(order != NULL, NULL);
+    xmlSecAssert2(order->refs > 0, NULL);
+
+    ++order->refs;
+    return(order);
+}
+
+/**
+ * xmlSecNodeOrderDestroy:
+ * @order:              the pointer to nodes numbering.
+ *
+ * Releases a reference to @order and destroys it when the last
+ * reference is released.
+ */
+void
+xmlSecNodeOrderDestroy(xmlSecNodeOrderPtr order) {
+    xmlSecAssert(order != NULL);
+    xmlSecAssert(order->refs > 0);
+
+    if(--order->refs > 0) {
+        return;
+    }
+    if(order->entries != NULL) {
+        xmlFree(order->entries);
+    }
+    if(order->nodes != NULL) {
+        xmlFree(order->nodes);
+    }
+    if(order->ends != NULL) {
+        xmlFree(order->ends);
+    }
+    memset(order, 0, sizeof(xmlSecNodeOrder));
+    xmlFree(order);
+}
+
+/**
+ * xmlSecNodeOrderFind:
+ * @order:              the pointer to nodes numbering.
+ * @node:               the pointer to XML node.
+ * @parent:             the pointer to @node parent node (used for namespace nodes).
+ * @pos:                the pointer to the result position.
+ *
+ * Finds the @node position in the document order. Namespace nodes
+ * are identified by the parent element and prefix the same way as
+ * XPath node sets do.
+ *
+ * Returns: 1 if the @node is found, 0 if it was not numbered
+ * (e.g. it was added to the document later) or a negative value
+ * if an error occurs.
+ */
+int
+xmlSecNodeOrderFind(xmlSecNodeOrderPtr order, xmlNodePtr node, xmlNodePtr parent, xmlSecSize* pos) {
+    xmlSecNodeOrderEntryPtr entry;
+
+    xmlSecAssert2(order != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+    xmlSecAssert2(pos != NULL, -1);
+
+    entry = xmlSecNodeOrderFindEntry(order, node, parent);
+    if((entry == NULL) || (entry->node == NULL)) {
+        return(0);
+    }
+    (*pos) = entry->pos;
+    return(1);
+}
@@ -0,0 +1,88 @@
+/*
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * THIS IS A PRIVATE XMLSEC HEADER FILE
+ * DON'T USE IT IN YOUR APPLICATION
+ *
+ * Document order nodes numbering.
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2024 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#ifndef __XMLSEC_NODEORDER_HELPERS_H__
+#define __XMLSEC_NODEORDER_HELPERS_H__
+
+#ifndef XMLSEC_PRIVATE
+#error "nodeorder_helpers.h file contains private xmlsec definitions and should not be used outside xmlsec or xmlsec-$crypto libraries"
+#endif /* XMLSEC_PRIVATE */
+
+#include <libxml/tree.h>
+
+#include <xmlsec/xmlsec.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct _xmlSecNodeOrder        xmlSecNodeOrder, *xmlSecNodeOrderPtr;
+
+typedef struct _xmlSecNodeOrderEntry {
+    const void*         node;           /* the node or the parent element for namespace nodes */
+    const xmlChar*      prefix;         /* the namespace prefix (namespace nodes only) */
+    int                 isNs;
+    xmlSecSize          pos;
+} xmlSecNodeOrderEntry, *xmlSecNodeOrderEntryPtr;
+
+/**
+ * xmlSecNodeOrder:
+ * @doc:                the numbered document.
+ * @refs:               the references count.
+ * @size:               the number of nodes.
+ * @nodes:              the nodes in the document order (namespace nodes are
+ *                      the in-scope #xmlNs declarations).
+ * @ends:               the position of the last node in each node subtree.
+ * @entries:            the node to position hash table.
+ * @entriesMask:        the hash table size minus one.
+ *
+ * The preorder numbering of the document nodes in the XPath document order:
+ * the document, then each element followed by its namespace nodes, its
+ * attributes and its children. Together with the subtree end positions,
+ * the "is descendant" check is two integer compares.
+ */
+struct _xmlSecNodeOrder {
+    xmlDocPtr                   doc;
+    int                         refs;
+    xmlSecSize                  size;
+    xmlNodePtr*                 nodes;
+    xmlSecSize*                 ends;
+    xmlSecNodeOrderEntryPtr     entries;
+    xmlSecSize                  entriesMask;
+};
+
+xmlSecNodeOrderPtr      xmlSecNodeOrderCreate           (xmlDocPtr doc);
+xmlSecNodeOrderPtr      xmlSecNodeOrderRef              (xmlSecNodeOrderPtr order);
+void                    xmlSecNodeOrderDestroy          (xmlSecNodeOrderPtr order);
+int                     xmlSecNodeOrderFind             (xmlSecNodeOrderPtr order,
+                                                         xmlNodePtr node,
+                                                         xmlNodePtr parent,
+                                                         xmlSecSize* pos);
+
+/**
+ * xmlSecNodeOrderIsDescendant:
+ * @order:              the pointer to nodes numbering.
+ * @ancestor:           the ancestor node position.
+ * @pos:                the node position.
+ *
+ * Checks whether the node at @pos is in the subtree of the node at
+ * @ancestor (not including the @ancestor itself).
+ */
+#define xmlSecNodeOrderIsDescendant(order, ancestor, pos) \
+    (((ancestor) < (pos)) && ((pos) <= (order)->ends[(ancestor)]))
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __XMLSEC_NODEORDER_HELPERS_H__ */
@@ -29,15 +29,53 @@
 #include <xmlsec/private.h>
 
 #include "cast_helpers.h"
+#include "nodeorder_helpers.h"
 
 #define xmlSecGetParent(node)           \
     (((node)->type != XML_NAMESPACE_DECL) ? \
         (node)->parent : \
         (xmlNodePtr)((xmlNsPtr)(node))->next)
 
+/* nodes set bitmaps over the document nodes numbering, see xmlSecNodeSetNumberNodes() */
+typedef struct _xmlSecNodeSetBitmap xmlSecNodeSetBitmap, *xmlSecNodeSetBitmapPtr;
+struct _xmlSecNodeSetBitmap {
+    xmlSecNodeOrderPtr  order;
+    xmlSecByte*         nodesBits;      /* the positions of the nset->nodes */
+    xmlSecSize*         subtrees;       /* the sorted positions of the not nested elements from nset->nodes */
+    xmlSecSize          subtreesNum;
+    xmlSecByte*         bits;           /* the materialized list membership (first nodes set only) */
+    xmlSecNodeSetPtr    last;           /* the last nodes set included in the bits */
+};
+
+/* the private nodes set data is allocated right after the public #xmlSecNodeSet
+ * structure (see xmlSecNodeSetCreate()) to keep the public structure layout unchanged */
+typedef struct _xmlSecNodeSetImpl {
+    xmlSecNodeSet               nset;
+    xmlSecNodeSetBitmapPtr      bitmap;
+} xmlSecNodeSetImpl, *xmlSecNodeSetImplPtr;
+
+#define xmlSecNodeSetGetBitmap(nset)            (((xmlSecNodeSetImplPtr)(nset))->bitmap)
+
+#define XMLSEC_NODESET_BITMAP_BYTES(size)       (((size) + 7) / 8)
+#define XMLSEC_NODESET_BITMAP_GET(bits, pos)    (((bits)[(pos) / 8] >> ((pos) % 8)) & 1)
+#define XMLSEC_NODESET_BITMAP_SET(bits, pos)    ((bits)[(pos) / 8] |= (xmlSecByte)(1U << ((pos) % 8)))
+
 static int      xmlSecNodeSetOneContains                (xmlSecNodeSetPtr nset,
                                                          xmlNodePtr node,
                                                          xmlNodePtr parent);
+static int      xmlSecNodeSetOneContainsPos             (xmlSecNodeSetPtr nset,
+                                                         xmlSecNodeOrderPtr order,
+                                                         xmlSecSize pos);
+static int      xmlSecNodeSetContainsFrom               (xmlSecNodeSetPtr nset,
+                                                         xmlSecNodeSetPtr start,
+                                                         int status,
+                                                         xmlSecNodeOrderPtr order,
+                                                         xmlSecSize pos,
+                                                         xmlNodePtr node,
+                                                         xmlNodePtr parent);
+static void     xmlSecNodeSetBitmapDestroy              (xmlSecNodeSetBitmapPtr bitmap);
+static int      xmlSecNodeSetNumberList                 (xmlSecNodeSetPtr nset,
+                                                         xmlSecNodeOrderPtr order);
 static int      xmlSecNodeSetWalkRecursive              (xmlSecNodeSetPtr nset,
                                                          xmlSecNodeSetWalkCallback walkFunc,
                                                          void* data,
@@ -59,12 +97,12 @@ xmlSecNodeSetPtr
 xmlSecNodeSetCreate(xmlDocPtr doc, xmlNodeSetPtr nodes, xmlSecNodeSetType type) {
     xmlSecNodeSetPtr nset;
 
-    nset = (xmlSecNodeSetPtr)xmlMalloc(sizeof(xmlSecNodeSet));
+    nset = (xmlSecNodeSetPtr)xmlMalloc(sizeof(xmlSecNodeSetImpl));
     if(nset == NULL) {
-        xmlSecMallocError(sizeof(xmlSecNodeSet), NULL);
+        xmlSecMallocError(sizeof(xmlSecNodeSetImpl), NULL);
         return(NULL);
     }
-    memset(nset, 0,  sizeof(xmlSecNodeSet));
+    memset(nset, 0,  sizeof(xmlSecNodeSetImpl));
 
     nset->doc   = doc;
     nset->nodes = nodes;
@@ -101,12 +139,15 @@ xmlSecNodeSetDestroy(xmlSecNodeSetPtr nset) {
         if(tmp->children != NULL) {
             xmlSecNodeSetDestroy(tmp->children);
         }
+        if(xmlSecNodeSetGetBitmap(tmp) != NULL) {
+            xmlSecNodeSetBitmapDestroy(xmlSecNodeSetGetBitmap(tmp));
+        }
         if((tmp->doc != NULL) && (tmp->destroyDoc != 0)) {
             /* all nodesets should belong to the same doc */
             xmlSecAssert((destroyDoc == NULL) || (tmp->doc == destroyDoc));
             destroyDoc = tmp->doc; /* can't destroy here because other node sets can refer to it */
         }
-        memset(tmp, 0,  sizeof(xmlSecNodeSet));
+        memset(tmp, 0,  sizeof(xmlSecNodeSetImpl));
         xmlFree(tmp);
     }
 
@@ -216,7 +257,6 @@ xmlSecNodeSetOneContains(xmlSecNodeSetPtr nset, xmlNodePtr node, xmlNodePtr pare
 int
 xmlSecNodeSetContains(xmlSecNodeSetPtr nset, xmlNodePtr node, xmlNodePtr parent) {
     int status = 1;
-    xmlSecNodeSetPtr cur;
 
     xmlSecAssert2(node != NULL, 0);
 
@@ -225,22 +265,59 @@ xmlSecNodeSetContains(xmlSecNodeSetPtr nset, xmlNodePtr node, xmlNodePtr parent)
         return(1);
     }
 
-    status = 1;
-    cur = nset;
+    /* numbered nodes set: the node is looked up once and the nodes
+     * sets checks are bit tests and integer compares */
+    if((xmlSecNodeSetGetBitmap(nset) != NULL) && (xmlSecNodeSetGetBitmap(nset)->order != NULL)) {
+        xmlSecNodeOrderPtr order = xmlSecNodeSetGetBitmap(nset)->order;
+        xmlSecSize pos;
+
+        if(xmlSecNodeOrderFind(order, node, parent, &pos) == 1) {
+            /* materialized nodes set: only the nodes sets added after
+             * the materialization need to be checked */
+            if(xmlSecNodeSetGetBitmap(nset)->bits != NULL) {
+                status = XMLSEC_NODESET_BITMAP_GET(xmlSecNodeSetGetBitmap(nset)->bits, pos);
+                if(xmlSecNodeSetGetBitmap(nset)->last->next == nset) {
+                    return(status);
+                }
+                return(xmlSecNodeSetContainsFrom(nset, xmlSecNodeSetGetBitmap(nset)->last->next, status,
+                    order, pos, node, parent));
+            }
+            return(xmlSecNodeSetContainsFrom(nset, nset, 1, order, pos, node, parent));
+        }
+    }
+
+    return(xmlSecNodeSetContainsFrom(nset, nset, 1, NULL, 0, node, parent));
+}
+
+static int
+xmlSecNodeSetContainsFrom(xmlSecNodeSetPtr nset, xmlSecNodeSetPtr start, int status,
+                          xmlSecNodeOrderPtr order, xmlSecSize pos,
+                          xmlNodePtr node, xmlNodePtr parent) {
+    xmlSecNodeSetPtr cur;
+
+    xmlSecAssert2(nset != NULL, -1);
+    xmlSecAssert2(start != NULL, -1);
+
+#define XMLSEC_NODESET_ONE_CONTAINS(cur) \
+    ((order != NULL) ? \
+        xmlSecNodeSetOneContainsPos((cur), order, pos) : \
+        xmlSecNodeSetOneContains((cur), node, parent))
+
+    cur = start;
     do {
         switch(cur->op) {
         case xmlSecNodeSetIntersection:
-            if(status && !xmlSecNodeSetOneContains(cur, node, parent)) {
+            if(status && !XMLSEC_NODESET_ONE_CONTAINS(cur)) {
                 status = 0;
             }
             break;
         case xmlSecNodeSetSubtraction:
-            if(status && xmlSecNodeSetOneContains(cur, node, parent)) {
+            if(status && XMLSEC_NODESET_ONE_CONTAINS(cur)) {
                 status = 0;
             }
             break;
         case xmlSecNodeSetUnion:
-            if(!status && xmlSecNodeSetOneContains(cur, node, parent)) {
+            if(!status && XMLSEC_NODESET_ONE_CONTAINS(cur)) {
                 status = 1;
             }
             break;
@@ -252,6 +329,8 @@ xmlSecNodeSetContains(xmlSecNodeSetPtr nset, xmlNodePtr node, xmlNodePtr parent)
         cur = cur->next;
     } while(cur != nset);
 
+#undef XMLSEC_NODESET_ONE_CONTAINS
+
     return(status);
 }
 
@@ -280,6 +359,24 @@ xmlSecNodeSetAdd(xmlSecNodeSetPtr nset, xmlSecNodeSetPtr newNSet,
     /* all nodesets should belong to the same doc */
     xmlSecAssert2(nset->doc == newNSet->doc, NULL);
 
+    /* only the first nodes set in the list can be materialized */
+    if((xmlSecNodeSetGetBitmap(newNSet) != NULL) && (xmlSecNodeSetGetBitmap(newNSet)->bits != NULL)) {
+        xmlFree(xmlSecNodeSetGetBitmap(newNSet)->bits);
+        xmlSecNodeSetGetBitmap(newNSet)->bits = NULL;
+        xmlSecNodeSetGetBitmap(newNSet)->last = NULL;
+    }
+
+    /* all nodesets in the list share the nodes numbering */
+    if((xmlSecNodeSetGetBitmap(nset) != NULL) && (xmlSecNodeSetGetBitmap(nset)->order != NULL)) {
+        int ret;
+
+        ret = xmlSecNodeSetNumberList(newNSet, xmlSecNodeSetGetBitmap(nset)->order);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecNodeSetNumberList", NULL);
+            return(NULL);
+        }
+    }
+
     newNSet->next = nset;
     newNSet->prev = nset->prev;
     nset->prev->next = newNSet;
@@ -321,6 +418,337 @@ xmlSecNodeSetAddList(xmlSecNodeSetPtr nset, xmlSecNodeSetPtr newNSet, xmlSecNode
 }
 
 
+/**************************************************************************
+ *
+ * Numbered nodes sets: all the nodes sets in the list share the document
+ * nodes numbering (see nodeorder.c) and keep their explicit nodes as a
+ * bitmap and their element nodes as sorted subtree intervals. Checking
+ * a node is a single hash lookup, then bit tests and a binary search per
+ * nodes set instead of linear scans over the nodes and the node ancestors.
+ *
+ *************************************************************************/
+static void
+xmlSecNodeSetBitmapDestroy(xmlSecNodeSetBitmapPtr bitmap) {
+    xmlSecAssert(bitmap != NULL);
+
+    if(bitmap->order != NULL) {
+        xmlSecNodeOrderDestroy(bitmap->order);
+    }
+    if(bitmap->nodesBits != NULL) {
+        xmlFree(bitmap->nodesBits);
+    }
+    if(bitmap->subtrees != NULL) {
+        xmlFree(bitmap->subtrees);
+    }
+    if(bitmap->bits != NULL) {
+        xmlFree(bitmap->bits);
+    }
+    memset(bitmap, 0, sizeof(xmlSecNodeSetBitmap));
+    xmlFree(bitmap);
+}
+
+static int
+xmlSecNodeSetBitmapCmpPos(const void* a, const void* b) {
+    xmlSecSize aa = *((const xmlSecSize*)a);
+    xmlSecSize bb = *((const xmlSecSize*)b);
+
+    return((aa < bb) ? -1 : ((aa > bb) ? 1 : 0));
+}
+
+static xmlSecNodeSetBitmapPtr
+xmlSecNodeSetBitmapCreate(xmlSecNodeSetPtr nset, xmlSecNodeOrderPtr order) {
+    xmlSecNodeSetBitmapPtr bitmap;
+    xmlSecSize bytesNum, pos, ii, jj;
+    xmlNodePtr node;
+    int nn;
+
+    xmlSecAssert2(nset != NULL, NULL);
+    xmlSecAssert2(order != NULL, NULL);
+
+    bitmap = (xmlSecNodeSetBitmapPtr)xmlMalloc(sizeof(xmlSecNodeSetBitmap));
+    if(bitmap == NULL) {
+        xmlSecMallocError(sizeof(xmlSecNodeSetBitmap), NULL);
+        return(NULL);
+    }
+    memset(bitmap, 0, sizeof(xmlSecNodeSetBitmap));
+    bitmap->order = xmlSecNodeOrderRef(order);
+
+    if((nset->nodes == NULL) || (nset->type == xmlSecNodeSetList)) {
+        return(bitmap);
+    }
+
+    bytesNum = XMLSEC_NODESET_BITMAP_BYTES(order->size);
+    bitmap->nodesBits = (xmlSecByte*)xmlMalloc(bytesNum);
+    if(bitmap->nodesBits == NULL) {
+        xmlSecMallocError(bytesNum, NULL);
+        xmlSecNodeSetBitmapDestroy(bitmap);
+        return(NULL);
+    }
+    memset(bitmap->nodesBits, 0, bytesNum);
+
+    if(nset->nodes->nodeNr > 0) {
+        bitmap->subtrees = (xmlSecSize*)xmlMalloc(sizeof(xmlSecSize) * (xmlSecSize)nset->nodes->nodeNr);
+        if(bitmap->subtrees == NULL) {
+            xmlSecMallocError(sizeof(xmlSecSize) * (xmlSecSize)nset->nodes->nodeNr, NULL);
+            xmlSecNodeSetBitmapDestroy(bitmap);
+            return(NULL);
+        }
+    }
+
+    for(nn = 0; nn < nset->nodes->nodeNr; ++nn) {
+        node = nset->nodes->nodeTab[nn];
+        if(node == NULL) {
+            continue;
+        }
+
+        /* the nodes outside of the numbering (e.g. the implicit "xml"
+         * namespace) are never found and use the slow path */
+        if(xmlSecNodeOrderFind(order, node, xmlSecGetParent(node), &pos) != 1) {
+            continue;
+        }
+        XMLSEC_NODESET_BITMAP_SET(bitmap->nodesBits, pos);
+
+        /* only elements pass the membership to descendants */
+        if(node->type == XML_ELEMENT_NODE) {
+            bitmap->subtrees[bitmap->subtreesNum++] = pos;
+        }
+    }
+
+    /* drop the subtrees nested in other subtrees */
+    if(bitmap->subtreesNum > 1) {
+        qsort(bitmap->subtrees, bitmap->subtreesNum, sizeof(xmlSecSize), xmlSecNodeSetBitmapCmpPos);
+        for(ii = 1, jj = 0; ii < bitmap->subtreesNum; ++ii) {
+            if(bitmap->subtrees[ii] > order->ends[bitmap->subtrees[jj]]) {
+                bitmap->subtrees[++jj] = bitmap->subtrees[ii];
+            }
+        }
+        bitmap->subtreesNum = jj + 1;
+    }
+    return(bitmap);
+}
+
+/* checks whether the node at @pos has an ancestor element from nset->nodes */
+static int
+xmlSecNodeSetBitmapInSubtrees(xmlSecNodeSetBitmapPtr bitmap, xmlSecSize pos) {
+    xmlSecSize lo, hi, mid;
+
+    xmlSecAssert2(bitmap != NULL, 0);
+    xmlSecAssert2(bitmap->order != NULL, 0);
+
+    /* find the last subtree that starts before the node */
+    lo = 0;
+    hi = bitmap->subtreesNum;
+    while(lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if(bitmap->subtrees[mid] < pos) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if(lo == 0) {
+        return(0);
+    }
+    return(xmlSecNodeOrderIsDescendant(bitmap->order, bitmap->subtrees[lo - 1], pos));
+}
+
+/* same as xmlSecNodeSetOneContains() for a numbered nodes set */
+static int
+xmlSecNodeSetOneContainsPos(xmlSecNodeSetPtr nset, xmlSecNodeOrderPtr order, xmlSecSize pos) {
+    xmlSecNodeSetBitmapPtr bitmap;
+    int in_nodes_set = 1;
+
+    xmlSecAssert2(nset != NULL, 0);
+    xmlSecAssert2(xmlSecNodeSetGetBitmap(nset) != NULL, 0);
+    xmlSecAssert2(xmlSecNodeSetGetBitmap(nset)->order == order, 0);
+    xmlSecAssert2(order != NULL, 0);
+    xmlSecAssert2(pos < order->size, 0);
+
+    bitmap = xmlSecNodeSetGetBitmap(nset);
+
+    /* special cases: */
+    switch(nset->type) {
+        case xmlSecNodeSetTreeWithoutComments:
+        case xmlSecNodeSetTreeWithoutCommentsInvert:
+            if(order->nodes[pos]->type == XML_COMMENT_NODE) {
+                return(0);
+            }
+            break;
+        case xmlSecNodeSetList:
+            return(xmlSecNodeSetContainsFrom(nset->children, nset->children, 1,
+                order, pos, NULL, NULL));
+        default:
+            break;
+    }
+
+    if(nset->nodes != NULL) {
+        in_nodes_set = XMLSEC_NODESET_BITMAP_GET(bitmap->nodesBits, pos);
+    }
+
+    switch(nset->type) {
+    case xmlSecNodeSetNormal:
+        return(in_nodes_set);
+    case xmlSecNodeSetInvert:
+        return(!in_nodes_set);
+    case xmlSecNodeSetTree:
+    case xmlSecNodeSetTreeWithoutComments:
+        if(in_nodes_set) {
+            return(1);
+        }
+        return(xmlSecNodeSetBitmapInSubtrees(bitmap, pos));
+    case xmlSecNodeSetTreeInvert:
+    case xmlSecNodeSetTreeWithoutCommentsInvert:
+        if(in_nodes_set) {
+            return(0);
+        }
+        return(!xmlSecNodeSetBitmapInSubtrees(bitmap, pos));
+    default:
+        xmlSecUnsupportedEnumValueError("node set type", nset->type, NULL);
+        return(0);
+    }
+}
+
+static int
+xmlSecNodeSetNumberList(xmlSecNodeSetPtr nset, xmlSecNodeOrderPtr order) {
+    xmlSecNodeSetPtr cur;
+    int ret;
+
+    xmlSecAssert2(nset != NULL, -1);
+    xmlSecAssert2(order != NULL, -1);
+
+    cur = nset;
+    do {
+        xmlSecAssert2(cur->doc == order->doc, -1);
+
+        if((xmlSecNodeSetGetBitmap(cur) == NULL) || (xmlSecNodeSetGetBitmap(cur)->order != order)) {
+            if(xmlSecNodeSetGetBitmap(cur) != NULL) {
+                xmlSecNodeSetBitmapDestroy(xmlSecNodeSetGetBitmap(cur));
+            }
+            xmlSecNodeSetGetBitmap(cur) = xmlSecNodeSetBitmapCreate(cur, order);
+            if(xmlSecNodeSetGetBitmap(cur) == NULL) {
+                xmlSecInternalError("xmlSecNodeSetBitmapCreate", NULL);
+                return(-1);
+            }
+        }
+        if(cur->type == xmlSecNodeSetList) {
+            xmlSecAssert2(cur->children != NULL, -1);
+
+            ret = xmlSecNodeSetNumberList(cur->children, order);
+            if(ret < 0) {
+                return(-1);
+            }
+        }
+        cur = cur->next;
+    } while(cur != nset);
+    return(0);
+}
+
+/**
+ * xmlSecNodeSetNumberNodes:
+ * @nset:               the pointer to node set.
+ *
+ * Numbers the @nset document nodes in the document order and shares the
+ * numbering with all the nodes sets in the list (including the nodes sets
+ * added later with #xmlSecNodeSetAdd). After that, #xmlSecNodeSetContains
+ * does a single node lookup and replaces the scans over the nodes sets
+ * nodes and the node ancestors with bit tests and subtree intervals
+ * checks. The document must not be modified while @nset is used.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecNodeSetNumberNodes(xmlSecNodeSetPtr nset) {
+    xmlSecNodeOrderPtr order;
+    int ret;
+
+    xmlSecAssert2(nset != NULL, -1);
+    xmlSecAssert2(nset->doc != NULL, -1);
+
+    if((xmlSecNodeSetGetBitmap(nset) != NULL) && (xmlSecNodeSetGetBitmap(nset)->order != NULL)) {
+        order = xmlSecNodeOrderRef(xmlSecNodeSetGetBitmap(nset)->order);
+    } else {
+        order = xmlSecNodeOrderCreate(nset->doc);
+        if(order == NULL) {
+            xmlSecInternalError("xmlSecNodeOrderCreate", NULL);
+            return(-1);
+        }
+    }
+
+    ret = xmlSecNodeSetNumberList(nset, order);
+    xmlSecNodeOrderDestroy(order);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecNodeSetNumberList", NULL);
+        return(-1);
+    }
+    return(0);
+}
+
+/**
+ * xmlSecNodeSetMaterialize:
+ * @nset:               the pointer to node set.
+ *
+ * Numbers the @nset document nodes (see #xmlSecNodeSetNumberNodes),
+ * evaluates the membership of every node once and stores the results
+ * in a bitmap. After that, #xmlSecNodeSetContains is a single lookup
+ * instead of a walk over all the nodes sets in the list. The nodes sets
+ * added to @nset after this call are still checked one by one.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecNodeSetMaterialize(xmlSecNodeSetPtr nset) {
+    xmlSecNodeSetBitmapPtr bitmap;
+    xmlSecNodeOrderPtr order;
+    xmlSecSize bytesNum, pos;
+    int ret;
+
+    xmlSecAssert2(nset != NULL, -1);
+    xmlSecAssert2(nset->doc != NULL, -1);
+
+    ret = xmlSecNodeSetNumberNodes(nset);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecNodeSetNumberNodes", NULL);
+        return(-1);
+    }
+    bitmap = xmlSecNodeSetGetBitmap(nset);
+    xmlSecAssert2(bitmap != NULL, -1);
+    order = bitmap->order;
+    xmlSecAssert2(order != NULL, -1);
+
+    if(bitmap->bits != NULL) {
+        if(bitmap->last == nset->prev) {
+            /* already done */
+            return(0);
+        }
+        xmlFree(bitmap->bits);
+        bitmap->bits = NULL;
+        bitmap->last = NULL;
+    }
+
+    bytesNum = XMLSEC_NODESET_BITMAP_BYTES(order->size);
+    bitmap->bits = (xmlSecByte*)xmlMalloc(bytesNum);
+    if(bitmap->bits == NULL) {
+        xmlSecMallocError(bytesNum, NULL);
+        return(-1);
+    }
+    memset(bitmap->bits, 0, bytesNum);
+
+    for(pos = 0; pos < order->size; ++pos) {
+        ret = xmlSecNodeSetContainsFrom(nset, nset, 1, order, pos, NULL, NULL);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecNodeSetContainsFrom", NULL);
+            xmlFree(bitmap->bits);
+            bitmap->bits = NULL;
+            return(-1);
+        }
+        if(ret) {
+            XMLSEC_NODESET_BITMAP_SET(bitmap->bits, pos);
+        }
+    }
+    bitmap->last = nset->prev;
+    return(0);
+}
+
 /**
  * xmlSecNodeSetWalk:
  * @nset:               the pointer to node set.
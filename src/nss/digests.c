@@ -31,6 +31,7 @@
 #include <xmlsec/nss/crypto.h>
 
 #include "../cast_helpers.h"
+#include "../transform_helpers.h"
 #include "private.h"
 
 /**************************************************************************
@@ -59,13 +60,23 @@ XMLSEC_TRANSFORM_DECLARE(NssDigest, xmlSecNssDigestCtx)
 static int      xmlSecNssDigestCheckId                  (xmlSecTransformPtr transform);
 static int      xmlSecNssDigestInitialize               (xmlSecTransformPtr transform);
 static void     xmlSecNssDigestFinalize                 (xmlSecTransformPtr transform);
+static int      xmlSecNssDigestCopyState                (xmlSecTransformPtr dst,
+                                                         xmlSecTransformPtr src);
 static int      xmlSecNssDigestVerify                   (xmlSecTransformPtr transform,
                                                          const xmlSecByte* data,
                                                          xmlSecSize dataSize,
                                                          xmlSecTransformCtxPtr transformCtx);
+static int      xmlSecNssDigestUpdate                   (xmlSecTransformPtr transform,
+                                                         const xmlSecByte* data,
+                                                         xmlSecSize dataSize);
 static int      xmlSecNssDigestExecute                  (xmlSecTransformPtr transform,
                                                          int last,
                                                          xmlSecTransformCtxPtr transformCtx);
+static int      xmlSecNssDigestPushBinV                 (xmlSecTransformPtr transform,
+                                                         const xmlSecTransformIOVec* vec,
+                                                         xmlSecSize vecSize,
+                                                         int final,
+                                                         xmlSecTransformCtxPtr transformCtx);
 
 static int
 xmlSecNssDigestCheckId(xmlSecTransformPtr transform) {
@@ -193,6 +204,41 @@ xmlSecNssDigestFinalize(xmlSecTransformPtr transform) {
     memset(ctx, 0, sizeof(xmlSecNssDigestCtx));
 }
 
+static int
+xmlSecNssDigestCopyState(xmlSecTransformPtr dst, xmlSecTransformPtr src) {
+    xmlSecNssDigestCtxPtr dstCtx, srcCtx;
+
+    xmlSecAssert2(xmlSecNssDigestCheckId(dst), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(dst, xmlSecNssDigestSize), -1);
+    xmlSecAssert2(xmlSecTransformCheckId(src, dst->id), -1);
+
+    dstCtx = xmlSecNssDigestGetCtx(dst);
+    xmlSecAssert2(dstCtx != NULL, -1);
+    xmlSecAssert2(dstCtx->digestCtx != NULL, -1);
+    srcCtx = xmlSecNssDigestGetCtx(src);
+    xmlSecAssert2(srcCtx != NULL, -1);
+    xmlSecAssert2(srcCtx->digestCtx != NULL, -1);
+    xmlSecAssert2(srcCtx->dgstSize <= sizeof(dstCtx->dgst), -1);
+
+    /* the hash state is only needed while the data is processed,
+     * the finished transforms only have the digest value */
+    if(src->status == xmlSecTransformStatusWorking) {
+        PK11Context* digestCtx;
+
+        digestCtx = PK11_CloneContext(srcCtx->digestCtx);
+        if(digestCtx == NULL) {
+            xmlSecNssError("PK11_CloneContext", xmlSecTransformGetName(dst));
+            return(-1);
+        }
+        PK11_DestroyContext(dstCtx->digestCtx, PR_TRUE);
+        dstCtx->digestCtx = digestCtx;
+    }
+
+    memcpy(dstCtx->dgst, srcCtx->dgst, srcCtx->dgstSize);
+    dstCtx->dgstSize = srcCtx->dgstSize;
+    return(0);
+}
+
 static int
 xmlSecNssDigestVerify(xmlSecTransformPtr transform,
                         const xmlSecByte* data, xmlSecSize dataSize,
@@ -229,6 +275,30 @@ xmlSecNssDigestVerify(xmlSecTransformPtr transform,
     return(0);
 }
 
+static int
+xmlSecNssDigestUpdate(xmlSecTransformPtr transform, const xmlSecByte* data, xmlSecSize dataSize) {
+    xmlSecNssDigestCtxPtr ctx;
+    unsigned int dataLen;
+    SECStatus rv;
+
+    xmlSecAssert2(xmlSecNssDigestCheckId(transform), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(transform, xmlSecNssDigestSize), -1);
+    xmlSecAssert2(transform->status == xmlSecTransformStatusWorking, -1);
+    xmlSecAssert2(data != NULL, -1);
+
+    ctx = xmlSecNssDigestGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->digestCtx != NULL, -1);
+
+    XMLSEC_SAFE_CAST_SIZE_TO_UINT(dataSize, dataLen, return(-1), xmlSecTransformGetName(transform));
+    rv = PK11_DigestOp(ctx->digestCtx, data, dataLen);
+    if (rv != SECSuccess) {
+        xmlSecNssError("PK11_DigestOp", xmlSecTransformGetName(transform));
+        return(-1);
+    }
+    return(0);
+}
+
 static int
 xmlSecNssDigestExecute(xmlSecTransformPtr transform, int last, xmlSecTransformCtxPtr transformCtx) {
     xmlSecNssDigestCtxPtr ctx;
@@ -265,9 +335,9 @@ xmlSecNssDigestExecute(xmlSecTransformPtr transform, int last, xmlSecTransformCt
             unsigned int inLen;
 
             XMLSEC_SAFE_CAST_SIZE_TO_UINT(inSize, inLen, return(-1), xmlSecTransformGetName(transform));
-            rv = PK11_DigestOp(ctx->digestCtx, xmlSecBufferGetData(in), inLen);
-            if (rv != SECSuccess) {
-                xmlSecNssError("PK11_DigestOp", xmlSecTransformGetName(transform));
+            ret = xmlSecNssDigestUpdate(transform, xmlSecBufferGetData(in), inSize);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecNssDigestUpdate", xmlSecTransformGetName(transform));
                 return(-1);
             }
 
@@ -311,6 +381,16 @@ xmlSecNssDigestExecute(xmlSecTransformPtr transform, int last, xmlSecTransformCt
     return(0);
 }
 
+static int
+xmlSecNssDigestPushBinV(xmlSecTransformPtr transform, const xmlSecTransformIOVec* vec,
+                        xmlSecSize vecSize, int final, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecAssert2(xmlSecNssDigestCheckId(transform), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(transform, xmlSecNssDigestSize), -1);
+
+    return(xmlSecTransformUpdatePushBinV(transform, vec, vecSize, final, transformCtx,
+        xmlSecNssDigestUpdate));
+}
+
 #ifndef XMLSEC_NO_MD5
 /******************************************************************************
  *
@@ -342,8 +422,8 @@ static xmlSecTransformKlass xmlSecNssMd5Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssDigestExecute,                     /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecNssDigestCopyState,                   /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecNssDigestPushBinV,                    /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -391,8 +471,8 @@ static xmlSecTransformKlass xmlSecNssSha1Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssDigestExecute,                     /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecNssDigestCopyState,                   /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecNssDigestPushBinV,                    /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -439,8 +519,8 @@ static xmlSecTransformKlass xmlSecNssSha224Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssDigestExecute,                     /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecNssDigestCopyState,                   /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecNssDigestPushBinV,                    /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -487,8 +567,8 @@ static xmlSecTransformKlass xmlSecNssSha256Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssDigestExecute,                     /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecNssDigestCopyState,                   /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecNssDigestPushBinV,                    /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -536,8 +616,8 @@ static xmlSecTransformKlass xmlSecNssSha384Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssDigestExecute,                     /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecNssDigestCopyState,                   /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecNssDigestPushBinV,                    /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -584,8 +664,8 @@ static xmlSecTransformKlass xmlSecNssSha512Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssDigestExecute,                     /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecNssDigestCopyState,                   /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecNssDigestPushBinV,                    /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
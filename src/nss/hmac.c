@@ -79,9 +79,17 @@ static int      xmlSecNssHmacVerify                     (xmlSecTransformPtr tran
                                                          const xmlSecByte* data,
                                                          xmlSecSize dataSize,
                                                          xmlSecTransformCtxPtr transformCtx);
+static int      xmlSecNssHmacUpdate                     (xmlSecTransformPtr transform,
+                                                         const xmlSecByte* data,
+                                                         xmlSecSize dataSize);
 static int      xmlSecNssHmacExecute                    (xmlSecTransformPtr transform,
                                                          int last,
                                                          xmlSecTransformCtxPtr transformCtx);
+static int      xmlSecNssHmacPushBinV                   (xmlSecTransformPtr transform,
+                                                         const xmlSecTransformIOVec* vec,
+                                                         xmlSecSize vecSize,
+                                                         int final,
+                                                         xmlSecTransformCtxPtr transformCtx);
 
 
 static int
@@ -359,6 +367,30 @@ xmlSecNssHmacVerify(xmlSecTransformPtr transform,
     return(0);
 }
 
+static int
+xmlSecNssHmacUpdate(xmlSecTransformPtr transform, const xmlSecByte* data, xmlSecSize dataSize) {
+    xmlSecNssHmacCtxPtr ctx;
+    unsigned int dataLen;
+    SECStatus rv;
+
+    xmlSecAssert2(xmlSecNssHmacCheckId(transform), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(transform, xmlSecNssHmacSize), -1);
+    xmlSecAssert2(transform->status == xmlSecTransformStatusWorking, -1);
+    xmlSecAssert2(data != NULL, -1);
+
+    ctx = xmlSecNssHmacGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->digestCtx != NULL, -1);
+
+    XMLSEC_SAFE_CAST_SIZE_TO_UINT(dataSize, dataLen, return(-1), xmlSecTransformGetName(transform));
+    rv = PK11_DigestOp(ctx->digestCtx, data, dataLen);
+    if (rv != SECSuccess) {
+        xmlSecNssError("PK11_DigestOp", xmlSecTransformGetName(transform));
+        return(-1);
+    }
+    return(0);
+}
+
 static int
 xmlSecNssHmacExecute(xmlSecTransformPtr transform, int last, xmlSecTransformCtxPtr transformCtx) {
     xmlSecNssHmacCtxPtr ctx;
@@ -395,9 +427,9 @@ xmlSecNssHmacExecute(xmlSecTransformPtr transform, int last, xmlSecTransformCtxP
             unsigned int inLen;
 
             XMLSEC_SAFE_CAST_SIZE_TO_UINT(inSize, inLen, return(-1), xmlSecTransformGetName(transform));
-            rv = PK11_DigestOp(ctx->digestCtx, xmlSecBufferGetData(in), inLen);
-            if (rv != SECSuccess) {
-                xmlSecNssError("PK11_DigestOp", xmlSecTransformGetName(transform));
+            ret = xmlSecNssHmacUpdate(transform, xmlSecBufferGetData(in), inSize);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecNssHmacUpdate", xmlSecTransformGetName(transform));
                 return(-1);
             }
 
@@ -447,6 +479,16 @@ xmlSecNssHmacExecute(xmlSecTransformPtr transform, int last, xmlSecTransformCtxP
     return(0);
 }
 
+static int
+xmlSecNssHmacPushBinV(xmlSecTransformPtr transform, const xmlSecTransformIOVec* vec,
+                      xmlSecSize vecSize, int final, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecAssert2(xmlSecNssHmacCheckId(transform), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(transform, xmlSecNssHmacSize), -1);
+
+    return(xmlSecTransformUpdatePushBinV(transform, vec, vecSize, final, transformCtx,
+        xmlSecNssHmacUpdate));
+}
+
 
 #ifndef XMLSEC_NO_RIPEMD160
 /******************************************************************************
@@ -477,8 +519,8 @@ static xmlSecTransformKlass xmlSecNssHmacRipemd160Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssHmacExecute,                       /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecNssHmacPushBinV,                      /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -523,8 +565,8 @@ static xmlSecTransformKlass xmlSecNssHmacMd5Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssHmacExecute,                       /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecNssHmacPushBinV,                      /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -569,8 +611,8 @@ static xmlSecTransformKlass xmlSecNssHmacSha1Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssHmacExecute,                       /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecNssHmacPushBinV,                      /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -615,8 +657,8 @@ static xmlSecTransformKlass xmlSecNssHmacSha224Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssHmacExecute,                       /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecNssHmacPushBinV,                      /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -661,8 +703,8 @@ static xmlSecTransformKlass xmlSecNssHmacSha256Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssHmacExecute,                       /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecNssHmacPushBinV,                      /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -707,8 +749,8 @@ static xmlSecTransformKlass xmlSecNssHmacSha384Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssHmacExecute,                       /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecNssHmacPushBinV,                      /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -753,8 +795,8 @@ static xmlSecTransformKlass xmlSecNssHmacSha512Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecNssHmacExecute,                       /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecNssHmacPushBinV,                      /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -22,6 +22,10 @@
  * DB.
  * Thus, the NSS DB can be used to pre-load keys and becomes an alternate
  * source of keys for xmlsec
+ *
+ * The results of the NSS DB lookups (including the keys that were not found)
+ * are cached in the keys store, the cache is emptied when a key is adopted
+ * or by #xmlSecNssKeysStoreFlushCache function.
  */
 #include "globals.h"
 
@@ -33,6 +37,8 @@
 #include <pk11pub.h>
 #include <keyhi.h>
 
+#include <libxml/threads.h>
+
 #include <xmlsec/xmlsec.h>
 #include <xmlsec/buffer.h>
 #include <xmlsec/base64.h>
@@ -51,12 +57,41 @@
  *
  * Nss Keys Store. Uses Simple Keys Store under the hood
  *
- * xmlSecKeyStore +  xmlSecKeyStorePtr(Simple Keys Store ptr)
+ * xmlSecKeyStore +  xmlSecNssKeysStoreCtx(Simple Keys Store ptr + NSS DB lookups cache)
  *
  ***************************************************************************/
-XMLSEC_KEY_STORE_DECLARE(NssKeysStore, xmlSecKeyStorePtr)
+#define XMLSEC_NSS_KEYS_STORE_CACHE_MAX_ENTRIES         256
+
+typedef struct _xmlSecNssKeysStoreCacheEntry            xmlSecNssKeysStoreCacheEntry,
+                                                        *xmlSecNssKeysStoreCacheEntryPtr;
+struct _xmlSecNssKeysStoreCacheEntry {
+    xmlChar*                    name;
+    xmlSecKeyDataType           keyType;
+    xmlSecKeyPtr                key;            /* NULL if the key is not in the NSS DB */
+};
+
+typedef struct _xmlSecNssKeysStoreCtx                   xmlSecNssKeysStoreCtx,
+                                                        *xmlSecNssKeysStoreCtxPtr;
+struct _xmlSecNssKeysStoreCtx {
+    xmlSecKeyStorePtr           simpleStore;
+    xmlSecPtrList               cache;          /* xmlSecNssKeysStoreCacheEntry items */
+    xmlSecSize                  cacheNext;      /* the entry to replace when the cache is full */
+    xmlMutexPtr                 mutex;
+};
+
+XMLSEC_KEY_STORE_DECLARE(NssKeysStore, xmlSecNssKeysStoreCtx)
 #define xmlSecNssKeysStoreSize XMLSEC_KEY_STORE_SIZE(NssKeysStore)
 
+static void                     xmlSecNssKeysStoreCacheEntryDestroy(xmlSecNssKeysStoreCacheEntryPtr entry);
+
+static xmlSecPtrListKlass xmlSecNssKeysStoreCacheListKlass = {
+    BAD_CAST "nss-keys-store-cache-list",
+    NULL,                                                               /* xmlSecPtrDuplicateItemMethod duplicateItem; */
+    (xmlSecPtrDestroyItemMethod)xmlSecNssKeysStoreCacheEntryDestroy,    /* xmlSecPtrDestroyItemMethod destroyItem; */
+    NULL,                                                               /* xmlSecPtrDebugDumpItemMethod debugDumpItem; */
+    NULL,                                                               /* xmlSecPtrDebugDumpItemMethod debugXmlDumpItem; */
+};
+
 static int                      xmlSecNssKeysStoreInitialize    (xmlSecKeyStorePtr store);
 static void                     xmlSecNssKeysStoreFinalize      (xmlSecKeyStorePtr store);
 static xmlSecKeyPtr             xmlSecNssKeysStoreFindKey       (xmlSecKeyStorePtr store,
@@ -106,16 +141,41 @@ xmlSecNssKeysStoreGetKlass(void) {
  */
 int
 xmlSecNssKeysStoreAdoptKey(xmlSecKeyStorePtr store, xmlSecKeyPtr key) {
-    xmlSecKeyStorePtr *ss;
+    xmlSecNssKeysStoreCtxPtr ctx;
 
     xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecNssKeysStoreId), -1);
     xmlSecAssert2((key != NULL), -1);
 
-    ss = xmlSecNssKeysStoreGetCtx(store);
-    xmlSecAssert2(((ss != NULL) && (*ss != NULL) &&
-                   (xmlSecKeyStoreCheckId(*ss, xmlSecSimpleKeysStoreId))), -1);
+    ctx = xmlSecNssKeysStoreGetCtx(store);
+    xmlSecAssert2(((ctx != NULL) && (ctx->simpleStore != NULL) &&
+                   (xmlSecKeyStoreCheckId(ctx->simpleStore, xmlSecSimpleKeysStoreId))), -1);
+
+    xmlSecNssKeysStoreFlushCache(store);
+    return (xmlSecSimpleKeysStoreAdoptKey(ctx->simpleStore, key));
+}
+
+/**
+ * xmlSecNssKeysStoreFlushCache:
+ * @store:              the pointer to Nss keys store.
+ *
+ * Removes all the cached results of the NSS DB lookups (both found
+ * and not found keys) from the @store. The application should call this
+ * function after changing the NSS DB.
+ */
+void
+xmlSecNssKeysStoreFlushCache(xmlSecKeyStorePtr store) {
+    xmlSecNssKeysStoreCtxPtr ctx;
+
+    xmlSecAssert(xmlSecKeyStoreCheckId(store, xmlSecNssKeysStoreId));
+
+    ctx = xmlSecNssKeysStoreGetCtx(store);
+    xmlSecAssert(ctx != NULL);
+    xmlSecAssert(ctx->mutex != NULL);
 
-    return (xmlSecSimpleKeysStoreAdoptKey(*ss, key));
+    xmlMutexLock(ctx->mutex);
+    xmlSecPtrListEmpty(&(ctx->cache));
+    ctx->cacheNext = 0;
+    xmlMutexUnlock(ctx->mutex);
 }
 
 /**
@@ -147,154 +207,248 @@ xmlSecNssKeysStoreLoad(xmlSecKeyStorePtr store, const char *uri,
  */
 int
 xmlSecNssKeysStoreSave(xmlSecKeyStorePtr store, const char *filename, xmlSecKeyDataType type) {
-    xmlSecKeyStorePtr *ss;
+    xmlSecNssKeysStoreCtxPtr ctx;
 
     xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecNssKeysStoreId), -1);
     xmlSecAssert2((filename != NULL), -1);
 
-    ss = xmlSecNssKeysStoreGetCtx(store);
-    xmlSecAssert2(((ss != NULL) && (*ss != NULL) &&
-                   (xmlSecKeyStoreCheckId(*ss, xmlSecSimpleKeysStoreId))), -1);
+    ctx = xmlSecNssKeysStoreGetCtx(store);
+    xmlSecAssert2(((ctx != NULL) && (ctx->simpleStore != NULL) &&
+                   (xmlSecKeyStoreCheckId(ctx->simpleStore, xmlSecSimpleKeysStoreId))), -1);
 
-    return (xmlSecSimpleKeysStoreSave(*ss, filename, type));
+    return (xmlSecSimpleKeysStoreSave(ctx->simpleStore, filename, type));
 }
 
 static int
 xmlSecNssKeysStoreInitialize(xmlSecKeyStorePtr store) {
-    xmlSecKeyStorePtr *ss;
+    xmlSecNssKeysStoreCtxPtr ctx;
+    int ret;
 
     xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecNssKeysStoreId), -1);
 
-    ss = xmlSecNssKeysStoreGetCtx(store);
-    xmlSecAssert2(((ss == NULL) || (*ss == NULL)), -1);
+    ctx = xmlSecNssKeysStoreGetCtx(store);
+    xmlSecAssert2(ctx != NULL, -1);
+    memset(ctx, 0, sizeof(xmlSecNssKeysStoreCtx));
 
-    *ss = xmlSecKeyStoreCreate(xmlSecSimpleKeysStoreId);
-    if(*ss == NULL) {
+    ctx->simpleStore = xmlSecKeyStoreCreate(xmlSecSimpleKeysStoreId);
+    if(ctx->simpleStore == NULL) {
         xmlSecInternalError("xmlSecKeyStoreCreate(xmlSecSimpleKeysStoreId)",
                             xmlSecKeyStoreGetName(store));
         return(-1);
     }
 
+    ret = xmlSecPtrListInitialize(&(ctx->cache), &xmlSecNssKeysStoreCacheListKlass);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInitialize", xmlSecKeyStoreGetName(store));
+        return(-1);
+    }
+
+    ctx->mutex = xmlNewMutex();
+    if(ctx->mutex == NULL) {
+        xmlSecXmlError("xmlNewMutex", xmlSecKeyStoreGetName(store));
+        return(-1);
+    }
+
     return(0);
 }
 
 static void
 xmlSecNssKeysStoreFinalize(xmlSecKeyStorePtr store) {
-    xmlSecKeyStorePtr *ss;
+    xmlSecNssKeysStoreCtxPtr ctx;
 
     xmlSecAssert(xmlSecKeyStoreCheckId(store, xmlSecNssKeysStoreId));
 
-    ss = xmlSecNssKeysStoreGetCtx(store);
-    xmlSecAssert((ss != NULL) && (*ss != NULL));
+    ctx = xmlSecNssKeysStoreGetCtx(store);
+    xmlSecAssert(ctx != NULL);
+
+    xmlSecPtrListFinalize(&(ctx->cache));
+    if(ctx->mutex != NULL) {
+        xmlFreeMutex(ctx->mutex);
+    }
+    if(ctx->simpleStore != NULL) {
+        xmlSecKeyStoreDestroy(ctx->simpleStore);
+    }
+    memset(ctx, 0, sizeof(xmlSecNssKeysStoreCtx));
+}
+
+static void
+xmlSecNssKeysStoreCacheEntryDestroy(xmlSecNssKeysStoreCacheEntryPtr entry) {
+    xmlSecAssert(entry != NULL);
 
-    xmlSecKeyStoreDestroy(*ss);
+    if(entry->name != NULL) {
+        xmlFree(entry->name);
+    }
+    if(entry->key != NULL) {
+        xmlSecKeyDestroy(entry->key);
+    }
+    memset(entry, 0, sizeof(xmlSecNssKeysStoreCacheEntry));
+    xmlFree(entry);
 }
 
-static xmlSecKeyPtr
-xmlSecNssKeysStoreFindKey(xmlSecKeyStorePtr store, const xmlChar* name, xmlSecKeyInfoCtxPtr keyInfoCtx) {
-    xmlSecKeyStorePtr* ss;
+/* the caller must hold the mutex */
+static xmlSecNssKeysStoreCacheEntryPtr
+xmlSecNssKeysStoreCacheFind(xmlSecNssKeysStoreCtxPtr ctx, const xmlChar* name, xmlSecKeyDataType keyType) {
+    xmlSecNssKeysStoreCacheEntryPtr entry;
+    xmlSecSize pos, size;
+
+    xmlSecAssert2(ctx != NULL, NULL);
+    xmlSecAssert2(name != NULL, NULL);
+
+    size = xmlSecPtrListGetSize(&(ctx->cache));
+    for(pos = 0; pos < size; ++pos) {
+        entry = (xmlSecNssKeysStoreCacheEntryPtr)xmlSecPtrListGetItem(&(ctx->cache), pos);
+        if((entry != NULL) && (entry->keyType == keyType) && xmlStrEqual(entry->name, name)) {
+            return(entry);
+        }
+    }
+    return(NULL);
+}
+
+/* the caller must hold the mutex; takes ownership of the @key */
+static xmlSecNssKeysStoreCacheEntryPtr
+xmlSecNssKeysStoreCacheAdd(xmlSecNssKeysStoreCtxPtr ctx, const xmlChar* name, xmlSecKeyDataType keyType,
+                           xmlSecKeyPtr key) {
+    xmlSecNssKeysStoreCacheEntryPtr entry;
+    int ret;
+
+    xmlSecAssert2(ctx != NULL, NULL);
+    xmlSecAssert2(name != NULL, NULL);
+
+    entry = (xmlSecNssKeysStoreCacheEntryPtr)xmlMalloc(sizeof(xmlSecNssKeysStoreCacheEntry));
+    if(entry == NULL) {
+        xmlSecMallocError(sizeof(xmlSecNssKeysStoreCacheEntry), NULL);
+        if(key != NULL) {
+            xmlSecKeyDestroy(key);
+        }
+        return(NULL);
+    }
+    memset(entry, 0, sizeof(xmlSecNssKeysStoreCacheEntry));
+    entry->keyType = keyType;
+    entry->key = key;
+
+    entry->name = xmlStrdup(name);
+    if(entry->name == NULL) {
+        xmlSecStrdupError(name, NULL);
+        xmlSecNssKeysStoreCacheEntryDestroy(entry);
+        return(NULL);
+    }
+
+    /* replace the oldest entry if the cache is full */
+    if(xmlSecPtrListGetSize(&(ctx->cache)) >= XMLSEC_NSS_KEYS_STORE_CACHE_MAX_ENTRIES) {
+        ret = xmlSecPtrListSet(&(ctx->cache), entry, ctx->cacheNext);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecPtrListSet", NULL);
+            xmlSecNssKeysStoreCacheEntryDestroy(entry);
+            return(NULL);
+        }
+        ctx->cacheNext = (ctx->cacheNext + 1) % XMLSEC_NSS_KEYS_STORE_CACHE_MAX_ENTRIES;
+        return(entry);
+    }
+
+    ret = xmlSecPtrListAdd(&(ctx->cache), entry);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListAdd", NULL);
+        xmlSecNssKeysStoreCacheEntryDestroy(entry);
+        return(NULL);
+    }
+    return(entry);
+}
+
+/* returns 0 and the key (or NULL if the key is not found), 1 if the key might be
+ * available later (e.g. the token is not logged in yet) and the result should not
+ * be cached, or a negative value if an error occurs */
+static int
+xmlSecNssKeysStoreFindKeyInDB(const xmlChar* name, xmlSecKeyDataType keyType, xmlSecKeyPtr* res) {
     xmlSecKeyPtr key = NULL;
-    xmlSecKeyPtr retval = NULL;
-    xmlSecKeyReqPtr keyReq = NULL;
     CERTCertificate *cert = NULL;
     SECKEYPublicKey *pubkey = NULL;
     SECKEYPrivateKey *privkey = NULL;
     xmlSecKeyDataPtr data = NULL;
     xmlSecKeyDataPtr x509Data = NULL;
     int ret;
+    int retval = -1;
 
-    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecNssKeysStoreId), NULL);
-    xmlSecAssert2(keyInfoCtx != NULL, NULL);
-
-    ss = xmlSecNssKeysStoreGetCtx(store);
-    xmlSecAssert2(((ss != NULL) && (*ss != NULL)), NULL);
+    xmlSecAssert2(name != NULL, -1);
+    xmlSecAssert2(res != NULL, -1);
 
-    key = xmlSecKeyStoreFindKey(*ss, name, keyInfoCtx);
-    if (key != NULL) {
-        return (key);
-    }
-
-    /* Try to find the key in the NSS DB, and construct an xmlSecKey.
-     * we must have a name to lookup keys in NSS DB.
-     */
-    if (name == NULL) {
-        goto done;
-    }
+    (*res) = NULL;
 
     /* what type of key are we looking for?
      * TBD: For now, we'll look only for public/private keys using the
      * name as a cert nickname. Later on, we can attempt to find
      * symmetric keys using PK11_FindFixedKey
      */
-    keyReq = &(keyInfoCtx->keyReq);
-    if (keyReq->keyType & (xmlSecKeyDataTypePublic | xmlSecKeyDataTypePrivate)) {
-        cert = CERT_FindCertByNickname (CERT_GetDefaultCertDB(), (char *)name);
-        if (cert == NULL) {
-            goto done;
-        }
-
-        if (keyReq->keyType & xmlSecKeyDataTypePublic) {
-            pubkey = CERT_ExtractPublicKey(cert);
-            if (pubkey == NULL) {
-                xmlSecNssError("CERT_ExtractPublicKey", NULL);
-                goto done;
-            }
-        }
+    cert = CERT_FindCertByNickname (CERT_GetDefaultCertDB(), (char *)name);
+    if (cert == NULL) {
+        /* not found */
+        retval = 0;
+        goto done;
+    }
 
-        if (keyReq->keyType & xmlSecKeyDataTypePrivate) {
-            privkey = PK11_FindKeyByAnyCert(cert, NULL);
-            if (privkey == NULL) {
-                xmlSecNssError("PK11_FindKeyByAnyCert", NULL);
-                goto done;
-            }
-        }
+    /* the public key is always required to determine the key data type */
+    pubkey = CERT_ExtractPublicKey(cert);
+    if (pubkey == NULL) {
+        xmlSecNssError("CERT_ExtractPublicKey", NULL);
+        goto done;
+    }
 
-        data = xmlSecNssPKIAdoptKey(privkey, pubkey);
-        if(data == NULL) {
-            xmlSecInternalError("xmlSecNssPKIAdoptKey", NULL);
+    if (keyType & xmlSecKeyDataTypePrivate) {
+        privkey = PK11_FindKeyByAnyCert(cert, NULL);
+        if (privkey == NULL) {
+            /* the private key might be on a token that is not logged in
+             * or not present yet: report not found but don't cache it */
+            retval = 1;
             goto done;
         }
-        privkey = NULL;
-        pubkey = NULL;
+    }
 
-        key = xmlSecKeyCreate();
-        if (key == NULL) {
-            xmlSecInternalError("xmlSecKeyCreate", NULL);
-            return (NULL);
-        }
+    data = xmlSecNssPKIAdoptKey(privkey, pubkey);
+    if(data == NULL) {
+        xmlSecInternalError("xmlSecNssPKIAdoptKey", NULL);
+        goto done;
+    }
+    privkey = NULL;
+    pubkey = NULL;
+
+    key = xmlSecKeyCreate();
+    if (key == NULL) {
+        xmlSecInternalError("xmlSecKeyCreate", NULL);
+        goto done;
+    }
 
 #ifndef XMLSEC_NO_X509
-        x509Data = xmlSecKeyDataCreate(xmlSecNssKeyDataX509Id);
-        if(x509Data == NULL) {
-            xmlSecInternalError("xmlSecKeyDataCreate", NULL);
-            goto done;
-        }
+    x509Data = xmlSecKeyDataCreate(xmlSecNssKeyDataX509Id);
+    if(x509Data == NULL) {
+        xmlSecInternalError("xmlSecKeyDataCreate", NULL);
+        goto done;
+    }
 
-        ret = xmlSecNssKeyDataX509AdoptKeyCert(x509Data, cert);
-        if (ret < 0) {
-            xmlSecInternalError("xmlSecNssKeyDataX509AdoptKeyCert", NULL);
-            goto done;
-        }
-        cert = NULL; /* owned by x509 data */
+    ret = xmlSecNssKeyDataX509AdoptKeyCert(x509Data, cert);
+    if (ret < 0) {
+        xmlSecInternalError("xmlSecNssKeyDataX509AdoptKeyCert", NULL);
+        goto done;
+    }
+    cert = NULL; /* owned by x509 data */
 #endif /* XMLSEC_NO_X509 */
 
-        ret = xmlSecKeySetValue(key, data);
-        if (ret < 0) {
-            xmlSecInternalError("xmlSecKeySetValue", NULL);
-            goto done;
-        }
-        data = NULL;
-
-        ret = xmlSecKeyAdoptData(key, x509Data);
-        if (ret < 0) {
-            xmlSecInternalError("xmlSecKeyAdoptData", NULL);
-            goto done;
-        }
-        x509Data = NULL;
+    ret = xmlSecKeySetValue(key, data);
+    if (ret < 0) {
+        xmlSecInternalError("xmlSecKeySetValue", NULL);
+        goto done;
+    }
+    data = NULL;
 
-        retval = key;
-        key = NULL;
+    ret = xmlSecKeyAdoptData(key, x509Data);
+    if (ret < 0) {
+        xmlSecInternalError("xmlSecKeyAdoptData", NULL);
+        goto done;
     }
+    x509Data = NULL;
+
+    /* success */
+    (*res) = key;
+    key = NULL;
+    retval = 0;
 
 done:
     if (cert != NULL) {
@@ -315,6 +469,88 @@ done:
     if (key != NULL) {
         xmlSecKeyDestroy(key);
     }
+    return (retval);
+}
+
+static xmlSecKeyPtr
+xmlSecNssKeysStoreFindKey(xmlSecKeyStorePtr store, const xmlChar* name, xmlSecKeyInfoCtxPtr keyInfoCtx) {
+    xmlSecNssKeysStoreCtxPtr ctx;
+    xmlSecNssKeysStoreCacheEntryPtr entry;
+    xmlSecKeyDataType keyType;
+    xmlSecKeyPtr key = NULL;
+    xmlSecKeyPtr retval = NULL;
+    int ret;
+
+    xmlSecAssert2(xmlSecKeyStoreCheckId(store, xmlSecNssKeysStoreId), NULL);
+    xmlSecAssert2(keyInfoCtx != NULL, NULL);
+
+    ctx = xmlSecNssKeysStoreGetCtx(store);
+    xmlSecAssert2(((ctx != NULL) && (ctx->simpleStore != NULL)), NULL);
+    xmlSecAssert2(ctx->mutex != NULL, NULL);
+
+    key = xmlSecKeyStoreFindKey(ctx->simpleStore, name, keyInfoCtx);
+    if (key != NULL) {
+        return (key);
+    }
+
+    /* Try to find the key in the NSS DB, and construct an xmlSecKey.
+     * we must have a name to lookup keys in NSS DB.
+     */
+    if (name == NULL) {
+        return (NULL);
+    }
+    keyType = keyInfoCtx->keyReq.keyType & (xmlSecKeyDataTypePublic | xmlSecKeyDataTypePrivate);
+    if (keyType == 0) {
+        return (NULL);
+    }
+
+    /* check the cache first */
+    xmlMutexLock(ctx->mutex);
+    entry = xmlSecNssKeysStoreCacheFind(ctx, name, keyType);
+    if(entry != NULL) {
+        if(entry->key != NULL) {
+            retval = xmlSecKeyDuplicate(entry->key);
+            if(retval == NULL) {
+                xmlSecInternalError("xmlSecKeyDuplicate", xmlSecKeyStoreGetName(store));
+            }
+        }
+        xmlMutexUnlock(ctx->mutex);
+        return (retval);
+    }
+    xmlMutexUnlock(ctx->mutex);
+
+    /* lookup NSS DB without holding the lock, errors and transient failures are not cached */
+    ret = xmlSecNssKeysStoreFindKeyInDB(name, keyType, &key);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecNssKeysStoreFindKeyInDB", xmlSecKeyStoreGetName(store));
+        return (NULL);
+    } else if(ret > 0) {
+        xmlSecAssert2(key == NULL, NULL);
+        return (NULL);
+    }
+
+    xmlMutexLock(ctx->mutex);
+    entry = xmlSecNssKeysStoreCacheFind(ctx, name, keyType);
+    if(entry != NULL) {
+        /* another thread was faster */
+        if(key != NULL) {
+            xmlSecKeyDestroy(key);
+        }
+    } else {
+        entry = xmlSecNssKeysStoreCacheAdd(ctx, name, keyType, key);
+        if(entry == NULL) {
+            xmlSecInternalError("xmlSecNssKeysStoreCacheAdd", xmlSecKeyStoreGetName(store));
+            xmlMutexUnlock(ctx->mutex);
+            return (NULL);
+        }
+    }
+    if(entry->key != NULL) {
+        retval = xmlSecKeyDuplicate(entry->key);
+        if(retval == NULL) {
+            xmlSecInternalError("xmlSecKeyDuplicate", xmlSecKeyStoreGetName(store));
+        }
+    }
+    xmlMutexUnlock(ctx->mutex);
 
     return (retval);
 }
@@ -324,7 +560,7 @@ xmlSecNssKeysStoreFindKeyFromX509Data(xmlSecKeyStorePtr store, xmlSecKeyX509Data
     xmlSecKeyInfoCtxPtr keyInfoCtx
 ) {
 #ifndef XMLSEC_NO_X509
-    xmlSecKeyStorePtr* simplekeystore;
+    xmlSecNssKeysStoreCtxPtr ctx;
     xmlSecPtrListPtr keysList;
     xmlSecKeyPtr key, res;
 
@@ -332,10 +568,10 @@ xmlSecNssKeysStoreFindKeyFromX509Data(xmlSecKeyStorePtr store, xmlSecKeyX509Data
     xmlSecAssert2(x509Data != NULL, NULL);
     xmlSecAssert2(keyInfoCtx != NULL, NULL);
 
-    simplekeystore = xmlSecNssKeysStoreGetCtx(store);
-    xmlSecAssert2(((simplekeystore != NULL) && (*simplekeystore != NULL)), NULL);
+    ctx = xmlSecNssKeysStoreGetCtx(store);
+    xmlSecAssert2(((ctx != NULL) && (ctx->simpleStore != NULL)), NULL);
 
-    keysList = xmlSecSimpleKeysStoreGetKeys(*simplekeystore);
+    keysList = xmlSecSimpleKeysStoreGetKeys(ctx->simpleStore);
     if(keysList == NULL) {
         xmlSecInternalError("xmlSecSimpleKeysStoreGetKeys", NULL);
         return(NULL);
@@ -0,0 +1,1107 @@
+/*
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * Open Packaging Conventions (OPC) packages support.
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2024 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+/**
+ * SECTION:opc
+ * @Short_description: Open Packaging Conventions (OPC) packages support.
+ * @Stability: Stable
+ *
+ * [Open Packaging Conventions](http://standards.iso.org/ittf/PubliclyAvailableStandards/c061796_ISO_IEC_29500-2_2012.zip)
+ * packages (.docx, .xlsx, .pptx, ...) are ZIP archives where each file
+ * is a package part. The package signature references the parts from
+ * the &lt;dsig:Manifest/&gt; element(s) inside the &lt;dsig:Object/&gt;
+ * element(s) using the part names as URIs (e.g.
+ * "/word/document.xml?ContentType=application/vnd...main+xml").
+ *
+ * The package engine reads the parts directly from the ZIP archive
+ * (the parts are inflated as they are digested, nothing is extracted
+ * to disk) and digests them on multiple threads.
+ */
+#include "globals.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libxml/tree.h>
+#include <libxml/uri.h>
+
+#include <xmlsec/xmlsec.h>
+#include <xmlsec/xmltree.h>
+#include <xmlsec/buffer.h>
+#include <xmlsec/parser.h>
+#include <xmlsec/transforms.h>
+#include <xmlsec/base64.h>
+#include <xmlsec/membuf.h>
+#include <xmlsec/xmldsig.h>
+#include <xmlsec/opc.h>
+#include <xmlsec/errors.h>
+
+#include "cast_helpers.h"
+#include "parallel_helpers.h"
+#include "zip_helpers.h"
+
+typedef struct _xmlSecOpcPackagePart {
+    xmlChar*            name;
+    xmlChar*            contentType;
+    xmlSecZipEntryPtr   entry;
+} xmlSecOpcPackagePart, *xmlSecOpcPackagePartPtr;
+
+struct _xmlSecOpcPackage {
+    xmlSecZipArchivePtr         zip;
+    xmlSecOpcPackagePartPtr     parts;          /* sorted by name */
+    xmlSecSize                  partsNum;
+};
+
+static int
+xmlSecOpcPackagePartCmp(const void* a, const void* b) {
+    return(xmlStrcasecmp(((const xmlSecOpcPackagePart*)a)->name, ((const xmlSecOpcPackagePart*)b)->name));
+}
+
+static xmlSecOpcPackagePartPtr
+xmlSecOpcPackageFindPart(xmlSecOpcPackagePtr pkg, const xmlChar* partName) {
+    xmlSecSize lo, hi, mid;
+    int ret;
+
+    xmlSecAssert2(pkg != NULL, NULL);
+    xmlSecAssert2(partName != NULL, NULL);
+
+    /* part names are ASCII case-insensitive */
+    lo = 0;
+    hi = pkg->partsNum;
+    while(lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        ret = xmlStrcasecmp(pkg->parts[mid].name, partName);
+        if(ret == 0) {
+            return(&(pkg->parts[mid]));
+        } else if(ret < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return(NULL);
+}
+
+/*
+ * The entry sizes come from the (untrusted) central directory, so the
+ * buffer grows as the data is actually read and the data size is limited.
+ */
+#define XMLSEC_OPC_PACKAGE_READ_CHUNK_SIZE              (64 * 1024)
+#define XMLSEC_OPC_PACKAGE_CONTENT_TYPES_MAX_SIZE       (16 * 1024 * 1024)
+#define XMLSEC_OPC_PACKAGE_PART_MAX_SIZE                (256 * 1024 * 1024)
+
+static int
+xmlSecOpcPackageReadEntry(xmlSecOpcPackagePtr pkg, xmlSecZipEntryPtr entry, xmlSecSize maxSize,
+                          xmlSecBufferPtr buffer) {
+    xmlSecZipReaderPtr reader;
+    xmlSecSize size, readSize, newMaxSize;
+    int ret;
+    int res = -1;
+
+    xmlSecAssert2(pkg != NULL, -1);
+    xmlSecAssert2(pkg->zip != NULL, -1);
+    xmlSecAssert2(entry != NULL, -1);
+    xmlSecAssert2(maxSize > 0, -1);
+    xmlSecAssert2(buffer != NULL, -1);
+
+    if(entry->size > maxSize) {
+        xmlSecInvalidSizeMoreThanError("OPC part size", entry->size, maxSize, NULL);
+        return(-1);
+    }
+
+    reader = xmlSecZipReaderCreate(pkg->zip, entry);
+    if(reader == NULL) {
+        xmlSecInternalError2("xmlSecZipReaderCreate", NULL,
+            "name=%s", xmlSecErrorsSafeString(entry->name));
+        return(-1);
+    }
+
+    /* the reader fails if the data is larger than the declared size and
+     * checks the size (and CRC-32) at the end of data */
+    size = 0;
+    do {
+        if(xmlSecBufferGetMaxSize(buffer) - size < XMLSEC_OPC_PACKAGE_READ_CHUNK_SIZE) {
+            newMaxSize = size + ((size > XMLSEC_OPC_PACKAGE_READ_CHUNK_SIZE) ? size : XMLSEC_OPC_PACKAGE_READ_CHUNK_SIZE);
+            if(newMaxSize > entry->size + 1) {
+                newMaxSize = entry->size + 1;
+            }
+            if(newMaxSize > xmlSecBufferGetMaxSize(buffer)) {
+                ret = xmlSecBufferSetMaxSize(buffer, newMaxSize);
+                if(ret < 0) {
+                    xmlSecInternalError2("xmlSecBufferSetMaxSize", NULL,
+                        "size=" XMLSEC_SIZE_FMT, newMaxSize);
+                    goto done;
+                }
+            }
+        }
+        xmlSecAssert2(xmlSecBufferGetMaxSize(buffer) > size, -1);
+
+        ret = xmlSecZipReaderRead(reader, xmlSecBufferGetData(buffer) + size,
+            xmlSecBufferGetMaxSize(buffer) - size, &readSize);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecZipReaderRead", NULL,
+                "name=%s", xmlSecErrorsSafeString(entry->name));
+            goto done;
+        }
+        size += readSize;
+    } while(readSize > 0);
+
+    if(size != entry->size) {
+        xmlSecInvalidSizeError("OPC part size", size, entry->size, NULL);
+        goto done;
+    }
+    ret = xmlSecBufferSetSize(buffer, size);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecBufferSetSize", NULL,
+            "size=" XMLSEC_SIZE_FMT, size);
+        goto done;
+    }
+
+    /* success */
+    res = 0;
+
+done:
+    xmlSecZipReaderDestroy(reader);
+    return(res);
+}
+
+/* gets the part content types from the [Content_Types].xml part */
+static int
+xmlSecOpcPackageReadContentTypes(xmlSecOpcPackagePtr pkg) {
+    xmlSecZipEntryPtr entry;
+    xmlSecOpcPackagePartPtr part;
+    xmlSecBuffer buffer;
+    xmlDocPtr doc = NULL;
+    xmlNodePtr root, cur;
+    xmlChar* name;
+    xmlChar* ext;
+    const xmlChar* p;
+    const xmlChar* q;
+    xmlSecSize ii;
+    int ret;
+    int res = -1;
+
+    xmlSecAssert2(pkg != NULL, -1);
+    xmlSecAssert2(pkg->zip != NULL, -1);
+
+    entry = xmlSecZipArchiveFindEntry(pkg->zip, xmlSecOpcContentTypesPartName);
+    if(entry == NULL) {
+        xmlSecOtherError2(XMLSEC_ERRORS_R_INVALID_DATA, NULL,
+            "part is not found; name=%s", xmlSecOpcContentTypesPartName);
+        return(-1);
+    }
+
+    ret = xmlSecBufferInitialize(&buffer, 0);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecBufferInitialize", NULL);
+        return(-1);
+    }
+    ret = xmlSecOpcPackageReadEntry(pkg, entry, XMLSEC_OPC_PACKAGE_CONTENT_TYPES_MAX_SIZE, &buffer);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecOpcPackageReadEntry", NULL);
+        goto done;
+    }
+    doc = xmlSecParseMemory(xmlSecBufferGetData(&buffer), xmlSecBufferGetSize(&buffer), 0);
+    if(doc == NULL) {
+        xmlSecInternalError("xmlSecParseMemory", NULL);
+        goto done;
+    }
+    root = xmlDocGetRootElement(doc);
+    if((root == NULL) || !xmlSecCheckNodeName(root, xmlSecOpcNodeTypes, xmlSecOpcContentTypesNs)) {
+        xmlSecInvalidNodeError(root, xmlSecOpcNodeTypes, NULL);
+        goto done;
+    }
+
+    /* overrides first */
+    for(cur = xmlSecGetNextElementNode(root->children); cur != NULL; cur = xmlSecGetNextElementNode(cur->next)) {
+        if(!xmlSecCheckNodeName(cur, xmlSecOpcNodeOverride, xmlSecOpcContentTypesNs)) {
+            continue;
+        }
+        name = xmlGetProp(cur, xmlSecOpcAttrPartName);
+        if(name == NULL) {
+            xmlSecInvalidNodeAttributeError(cur, xmlSecOpcAttrPartName, NULL, "empty");
+            goto done;
+        }
+        part = xmlSecOpcPackageFindPart(pkg, name);
+        xmlFree(name);
+        if((part != NULL) && (part->contentType == NULL)) {
+            part->contentType = xmlGetProp(cur, xmlSecOpcAttrContentType);
+        }
+    }
+
+    /* then defaults by extension */
+    for(ii = 0; ii < pkg->partsNum; ++ii) {
+        part = &(pkg->parts[ii]);
+        if(part->contentType != NULL) {
+            continue;
+        }
+        /* the extension is after the last '.' in the last segment */
+        p = NULL;
+        for(q = part->name; (*q) != '\0'; ++q) {
+            if((*q) == '.') {
+                p = q;
+            } else if((*q) == '/') {
+                p = NULL;
+            }
+        }
+        if(p == NULL) {
+            continue;
+        }
+        for(cur = xmlSecGetNextElementNode(root->children); cur != NULL; cur = xmlSecGetNextElementNode(cur->next)) {
+            if(!xmlSecCheckNodeName(cur, xmlSecOpcNodeDefault, xmlSecOpcContentTypesNs)) {
+                continue;
+            }
+            ext = xmlGetProp(cur, xmlSecOpcAttrExtension);
+            if(ext == NULL) {
+                xmlSecInvalidNodeAttributeError(cur, xmlSecOpcAttrExtension, NULL, "empty");
+                goto done;
+            }
+            ret = xmlStrcasecmp(ext, p + 1);
+            xmlFree(ext);
+            if(ret == 0) {
+                part->contentType = xmlGetProp(cur, xmlSecOpcAttrContentType);
+                break;
+            }
+        }
+    }
+
+    /* success */
+    res = 0;
+
+done:
+    if(doc != NULL) {
+        xmlFreeDoc(doc);
+    }
+    xmlSecBufferFinalize(&buffer);
+    return(res);
+}
+
+/**
+ * xmlSecOpcPackageOpen:
+ * @filename:           the package filename.
+ *
+ * Opens the OPC package: reads the ZIP archive central directory and
+ * the parts content types. The parts data is read only when needed.
+ * The caller is responsible for closing the returned package by calling
+ * #xmlSecOpcPackageClose function.
+ *
+ * Returns: the pointer to the package or NULL if an error occurs.
+ */
+xmlSecOpcPackagePtr
+xmlSecOpcPackageOpen(const char* filename) {
+    xmlSecOpcPackagePtr pkg;
+    xmlSecZipEntryPtr entry;
+    xmlSecSize ii, size;
+    int ret;
+
+    xmlSecAssert2(filename != NULL, NULL);
+
+    pkg = (xmlSecOpcPackagePtr)xmlMalloc(sizeof(xmlSecOpcPackage));
+    if(pkg == NULL) {
+        xmlSecMallocError(sizeof(xmlSecOpcPackage), NULL);
+        return(NULL);
+    }
+    memset(pkg, 0, sizeof(xmlSecOpcPackage));
+
+    pkg->zip = xmlSecZipArchiveOpen(filename);
+    if(pkg->zip == NULL) {
+        xmlSecInternalError2("xmlSecZipArchiveOpen", NULL,
+            "filename=%s", xmlSecErrorsSafeString(filename));
+        goto error;
+    }
+
+    size = xmlSecZipArchiveGetSize(pkg->zip);
+    if(size > 0) {
+        pkg->parts = (xmlSecOpcPackagePartPtr)xmlMalloc(sizeof(xmlSecOpcPackagePart) * size);
+        if(pkg->parts == NULL) {
+            xmlSecMallocError(sizeof(xmlSecOpcPackagePart) * size, NULL);
+            goto error;
+        }
+        memset(pkg->parts, 0, sizeof(xmlSecOpcPackagePart) * size);
+    }
+
+    /* every file (except the content types) is a part, the part name
+     * is the file name with the leading '/' */
+    for(ii = 0; ii < size; ++ii) {
+        entry = xmlSecZipArchiveGetEntry(pkg->zip, ii);
+        if((entry == NULL) || (entry->name == NULL)) {
+            xmlSecInternalError("xmlSecZipArchiveGetEntry", NULL);
+            goto error;
+        }
+        if((entry->name[0] == '\0') || (entry->name[xmlStrlen(entry->name) - 1] == '/') ||
+           (xmlStrcasecmp(entry->name, xmlSecOpcContentTypesPartName) == 0)) {
+            continue;
+        }
+
+        /* the ZIP item names don't start with '/' (otherwise two different
+         * items might map to the same part name) */
+        if(entry->name[0] == '/') {
+            xmlSecOtherError2(XMLSEC_ERRORS_R_INVALID_DATA, NULL,
+                "invalid ZIP item name; name=%s", xmlSecErrorsSafeString(entry->name));
+            goto error;
+        }
+
+        pkg->parts[pkg->partsNum].name = xmlStrncatNew(BAD_CAST "/", entry->name, -1);
+        if(pkg->parts[pkg->partsNum].name == NULL) {
+            xmlSecStrdupError(entry->name, NULL);
+            goto error;
+        }
+        pkg->parts[pkg->partsNum].entry = entry;
+        ++(pkg->partsNum);
+    }
+    if(pkg->partsNum > 0) {
+        qsort(pkg->parts, pkg->partsNum, sizeof(xmlSecOpcPackagePart), xmlSecOpcPackagePartCmp);
+    }
+
+    /* the equivalent (ASCII case-insensitive) part names are not allowed:
+     * otherwise the signed part might be different from the part used
+     * by the application */
+    for(ii = 1; ii < pkg->partsNum; ++ii) {
+        if(xmlStrcasecmp(pkg->parts[ii - 1].name, pkg->parts[ii].name) == 0) {
+            xmlSecOtherError2(XMLSEC_ERRORS_R_INVALID_DATA, NULL,
+                "duplicate part name; name=%s", xmlSecErrorsSafeString(pkg->parts[ii].name));
+            goto error;
+        }
+    }
+
+    ret = xmlSecOpcPackageReadContentTypes(pkg);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecOpcPackageReadContentTypes", NULL,
+            "filename=%s", xmlSecErrorsSafeString(filename));
+        goto error;
+    }
+    return(pkg);
+
+error:
+    xmlSecOpcPackageClose(pkg);
+    return(NULL);
+}
+
+/**
+ * xmlSecOpcPackageClose:
+ * @pkg:                the pointer to OPC package.
+ *
+ * Closes the package and frees the memory.
+ */
+void
+xmlSecOpcPackageClose(xmlSecOpcPackagePtr pkg) {
+    xmlSecSize ii;
+
+    xmlSecAssert(pkg != NULL);
+
+    if(pkg->parts != NULL) {
+        for(ii = 0; ii < pkg->partsNum; ++ii) {
+            if(pkg->parts[ii].name != NULL) {
+                xmlFree(pkg->parts[ii].name);
+            }
+            if(pkg->parts[ii].contentType != NULL) {
+                xmlFree(pkg->parts[ii].contentType);
+            }
+        }
+        xmlFree(pkg->parts);
+    }
+    if(pkg->zip != NULL) {
+        xmlSecZipArchiveClose(pkg->zip);
+    }
+    memset(pkg, 0, sizeof(xmlSecOpcPackage));
+    xmlFree(pkg);
+}
+
+/**
+ * xmlSecOpcPackageGetPartsNumber:
+ * @pkg:                the pointer to OPC package.
+ *
+ * Gets the number of parts in the package.
+ *
+ * Returns: the number of parts.
+ */
+xmlSecSize
+xmlSecOpcPackageGetPartsNumber(xmlSecOpcPackagePtr pkg) {
+    xmlSecAssert2(pkg != NULL, 0);
+    return(pkg->partsNum);
+}
+
+/**
+ * xmlSecOpcPackageGetPartName:
+ * @pkg:                the pointer to OPC package.
+ * @pos:                the part position.
+ *
+ * Gets the name of the part at @pos (the parts are sorted by name).
+ *
+ * Returns: the part name (e.g. "/word/document.xml") or NULL if an error occurs.
+ */
+const xmlChar*
+xmlSecOpcPackageGetPartName(xmlSecOpcPackagePtr pkg, xmlSecSize pos) {
+    xmlSecAssert2(pkg != NULL, NULL);
+    xmlSecAssert2(pos < pkg->partsNum, NULL);
+
+    return(pkg->parts[pos].name);
+}
+
+/**
+ * xmlSecOpcPackageGetPartContentType:
+ * @pkg:                the pointer to OPC package.
+ * @partName:           the part name.
+ *
+ * Gets the content type of the part @partName from the package
+ * "[Content_Types].xml" part.
+ *
+ * Returns: the part content type or NULL if the part is not found or
+ * doesn't have a content type.
+ */
+const xmlChar*
+xmlSecOpcPackageGetPartContentType(xmlSecOpcPackagePtr pkg, const xmlChar* partName) {
+    xmlSecOpcPackagePartPtr part;
+
+    xmlSecAssert2(pkg != NULL, NULL);
+    xmlSecAssert2(partName != NULL, NULL);
+
+    part = xmlSecOpcPackageFindPart(pkg, partName);
+    if(part == NULL) {
+        return(NULL);
+    }
+    return(part->contentType);
+}
+
+/**
+ * xmlSecOpcPackageReadPart:
+ * @pkg:                the pointer to OPC package.
+ * @partName:           the part name.
+ * @buffer:             the output buffer.
+ *
+ * Reads the part @partName data (e.g. the signature part) into @buffer.
+ * The parts larger than 256MB are rejected.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecOpcPackageReadPart(xmlSecOpcPackagePtr pkg, const xmlChar* partName, xmlSecBufferPtr buffer) {
+    xmlSecOpcPackagePartPtr part;
+    int ret;
+
+    xmlSecAssert2(pkg != NULL, -1);
+    xmlSecAssert2(partName != NULL, -1);
+    xmlSecAssert2(buffer != NULL, -1);
+
+    part = xmlSecOpcPackageFindPart(pkg, partName);
+    if(part == NULL) {
+        xmlSecOtherError2(XMLSEC_ERRORS_R_INVALID_DATA, NULL,
+            "part is not found; name=%s", xmlSecErrorsSafeString(partName));
+        return(-1);
+    }
+    ret = xmlSecOpcPackageReadEntry(pkg, part->entry, XMLSEC_OPC_PACKAGE_PART_MAX_SIZE, buffer);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecOpcPackageReadEntry", NULL,
+            "name=%s", xmlSecErrorsSafeString(partName));
+        return(-1);
+    }
+    return(0);
+}
+
+#ifndef XMLSEC_NO_XMLDSIG
+
+/**************************************************************************
+ *
+ * Package signature: the &lt;dsig:Reference/&gt; elements from the
+ * &lt;dsig:Manifest/&gt; elements that point to the package parts are
+ * read and prepared on the main thread, the parts data is digested on
+ * the worker threads (each part has its own transforms chain and its
+ * own file handle), and then the results are written or verified on the
+ * main thread again.
+ *
+ *************************************************************************/
+typedef struct _xmlSecOpcPackageReference {
+    xmlSecDSigReferenceCtxPtr   dsigRefCtx;
+    xmlNodePtr                  digestValueNode;
+    xmlSecOpcPackagePartPtr     part;
+} xmlSecOpcPackageReference, *xmlSecOpcPackageReferencePtr;
+
+typedef struct _xmlSecOpcPackageDigestCtx {
+    xmlSecOpcPackagePtr         pkg;
+    xmlSecOpcPackageReferencePtr refs;
+    xmlSecSize                  refsNum;
+    xmlSecSize                  refsMax;
+} xmlSecOpcPackageDigestCtx, *xmlSecOpcPackageDigestCtxPtr;
+
+static const xmlChar* xmlSecOpcPackageDSigIds[] = { xmlSecAttrId, NULL };
+
+/* the part references are absolute part names (but not network path references) */
+static int
+xmlSecOpcPackageIsPartUri(const xmlChar* uri) {
+    return((uri != NULL) && (uri[0] == '/') && (uri[1] != '/'));
+}
+
+/* gets the value of the "ContentType" parameter from the URI query (or NULL) */
+static xmlChar*
+xmlSecOpcPackageGetUriContentType(const xmlChar* query) {
+    const xmlChar* p;
+    const xmlChar* end;
+    xmlSecSize len;
+    int lenInt;
+
+    xmlSecAssert2(query != NULL, NULL);
+
+    for(p = query; p != NULL; p = xmlStrchr(p, '&')) {
+        if(p[0] == '&') {
+            ++p;
+        }
+        if(xmlStrncmp(p, xmlSecOpcUriContentType, xmlStrlen(xmlSecOpcUriContentType)) != 0) {
+            continue;
+        }
+        p += xmlStrlen(xmlSecOpcUriContentType);
+        end = xmlStrchr(p, '&');
+        len = (end != NULL) ? (xmlSecSize)(end - p) : (xmlSecSize)xmlStrlen(p);
+        XMLSEC_SAFE_CAST_SIZE_TO_INT(len, lenInt, return(NULL), NULL);
+        return(BAD_CAST xmlURIUnescapeString((const char*)p, lenInt, NULL));
+    }
+    return(NULL);
+}
+
+/* finds the part for URI "/part/name?ContentType=..." and checks the content type */
+static xmlSecOpcPackagePartPtr
+xmlSecOpcPackageFindPartByUri(xmlSecOpcPackagePtr pkg, const xmlChar* uri) {
+    xmlSecOpcPackagePartPtr part;
+    const xmlChar* query;
+    xmlChar* partName;
+    xmlChar* contentType;
+    int len;
+
+    xmlSecAssert2(pkg != NULL, NULL);
+    xmlSecAssert2(uri != NULL, NULL);
+
+    query = xmlStrchr(uri, '?');
+    len = (query != NULL) ? (int)(query - uri) : xmlStrlen(uri);
+    partName = BAD_CAST xmlURIUnescapeString((const char*)uri, len, NULL);
+    if(partName == NULL) {
+        xmlSecXmlError2("xmlURIUnescapeString", NULL,
+            "uri=%s", xmlSecErrorsSafeString(uri));
+        return(NULL);
+    }
+    part = xmlSecOpcPackageFindPart(pkg, partName);
+    if(part == NULL) {
+        xmlSecOtherError2(XMLSEC_ERRORS_R_INVALID_URI_TYPE, NULL,
+            "part is not found; uri=%s", xmlSecErrorsSafeString(uri));
+        xmlFree(partName);
+        return(NULL);
+    }
+    xmlFree(partName);
+
+    if(query != NULL) {
+        contentType = xmlSecOpcPackageGetUriContentType(query + 1);
+        if((contentType != NULL) &&
+           ((part->contentType == NULL) || (xmlStrcasecmp(contentType, part->contentType) != 0))) {
+            xmlSecOtherError3(XMLSEC_ERRORS_R_INVALID_DATA, NULL,
+                "part content type doesn't match; uri=%s; contentType=%s",
+                xmlSecErrorsSafeString(uri), xmlSecErrorsSafeString(part->contentType));
+            xmlFree(contentType);
+            return(NULL);
+        }
+        if(contentType != NULL) {
+            xmlFree(contentType);
+        }
+    }
+    return(part);
+}
+
+/* reads the <dsig:Reference/> node and prepares its transforms chain for the part data */
+static int
+xmlSecOpcPackageReferenceRead(xmlSecOpcPackageReferencePtr ref, xmlSecOpcPackagePtr pkg, xmlNodePtr node) {
+    xmlSecDSigReferenceCtxPtr dsigRefCtx;
+    xmlSecTransformCtxPtr transformCtx;
+    xmlNodePtr cur;
+    int ret;
+
+    xmlSecAssert2(ref != NULL, -1);
+    xmlSecAssert2(ref->dsigRefCtx != NULL, -1);
+    xmlSecAssert2(ref->dsigRefCtx->dsigCtx != NULL, -1);
+    xmlSecAssert2(pkg != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    dsigRefCtx = ref->dsigRefCtx;
+    transformCtx = &(dsigRefCtx->transformCtx);
+
+    /* read attributes first: the URI is resolved in the package only
+     * thus there is no URI type check */
+    dsigRefCtx->uri = xmlGetProp(node, xmlSecAttrURI);
+    dsigRefCtx->id  = xmlGetProp(node, xmlSecAttrId);
+    dsigRefCtx->type= xmlGetProp(node, xmlSecAttrType);
+
+    ref->part = xmlSecOpcPackageFindPartByUri(pkg, dsigRefCtx->uri);
+    if(ref->part == NULL) {
+        xmlSecInternalError2("xmlSecOpcPackageFindPartByUri", NULL,
+            "uri=%s", xmlSecErrorsSafeString(dsigRefCtx->uri));
+        return(-1);
+    }
+
+    /* first is optional Transforms node */
+    cur  = xmlSecGetNextElementNode(node->children);
+    if((cur != NULL) && (xmlSecCheckNodeName(cur, xmlSecNodeTransforms, xmlSecDSigNs))) {
+        ret = xmlSecTransformCtxNodesListRead(transformCtx, cur, xmlSecTransformUsageDSigTransform);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecTransformCtxNodesListRead", NULL,
+                                 "node=%s", xmlSecErrorsSafeString(xmlSecNodeGetName(cur)));
+            return(-1);
+        }
+        cur = xmlSecGetNextElementNode(cur->next);
+    }
+
+    /* insert membuf if requested */
+    if((dsigRefCtx->dsigCtx->flags & XMLSEC_DSIG_FLAGS_STORE_MANIFEST_REFERENCES) != 0) {
+        dsigRefCtx->preDigestMemBufMethod = xmlSecTransformCtxCreateAndAppend(transformCtx,
+                                                xmlSecTransformMemBufId);
+        if(dsigRefCtx->preDigestMemBufMethod == NULL) {
+            xmlSecInternalError("xmlSecTransformCtxCreateAndAppend(xmlSecTransformMemBufId)", NULL);
+            return(-1);
+        }
+    }
+
+    /* next node is required DigestMethod. */
+    if((cur != NULL) && (xmlSecCheckNodeName(cur, xmlSecNodeDigestMethod, xmlSecDSigNs))) {
+        dsigRefCtx->digestMethod = xmlSecTransformCtxNodeRead(transformCtx, cur,
+                                        xmlSecTransformUsageDigestMethod);
+        if(dsigRefCtx->digestMethod == NULL) {
+            xmlSecInternalError("xmlSecTransformCtxNodeRead", xmlSecNodeGetName(cur));
+            return(-1);
+        }
+        cur = xmlSecGetNextElementNode(cur->next);
+    } else if(dsigRefCtx->dsigCtx->defDigestMethodId != xmlSecTransformIdUnknown) {
+        dsigRefCtx->digestMethod = xmlSecTransformCtxCreateAndAppend(transformCtx,
+                                        dsigRefCtx->dsigCtx->defDigestMethodId);
+        if(dsigRefCtx->digestMethod == NULL) {
+            xmlSecInternalError("xmlSecTransformCtxCreateAndAppend", NULL);
+            return(-1);
+        }
+    } else {
+        xmlSecInvalidNodeError(cur, xmlSecNodeDigestMethod, NULL);
+        return(-1);
+    }
+    dsigRefCtx->digestMethod->operation = dsigRefCtx->dsigCtx->operation;
+
+    /* last node is required DigestValue */
+    if((cur != NULL) && (xmlSecCheckNodeName(cur, xmlSecNodeDigestValue, xmlSecDSigNs))) {
+        ref->digestValueNode = cur;
+        cur = xmlSecGetNextElementNode(cur->next);
+    } else {
+        xmlSecInvalidNodeError(cur, xmlSecNodeDigestValue, NULL);
+        return(-1);
+    }
+    if(cur != NULL) {
+        xmlSecUnexpectedNodeError(cur,  NULL);
+        return(-1);
+    }
+
+    /* if we need to write result to xml node then we need base64 encode result */
+    if(dsigRefCtx->dsigCtx->operation == xmlSecTransformOperationSign) {
+        xmlSecTransformPtr base64Encode;
+
+        base64Encode = xmlSecTransformCtxCreateAndAppend(transformCtx, xmlSecTransformBase64Id);
+        if(base64Encode == NULL) {
+            xmlSecInternalError("xmlSecTransformCtxCreateAndAppend", NULL);
+            return(-1);
+        }
+        base64Encode->operation = xmlSecTransformOperationEncode;
+    }
+
+    /* the part size from the ZIP central directory is not trusted and
+     * it is used only if it matches the compressed data size */
+    xmlSecTransformCtxSetInputSizeHint(transformCtx, xmlSecZipEntryGetSizeHint(ref->part->entry));
+    ret = xmlSecTransformCtxPrepare(transformCtx, xmlSecTransformDataTypeBin);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecTransformCtxPrepare(TypeBin)", NULL);
+        return(-1);
+    }
+    return(0);
+}
+
+/* digests one part: called from the worker threads */
+static int
+xmlSecOpcPackageDigestTask(void* data, xmlSecSize pos) {
+    xmlSecOpcPackageDigestCtxPtr ctx = (xmlSecOpcPackageDigestCtxPtr)data;
+    xmlSecOpcPackageReferencePtr ref;
+    xmlSecTransformCtxPtr transformCtx;
+    xmlSecZipReaderPtr reader;
+    xmlSecByte* buf = NULL;
+    xmlSecSize bufSize, readSize;
+    int ret;
+    int res = -1;
+
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->pkg != NULL, -1);
+    xmlSecAssert2(pos < ctx->refsNum, -1);
+
+    ref = &(ctx->refs[pos]);
+    xmlSecAssert2(ref->dsigRefCtx != NULL, -1);
+    xmlSecAssert2(ref->part != NULL, -1);
+
+    transformCtx = &(ref->dsigRefCtx->transformCtx);
+    xmlSecAssert2(transformCtx->first != NULL, -1);
+
+    reader = xmlSecZipReaderCreate(ctx->pkg->zip, ref->part->entry);
+    if(reader == NULL) {
+        xmlSecInternalError2("xmlSecZipReaderCreate", NULL,
+            "part=%s", xmlSecErrorsSafeString(ref->part->name));
+        return(-1);
+    }
+
+    bufSize = xmlSecTransformCtxGetBinaryChunkSize(transformCtx);
+    buf = (xmlSecByte*)xmlMalloc(bufSize);
+    if(buf == NULL) {
+        xmlSecMallocError(bufSize, NULL);
+        goto done;
+    }
+
+    while(1) {
+        ret = xmlSecZipReaderRead(reader, buf, bufSize, &readSize);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecZipReaderRead", NULL,
+                "part=%s", xmlSecErrorsSafeString(ref->part->name));
+            goto done;
+        }
+        if(readSize == 0) {
+            break;
+        }
+        ret = xmlSecTransformPushBin(transformCtx->first, buf, readSize, 0, transformCtx);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecTransformPushBin", NULL,
+                "part=%s", xmlSecErrorsSafeString(ref->part->name));
+            goto done;
+        }
+    }
+    ret = xmlSecTransformPushBin(transformCtx->first, NULL, 0, 1, transformCtx);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecTransformPushBin", NULL,
+            "part=%s", xmlSecErrorsSafeString(ref->part->name));
+        goto done;
+    }
+    transformCtx->status = xmlSecTransformStatusFinished;
+
+    /* success */
+    res = 0;
+
+done:
+    if(buf != NULL) {
+        xmlFree(buf);
+    }
+    xmlSecZipReaderDestroy(reader);
+    return(res);
+}
+
+/* writes or verifies the part digest */
+static int
+xmlSecOpcPackageReferenceFinish(xmlSecOpcPackageReferencePtr ref) {
+    xmlSecDSigReferenceCtxPtr dsigRefCtx;
+    int ret;
+
+    xmlSecAssert2(ref != NULL, -1);
+    xmlSecAssert2(ref->dsigRefCtx != NULL, -1);
+    xmlSecAssert2(ref->digestValueNode != NULL, -1);
+
+    dsigRefCtx = ref->dsigRefCtx;
+    dsigRefCtx->result = dsigRefCtx->transformCtx.result;
+
+    if(dsigRefCtx->dsigCtx->operation == xmlSecTransformOperationSign) {
+        xmlSecByte* outBuf;
+        xmlSecSize outSize;
+        int outLen;
+
+        if((dsigRefCtx->result == NULL) || (xmlSecBufferGetData(dsigRefCtx->result) == NULL)) {
+            xmlSecOtherError(XMLSEC_ERRORS_R_INVALID_RESULT, NULL, NULL);
+            return(-1);
+        }
+        outBuf = xmlSecBufferGetData(dsigRefCtx->result);
+        outSize = xmlSecBufferGetSize(dsigRefCtx->result);
+        XMLSEC_SAFE_CAST_SIZE_TO_INT(outSize, outLen, return(-1), NULL);
+        xmlNodeSetContentLen(ref->digestValueNode, outBuf, outLen);
+        dsigRefCtx->status = xmlSecDSigStatusSucceeded;
+    } else {
+        ret = xmlSecTransformVerifyNodeContent(dsigRefCtx->digestMethod,
+                    ref->digestValueNode, &(dsigRefCtx->transformCtx));
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformVerifyNodeContent", NULL);
+            return(-1);
+        }
+        if(dsigRefCtx->digestMethod->status == xmlSecTransformStatusOk) {
+            dsigRefCtx->status = xmlSecDSigStatusSucceeded;
+        } else {
+            dsigRefCtx->status = xmlSecDSigStatusInvalid;
+        }
+    }
+    return(0);
+}
+
+static int
+xmlSecOpcPackageDigestCtxAddReference(xmlSecOpcPackageDigestCtxPtr ctx, xmlSecDSigReferenceCtxPtr dsigRefCtx,
+                                      xmlNodePtr node) {
+    xmlSecOpcPackageReferencePtr refs;
+    xmlSecSize newMax;
+    int ret;
+
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(dsigRefCtx != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    if(ctx->refsNum >= ctx->refsMax) {
+        newMax = (ctx->refsMax > 0) ? (2 * ctx->refsMax) : 16;
+        refs = (xmlSecOpcPackageReferencePtr)xmlRealloc(ctx->refs, sizeof(xmlSecOpcPackageReference) * newMax);
+        if(refs == NULL) {
+            xmlSecMallocError(sizeof(xmlSecOpcPackageReference) * newMax, NULL);
+            return(-1);
+        }
+        ctx->refs = refs;
+        ctx->refsMax = newMax;
+    }
+
+    memset(&(ctx->refs[ctx->refsNum]), 0, sizeof(xmlSecOpcPackageReference));
+    ctx->refs[ctx->refsNum].dsigRefCtx = dsigRefCtx;
+    ret = xmlSecOpcPackageReferenceRead(&(ctx->refs[ctx->refsNum]), ctx->pkg, node);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecOpcPackageReferenceRead", NULL,
+            "uri=%s", xmlSecErrorsSafeString(dsigRefCtx->uri));
+        return(-1);
+    }
+    ++(ctx->refsNum);
+    return(0);
+}
+
+static int
+xmlSecOpcPackageProcessManifest(xmlSecOpcPackageDigestCtxPtr ctx, xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node) {
+    xmlSecDSigReferenceCtxPtr dsigRefCtx;
+    xmlChar* uri;
+    xmlNodePtr cur;
+    int isPart;
+    int ret;
+
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(dsigCtx != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    cur = xmlSecGetNextElementNode(node->children);
+    while((cur != NULL) && (xmlSecCheckNodeName(cur, xmlSecNodeReference, xmlSecDSigNs))) {
+        dsigRefCtx = xmlSecDSigReferenceCtxCreate(dsigCtx, xmlSecDSigReferenceOriginManifest);
+        if(dsigRefCtx == NULL) {
+            xmlSecInternalError("xmlSecDSigReferenceCtxCreate", NULL);
+            return(-1);
+        }
+        ret = xmlSecPtrListAdd(&(dsigCtx->manifestReferences), dsigRefCtx);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecPtrListAdd", NULL);
+            xmlSecDSigReferenceCtxDestroy(dsigRefCtx);
+            return(-1);
+        }
+
+        uri = xmlGetProp(cur, xmlSecAttrURI);
+        isPart = xmlSecOpcPackageIsPartUri(uri);
+        if(uri != NULL) {
+            xmlFree(uri);
+        }
+        if(isPart) {
+            ret = xmlSecOpcPackageDigestCtxAddReference(ctx, dsigRefCtx, cur);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecOpcPackageDigestCtxAddReference", NULL);
+                return(-1);
+            }
+        } else {
+            /* not a part: process as usual */
+            ret = xmlSecDSigReferenceCtxProcessNode(dsigRefCtx, cur);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecDSigReferenceCtxProcessNode", xmlSecNodeGetName(cur));
+                return(-1);
+            }
+        }
+        cur = xmlSecGetNextElementNode(cur->next);
+    }
+
+    if(cur != NULL) {
+        xmlSecUnexpectedNodeError(cur,  NULL);
+        return(-1);
+    }
+    return(0);
+}
+
+/* processes the <dsig:Manifest/> references in the <dsig:Object/> nodes */
+static int
+xmlSecOpcPackageProcessManifests(xmlSecOpcPackagePtr pkg, xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node,
+                                 xmlSecSize threadsNum) {
+    xmlSecOpcPackageDigestCtx ctx;
+    xmlNodePtr cur, child;
+    xmlSecSize ii;
+    int ret;
+    int res = -1;
+
+    xmlSecAssert2(pkg != NULL, -1);
+    xmlSecAssert2(dsigCtx != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+    xmlSecAssert2(node->doc != NULL, -1);
+
+    if(!xmlSecCheckNodeName(node, xmlSecNodeSignature, xmlSecDSigNs)) {
+        xmlSecInvalidNodeError(node, xmlSecNodeSignature, NULL);
+        return(-1);
+    }
+    xmlSecAddIDs(node->doc, node, xmlSecOpcPackageDSigIds);
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.pkg = pkg;
+
+    /* the Signature node structure is checked later */
+    for(cur = xmlSecGetNextElementNode(node->children); cur != NULL; cur = xmlSecGetNextElementNode(cur->next)) {
+        if(!xmlSecCheckNodeName(cur, xmlSecNodeObject, xmlSecDSigNs)) {
+            continue;
+        }
+        for(child = xmlSecGetNextElementNode(cur->children); child != NULL; child = xmlSecGetNextElementNode(child->next)) {
+            if(!xmlSecCheckNodeName(child, xmlSecNodeManifest, xmlSecDSigNs)) {
+                continue;
+            }
+            ret = xmlSecOpcPackageProcessManifest(&ctx, dsigCtx, child);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecOpcPackageProcessManifest", NULL);
+                goto done;
+            }
+        }
+    }
+
+    if(ctx.refsNum > 0) {
+        ret = xmlSecParallelRun(xmlSecOpcPackageDigestTask, &ctx, ctx.refsNum, threadsNum);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecParallelRun", NULL);
+            goto done;
+        }
+    }
+    for(ii = 0; ii < ctx.refsNum; ++ii) {
+        ret = xmlSecOpcPackageReferenceFinish(&(ctx.refs[ii]));
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecOpcPackageReferenceFinish", NULL,
+                "uri=%s", xmlSecErrorsSafeString(ctx.refs[ii].dsigRefCtx->uri));
+            goto done;
+        }
+    }
+
+    /* success */
+    res = 0;
+
+done:
+    if(ctx.refs != NULL) {
+        xmlFree(ctx.refs);
+    }
+    return(res);
+}
+
+/**
+ * xmlSecOpcPackageSign:
+ * @pkg:                the pointer to OPC package.
+ * @dsigCtx:            the pointer to &lt;dsig:Signature/&gt; processing context.
+ * @tmpl:               the pointer to &lt;dsig:Signature/&gt; node with signature template.
+ * @threadsNum:         the max number of threads to digest the parts (0 or 1 to
+ *                      digest everything in the current thread, see xmlsec/opc.h
+ *                      for the crypto libraries requirements).
+ *
+ * Signs the @pkg parts as described in the @tmpl node: the
+ * &lt;dsig:Reference/&gt; elements with the part names URIs
+ * (e.g. "/word/document.xml?ContentType=...") from the &lt;dsig:Manifest/&gt;
+ * elements are digested directly from the package (using up to @threadsNum
+ * threads) and then &lt;dsig:SignedInfo/&gt; is signed as usual. Other
+ * &lt;dsig:Manifest/&gt; references are processed as usual.
+ *
+ * The package itself is not modified: the application is responsible
+ * for adding the signed @tmpl document to the package as the signature part.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecOpcPackageSign(xmlSecOpcPackagePtr pkg, xmlSecDSigCtxPtr dsigCtx, xmlNodePtr tmpl, xmlSecSize threadsNum) {
+    unsigned int flags;
+    int ret;
+
+    xmlSecAssert2(pkg != NULL, -1);
+    xmlSecAssert2(dsigCtx != NULL, -1);
+    xmlSecAssert2(dsigCtx->status == xmlSecDSigStatusUnknown, -1);
+    xmlSecAssert2(tmpl != NULL, -1);
+
+    dsigCtx->operation = xmlSecTransformOperationSign;
+    ret = xmlSecOpcPackageProcessManifests(pkg, dsigCtx, tmpl, threadsNum);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecOpcPackageProcessManifests", NULL);
+        return(-1);
+    }
+
+    /* the manifests are done */
+    flags = dsigCtx->flags;
+    dsigCtx->flags |= XMLSEC_DSIG_FLAGS_IGNORE_MANIFESTS;
+    ret = xmlSecDSigCtxSign(dsigCtx, tmpl);
+    dsigCtx->flags = flags;
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecDSigCtxSign", NULL);
+        return(-1);
+    }
+    return(0);
+}
+
+/**
+ * xmlSecOpcPackageVerify:
+ * @pkg:                the pointer to OPC package.
+ * @dsigCtx:            the pointer to &lt;dsig:Signature/&gt; processing context.
+ * @node:               the pointer with &lt;dsig:Signature/&gt; node.
+ * @threadsNum:         the max number of threads to digest the parts (0 or 1 to
+ *                      digest everything in the current thread, see xmlsec/opc.h
+ *                      for the crypto libraries requirements).
+ *
+ * Verifies the package signature in @node: the parts referenced from
+ * the &lt;dsig:Manifest/&gt; elements are digested directly from the @pkg
+ * (using up to @threadsNum threads) and then the signature is verified
+ * as usual. Unlike #xmlSecDSigCtxVerify, the package signature is valid
+ * only if all the &lt;dsig:Manifest/&gt; references are valid.
+ *
+ * Returns: 0 on success (check #status member of @dsigCtx to get
+ * signature verification result) or a negative value if an error occurs.
+ */
+int
+xmlSecOpcPackageVerify(xmlSecOpcPackagePtr pkg, xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node, xmlSecSize threadsNum) {
+    xmlSecDSigReferenceCtxPtr dsigRefCtx;
+    unsigned int flags;
+    xmlSecSize ii, size;
+    int ret;
+
+    xmlSecAssert2(pkg != NULL, -1);
+    xmlSecAssert2(dsigCtx != NULL, -1);
+    xmlSecAssert2(dsigCtx->status == xmlSecDSigStatusUnknown, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    dsigCtx->operation = xmlSecTransformOperationVerify;
+    ret = xmlSecOpcPackageProcessManifests(pkg, dsigCtx, node, threadsNum);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecOpcPackageProcessManifests", NULL);
+        return(-1);
+    }
+
+    /* the manifests are done */
+    flags = dsigCtx->flags;
+    dsigCtx->flags |= XMLSEC_DSIG_FLAGS_IGNORE_MANIFESTS;
+    ret = xmlSecDSigCtxVerify(dsigCtx, node);
+    dsigCtx->flags = flags;
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecDSigCtxVerify", NULL);
+        return(-1);
+    }
+
+    /* all the parts must be valid */
+    if(dsigCtx->status == xmlSecDSigStatusSucceeded) {
+        size = xmlSecPtrListGetSize(&(dsigCtx->manifestReferences));
+        for(ii = 0; ii < size; ++ii) {
+            dsigRefCtx = (xmlSecDSigReferenceCtxPtr)xmlSecPtrListGetItem(&(dsigCtx->manifestReferences), ii);
+            if((dsigRefCtx == NULL) || (dsigRefCtx->status != xmlSecDSigStatusSucceeded)) {
+                dsigCtx->status = xmlSecDSigStatusInvalid;
+                dsigCtx->failureReason = xmlSecDSigFailureReasonReference;
+                break;
+            }
+        }
+    }
+    return(0);
+}
+
+#endif /* XMLSEC_NO_XMLDSIG */
@@ -910,6 +910,110 @@ xmlSecOpenSSLEvpBlockCipherExecute(xmlSecTransformPtr transform, int last, xmlSe
 }
 
 
+/* processes the full blocks directly from the fragments: only the partial
+ * block (and the data kept for the final call) is copied to the input buffer */
+static int
+xmlSecOpenSSLEvpBlockCipherPushBinV(xmlSecTransformPtr transform, const xmlSecTransformIOVec* vec,
+                                    xmlSecSize vecSize, int final, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecOpenSSLEvpBlockCipherCtxPtr ctx;
+    xmlSecBufferPtr in, out;
+    xmlSecSize ii, blockSize, keepSize, inSize, totalSize, processSize, headSize, size;
+    const xmlSecByte* data;
+    int blockLen;
+    int ret;
+
+    xmlSecAssert2(xmlSecOpenSSLEvpBlockCipherCheckId(transform), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(transform, xmlSecOpenSSLEvpBlockCipherSize), -1);
+    xmlSecAssert2((vec != NULL) || (vecSize == 0), -1);
+    xmlSecAssert2(transformCtx != NULL, -1);
+
+    ctx = xmlSecOpenSSLEvpBlockCipherGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
+
+    /* the iv is read from (or written to) the data: let the default
+     * implementation handle everything until the cipher is initialized */
+    if((transform->status != xmlSecTransformStatusWorking) || (ctx->ctxInitialized == 0)) {
+        return(xmlSecTransformDefaultPushBinV(transform, vec, vecSize, final, transformCtx));
+    }
+
+    blockLen = EVP_CIPHER_block_size(ctx->cipher);
+    xmlSecAssert2(blockLen > 0, -1);
+    XMLSEC_SAFE_CAST_INT_TO_SIZE(blockLen, blockSize, return(-1), xmlSecTransformGetName(transform));
+
+    /* see xmlSecOpenSSLEvpBlockCipherCtxUpdate(): the last block (CBC) or
+     * the tag (GCM) is kept in the input buffer for the final call */
+    keepSize = (ctx->cbcMode) ? 1 : XMLSEC_OPENSSL_AES_GCM_TAG_SIZE;
+
+    in = &(transform->inBuf);
+    out = &(transform->outBuf);
+    for(ii = 0; ii < vecSize; ++ii) {
+        data = vec[ii].data;
+        size = vec[ii].size;
+        if(size == 0) {
+            continue;
+        }
+        xmlSecAssert2(data != NULL, -1);
+
+        inSize = xmlSecBufferGetSize(in);
+        totalSize = inSize + size;
+        processSize = (totalSize > keepSize) ? blockSize * ((totalSize - keepSize) / blockSize) : 0;
+
+        /* complete the pending data in the input buffer to a full block first */
+        headSize = blockSize * ((inSize + blockSize - 1) / blockSize);
+        if((processSize == 0) || (headSize > processSize)) {
+            ret = xmlSecBufferAppend(in, data, size);
+            if(ret < 0) {
+                xmlSecInternalError2("xmlSecBufferAppend", xmlSecTransformGetName(transform),
+                    "size=" XMLSEC_SIZE_FMT, size);
+                return(-1);
+            }
+            continue;
+        }
+        if(headSize > 0) {
+            ret = xmlSecBufferAppend(in, data, headSize - inSize);
+            if(ret < 0) {
+                xmlSecInternalError2("xmlSecBufferAppend", xmlSecTransformGetName(transform),
+                    "size=" XMLSEC_SIZE_FMT, (headSize - inSize));
+                return(-1);
+            }
+            ret = xmlSecOpenSSLEvpBlockCipherCtxUpdateBlock(ctx, xmlSecBufferGetData(in), headSize,
+                out, xmlSecTransformGetName(transform), 0, NULL);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecOpenSSLEvpBlockCipherCtxUpdateBlock", xmlSecTransformGetName(transform));
+                return(-1);
+            }
+            xmlSecBufferEmpty(in);
+            data += (headSize - inSize);
+            size -= (headSize - inSize);
+            processSize -= headSize;
+        }
+
+        /* the full blocks from the fragment itself */
+        if(processSize > 0) {
+            ret = xmlSecOpenSSLEvpBlockCipherCtxUpdateBlock(ctx, data, processSize,
+                out, xmlSecTransformGetName(transform), 0, NULL);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecOpenSSLEvpBlockCipherCtxUpdateBlock", xmlSecTransformGetName(transform));
+                return(-1);
+            }
+            data += processSize;
+            size -= processSize;
+        }
+
+        /* and keep the rest */
+        xmlSecAssert2(size > 0, -1);
+        ret = xmlSecBufferAppend(in, data, size);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecBufferAppend", xmlSecTransformGetName(transform),
+                "size=" XMLSEC_SIZE_FMT, size);
+            return(-1);
+        }
+    }
+
+    /* finalize (if needed) and push the results to the next transform */
+    return(xmlSecTransformDefaultPushBin(transform, NULL, 0, final, transformCtx));
+}
+
 #ifndef XMLSEC_NO_AES
 /*********************************************************************
  *
@@ -939,8 +1043,8 @@ static xmlSecTransformKlass xmlSecOpenSSLAes128CbcKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpBlockCipherExecute,         /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLEvpBlockCipherPushBinV,        /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -978,8 +1082,8 @@ static xmlSecTransformKlass xmlSecOpenSSLAes192CbcKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpBlockCipherExecute,         /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLEvpBlockCipherPushBinV,        /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -1017,8 +1121,8 @@ static xmlSecTransformKlass xmlSecOpenSSLAes256CbcKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpBlockCipherExecute,         /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLEvpBlockCipherPushBinV,        /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -1056,8 +1160,8 @@ static xmlSecTransformKlass xmlSecOpenSSLAes128GcmKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpBlockCipherExecute,         /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLEvpBlockCipherPushBinV,        /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -1096,8 +1200,8 @@ static xmlSecTransformKlass xmlSecOpenSSLAes192GcmKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpBlockCipherExecute,         /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLEvpBlockCipherPushBinV,        /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -1136,8 +1240,8 @@ static xmlSecTransformKlass xmlSecOpenSSLAes256GcmKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpBlockCipherExecute,         /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLEvpBlockCipherPushBinV,        /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -1179,8 +1283,8 @@ static xmlSecTransformKlass xmlSecOpenSSLDes3CbcKlass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpBlockCipherExecute,         /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLEvpBlockCipherPushBinV,        /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -38,6 +38,7 @@
 #include <xmlsec/openssl/x509.h>
 
 #include "openssl_compat.h"
+#include "private.h"
 #include "../cast_helpers.h"
 
 static int              xmlSecOpenSSLErrorsInit                 (void);
@@ -452,6 +453,13 @@ xmlSecOpenSSLInit (void)  {
         return(-1);
     }
 
+#ifdef XMLSEC_OPENSSL_API_300
+    if(xmlSecOpenSSLEvpDigestsCacheInitialize() < 0) {
+        xmlSecInternalError("xmlSecOpenSSLEvpDigestsCacheInitialize", NULL);
+        return(-1);
+    }
+#endif /* XMLSEC_OPENSSL_API_300 */
+
     /* register our klasses */
     if(xmlSecCryptoDLFunctionsRegisterKeyDataAndTransforms(xmlSecCryptoGetFunctions_openssl()) < 0) {
         xmlSecInternalError("xmlSecCryptoDLFunctionsRegisterKeyDataAndTransforms", NULL);
@@ -471,6 +479,9 @@ xmlSecOpenSSLInit (void)  {
 int
 xmlSecOpenSSLShutdown(void) {
     xmlSecOpenSSLSetDefaultTrustedCertsFolder(NULL);
+#ifdef XMLSEC_OPENSSL_API_300
+    xmlSecOpenSSLEvpDigestsCacheFinalize();
+#endif /* XMLSEC_OPENSSL_API_300 */
     xmlSecOpenSSLErrorsShutdown();
     return(0);
 }
@@ -676,12 +687,17 @@ static OSSL_LIB_CTX* gXmlSecOpenSSLLibCtx = NULL;
  *                    or NULL to use default.
  *
  * Sets the OSSL_LIB_CTX object to be used by xmlsec-openssl. The caller is
- * responsible for lifetime of this object.
+ * responsible for lifetime of this object. The digests fetched from the
+ * previous OSSL_LIB_CTX and cached by xmlsec-openssl are released, the
+ * previous OSSL_LIB_CTX object can be freed after this call.
  *
  * Returns: 0 on success or a negative value if an error occurs.
  */
 int
 xmlSecOpenSSLSetLibCtx(OSSL_LIB_CTX* libctx) {
+    if(gXmlSecOpenSSLLibCtx != libctx) {
+        xmlSecOpenSSLEvpDigestsCacheFlush();
+    }
     gXmlSecOpenSSLLibCtx = libctx;
     return(0);
 }
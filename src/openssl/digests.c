@@ -26,12 +26,14 @@
 #include <xmlsec/openssl/crypto.h>
 #include <xmlsec/openssl/evp.h>
 #include "openssl_compat.h"
+#include "private.h"
 
 #ifdef XMLSEC_OPENSSL_API_300
 #include <openssl/core_names.h>
 #endif /* XMLSEC_OPENSSL_API_300 */
 
 #include "../cast_helpers.h"
+#include "../transform_helpers.h"
 
 /**************************************************************************
  *
@@ -52,6 +54,186 @@ struct _xmlSecOpenSSLEvpDigestCtx {
     xmlSecSize          dgstSize;       /* dgst size in bytes */
 };
 
+#ifdef XMLSEC_OPENSSL_API_300
+
+/**************************************************************************
+ *
+ * Fetched digests cache: EVP_MD_fetch() walks the providers and takes locks,
+ * for small <dsig:Reference/> elements it costs more than the digest itself.
+ * The digests are fetched once for the current OSSL_LIB_CTX and kept until
+ * shutdown or until the OSSL_LIB_CTX is changed with xmlSecOpenSSLSetLibCtx().
+ *
+ *****************************************************************************/
+#define XMLSEC_OPENSSL_EVP_DIGESTS_CACHE_SIZE           16
+
+typedef struct _xmlSecOpenSSLEvpDigestsCacheItem {
+    const char*         digestName;     /* NOT OWNED: static string */
+    OSSL_LIB_CTX*       libCtx;         /* NOT OWNED */
+    EVP_MD*             digest;
+} xmlSecOpenSSLEvpDigestsCacheItem;
+
+static xmlSecOpenSSLEvpDigestsCacheItem gXmlSecOpenSSLEvpDigestsCache[XMLSEC_OPENSSL_EVP_DIGESTS_CACHE_SIZE];
+static xmlSecSize gXmlSecOpenSSLEvpDigestsCacheSize = 0;
+static CRYPTO_RWLOCK* gXmlSecOpenSSLEvpDigestsCacheLock = NULL;
+
+/* the caller holds the write lock (or there is no lock) */
+static void
+xmlSecOpenSSLEvpDigestsCacheClear(void) {
+    xmlSecSize ii;
+
+    for(ii = 0; ii < gXmlSecOpenSSLEvpDigestsCacheSize; ++ii) {
+        EVP_MD_free(gXmlSecOpenSSLEvpDigestsCache[ii].digest);
+    }
+    memset(gXmlSecOpenSSLEvpDigestsCache, 0, sizeof(gXmlSecOpenSSLEvpDigestsCache));
+    gXmlSecOpenSSLEvpDigestsCacheSize = 0;
+}
+
+/**
+ * xmlSecOpenSSLEvpDigestsCacheInitialize:
+ *
+ * Initializes the fetched digests cache (called from xmlSecOpenSSLInit).
+ * If the cache is already initialized then it is flushed.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecOpenSSLEvpDigestsCacheInitialize(void) {
+    if(gXmlSecOpenSSLEvpDigestsCacheLock != NULL) {
+        xmlSecOpenSSLEvpDigestsCacheFlush();
+        return(0);
+    }
+
+    gXmlSecOpenSSLEvpDigestsCacheLock = CRYPTO_THREAD_lock_new();
+    if(gXmlSecOpenSSLEvpDigestsCacheLock == NULL) {
+        xmlSecOpenSSLError("CRYPTO_THREAD_lock_new", NULL);
+        return(-1);
+    }
+    xmlSecOpenSSLEvpDigestsCacheClear();
+    return(0);
+}
+
+/**
+ * xmlSecOpenSSLEvpDigestsCacheFinalize:
+ *
+ * Frees the fetched digests cache (called from xmlSecOpenSSLShutdown).
+ * It is safe to call this function if the cache is not initialized.
+ */
+void
+xmlSecOpenSSLEvpDigestsCacheFinalize(void) {
+    xmlSecOpenSSLEvpDigestsCacheClear();
+
+    if(gXmlSecOpenSSLEvpDigestsCacheLock != NULL) {
+        CRYPTO_THREAD_lock_free(gXmlSecOpenSSLEvpDigestsCacheLock);
+        gXmlSecOpenSSLEvpDigestsCacheLock = NULL;
+    }
+}
+
+/**
+ * xmlSecOpenSSLEvpDigestsCacheFlush:
+ *
+ * Frees all the fetched digests (called from xmlSecOpenSSLSetLibCtx since
+ * the cached digests might keep references to the previous OSSL_LIB_CTX).
+ * The digests already returned by #xmlSecOpenSSLEvpDigestFetch are not
+ * affected.
+ */
+void
+xmlSecOpenSSLEvpDigestsCacheFlush(void) {
+    if(gXmlSecOpenSSLEvpDigestsCacheLock == NULL) {
+        xmlSecOpenSSLEvpDigestsCacheClear();
+        return;
+    }
+    if(CRYPTO_THREAD_write_lock(gXmlSecOpenSSLEvpDigestsCacheLock) != 1) {
+        xmlSecOpenSSLError("CRYPTO_THREAD_write_lock", NULL);
+        return;
+    }
+    xmlSecOpenSSLEvpDigestsCacheClear();
+    CRYPTO_THREAD_unlock(gXmlSecOpenSSLEvpDigestsCacheLock);
+}
+
+/* the caller holds the lock */
+static EVP_MD*
+xmlSecOpenSSLEvpDigestsCacheFind(const char* digestName, OSSL_LIB_CTX* libCtx) {
+    xmlSecSize ii;
+
+    for(ii = 0; ii < gXmlSecOpenSSLEvpDigestsCacheSize; ++ii) {
+        if((gXmlSecOpenSSLEvpDigestsCache[ii].libCtx == libCtx) &&
+           (strcmp(gXmlSecOpenSSLEvpDigestsCache[ii].digestName, digestName) == 0)) {
+            return(gXmlSecOpenSSLEvpDigestsCache[ii].digest);
+        }
+    }
+    return(NULL);
+}
+
+/**
+ * xmlSecOpenSSLEvpDigestFetch:
+ * @digestName:         the digest name (static string).
+ *
+ * Fetches the digest from the current OSSL_LIB_CTX using the cache
+ * if possible. The caller is responsible for freeing the result
+ * with EVP_MD_free().
+ *
+ * Returns: the digest or NULL if an error occurs.
+ */
+EVP_MD*
+xmlSecOpenSSLEvpDigestFetch(const char* digestName) {
+    OSSL_LIB_CTX* libCtx = xmlSecOpenSSLGetLibCtx();
+    EVP_MD* digest = NULL;
+    EVP_MD* cached;
+
+    xmlSecAssert2(digestName != NULL, NULL);
+
+    /* no cache (e.g. xmlSecOpenSSLInit wasn't called) */
+    if(gXmlSecOpenSSLEvpDigestsCacheLock == NULL) {
+        digest = EVP_MD_fetch(libCtx, digestName, NULL);
+        if(digest == NULL) {
+            xmlSecOpenSSLError2("EVP_MD_fetch", NULL,
+                "digestName=%s", xmlSecErrorsSafeString(digestName));
+            return(NULL);
+        }
+        return(digest);
+    }
+
+    /* fast path: already fetched */
+    if(CRYPTO_THREAD_read_lock(gXmlSecOpenSSLEvpDigestsCacheLock) != 1) {
+        xmlSecOpenSSLError("CRYPTO_THREAD_read_lock", NULL);
+        return(NULL);
+    }
+    cached = xmlSecOpenSSLEvpDigestsCacheFind(digestName, libCtx);
+    if((cached != NULL) && (EVP_MD_up_ref(cached) == 1)) {
+        digest = cached;
+    }
+    CRYPTO_THREAD_unlock(gXmlSecOpenSSLEvpDigestsCacheLock);
+    if(digest != NULL) {
+        return(digest);
+    }
+
+    /* fetch outside of the lock and add to the cache if there is still space */
+    digest = EVP_MD_fetch(libCtx, digestName, NULL);
+    if(digest == NULL) {
+        xmlSecOpenSSLError2("EVP_MD_fetch", NULL,
+            "digestName=%s", xmlSecErrorsSafeString(digestName));
+        return(NULL);
+    }
+    if(CRYPTO_THREAD_write_lock(gXmlSecOpenSSLEvpDigestsCacheLock) != 1) {
+        /* not fatal, we just don't cache it */
+        return(digest);
+    }
+    /* don't cache the digest if the OSSL_LIB_CTX was changed (and the cache flushed) */
+    if((libCtx == xmlSecOpenSSLGetLibCtx()) &&
+       (xmlSecOpenSSLEvpDigestsCacheFind(digestName, libCtx) == NULL) &&
+       (gXmlSecOpenSSLEvpDigestsCacheSize < XMLSEC_OPENSSL_EVP_DIGESTS_CACHE_SIZE) &&
+       (EVP_MD_up_ref(digest) == 1)) {
+        gXmlSecOpenSSLEvpDigestsCache[gXmlSecOpenSSLEvpDigestsCacheSize].digestName = digestName;
+        gXmlSecOpenSSLEvpDigestsCache[gXmlSecOpenSSLEvpDigestsCacheSize].libCtx = libCtx;
+        gXmlSecOpenSSLEvpDigestsCache[gXmlSecOpenSSLEvpDigestsCacheSize].digest = digest;
+        ++gXmlSecOpenSSLEvpDigestsCacheSize;
+    }
+    CRYPTO_THREAD_unlock(gXmlSecOpenSSLEvpDigestsCacheLock);
+    return(digest);
+}
+
+#endif /* XMLSEC_OPENSSL_API_300 */
+
 /******************************************************************************
  *
  * EVP Digest transforms
@@ -62,13 +244,23 @@ XMLSEC_TRANSFORM_DECLARE(OpenSSLEvpDigest, xmlSecOpenSSLEvpDigestCtx)
 
 static int      xmlSecOpenSSLEvpDigestInitialize        (xmlSecTransformPtr transform);
 static void     xmlSecOpenSSLEvpDigestFinalize          (xmlSecTransformPtr transform);
+static int      xmlSecOpenSSLEvpDigestCopyState         (xmlSecTransformPtr dst,
+                                                         xmlSecTransformPtr src);
 static int      xmlSecOpenSSLEvpDigestVerify            (xmlSecTransformPtr transform,
                                                          const xmlSecByte* data,
                                                          xmlSecSize dataSize,
                                                          xmlSecTransformCtxPtr transformCtx);
+static int      xmlSecOpenSSLEvpDigestUpdate            (xmlSecTransformPtr transform,
+                                                         const xmlSecByte* data,
+                                                         xmlSecSize dataSize);
 static int      xmlSecOpenSSLEvpDigestExecute           (xmlSecTransformPtr transform,
                                                          int last,
                                                          xmlSecTransformCtxPtr transformCtx);
+static int      xmlSecOpenSSLEvpDigestPushBinV          (xmlSecTransformPtr transform,
+                                                         const xmlSecTransformIOVec* vec,
+                                                         xmlSecSize vecSize,
+                                                         int final,
+                                                         xmlSecTransformCtxPtr transformCtx);
 static int      xmlSecOpenSSLEvpDigestCheckId           (xmlSecTransformPtr transform);
 
 static int
@@ -310,9 +502,9 @@ xmlSecOpenSSLEvpDigestInitialize(xmlSecTransformPtr transform) {
 #ifdef XMLSEC_OPENSSL_API_300
     if(ctx->legacyDigest == 0) {
         xmlSecAssert2(ctx->digestName != NULL, -1);
-        ctx->digest = EVP_MD_fetch(xmlSecOpenSSLGetLibCtx(), ctx->digestName, NULL);
+        ctx->digest = xmlSecOpenSSLEvpDigestFetch(ctx->digestName);
         if(ctx->digest == NULL) {
-            xmlSecOpenSSLError2("EVP_MD_fetch", xmlSecTransformGetName(transform),
+            xmlSecInternalError2("xmlSecOpenSSLEvpDigestFetch", xmlSecTransformGetName(transform),
                                 "digestName=%s", xmlSecErrorsSafeString(ctx->digestName));
             xmlSecOpenSSLEvpDigestFinalize(transform);
             return(-1);
@@ -355,6 +547,38 @@ xmlSecOpenSSLEvpDigestFinalize(xmlSecTransformPtr transform) {
     memset(ctx, 0, sizeof(xmlSecOpenSSLEvpDigestCtx));
 }
 
+static int
+xmlSecOpenSSLEvpDigestCopyState(xmlSecTransformPtr dst, xmlSecTransformPtr src) {
+    xmlSecOpenSSLEvpDigestCtxPtr dstCtx, srcCtx;
+    int ret;
+
+    xmlSecAssert2(xmlSecOpenSSLEvpDigestCheckId(dst), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(dst, xmlSecOpenSSLEvpDigestSize), -1);
+    xmlSecAssert2(xmlSecTransformCheckId(src, dst->id), -1);
+
+    dstCtx = xmlSecOpenSSLEvpDigestGetCtx(dst);
+    xmlSecAssert2(dstCtx != NULL, -1);
+    xmlSecAssert2(dstCtx->digestCtx != NULL, -1);
+    srcCtx = xmlSecOpenSSLEvpDigestGetCtx(src);
+    xmlSecAssert2(srcCtx != NULL, -1);
+    xmlSecAssert2(srcCtx->digestCtx != NULL, -1);
+    xmlSecAssert2(srcCtx->dgstSize <= sizeof(dstCtx->dgst), -1);
+
+    /* the hash state is only needed while the data is processed,
+     * the finished transforms only have the digest value */
+    if(src->status == xmlSecTransformStatusWorking) {
+        ret = EVP_MD_CTX_copy_ex(dstCtx->digestCtx, srcCtx->digestCtx);
+        if(ret != 1) {
+            xmlSecOpenSSLError("EVP_MD_CTX_copy_ex", xmlSecTransformGetName(dst));
+            return(-1);
+        }
+    }
+
+    memcpy(dstCtx->dgst, srcCtx->dgst, srcCtx->dgstSize);
+    dstCtx->dgstSize = srcCtx->dgstSize;
+    return(0);
+}
+
 static int
 xmlSecOpenSSLEvpDigestVerify(xmlSecTransformPtr transform,
                         const xmlSecByte* data, xmlSecSize dataSize,
@@ -390,6 +614,30 @@ xmlSecOpenSSLEvpDigestVerify(xmlSecTransformPtr transform,
     return(0);
 }
 
+static int
+xmlSecOpenSSLEvpDigestUpdate(xmlSecTransformPtr transform, const xmlSecByte* data, xmlSecSize dataSize) {
+    xmlSecOpenSSLEvpDigestCtxPtr ctx;
+    int ret;
+
+    xmlSecAssert2(xmlSecOpenSSLEvpDigestCheckId(transform), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(transform, xmlSecOpenSSLEvpDigestSize), -1);
+    xmlSecAssert2(transform->status == xmlSecTransformStatusWorking, -1);
+    xmlSecAssert2(data != NULL, -1);
+
+    ctx = xmlSecOpenSSLEvpDigestGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->digestCtx != NULL, -1);
+
+    ret = EVP_DigestUpdate(ctx->digestCtx, data, dataSize);
+    if(ret != 1) {
+        xmlSecOpenSSLError2("EVP_DigestUpdate",
+                            xmlSecTransformGetName(transform),
+                            "size=" XMLSEC_SIZE_FMT, dataSize);
+        return(-1);
+    }
+    return(0);
+}
+
 static int
 xmlSecOpenSSLEvpDigestExecute(xmlSecTransformPtr transform, int last, xmlSecTransformCtxPtr transformCtx) {
     xmlSecOpenSSLEvpDigestCtxPtr ctx;
@@ -427,11 +675,10 @@ xmlSecOpenSSLEvpDigestExecute(xmlSecTransformPtr transform, int last, xmlSecTran
 
         inSize = xmlSecBufferGetSize(in);
         if(inSize > 0) {
-            ret = EVP_DigestUpdate(ctx->digestCtx, xmlSecBufferGetData(in), inSize);
-            if(ret != 1) {
-                xmlSecOpenSSLError2("EVP_DigestUpdate",
-                                    xmlSecTransformGetName(transform),
-                                    "size=" XMLSEC_SIZE_FMT, inSize);
+            ret = xmlSecOpenSSLEvpDigestUpdate(transform, xmlSecBufferGetData(in), inSize);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecOpenSSLEvpDigestUpdate",
+                                    xmlSecTransformGetName(transform));
                 return(-1);
             }
 
@@ -488,6 +735,16 @@ xmlSecOpenSSLEvpDigestExecute(xmlSecTransformPtr transform, int last, xmlSecTran
     return(0);
 }
 
+static int
+xmlSecOpenSSLEvpDigestPushBinV(xmlSecTransformPtr transform, const xmlSecTransformIOVec* vec,
+                               xmlSecSize vecSize, int final, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecAssert2(xmlSecOpenSSLEvpDigestCheckId(transform), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(transform, xmlSecOpenSSLEvpDigestSize), -1);
+
+    return(xmlSecTransformUpdatePushBinV(transform, vec, vecSize, final, transformCtx,
+        xmlSecOpenSSLEvpDigestUpdate));
+}
+
 
 #ifndef XMLSEC_NO_MD5
 /******************************************************************************
@@ -518,8 +775,8 @@ static xmlSecTransformKlass xmlSecOpenSSLMd5Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecOpenSSLEvpDigestCopyState,            /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLEvpDigestPushBinV,             /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -564,8 +821,8 @@ static xmlSecTransformKlass xmlSecOpenSSLRipemd160Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecOpenSSLEvpDigestCopyState,            /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLEvpDigestPushBinV,             /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -611,8 +868,8 @@ static xmlSecTransformKlass xmlSecOpenSSLSha1Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecOpenSSLEvpDigestCopyState,            /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLEvpDigestPushBinV,             /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -657,8 +914,8 @@ static xmlSecTransformKlass xmlSecOpenSSLSha224Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecOpenSSLEvpDigestCopyState,            /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLEvpDigestPushBinV,             /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -703,8 +960,8 @@ static xmlSecTransformKlass xmlSecOpenSSLSha256Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecOpenSSLEvpDigestCopyState,            /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLEvpDigestPushBinV,             /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -749,8 +1006,8 @@ static xmlSecTransformKlass xmlSecOpenSSLSha384Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecOpenSSLEvpDigestCopyState,            /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLEvpDigestPushBinV,             /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -795,8 +1052,8 @@ static xmlSecTransformKlass xmlSecOpenSSLSha512Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecOpenSSLEvpDigestCopyState,            /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLEvpDigestPushBinV,             /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -842,8 +1099,8 @@ static xmlSecTransformKlass xmlSecOpenSSLSha3_224Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecOpenSSLEvpDigestCopyState,            /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLEvpDigestPushBinV,             /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -886,8 +1143,8 @@ static xmlSecTransformKlass xmlSecOpenSSLSha3_256Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecOpenSSLEvpDigestCopyState,            /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLEvpDigestPushBinV,             /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -930,8 +1187,8 @@ static xmlSecTransformKlass xmlSecOpenSSLSha3_384Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecOpenSSLEvpDigestCopyState,            /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLEvpDigestPushBinV,             /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -974,8 +1231,8 @@ static xmlSecTransformKlass xmlSecOpenSSLSha3_512Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,              /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecOpenSSLEvpDigestCopyState,            /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLEvpDigestPushBinV,             /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -1018,8 +1275,8 @@ static xmlSecTransformKlass xmlSecOpenSSLGostR3411_94Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,                /* xmlSecTransformExecuteMethod execute; */
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecOpenSSLEvpDigestCopyState,            /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLEvpDigestPushBinV,             /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -1063,8 +1320,8 @@ static xmlSecTransformKlass xmlSecOpenSSLGostR3411_2012_256Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,                /* xmlSecTransformExecuteMethod execute; */
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecOpenSSLEvpDigestCopyState,            /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLEvpDigestPushBinV,             /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -1105,8 +1362,8 @@ static xmlSecTransformKlass xmlSecOpenSSLGostR3411_2012_512Klass = {
     NULL,                                       /* xmlSecTransformPushXmlMethod pushXml; */
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLEvpDigestExecute,                /* xmlSecTransformExecuteMethod execute; */
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    xmlSecOpenSSLEvpDigestCopyState,            /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLEvpDigestPushBinV,             /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -102,9 +102,17 @@ static int      xmlSecOpenSSLHmacVerify                         (xmlSecTransform
                                                                  const xmlSecByte* data,
                                                                  xmlSecSize dataSize,
                                                                  xmlSecTransformCtxPtr transformCtx);
+static int      xmlSecOpenSSLHmacUpdate                         (xmlSecTransformPtr transform,
+                                                                 const xmlSecByte* data,
+                                                                 xmlSecSize dataSize);
 static int      xmlSecOpenSSLHmacExecute                        (xmlSecTransformPtr transform,
                                                                  int last,
                                                                  xmlSecTransformCtxPtr transformCtx);
+static int      xmlSecOpenSSLHmacPushBinV                       (xmlSecTransformPtr transform,
+                                                                 const xmlSecTransformIOVec* vec,
+                                                                 xmlSecSize vecSize,
+                                                                 int final,
+                                                                 xmlSecTransformCtxPtr transformCtx);
 
 
 static int
@@ -475,6 +483,43 @@ xmlSecOpenSSLHmacVerify(xmlSecTransformPtr transform,
     return(0);
 }
 
+static int
+xmlSecOpenSSLHmacUpdate(xmlSecTransformPtr transform, const xmlSecByte* data, xmlSecSize dataSize) {
+    xmlSecOpenSSLHmacCtxPtr ctx;
+    int ret;
+
+    xmlSecAssert2(xmlSecTransformIsValid(transform), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(transform, xmlSecOpenSSLHmacSize), -1);
+    xmlSecAssert2(transform->status == xmlSecTransformStatusWorking, -1);
+    xmlSecAssert2(data != NULL, -1);
+
+    ctx = xmlSecOpenSSLHmacGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->ctxInitialized != 0, -1);
+
+#ifndef XMLSEC_OPENSSL_API_300
+    xmlSecAssert2(ctx->hmacCtx != NULL, -1);
+
+    ret = HMAC_Update(ctx->hmacCtx, data, dataSize);
+    if(ret != 1) {
+        xmlSecOpenSSLError("HMAC_Update",
+                           xmlSecTransformGetName(transform));
+        return(-1);
+    }
+#else /* XMLSEC_OPENSSL_API_300 */
+    xmlSecAssert2(ctx->evpHmacCtx != NULL, -1);
+
+    ret = EVP_MAC_update(ctx->evpHmacCtx, data, dataSize);
+    if(ret != 1) {
+        xmlSecOpenSSLError("EVP_MAC_update",
+                           xmlSecTransformGetName(transform));
+        return(-1);
+    }
+#endif /* XMLSEC_OPENSSL_API_300 */
+
+    return(0);
+}
+
 static int
 xmlSecOpenSSLHmacExecute(xmlSecTransformPtr transform, int last, xmlSecTransformCtxPtr transformCtx) {
     xmlSecOpenSSLHmacCtxPtr ctx;
@@ -503,25 +548,12 @@ xmlSecOpenSSLHmacExecute(xmlSecTransformPtr transform, int last, xmlSecTransform
 
         inSize = xmlSecBufferGetSize(in);
         if(inSize > 0) {
-#ifndef XMLSEC_OPENSSL_API_300
-            xmlSecAssert2(ctx->hmacCtx != NULL, -1);
-
-            ret = HMAC_Update(ctx->hmacCtx, xmlSecBufferGetData(in), inSize);
-            if(ret != 1) {
-                xmlSecOpenSSLError("HMAC_Update",
-                                   xmlSecTransformGetName(transform));
-                return(-1);
-            }
-#else /* XMLSEC_OPENSSL_API_300 */
-            xmlSecAssert2(ctx->evpHmacCtx != NULL, -1);
-
-            ret = EVP_MAC_update(ctx->evpHmacCtx, xmlSecBufferGetData(in), inSize);
-            if(ret != 1) {
-                xmlSecOpenSSLError("EVP_MAC_update",
-                                   xmlSecTransformGetName(transform));
+            ret = xmlSecOpenSSLHmacUpdate(transform, xmlSecBufferGetData(in), inSize);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecOpenSSLHmacUpdate",
+                                    xmlSecTransformGetName(transform));
                 return(-1);
             }
-#endif /* XMLSEC_OPENSSL_API_300 */
 
             ret = xmlSecBufferRemoveHead(in, inSize);
             if(ret < 0) {
@@ -584,6 +616,16 @@ xmlSecOpenSSLHmacExecute(xmlSecTransformPtr transform, int last, xmlSecTransform
     return(0);
 }
 
+static int
+xmlSecOpenSSLHmacPushBinV(xmlSecTransformPtr transform, const xmlSecTransformIOVec* vec,
+                          xmlSecSize vecSize, int final, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecAssert2(xmlSecTransformIsValid(transform), -1);
+    xmlSecAssert2(xmlSecTransformCheckSize(transform, xmlSecOpenSSLHmacSize), -1);
+
+    return(xmlSecTransformUpdatePushBinV(transform, vec, vecSize, final, transformCtx,
+        xmlSecOpenSSLHmacUpdate));
+}
+
 #ifndef XMLSEC_NO_MD5
 
 /********************************************************************
@@ -614,8 +656,8 @@ static xmlSecTransformKlass xmlSecOpenSSLHmacMd5Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLHmacExecute,                   /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLHmacPushBinV,                  /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -662,8 +704,8 @@ static xmlSecTransformKlass xmlSecOpenSSLHmacRipemd160Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLHmacExecute,                   /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLHmacPushBinV,                  /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -708,8 +750,8 @@ static xmlSecTransformKlass xmlSecOpenSSLHmacSha1Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLHmacExecute,                   /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLHmacPushBinV,                  /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -755,8 +797,8 @@ static xmlSecTransformKlass xmlSecOpenSSLHmacSha224Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLHmacExecute,                   /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLHmacPushBinV,                  /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -802,8 +844,8 @@ static xmlSecTransformKlass xmlSecOpenSSLHmacSha256Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLHmacExecute,                   /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLHmacPushBinV,                  /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -849,8 +891,8 @@ static xmlSecTransformKlass xmlSecOpenSSLHmacSha384Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLHmacExecute,                   /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLHmacPushBinV,                  /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
@@ -896,8 +938,8 @@ static xmlSecTransformKlass xmlSecOpenSSLHmacSha512Klass = {
     NULL,                                       /* xmlSecTransformPopXmlMethod popXml; */
     xmlSecOpenSSLHmacExecute,                   /* xmlSecTransformExecuteMethod execute; */
 
-    NULL,                                       /* void* reserved0; */
-    NULL,                                       /* void* reserved1; */
+    NULL,                                       /* xmlSecTransformCopyStateMethod copyState; */
+    xmlSecOpenSSLHmacPushBinV,                  /* xmlSecTransformPushBinVMethod pushBinV; */
 };
 
 /**
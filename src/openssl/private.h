@@ -88,6 +88,20 @@ STACK_OF(X509_CRL)*    xmlSecOpenSSLKeyDataX509GetCrls          (xmlSecKeyDataPt
 
 #endif /* XMLSEC_NO_X509 */
 
+/******************************************************************************
+ *
+ * Digests
+ *
+ ******************************************************************************/
+#ifdef XMLSEC_OPENSSL_API_300
+
+int             xmlSecOpenSSLEvpDigestsCacheInitialize          (void);
+void            xmlSecOpenSSLEvpDigestsCacheFinalize            (void);
+void            xmlSecOpenSSLEvpDigestsCacheFlush               (void);
+EVP_MD*         xmlSecOpenSSLEvpDigestFetch                     (const char* digestName);
+
+#endif /* XMLSEC_OPENSSL_API_300 */
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -30,6 +30,7 @@
 #include <xmlsec/openssl/crypto.h>
 #include <xmlsec/openssl/evp.h>
 #include "openssl_compat.h"
+#include "private.h"
 
 
 #ifdef XMLSEC_OPENSSL_API_300
@@ -744,9 +745,9 @@ xmlSecOpenSSLEvpSignatureInitialize(xmlSecTransformPtr transform) {
     /* fetch digest */
     if(ctx->legacyDigest == 0) {
         xmlSecAssert2(ctx->digestName != NULL, -1);
-        ctx->digest = EVP_MD_fetch(xmlSecOpenSSLGetLibCtx(), ctx->digestName, NULL);
+        ctx->digest = xmlSecOpenSSLEvpDigestFetch(ctx->digestName);
         if(ctx->digest == NULL) {
-            xmlSecOpenSSLError2("EVP_MD_fetch", xmlSecTransformGetName(transform),
+            xmlSecInternalError2("xmlSecOpenSSLEvpDigestFetch", xmlSecTransformGetName(transform),
                                "digestName=%s", xmlSecErrorsSafeString(ctx->digestName));
             xmlSecOpenSSLEvpSignatureFinalize(transform);
             return(-1);
@@ -0,0 +1,236 @@
+/*
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * Simple helper to run independent tasks on a pool of threads.
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2024 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#include "globals.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <xmlsec/xmlsec.h>
+#include <xmlsec/errors.h>
+#include <xmlsec/private.h>
+
+#if defined(XMLSEC_WINDOWS)
+#include <windows.h>
+#include <process.h>
+#elif !defined(XMLSEC_NO_THREADS)
+#include <pthread.h>
+#endif /* defined(XMLSEC_WINDOWS) */
+
+#include "parallel_helpers.h"
+
+#if defined(XMLSEC_WINDOWS) || !defined(XMLSEC_NO_THREADS)
+
+/**************************************************************************
+ *
+ * Threads pool: all the threads (including the caller's one) pick the next
+ * task from the shared counter until there are no tasks left or one of the
+ * tasks fails.
+ *
+ *************************************************************************/
+typedef struct _xmlSecParallelCtx {
+    xmlSecParallelTaskMethod    task;
+    void*                       data;
+    xmlSecSize                  tasksNum;
+    xmlSecSize                  next;
+    int                         failed;
+#if defined(XMLSEC_WINDOWS)
+    CRITICAL_SECTION            lock;
+#else  /* defined(XMLSEC_WINDOWS) */
+    pthread_mutex_t             lock;
+#endif /* defined(XMLSEC_WINDOWS) */
+} xmlSecParallelCtx, *xmlSecParallelCtxPtr;
+
+static void
+xmlSecParallelCtxLock(xmlSecParallelCtxPtr ctx) {
+#if defined(XMLSEC_WINDOWS)
+    EnterCriticalSection(&(ctx->lock));
+#else  /* defined(XMLSEC_WINDOWS) */
+    pthread_mutex_lock(&(ctx->lock));
+#endif /* defined(XMLSEC_WINDOWS) */
+}
+
+static void
+xmlSecParallelCtxUnlock(xmlSecParallelCtxPtr ctx) {
+#if defined(XMLSEC_WINDOWS)
+    LeaveCriticalSection(&(ctx->lock));
+#else  /* defined(XMLSEC_WINDOWS) */
+    pthread_mutex_unlock(&(ctx->lock));
+#endif /* defined(XMLSEC_WINDOWS) */
+}
+
+static void
+xmlSecParallelWorker(xmlSecParallelCtxPtr ctx) {
+    xmlSecSize pos;
+    int ret;
+
+    while(1) {
+        xmlSecParallelCtxLock(ctx);
+        if((ctx->failed != 0) || (ctx->next >= ctx->tasksNum)) {
+            xmlSecParallelCtxUnlock(ctx);
+            break;
+        }
+        pos = (ctx->next)++;
+        xmlSecParallelCtxUnlock(ctx);
+
+        ret = ctx->task(ctx->data, pos);
+        if(ret < 0) {
+            xmlSecParallelCtxLock(ctx);
+            ctx->failed = 1;
+            xmlSecParallelCtxUnlock(ctx);
+            break;
+        }
+    }
+}
+
+#if defined(XMLSEC_WINDOWS)
+typedef HANDLE  xmlSecParallelThread;
+
+static unsigned __stdcall
+xmlSecParallelThreadMain(void* arg) {
+    xmlSecParallelWorker((xmlSecParallelCtxPtr)arg);
+    return(0);
+}
+
+static int
+xmlSecParallelThreadStart(xmlSecParallelThread* thread, xmlSecParallelCtxPtr ctx) {
+    uintptr_t res;
+
+    res = _beginthreadex(NULL, 0, xmlSecParallelThreadMain, ctx, 0, NULL);
+    if(res == 0) {
+        return(-1);
+    }
+    (*thread) = (HANDLE)res;
+    return(0);
+}
+
+static void
+xmlSecParallelThreadJoin(xmlSecParallelThread thread) {
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+#else  /* defined(XMLSEC_WINDOWS) */
+typedef pthread_t xmlSecParallelThread;
+
+static void*
+xmlSecParallelThreadMain(void* arg) {
+    xmlSecParallelWorker((xmlSecParallelCtxPtr)arg);
+    return(NULL);
+}
+
+static int
+xmlSecParallelThreadStart(xmlSecParallelThread* thread, xmlSecParallelCtxPtr ctx) {
+    if(pthread_create(thread, NULL, xmlSecParallelThreadMain, ctx) != 0) {
+        return(-1);
+    }
+    return(0);
+}
+
+static void
+xmlSecParallelThreadJoin(xmlSecParallelThread thread) {
+    pthread_join(thread, NULL);
+}
+
+#endif /* defined(XMLSEC_WINDOWS) */
+
+#endif /* defined(XMLSEC_WINDOWS) || !defined(XMLSEC_NO_THREADS) */
+
+/**
+ * xmlSecParallelRun:
+ * @task:               the task method.
+ * @data:               the data passed to the @task method.
+ * @tasksNum:           the number of tasks.
+ * @threadsNum:         the max number of threads (including the current one)
+ *                      to use; 0 or 1 executes all the tasks in the current thread.
+ *
+ * Executes @task for each task number from 0 to @tasksNum - 1. The tasks
+ * are distributed between up to @threadsNum threads in no particular order.
+ * If threads support is disabled or if the threads can't be created then
+ * the tasks are executed in the current thread. No new tasks are started
+ * after one of the tasks fails.
+ *
+ * Returns: 0 if all the tasks succeeded or a negative value otherwise.
+ */
+int
+xmlSecParallelRun(xmlSecParallelTaskMethod task, void* data, xmlSecSize tasksNum, xmlSecSize threadsNum) {
+#if defined(XMLSEC_WINDOWS) || !defined(XMLSEC_NO_THREADS)
+    xmlSecParallelCtx ctx;
+    xmlSecParallelThread* threads = NULL;
+    xmlSecSize threadsStarted = 0;
+    xmlSecSize ii;
+#else  /* defined(XMLSEC_WINDOWS) || !defined(XMLSEC_NO_THREADS) */
+    xmlSecSize ii;
+    int ret;
+#endif /* defined(XMLSEC_WINDOWS) || !defined(XMLSEC_NO_THREADS) */
+
+    xmlSecAssert2(task != NULL, -1);
+
+#if defined(XMLSEC_WINDOWS) || !defined(XMLSEC_NO_THREADS)
+    if(threadsNum > tasksNum) {
+        threadsNum = tasksNum;
+    }
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.task     = task;
+    ctx.data     = data;
+    ctx.tasksNum = tasksNum;
+
+#if defined(XMLSEC_WINDOWS)
+    InitializeCriticalSection(&(ctx.lock));
+#else  /* defined(XMLSEC_WINDOWS) */
+    if(pthread_mutex_init(&(ctx.lock), NULL) != 0) {
+        xmlSecInternalError("pthread_mutex_init", NULL);
+        return(-1);
+    }
+#endif /* defined(XMLSEC_WINDOWS) */
+
+    /* start the additional threads, if we can't then just do more work ourselves */
+    if(threadsNum > 1) {
+        threads = (xmlSecParallelThread*)xmlMalloc(sizeof(xmlSecParallelThread) * (threadsNum - 1));
+        if(threads != NULL) {
+            for(ii = 0; ii < threadsNum - 1; ++ii) {
+                if(xmlSecParallelThreadStart(&(threads[ii]), &ctx) < 0) {
+                    break;
+                }
+                ++threadsStarted;
+            }
+        }
+    }
+
+    /* the current thread is a worker too */
+    xmlSecParallelWorker(&ctx);
+    for(ii = 0; ii < threadsStarted; ++ii) {
+        xmlSecParallelThreadJoin(threads[ii]);
+    }
+    if(threads != NULL) {
+        xmlFree(threads);
+    }
+
+#if defined(XMLSEC_WINDOWS)
+    DeleteCriticalSection(&(ctx.lock));
+#else  /* defined(XMLSEC_WINDOWS) */
+    pthread_mutex_destroy(&(ctx.lock));
+#endif /* defined(XMLSEC_WINDOWS) */
+
+    return((ctx.failed == 0) ? 0 : -1);
+
+#else  /* defined(XMLSEC_WINDOWS) || !defined(XMLSEC_NO_THREADS) */
+    UNREFERENCED_PARAMETER(threadsNum);
+
+    for(ii = 0; ii < tasksNum; ++ii) {
+        ret = task(data, ii);
+        if(ret < 0) {
+            return(-1);
+        }
+    }
+    return(0);
+#endif /* defined(XMLSEC_WINDOWS) || !defined(XMLSEC_NO_THREADS) */
+}
@@ -0,0 +1,50 @@
+/*
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * THIS IS A PRIVATE XMLSEC HEADER FILE
+ * DON'T USE IT IN YOUR APPLICATION
+ *
+ * Simple helper to run independent tasks on a pool of threads.
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2024 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#ifndef __XMLSEC_PARALLEL_HELPERS_H__
+#define __XMLSEC_PARALLEL_HELPERS_H__
+
+#ifndef XMLSEC_PRIVATE
+#error "parallel_helpers.h file contains private xmlsec definitions and should not be used outside xmlsec or xmlsec-$crypto libraries"
+#endif /* XMLSEC_PRIVATE */
+
+#include <xmlsec/xmlsec.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * xmlSecParallelTaskMethod:
+ * @data:               the tasks data.
+ * @pos:                the task number.
+ *
+ * Executes task number @pos. The method is called from multiple
+ * threads at the same time and must not modify data shared with
+ * other tasks.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+typedef int             (*xmlSecParallelTaskMethod)                     (void* data,
+                                                                         xmlSecSize pos);
+
+int                     xmlSecParallelRun                               (xmlSecParallelTaskMethod task,
+                                                                         void* data,
+                                                                         xmlSecSize tasksNum,
+                                                                         xmlSecSize threadsNum);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __XMLSEC_PARALLEL_HELPERS_H__ */
@@ -18,13 +18,13 @@
 #include <string.h>
 
 #include <libxml/tree.h>
+#include <libxml/hash.h>
 #include <libxml/xpointer.h>
 #include <libxml/c14n.h>
 
 #include <xmlsec/xmlsec.h>
 #include <xmlsec/xmltree.h>
 #include <xmlsec/keys.h>
-#include <xmlsec/list.h>
 #include <xmlsec/transforms.h>
 #include <xmlsec/errors.h>
 
@@ -95,15 +95,26 @@
  *     when there will be such an input, then it'll be easy to add support for that. But I didn't want to clutter
  *     the current implementation with details that doesn't seem to be used in practice
  *
+ *   * The SourceId values are kept in a hash table and the selected Relationship elements are
+ *     sorted as an array (with the Id values read once per element), so packages with tens of
+ *     thousands of relationships don't hit quadratic behavior.
+ *
  * xmlSecTransform + xmlSecRelationshipCtx
  *
  ***************************************************************************/
 typedef struct _xmlSecRelationshipCtx           xmlSecRelationshipCtx,
                                                 *xmlSecRelationshipCtxPtr;
 struct _xmlSecRelationshipCtx {
-    xmlSecPtrListPtr                    sourceIdList;
+    xmlHashTablePtr                     sourceIds;
 };
 
+/* Relationship element selected for the output with the cached Id value */
+typedef struct _xmlSecRelationshipItem {
+    xmlNodePtr                          node;
+    xmlChar*                            id;
+    xmlSecSize                          pos;
+} xmlSecRelationshipItem, *xmlSecRelationshipItemPtr;
+
 XMLSEC_TRANSFORM_DECLARE(Relationship, xmlSecRelationshipCtx)
 #define xmlSecRelationshipSize XMLSEC_TRANSFORM_SIZE(Relationship)
 
@@ -178,10 +189,10 @@ xmlSecRelationshipInitialize(xmlSecTransformPtr transform) {
     /* initialize context */
     memset(ctx, 0, sizeof(xmlSecRelationshipCtx));
 
-    ctx->sourceIdList = xmlSecPtrListCreate(xmlSecStringListId);
-    if(ctx->sourceIdList == NULL) {
-        xmlSecInternalError("xmlSecPtrListCreate",
-                            xmlSecTransformGetName(transform));
+    ctx->sourceIds = xmlHashCreate(0);
+    if(ctx->sourceIds == NULL) {
+        xmlSecXmlError("xmlHashCreate",
+                       xmlSecTransformGetName(transform));
         return(-1);
     }
     return(0);
@@ -197,8 +208,8 @@ xmlSecRelationshipFinalize(xmlSecTransformPtr transform) {
     ctx = xmlSecRelationshipGetCtx(transform);
     xmlSecAssert(ctx != NULL);
 
-    if(ctx->sourceIdList != NULL) {
-       xmlSecPtrListDestroy(ctx->sourceIdList);
+    if(ctx->sourceIds != NULL) {
+       xmlHashFree(ctx->sourceIds, NULL);
     }
 
     memset(ctx, 0, sizeof(xmlSecRelationshipCtx));
@@ -229,13 +240,18 @@ xmlSecRelationshipReadNode(xmlSecTransformPtr transform, xmlNodePtr node, xmlSec
                 return(-1);
             }
 
-            ret = xmlSecPtrListAdd(ctx->sourceIdList, sourceId);
-            if(ret < 0) {
-                xmlSecInternalError("xmlSecPtrListAdd",
-                                    xmlSecTransformGetName(transform));
-                xmlFree(sourceId);
-                return(-1);
+            /* the same SourceId might be specified more than once */
+            if(xmlHashLookup(ctx->sourceIds, sourceId) == NULL) {
+                ret = xmlHashAddEntry(ctx->sourceIds, sourceId, ctx);
+                if(ret < 0) {
+                    xmlSecXmlError2("xmlHashAddEntry",
+                                    xmlSecTransformGetName(transform),
+                                    "sourceId=%s", xmlSecErrorsSafeString(sourceId));
+                    xmlFree(sourceId);
+                    return(-1);
+                }
             }
+            xmlFree(sourceId);
         }
 
         cur = cur->next;
@@ -244,152 +260,147 @@ xmlSecRelationshipReadNode(xmlSecTransformPtr transform, xmlNodePtr node, xmlSec
     return(0);
 }
 
-/* Sorts Relationship elements by Id value in lexicographical order. */
+/* Sorts Relationship elements by Id value in lexicographical order (document order for equal Ids). */
 static int
-xmlSecTransformRelationshipCompare(xmlNodePtr node1, xmlNodePtr node2) {
-    xmlChar* id1 = NULL;
-    xmlChar* id2 = NULL;
+xmlSecTransformRelationshipCompare(const void* a, const void* b) {
+    const xmlSecRelationshipItem* item1 = (const xmlSecRelationshipItem*)a;
+    const xmlSecRelationshipItem* item2 = (const xmlSecRelationshipItem*)b;
     int ret;
 
-    if(node1 == node2) {
-        return(0);
-    }
-    if(node1 == NULL) {
+    if((item1->id == NULL) && (item2->id != NULL)) {
         return(-1);
     }
-    if(node2 == NULL) {
+    if((item1->id != NULL) && (item2->id == NULL)) {
         return(1);
     }
 
-    id1 = xmlGetProp(node1, xmlSecRelationshipAttrId);
-    id2 = xmlGetProp(node2, xmlSecRelationshipAttrId);
-    if(id1 == NULL) {
-        ret = -1;
-        goto done;
-    }
-    if(id2 == NULL) {
-        ret = 1;
-        goto done;
-    }
-
-    ret = xmlStrcmp(id1, id2);
-
-done:
-    if (id1 != NULL) {
-        xmlFree(id1);
-    }
-    if (id2 != NULL) {
-        xmlFree(id2);
+    ret = xmlStrcmp(item1->id, item2->id);
+    if(ret != 0) {
+        return(ret);
     }
-
-    return ret;
+    return((item1->pos < item2->pos) ? -1 : ((item1->pos > item2->pos) ? 1 : 0));
 }
 
 /*
- * This is step 2, point 4: if the input sourceId list doesn't contain the Id attribute of the current node,
- * then exclude it from the output, instead of processing it.
+ * This is step 2, point 4: if the input sourceId set doesn't contain the Id attribute of the current node,
+ * then exclude it from the output. The Id value is returned in @id (NULL if the node is excluded).
  */
 static int
-xmlSecTransformRelationshipProcessNode(xmlSecTransformPtr transform, xmlOutputBufferPtr buf, xmlNodePtr cur) {
-    int found = -1;
+xmlSecTransformRelationshipSelectNode(xmlSecTransformPtr transform, xmlNodePtr cur, xmlChar** id) {
     xmlSecRelationshipCtxPtr ctx;
-    xmlSecSize ii;
-    int ret;
 
     xmlSecAssert2(transform != NULL, -1);
-    xmlSecAssert2(buf != NULL, -1);
     xmlSecAssert2(cur != NULL, -1);
+    xmlSecAssert2(id != NULL, -1);
 
-    if(xmlSecCheckNodeName(cur, xmlSecNodeRelationship, xmlSecRelationshipsNs)) {
-        xmlChar* id = xmlGetProp(cur, xmlSecRelationshipAttrId);
-        if(id == NULL) {
-            xmlSecXmlError2("xmlGetProp(xmlSecRelationshipAttrId)",
-                            xmlSecTransformGetName(transform),
-                            "name=%s", xmlSecRelationshipAttrId);
-            return(-1);
-        }
-
-        ctx = xmlSecRelationshipGetCtx(transform);
-        for(ii = 0; ii < xmlSecPtrListGetSize(ctx->sourceIdList); ++ii) {
-            if(xmlStrcmp((xmlChar *)xmlSecPtrListGetItem(ctx->sourceIdList, ii), id) == 0) {
-                found = 1;
-                break;
-            }
-        }
-
-        xmlFree(id);
+    ctx = xmlSecRelationshipGetCtx(transform);
+    xmlSecAssert2(ctx != NULL, -1);
+    xmlSecAssert2(ctx->sourceIds != NULL, -1);
 
-        if(found < 0) {
-            return(0);
-        }
+    (*id) = xmlGetProp(cur, xmlSecRelationshipAttrId);
+    if(!xmlSecCheckNodeName(cur, xmlSecNodeRelationship, xmlSecRelationshipsNs)) {
+        /* not a relationship from the Relationships namespace: keep it as-is */
+        return(1);
     }
-
-    ret = xmlSecTransformRelationshipProcessElementNode(transform, buf, cur);
-    if(ret < 0) {
-        xmlSecInternalError("xmlSecTransformRelationshipProcessElementNode",
-                            xmlSecTransformGetName(transform));
+    if((*id) == NULL) {
+        xmlSecXmlError2("xmlGetProp(xmlSecRelationshipAttrId)",
+                        xmlSecTransformGetName(transform),
+                        "name=%s", xmlSecRelationshipAttrId);
         return(-1);
     }
-
-    return(0);
+    if(xmlHashLookup(ctx->sourceIds, (*id)) == NULL) {
+        xmlFree(*id);
+        (*id) = NULL;
+        return(0);
+    }
+    return(1);
 }
 
 /*
- * This is step 2, point 3: sort elements by Id: we process other elements as-is, but for elements we collect them in a list,
- * then sort, and finally process them (process the head of the list, then pop the head, till the list becomes empty).
+ * This is step 2, point 3: sort elements by Id: we process other elements as-is, but for elements we collect
+ * the selected ones in an array, then sort, and finally process them.
  */
 static int
 xmlSecTransformRelationshipProcessNodeList(xmlSecTransformPtr transform, xmlOutputBufferPtr buf, xmlNodePtr cur) {
-    xmlListPtr list;
+    xmlSecRelationshipItemPtr items = NULL;
+    xmlSecSize itemsSize = 0;
+    xmlSecSize itemsNum = 0;
+    xmlSecSize ii;
+    xmlNodePtr node;
+    int res = -1;
     int ret;
 
     xmlSecAssert2(transform != NULL, -1);
     xmlSecAssert2(buf != NULL, -1);
     xmlSecAssert2(cur != NULL, -1);
 
-    list = xmlListCreate(NULL, (xmlListDataCompare)xmlSecTransformRelationshipCompare);
-    if(list == NULL) {
-        xmlSecXmlError("xmlListCreate", xmlSecTransformGetName(transform));
-        return(-1);
+    for(node = cur; node != NULL; node = node->next) {
+        if(xmlStrcmp(node->name, xmlSecNodeRelationship) == 0) {
+            ++itemsSize;
+        }
+    }
+    if(itemsSize > 0) {
+        items = (xmlSecRelationshipItemPtr)xmlMalloc(sizeof(xmlSecRelationshipItem) * itemsSize);
+        if(items == NULL) {
+            xmlSecMallocError(sizeof(xmlSecRelationshipItem) * itemsSize,
+                              xmlSecTransformGetName(transform));
+            return(-1);
+        }
     }
 
-    for(; cur; cur = cur->next) {
-        if(xmlStrcmp(cur->name, xmlSecNodeRelationship) == 0) {
-            if(xmlListInsert(list, cur) != 0) {
-                xmlSecXmlError("xmlListInsert", xmlSecTransformGetName(transform));
-                return(-1);
+    for(node = cur, ii = 0; node != NULL; node = node->next, ++ii) {
+        if(xmlStrcmp(node->name, xmlSecNodeRelationship) == 0) {
+            xmlChar* id = NULL;
+
+            ret = xmlSecTransformRelationshipSelectNode(transform, node, &id);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecTransformRelationshipSelectNode",
+                                    xmlSecTransformGetName(transform));
+                goto done;
+            } else if(ret == 0) {
+                continue;
             }
+
+            items[itemsNum].node = node;
+            items[itemsNum].id   = id;
+            items[itemsNum].pos  = ii;
+            ++itemsNum;
         } else {
-            ret = xmlSecTransformRelationshipProcessNode(transform, buf, cur);
+            ret = xmlSecTransformRelationshipProcessElementNode(transform, buf, node);
             if(ret < 0) {
-                xmlSecInternalError("xmlSecTransformRelationshipProcessNode",
+                xmlSecInternalError("xmlSecTransformRelationshipProcessElementNode",
                                     xmlSecTransformGetName(transform));
-                xmlListDelete(list);
-                return(-1);
+                goto done;
             }
         }
     }
 
-    xmlListSort(list);
-
-    while(!xmlListEmpty(list)) {
-        xmlLinkPtr link = xmlListFront(list);
-        xmlNodePtr node = (xmlNodePtr)xmlLinkGetData(link);
+    if(itemsNum > 1) {
+        qsort(items, itemsNum, sizeof(xmlSecRelationshipItem), xmlSecTransformRelationshipCompare);
+    }
 
-        ret = xmlSecTransformRelationshipProcessNode(transform, buf, node);
+    for(ii = 0; ii < itemsNum; ++ii) {
+        ret = xmlSecTransformRelationshipProcessElementNode(transform, buf, items[ii].node);
         if(ret < 0) {
-            xmlSecInternalError("xmlSecTransformRelationshipProcessNode",
+            xmlSecInternalError("xmlSecTransformRelationshipProcessElementNode",
                                 xmlSecTransformGetName(transform));
-            xmlListDelete(list);
-            return(-1);
+            goto done;
         }
-
-        xmlListPopFront(list);
     }
 
-    /* done */
-    xmlListDelete(list);
-    return(0);
+    /* success */
+    res = 0;
+
+done:
+    if(items != NULL) {
+        for(ii = 0; ii < itemsNum; ++ii) {
+            if(items[ii].id != NULL) {
+                xmlFree(items[ii].id);
+            }
+        }
+        xmlFree(items);
+    }
+    return(res);
 }
 
 static int
@@ -685,15 +696,16 @@ xmlSecTransformRelationshipPopBin(xmlSecTransformPtr transform, xmlSecByte* data
     }
 
     if(transform->status == xmlSecTransformStatusWorking) {
-       xmlSecSize outSize;
+       xmlSecSize outSize, chunkSize;
 
        /* return chunk after chunk */
        outSize = xmlSecBufferGetSize(out);
        if(outSize > maxDataSize) {
            outSize = maxDataSize;
        }
-       if(outSize > transformCtx->binaryChunkSize) {
-           outSize = transformCtx->binaryChunkSize;
+       chunkSize = xmlSecTransformCtxGetBinaryChunkSize(transformCtx);
+       if(outSize > chunkSize) {
+           outSize = chunkSize;
        }
        if(outSize > 0) {
            xmlSecAssert2(xmlSecBufferGetData(out), -1);
@@ -453,6 +453,7 @@ const xmlChar xmlSecNodeKeyValue[]              = "KeyValue";
  *
  ************************************************************************/
 const xmlChar xmlSecNameMemBuf[]                = "membuf-transform";
+const xmlChar xmlSecNameOutputBuf[]             = "output-buffer-transform";
 
 /*************************************************************************
  *
@@ -485,6 +486,7 @@ const xmlChar xmlSecNodePbkdf2PRF[]             = "PRF";
  *
  ************************************************************************/
 const xmlChar xmlSecNameRetrievalMethod[]       = "retrieval-method";
+const xmlChar xmlSecNameRetrievalCacheStore[]   = "retrieval-cache-store";
 const xmlChar xmlSecNodeRetrievalMethod[]       = "RetrievalMethod";
 
 /*************************************************************************
@@ -712,6 +714,21 @@ const xmlChar xmlSecRelationshipAttrId[]        = "Id";
 const xmlChar xmlSecRelationshipAttrSourceId[]  = "SourceId";
 const xmlChar xmlSecRelationshipAttrTargetMode[]= "TargetMode";
 
+/*************************************************************************
+ *
+ * OPC package strings
+ *
+ ************************************************************************/
+const xmlChar xmlSecOpcContentTypesPartName[]   = "[Content_Types].xml";
+const xmlChar xmlSecOpcContentTypesNs[]         = "http://schemas.openxmlformats.org/package/2006/content-types";
+const xmlChar xmlSecOpcNodeTypes[]              = "Types";
+const xmlChar xmlSecOpcNodeDefault[]            = "Default";
+const xmlChar xmlSecOpcNodeOverride[]           = "Override";
+const xmlChar xmlSecOpcAttrExtension[]          = "Extension";
+const xmlChar xmlSecOpcAttrPartName[]           = "PartName";
+const xmlChar xmlSecOpcAttrContentType[]        = "ContentType";
+const xmlChar xmlSecOpcUriContentType[]         = "ContentType=";
+
 /*************************************************************************
  *
  * Xslt strings
@@ -22,6 +22,23 @@
 #include <xmlsec/transforms.h>
 
 
+/**************************** Transforms reading ********************************/
+XMLSEC_EXPORT xmlSecTransformPtr xmlSecTransformCtxNodeReadById    (xmlSecTransformCtxPtr ctx,
+                                                                    xmlNodePtr node,
+                                                                    xmlSecTransformId id);
+
+/**************************** Vectored push ********************************/
+typedef int (*xmlSecTransformUpdateMethod)                          (xmlSecTransformPtr transform,
+                                                                    const xmlSecByte* data,
+                                                                    xmlSecSize dataSize);
+
+XMLSEC_EXPORT int xmlSecTransformUpdatePushBinV                     (xmlSecTransformPtr transform,
+                                                                    const xmlSecTransformIOVec* vec,
+                                                                    xmlSecSize vecSize,
+                                                                    int final,
+                                                                    xmlSecTransformCtxPtr transformCtx,
+                                                                    xmlSecTransformUpdateMethod update);
+
 /**************************** Common Key Agreement params ********************************/
 struct _xmlSecTransformKeyAgreementParams {
     xmlSecTransformPtr  kdfTransform;
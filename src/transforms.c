@@ -284,6 +284,21 @@ xmlSecTransformUriTypeCheck(xmlSecTransformUriType type, const xmlChar* uri) {
  *************************************************************************/
 static xmlSecSize g_xmlSecTransformCtxDefaultBinaryChunkSize = (64*1024); /* 64kb */
 
+#define XMLSEC_TRANSFORM_CHUNK_ALIGNMENT  (4*1024) /* 4kb, see XMLSEC_TRANSFORMCTX_FLAGS_ADAPTIVE_CHUNK_SIZE */
+
+/* the private state is kept in the reserved0 slot to keep xmlSecTransformCtx layout */
+typedef struct _xmlSecTransformCtxPrivate       xmlSecTransformCtxPrivate,
+                                                *xmlSecTransformCtxPrivatePtr;
+struct _xmlSecTransformCtxPrivate {
+    xmlSecSize          inputSizeHint;
+};
+#define xmlSecTransformCtxGetPrivate(ctx) \
+    ((xmlSecTransformCtxPrivatePtr)((ctx)->reserved0))
+
+static xmlSecTransformPtr xmlSecTransformNodeReadById           (xmlNodePtr node,
+                                                                 xmlSecTransformId id,
+                                                                 xmlSecTransformCtxPtr transformCtx);
+
 /**
  * xmlSecTransformCtxGetDefaultBinaryChunkSize:
  *
@@ -312,7 +327,84 @@ xmlSecTransformCtxSetDefaultBinaryChunkSize(xmlSecSize binaryChunkSize) {
     g_xmlSecTransformCtxDefaultBinaryChunkSize = binaryChunkSize;
 }
 
+/**
+ * xmlSecTransformCtxGetBinaryChunkSize:
+ * @ctx:                the pointer to transforms chain processing context.
+ *
+ * Gets the binary chunk size for the transforms chain in @ctx. This is
+ * the @binaryChunkSize from @ctx unless the #XMLSEC_TRANSFORMCTX_FLAGS_ADAPTIVE_CHUNK_SIZE
+ * flag is set and the input size hint (see #xmlSecTransformCtxSetInputSizeHint)
+ * is smaller: in this case the data is processed in a single chunk of
+ * the input size rounded up to 4KB. The same chunk size is used for all
+ * the transforms in the chain.
+ *
+ * Returns: the binary chunk size.
+ */
+xmlSecSize
+xmlSecTransformCtxGetBinaryChunkSize(xmlSecTransformCtxPtr ctx) {
+    xmlSecSize inputSizeHint, chunkSize;
+
+    xmlSecAssert2(ctx != NULL, 0);
+    xmlSecAssert2(ctx->binaryChunkSize > 0, 0);
 
+    inputSizeHint = xmlSecTransformCtxGetInputSizeHint(ctx);
+    if(((ctx->flags & XMLSEC_TRANSFORMCTX_FLAGS_ADAPTIVE_CHUNK_SIZE) == 0) ||
+       (inputSizeHint == 0) || (inputSizeHint >= ctx->binaryChunkSize)) {
+        return(ctx->binaryChunkSize);
+    }
+
+    /* small input: single chunk */
+    chunkSize = XMLSEC_TRANSFORM_CHUNK_ALIGNMENT * ((inputSizeHint + XMLSEC_TRANSFORM_CHUNK_ALIGNMENT - 1) / XMLSEC_TRANSFORM_CHUNK_ALIGNMENT);
+    if(chunkSize > ctx->binaryChunkSize) {
+        return(ctx->binaryChunkSize);
+    }
+    return(chunkSize);
+}
+
+/**
+ * xmlSecTransformCtxGetInputSizeHint:
+ * @ctx:                the pointer to transforms chain processing context.
+ *
+ * Gets the expected size of the binary input data for the transforms
+ * chain in @ctx.
+ *
+ * Returns: the input size hint or 0 if the size is unknown.
+ */
+xmlSecSize
+xmlSecTransformCtxGetInputSizeHint(xmlSecTransformCtxPtr ctx) {
+    xmlSecTransformCtxPrivatePtr ctxPriv;
+
+    xmlSecAssert2(ctx != NULL, 0);
+
+    ctxPriv = xmlSecTransformCtxGetPrivate(ctx);
+    if(ctxPriv == NULL) {
+        return(0);
+    }
+    return(ctxPriv->inputSizeHint);
+}
+
+/**
+ * xmlSecTransformCtxSetInputSizeHint:
+ * @ctx:                the pointer to transforms chain processing context.
+ * @inputSizeHint:      the expected size of the binary input data or 0 if unknown.
+ *
+ * Sets the expected size of the binary input data for the transforms chain
+ * in @ctx (see #XMLSEC_TRANSFORMCTX_FLAGS_ADAPTIVE_CHUNK_SIZE). If the hint
+ * is not set by the application then the transforms execution functions
+ * set it from the input data (e.g. the file size); it is reset by
+ * #xmlSecTransformCtxReset.
+ */
+void
+xmlSecTransformCtxSetInputSizeHint(xmlSecTransformCtxPtr ctx, xmlSecSize inputSizeHint) {
+    xmlSecTransformCtxPrivatePtr ctxPriv;
+
+    xmlSecAssert(ctx != NULL);
+
+    ctxPriv = xmlSecTransformCtxGetPrivate(ctx);
+    xmlSecAssert(ctxPriv != NULL);
+
+    ctxPriv->inputSizeHint = inputSizeHint;
+}
 
 /**
  * xmlSecTransformCtxCreate:
@@ -378,9 +470,18 @@ xmlSecTransformCtxInitialize(xmlSecTransformCtxPtr ctx) {
 
     memset(ctx, 0, sizeof(xmlSecTransformCtx));
 
+    ctx->reserved0 = xmlMalloc(sizeof(xmlSecTransformCtxPrivate));
+    if(ctx->reserved0 == NULL) {
+        xmlSecMallocError(sizeof(xmlSecTransformCtxPrivate), NULL);
+        return(-1);
+    }
+    memset(ctx->reserved0, 0, sizeof(xmlSecTransformCtxPrivate));
+
     ret = xmlSecPtrListInitialize(&(ctx->enabledTransforms), xmlSecTransformIdListId);
     if(ret < 0) {
         xmlSecInternalError("xmlSecPtrListInitialize(xmlSecTransformIdListId)", NULL);
+        xmlFree(ctx->reserved0);
+        ctx->reserved0 = NULL;
         return(-1);
     }
 
@@ -401,6 +502,9 @@ xmlSecTransformCtxFinalize(xmlSecTransformCtxPtr ctx) {
 
     xmlSecTransformCtxReset(ctx);
     xmlSecPtrListFinalize(&(ctx->enabledTransforms));
+    if(ctx->reserved0 != NULL) {
+        xmlFree(ctx->reserved0);
+    }
     memset(ctx, 0, sizeof(xmlSecTransformCtx));
 }
 
@@ -418,6 +522,9 @@ xmlSecTransformCtxReset(xmlSecTransformCtxPtr ctx) {
 
     ctx->result = NULL;
     ctx->status = xmlSecTransformStatusNone;
+    if(xmlSecTransformCtxGetPrivate(ctx) != NULL) {
+        xmlSecTransformCtxGetPrivate(ctx)->inputSizeHint = 0;
+    }
 
     /* destroy uri */
     if(ctx->uri != NULL) {
@@ -649,6 +756,46 @@ xmlSecTransformCtxNodeRead(xmlSecTransformCtxPtr ctx, xmlNodePtr node,
     return(transform);
 }
 
+/**
+ * xmlSecTransformCtxNodeReadById:
+ * @ctx:                the pointer to transforms chain processing context.
+ * @node:               the pointer to transform's node.
+ * @id:                 the transform's klass.
+ *
+ * Same as #xmlSecTransformCtxNodeRead but skips the transform's klass
+ * lookup by the Algorithm attribute value (e.g. when the @node was
+ * already processed before).
+ *
+ * Returns: pointer to newly created transform or NULL if an error occurs.
+ */
+xmlSecTransformPtr
+xmlSecTransformCtxNodeReadById(xmlSecTransformCtxPtr ctx, xmlNodePtr node, xmlSecTransformId id) {
+    xmlSecTransformPtr transform;
+    int ret;
+
+    xmlSecAssert2(ctx != NULL, NULL);
+    xmlSecAssert2(ctx->status == xmlSecTransformStatusNone, NULL);
+    xmlSecAssert2(node != NULL, NULL);
+    xmlSecAssert2(id != xmlSecTransformIdUnknown, NULL);
+
+    transform = xmlSecTransformNodeReadById(node, id, ctx);
+    if(transform == NULL) {
+        xmlSecInternalError("xmlSecTransformNodeReadById",
+                            xmlSecNodeGetName(node));
+        return(NULL);
+    }
+
+    ret = xmlSecTransformCtxAppend(ctx, transform);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecTransformCtxAppend",
+                            xmlSecTransformGetName(transform));
+        xmlSecTransformDestroy(transform);
+        return(NULL);
+    }
+
+    return(transform);
+}
+
 /**
  * xmlSecTransformCtxNodesListRead:
  * @ctx:                the pointer to transforms chain processing context.
@@ -971,6 +1118,9 @@ xmlSecTransformCtxBinaryExecute(xmlSecTransformCtxPtr ctx,
         return(-1);
     }
 
+    if(xmlSecTransformCtxGetInputSizeHint(ctx) == 0) {
+        xmlSecTransformCtxSetInputSizeHint(ctx, dataSize);
+    }
     ret = xmlSecTransformPushBin(ctx->first, data, dataSize, 1, ctx);
     if(ret < 0) {
         xmlSecInternalError2("xmlSecTransformPushBin", NULL,
@@ -1023,6 +1173,11 @@ xmlSecTransformCtxUriExecute(xmlSecTransformCtxPtr ctx, const xmlChar* uri) {
         return(-1);
     }
 
+    /* the input URI transform knows the data size for files (and sometimes for http) */
+    if(xmlSecTransformCtxGetInputSizeHint(ctx) == 0) {
+        xmlSecTransformCtxSetInputSizeHint(ctx, xmlSecTransformInputURIGetSizeHint(uriTransform));
+    }
+
     /* Now we have a choice: we either can push from first transform or pop
      * from last. Our C14N transforms prefers push, so push data!
      */
@@ -1334,7 +1489,6 @@ xmlSecTransformNodeRead(xmlNodePtr node, xmlSecTransformUsage usage, xmlSecTrans
     xmlSecTransformPtr transform;
     xmlSecTransformId id;
     xmlChar *href;
-    int ret;
 
     xmlSecAssert2(node != NULL, NULL);
     xmlSecAssert2(transformCtx != NULL, NULL);
@@ -1354,13 +1508,35 @@ xmlSecTransformNodeRead(xmlNodePtr node, xmlSecTransformUsage usage, xmlSecTrans
         return(NULL);
     }
 
+    transform = xmlSecTransformNodeReadById(node, id, transformCtx);
+    if(transform == NULL) {
+        xmlSecInternalError2("xmlSecTransformNodeReadById",
+                             xmlSecTransformKlassGetName(id),
+                             "href=%s", xmlSecErrorsSafeString(href));
+        xmlFree(href);
+        return(NULL);
+    }
+
+    xmlFree(href);
+    return(transform);
+}
+
+/* same as xmlSecTransformNodeRead() when the transform id is already known */
+static xmlSecTransformPtr
+xmlSecTransformNodeReadById(xmlNodePtr node, xmlSecTransformId id, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecTransformPtr transform;
+    int ret;
+
+    xmlSecAssert2(node != NULL, NULL);
+    xmlSecAssert2(id != xmlSecTransformIdUnknown, NULL);
+    xmlSecAssert2(transformCtx != NULL, NULL);
+
     /* check with enabled transforms list */
     if((xmlSecPtrListGetSize(&(transformCtx->enabledTransforms)) > 0) &&
        (xmlSecTransformIdListFind(&(transformCtx->enabledTransforms), id) != 1)) {
         xmlSecOtherError2(XMLSEC_ERRORS_R_TRANSFORM_DISABLED,
                           xmlSecTransformKlassGetName(id),
-                          "href=%s", xmlSecErrorsSafeString(href));
-        xmlFree(href);
+                          "href=%s", xmlSecErrorsSafeString(id->href));
         return(NULL);
     }
 
@@ -1368,7 +1544,6 @@ xmlSecTransformNodeRead(xmlNodePtr node, xmlSecTransformUsage usage, xmlSecTrans
     if(!xmlSecTransformIsValid(transform)) {
         xmlSecInternalError("xmlSecTransformCreate(id)",
                             xmlSecTransformKlassGetName(id));
-        xmlFree(href);
         return(NULL);
     }
 
@@ -1378,14 +1553,12 @@ xmlSecTransformNodeRead(xmlNodePtr node, xmlSecTransformUsage usage, xmlSecTrans
             xmlSecInternalError("readNode",
                                 xmlSecTransformGetName(transform));
             xmlSecTransformDestroy(transform);
-            xmlFree(href);
             return(NULL);
         }
     }
 
     /* finally remember the transform node */
     transform->hereNode = node;
-    xmlFree(href);
     return(transform);
 }
 
@@ -1434,18 +1607,20 @@ xmlSecTransformPump(xmlSecTransformPtr left, xmlSecTransformPtr right, xmlSecTra
        }
     }  else if(((leftType & xmlSecTransformDataTypeBin) != 0) &&
                ((rightType & xmlSecTransformDataTypeBin) != 0)) {
+        xmlSecSize chunkSize;
         xmlSecByte* buf;
         int final = 0;
 
-        buf = xmlMalloc(transformCtx->binaryChunkSize);
+        chunkSize = xmlSecTransformCtxGetBinaryChunkSize(transformCtx);
+        buf = xmlMalloc(chunkSize);
         if(buf == NULL) {
-            xmlSecMallocError(transformCtx->binaryChunkSize, NULL);
+            xmlSecMallocError(chunkSize, NULL);
             return(-1);
         }
 
         do {
             xmlSecSize bufSize = 0;
-            ret = xmlSecTransformPopBin(left, buf, transformCtx->binaryChunkSize, &bufSize, transformCtx);
+            ret = xmlSecTransformPopBin(left, buf, chunkSize, &bufSize, transformCtx);
             if(ret < 0) {
                 xmlSecInternalError("xmlSecTransformPopBin", xmlSecTransformGetName(left));
                 xmlFree(buf);
@@ -1587,6 +1762,47 @@ xmlSecTransformVerifyNodeContent(xmlSecTransformPtr transform, xmlNodePtr node,
     return(0);
 }
 
+/**
+ * xmlSecTransformCopyState:
+ * @dst:                the pointer to destination transform.
+ * @src:                the pointer to source transform.
+ *
+ * Copies the processing state (e.g. the digest of the data processed
+ * so far or the final digest value) and the status from @src to @dst.
+ * Both transforms must have the same klass and the klass must implement
+ * the copyState method. The transforms' input and output buffers are not
+ * copied. This allows a caller to process a common data prefix once and
+ * fork the state for several consumers.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecTransformCopyState(xmlSecTransformPtr dst, xmlSecTransformPtr src) {
+    int ret;
+
+    xmlSecAssert2(xmlSecTransformIsValid(dst), -1);
+    xmlSecAssert2(xmlSecTransformIsValid(src), -1);
+    xmlSecAssert2(dst != src, -1);
+
+    if(dst->id != src->id) {
+        xmlSecInvalidTransfromError2(dst,
+            "expected transform: %s", xmlSecErrorsSafeString(xmlSecTransformGetName(src)));
+        return(-1);
+    }
+    if(dst->id->copyState == NULL) {
+        xmlSecNotImplementedError((const char*)xmlSecTransformGetName(dst));
+        return(-1);
+    }
+
+    ret = (dst->id->copyState)(dst, src);
+    if(ret < 0) {
+        xmlSecInternalError("copyState", xmlSecTransformGetName(dst));
+        return(-1);
+    }
+    dst->status = src->status;
+    return(0);
+}
+
 /**
  * xmlSecTransformGetDataType:
  * @transform:          the pointer to transform.
@@ -1630,6 +1846,34 @@ xmlSecTransformPushBin(xmlSecTransformPtr transform, const xmlSecByte* data,
     return((transform->id->pushBin)(transform, data, dataSize, final, transformCtx));
 }
 
+/**
+ * xmlSecTransformPushBinV:
+ * @transform:          the pointer to transform object.
+ * @vec:                the input binary data fragments.
+ * @vecSize:            the number of fragments in @vec.
+ * @final:              the flag: if set to 1 then it's the last data chunk.
+ * @transformCtx:       the pointer to transform context object.
+ *
+ * Same as #xmlSecTransformPushBin but the input data is given as a list of
+ * fragments (e.g. several memory regions or text nodes). Transforms that
+ * implement the pushBinV method process the fragments without joining them
+ * first, for all other transforms the fragments are pushed one by one.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecTransformPushBinV(xmlSecTransformPtr transform, const xmlSecTransformIOVec* vec,
+                    xmlSecSize vecSize, int final, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecAssert2(xmlSecTransformIsValid(transform), -1);
+    xmlSecAssert2((vec != NULL) || (vecSize == 0), -1);
+    xmlSecAssert2(transformCtx != NULL, -1);
+
+    if(transform->id->pushBinV != NULL) {
+        return((transform->id->pushBinV)(transform, vec, vecSize, final, transformCtx));
+    }
+    return(xmlSecTransformDefaultPushBinV(transform, vec, vecSize, final, transformCtx));
+}
+
 /**
  * xmlSecTransformPopBin:
  * @transform:          the pointer to transform object.
@@ -1932,6 +2176,7 @@ xmlSecTransformDefaultGetDataType(xmlSecTransformPtr transform, xmlSecTransformM
 int
 xmlSecTransformDefaultPushBin(xmlSecTransformPtr transform, const xmlSecByte* data,
                         xmlSecSize dataSize, int final, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecSize binaryChunkSize;
     xmlSecSize inSize = 0;
     xmlSecSize outSize = 0;
     int finalData = 0;
@@ -1940,6 +2185,7 @@ xmlSecTransformDefaultPushBin(xmlSecTransformPtr transform, const xmlSecByte* da
     xmlSecAssert2(xmlSecTransformIsValid(transform), -1);
     xmlSecAssert2(transformCtx != NULL, -1);
 
+    binaryChunkSize = xmlSecTransformCtxGetBinaryChunkSize(transformCtx);
     do {
         /* append data to input buffer */
         if(dataSize > 0) {
@@ -1948,8 +2194,8 @@ xmlSecTransformDefaultPushBin(xmlSecTransformPtr transform, const xmlSecByte* da
             xmlSecAssert2(data != NULL, -1);
 
             chunkSize = dataSize;
-            if(chunkSize > transformCtx->binaryChunkSize) {
-                chunkSize = transformCtx->binaryChunkSize;
+            if(chunkSize > binaryChunkSize) {
+                chunkSize = binaryChunkSize;
             }
 
             ret = xmlSecBufferAppend(&(transform->inBuf), data, chunkSize);
@@ -1979,22 +2225,32 @@ xmlSecTransformDefaultPushBin(xmlSecTransformPtr transform, const xmlSecByte* da
             finalData = 0;
         }
 
-        /* we don't want to push too much */
-        if(outSize > transformCtx->binaryChunkSize) {
-            outSize = transformCtx->binaryChunkSize;
-            finalData = 0;
-        }
-        if((transform->next != NULL) && ((outSize > 0) || (finalData != 0))) {
-            ret = xmlSecTransformPushBin(transform->next,
-                            xmlSecBufferGetData(&(transform->outBuf)),
-                            outSize,
-                            finalData,
-                            transformCtx);
-            if(ret < 0) {
-                xmlSecInternalError3("xmlSecTransformPushBin", xmlSecTransformGetName(transform->next),
-                    "final=%d;outSize=" XMLSEC_SIZE_FMT, final, outSize);
-                return(-1);
-            }
+        /* we don't want to push too much at once: transforms that produce more
+         * output than input (e.g. base64 encode) are drained in chunks and the
+         * output buffer is shifted only once */
+        if(transform->next != NULL) {
+            const xmlSecByte* outData = xmlSecBufferGetData(&(transform->outBuf));
+            xmlSecSize pushedSize = 0;
+
+            do {
+                xmlSecSize chunkSize = outSize - pushedSize;
+                int finalChunk = finalData;
+
+                if(chunkSize > binaryChunkSize) {
+                    chunkSize = binaryChunkSize;
+                    finalChunk = 0;
+                }
+                if((chunkSize > 0) || (finalChunk != 0)) {
+                    ret = xmlSecTransformPushBin(transform->next, outData + pushedSize,
+                                    chunkSize, finalChunk, transformCtx);
+                    if(ret < 0) {
+                        xmlSecInternalError3("xmlSecTransformPushBin", xmlSecTransformGetName(transform->next),
+                            "final=%d;outSize=" XMLSEC_SIZE_FMT, final, chunkSize);
+                        return(-1);
+                    }
+                }
+                pushedSize += chunkSize;
+            } while(pushedSize < outSize);
         }
 
         /* remove data anyway */
@@ -2011,6 +2267,115 @@ xmlSecTransformDefaultPushBin(xmlSecTransformPtr transform, const xmlSecByte* da
     return(0);
 }
 
+/**
+ * xmlSecTransformDefaultPushBinV:
+ * @transform:          the pointer to transform object.
+ * @vec:                the input binary data fragments.
+ * @vecSize:            the number of fragments in @vec.
+ * @final:              the flag: if set to 1 then it's the last data chunk.
+ * @transformCtx:       the pointer to transform context object.
+ *
+ * Pushes the non-empty fragments from @vec one by one using
+ * #xmlSecTransformPushBin (the @final flag is set only for the last one).
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecTransformDefaultPushBinV(xmlSecTransformPtr transform, const xmlSecTransformIOVec* vec,
+                        xmlSecSize vecSize, int final, xmlSecTransformCtxPtr transformCtx) {
+    xmlSecSize ii, last;
+    int ret;
+
+    xmlSecAssert2(xmlSecTransformIsValid(transform), -1);
+    xmlSecAssert2((vec != NULL) || (vecSize == 0), -1);
+    xmlSecAssert2(transformCtx != NULL, -1);
+
+    /* find the last non-empty fragment to set the final flag */
+    last = vecSize;
+    while((last > 0) && (vec[last - 1].size == 0)) {
+        --last;
+    }
+    if(last == 0) {
+        return(xmlSecTransformPushBin(transform, NULL, 0, final, transformCtx));
+    }
+
+    for(ii = 0; ii < last; ++ii) {
+        if(vec[ii].size == 0) {
+            continue;
+        }
+        xmlSecAssert2(vec[ii].data != NULL, -1);
+
+        ret = xmlSecTransformPushBin(transform, vec[ii].data, vec[ii].size,
+            ((ii + 1 == last) ? final : 0), transformCtx);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecTransformPushBin", xmlSecTransformGetName(transform),
+                "size=" XMLSEC_SIZE_FMT, vec[ii].size);
+            return(-1);
+        }
+    }
+    return(0);
+}
+
+/**
+ * xmlSecTransformUpdatePushBinV:
+ * @transform:          the pointer to transform object.
+ * @vec:                the input binary data fragments.
+ * @vecSize:            the number of fragments in @vec.
+ * @final:              the flag: if set to 1 then it's the last data chunk.
+ * @transformCtx:       the pointer to transform context object.
+ * @update:             the transform's method to process the data directly.
+ *
+ * The pushBinV implementation for the transforms that consume all the input
+ * data in the execute method (e.g. digests and HMAC): the fragments are
+ * given to @update without copying them into the input buffer, the rest
+ * (finalization and pushing the result to the next transform) is done by
+ * #xmlSecTransformDefaultPushBin.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecTransformUpdatePushBinV(xmlSecTransformPtr transform, const xmlSecTransformIOVec* vec,
+                        xmlSecSize vecSize, int final, xmlSecTransformCtxPtr transformCtx,
+                        xmlSecTransformUpdateMethod update) {
+    xmlSecSize ii;
+    int ret;
+
+    xmlSecAssert2(xmlSecTransformIsValid(transform), -1);
+    xmlSecAssert2((vec != NULL) || (vecSize == 0), -1);
+    xmlSecAssert2(transformCtx != NULL, -1);
+    xmlSecAssert2(update != NULL, -1);
+
+    /* let the transform start processing */
+    if(transform->status == xmlSecTransformStatusNone) {
+        ret = xmlSecTransformExecute(transform, 0, transformCtx);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformExecute", xmlSecTransformGetName(transform));
+            return(-1);
+        }
+    }
+
+    /* anything unusual is handled (and reported) by the default implementation */
+    if((transform->status != xmlSecTransformStatusWorking) || (xmlSecBufferGetSize(&(transform->inBuf)) > 0)) {
+        return(xmlSecTransformDefaultPushBinV(transform, vec, vecSize, final, transformCtx));
+    }
+
+    for(ii = 0; ii < vecSize; ++ii) {
+        if(vec[ii].size == 0) {
+            continue;
+        }
+        xmlSecAssert2(vec[ii].data != NULL, -1);
+
+        ret = update(transform, vec[ii].data, vec[ii].size);
+        if(ret < 0) {
+            xmlSecInternalError2("update", xmlSecTransformGetName(transform),
+                "size=" XMLSEC_SIZE_FMT, vec[ii].size);
+            return(-1);
+        }
+    }
+
+    return(xmlSecTransformDefaultPushBin(transform, NULL, 0, final, transformCtx));
+}
+
 /**
  * xmlSecTransformDefaultPopBin:
  * @transform:          the pointer to transform object.
@@ -2029,7 +2394,7 @@ int
 xmlSecTransformDefaultPopBin(xmlSecTransformPtr transform, xmlSecByte* data,
                              xmlSecSize maxDataSize, xmlSecSize* dataSize,
                              xmlSecTransformCtxPtr transformCtx) {
-    xmlSecSize outSize;
+    xmlSecSize outSize, outChunkSize;
     int final = 0;
     int ret;
 
@@ -2044,7 +2409,7 @@ xmlSecTransformDefaultPopBin(xmlSecTransformPtr transform, xmlSecByte* data,
             xmlSecSize inSize, chunkSize;
 
             inSize = xmlSecBufferGetSize(&(transform->inBuf));
-            chunkSize = transformCtx->binaryChunkSize;
+            chunkSize = xmlSecTransformCtxGetBinaryChunkSize(transformCtx);
 
             /* ensure that we have space for at least one data chunk */
             ret = xmlSecBufferSetMaxSize(&(transform->inBuf), inSize + chunkSize);
@@ -2095,8 +2460,9 @@ xmlSecTransformDefaultPopBin(xmlSecTransformPtr transform, xmlSecByte* data,
     }
 
     /* we don't want to put too much */
-    if(outSize > transformCtx->binaryChunkSize) {
-        outSize = transformCtx->binaryChunkSize;
+    outChunkSize = xmlSecTransformCtxGetBinaryChunkSize(transformCtx);
+    if(outSize > outChunkSize) {
+        outSize = outChunkSize;
     }
     if(outSize > 0) {
         xmlSecAssert2(xmlSecBufferGetData(&(transform->outBuf)), -1);
@@ -2397,6 +2763,7 @@ struct _xmlSecTransformIOBuffer {
     xmlSecTransformIOBufferMode         mode;
     xmlSecTransformPtr                  transform;
     xmlSecTransformCtxPtr               transformCtx;
+    xmlSecBuffer                        chunk;          /* write mode only */
 };
 
 static xmlSecTransformIOBufferPtr xmlSecTransformIOBufferCreate (xmlSecTransformIOBufferMode mode,
@@ -2410,6 +2777,8 @@ static int      xmlSecTransformIOBufferWrite                    (xmlSecTransform
                                                                  const xmlSecByte *buf,
                                                                  int len);
 static int      xmlSecTransformIOBufferClose                    (xmlSecTransformIOBufferPtr buffer);
+static int      xmlSecTransformIOBufferFlushChunk               (xmlSecTransformIOBufferPtr buffer,
+                                                                 int final);
 
 
 /**
@@ -2510,6 +2879,7 @@ static xmlSecTransformIOBufferPtr
 xmlSecTransformIOBufferCreate(xmlSecTransformIOBufferMode mode, xmlSecTransformPtr transform,
                               xmlSecTransformCtxPtr transformCtx) {
     xmlSecTransformIOBufferPtr buffer;
+    int ret;
 
     xmlSecAssert2(xmlSecTransformIsValid(transform), NULL);
     xmlSecAssert2(transformCtx != NULL, NULL);
@@ -2525,6 +2895,17 @@ xmlSecTransformIOBufferCreate(xmlSecTransformIOBufferMode mode, xmlSecTransformP
     buffer->transform = transform;
     buffer->transformCtx = transformCtx;
 
+    /* libxml2 writes small pieces of data, we collect them into binary chunk size blocks */
+    if(mode == xmlSecTransformIOBufferModeWrite) {
+        ret = xmlSecBufferInitialize(&(buffer->chunk), xmlSecTransformCtxGetBinaryChunkSize(transformCtx));
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecBufferInitialize",
+                                xmlSecTransformGetName(transform));
+            xmlFree(buffer);
+            return(NULL);
+        }
+    }
+
     return(buffer);
 }
 
@@ -2532,6 +2913,9 @@ static void
 xmlSecTransformIOBufferDestroy(xmlSecTransformIOBufferPtr buffer) {
     xmlSecAssert(buffer != NULL);
 
+    if(buffer->mode == xmlSecTransformIOBufferModeWrite) {
+        xmlSecBufferFinalize(&(buffer->chunk));
+    }
     memset(buffer, 0, sizeof(xmlSecTransformIOBuffer));
     xmlFree(buffer);
 }
@@ -2563,7 +2947,7 @@ xmlSecTransformIOBufferRead(xmlSecTransformIOBufferPtr buffer,
 static int
 xmlSecTransformIOBufferWrite(xmlSecTransformIOBufferPtr buffer,
                             const xmlSecByte *buf, int len) {
-    xmlSecSize size;
+    xmlSecSize size, chunkSize;
     int ret;
     int res;
 
@@ -2574,14 +2958,62 @@ xmlSecTransformIOBufferWrite(xmlSecTransformIOBufferPtr buffer,
     xmlSecAssert2(buf != NULL, -1);
 
     XMLSEC_SAFE_CAST_INT_TO_SIZE(len, size, return(-1), xmlSecTransformGetName(buffer->transform));
-    ret = xmlSecTransformPushBin(buffer->transform, buf, size, 0, buffer->transformCtx);
+
+    /* flush the collected data if the new data doesn't fit */
+    chunkSize = xmlSecTransformCtxGetBinaryChunkSize(buffer->transformCtx);
+    if((xmlSecBufferGetSize(&(buffer->chunk)) > 0) && (xmlSecBufferGetSize(&(buffer->chunk)) + size > chunkSize)) {
+        ret = xmlSecTransformIOBufferFlushChunk(buffer, 0);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformIOBufferFlushChunk",
+                                xmlSecTransformGetName(buffer->transform));
+            return(-1);
+        }
+    }
+
+    if(size >= chunkSize) {
+        /* big enough, no need to copy */
+        ret = xmlSecTransformPushBin(buffer->transform, buf, size, 0, buffer->transformCtx);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformPushBin",
+                                xmlSecTransformGetName(buffer->transform));
+            return(-1);
+        }
+    } else {
+        ret = xmlSecBufferAppend(&(buffer->chunk), buf, size);
+        if(ret < 0) {
+            xmlSecInternalError2("xmlSecBufferAppend",
+                                 xmlSecTransformGetName(buffer->transform),
+                                 "size=" XMLSEC_SIZE_FMT, size);
+            return(-1);
+        }
+    }
+    XMLSEC_SAFE_CAST_SIZE_TO_INT(size, res, return(-1), NULL);
+    return(res);
+}
+
+static int
+xmlSecTransformIOBufferFlushChunk(xmlSecTransformIOBufferPtr buffer, int final) {
+    int ret;
+
+    xmlSecAssert2(buffer != NULL, -1);
+    xmlSecAssert2(buffer->mode == xmlSecTransformIOBufferModeWrite, -1);
+
+    ret = xmlSecTransformPushBin(buffer->transform,
+        xmlSecBufferGetData(&(buffer->chunk)), xmlSecBufferGetSize(&(buffer->chunk)),
+        final, buffer->transformCtx);
     if(ret < 0) {
         xmlSecInternalError("xmlSecTransformPushBin",
                             xmlSecTransformGetName(buffer->transform));
         return(-1);
     }
-    XMLSEC_SAFE_CAST_SIZE_TO_INT(size, res, return(-1), NULL);
-    return(res);
+    /* the buffer is cleaned up in xmlSecBufferFinalize() */
+    ret = xmlSecBufferSetSize(&(buffer->chunk), 0);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecBufferSetSize",
+                            xmlSecTransformGetName(buffer->transform));
+        return(-1);
+    }
+    return(0);
 }
 
 static int
@@ -2594,9 +3026,9 @@ xmlSecTransformIOBufferClose(xmlSecTransformIOBufferPtr buffer) {
 
     /* need to flush write buffer before destroying */
     if(buffer->mode == xmlSecTransformIOBufferModeWrite) {
-        ret = xmlSecTransformPushBin(buffer->transform, NULL, 0, 1, buffer->transformCtx);
+        ret = xmlSecTransformIOBufferFlushChunk(buffer, 1);
         if(ret < 0) {
-            xmlSecInternalError("xmlSecTransformPushBin",
+            xmlSecInternalError("xmlSecTransformIOBufferFlushChunk",
                                 xmlSecTransformGetName(buffer->transform));
             return(-1);
         }
@@ -37,17 +37,54 @@
 #include <xmlsec/errors.h>
 
 #include "cast_helpers.h"
+#include "transform_helpers.h"
 
 /**************************************************************************
  *
  * xmlSecDSigCtx
  *
  *************************************************************************/
-static int      xmlSecDSigCtxProcessSignatureNode       (xmlSecDSigCtxPtr dsigCtx,
+/*
+ * The precompiled signature template: the algorithms for the signature
+ * and for each &lt;dsig:Reference/&gt; are resolved once when the profile is
+ * created.
+ */
+typedef struct _xmlSecDSigSignProfileReference  xmlSecDSigSignProfileReference,
+                                                *xmlSecDSigSignProfileReferencePtr;
+
+struct _xmlSecDSigSignProfileReference {
+    xmlSecPtrList               transforms;     /* xmlSecTransformIdListId */
+    xmlSecTransformId           digestMethodId;
+};
+
+struct _xmlSecDSigSignProfile {
+    xmlDocPtr                   doc;            /* private copy of the template */
+    xmlSecTransformId           c14nMethodId;
+    xmlSecTransformId           signMethodId;
+    xmlSecPtrList               references;     /* xmlSecDSigSignProfileReference items */
+};
+
+static int      xmlSecDSigSignProfileMatch              (xmlSecDSigSignProfilePtr profile,
                                                          xmlNodePtr node);
+static int      xmlSecDSigSignProfileReferenceReadTransforms(xmlSecDSigSignProfileReferencePtr profileRef,
+                                                         xmlSecTransformCtxPtr transformCtx,
+                                                         xmlNodePtr node);
+
+static int      xmlSecDSigCtxSignImpl                   (xmlSecDSigCtxPtr dsigCtx,
+                                                         xmlNodePtr tmpl,
+                                                         xmlNodeSetPtr changedNodes,
+                                                         xmlSecDSigSignProfilePtr profile);
+static int      xmlSecDSigCtxVerifyImpl                 (xmlSecDSigCtxPtr dsigCtx,
+                                                         xmlNodePtr node,
+                                                         xmlSecDSigSignProfilePtr profile);
+static int      xmlSecDSigCtxProcessSignatureNode       (xmlSecDSigCtxPtr dsigCtx,
+                                                         xmlNodePtr node,
+                                                         xmlNodeSetPtr changedNodes,
+                                                         xmlSecDSigSignProfilePtr profile);
 static int      xmlSecDSigCtxProcessSignedInfoNode      (xmlSecDSigCtxPtr dsigCtx,
                                                          xmlNodePtr node,
-                                                         xmlNodePtr * firstReferenceNode);
+                                                         xmlNodePtr * firstReferenceNode,
+                                                         xmlSecDSigSignProfilePtr profile);
 static int      xmlSecDSigCtxProcessKeyInfoNode         (xmlSecDSigCtxPtr dsigCtx,
                                                          xmlNodePtr node);
 static int      xmlSecDSigCtxProcessObjectNode          (xmlSecDSigCtxPtr dsigCtx,
@@ -56,13 +93,28 @@ static int      xmlSecDSigCtxProcessManifestNode        (xmlSecDSigCtxPtr dsigCt
                                                          xmlNodePtr node);
 
 static int      xmlSecDSigCtxProcessReferences          (xmlSecDSigCtxPtr dsigCtx,
-                                                         xmlNodePtr firstReferenceNode);
+                                                         xmlNodePtr firstReferenceNode,
+                                                         xmlNodeSetPtr changedNodes,
+                                                         xmlSecDSigSignProfilePtr profile);
 
 
 static void     xmlSecDSigCtxMarkAsSucceeded            (xmlSecDSigCtxPtr dsigCtx);
 static void     xmlSecDSigCtxMarkAsFailed               (xmlSecDSigCtxPtr dsigCtx,
                                                          xmlSecDSigFailureReason failureReason);
 
+static int      xmlSecDSigReferenceCtxProcessNodeImpl   (xmlSecDSigReferenceCtxPtr dsigRefCtx,
+                                                         xmlNodePtr node,
+                                                         xmlNodeSetPtr changedNodes,
+                                                         xmlSecDSigSignProfileReferencePtr profileRef);
+static xmlSecDSigReferenceCtxPtr xmlSecDSigReferenceCtxFindSameData(xmlSecDSigReferenceCtxPtr dsigRefCtx,
+                                                         xmlNodePtr node);
+static int      xmlSecDSigReferenceCtxCanKeepDigest     (xmlSecDSigReferenceCtxPtr dsigRefCtx,
+                                                         xmlNodePtr node,
+                                                         xmlNodePtr digestValueNode,
+                                                         xmlNodeSetPtr changedNodes);
+static int      xmlSecDSigCtxCheckPreviousSignature     (xmlSecDSigCtxPtr dsigCtx,
+                                                         xmlNodePtr signedInfoNode);
+
 /* The ID attribute in XMLDSig is 'Id' */
 static const xmlChar*           xmlSecDSigIds[] = { xmlSecAttrId, NULL };
 
@@ -280,6 +332,48 @@ xmlSecDSigCtxGetPreSignBuffer(xmlSecDSigCtxPtr dsigCtx) {
  */
 int
 xmlSecDSigCtxSign(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr tmpl) {
+    return(xmlSecDSigCtxSignImpl(dsigCtx, tmpl, NULL, NULL));
+}
+
+/**
+ * xmlSecDSigCtxSignIncremental:
+ * @dsigCtx:            the pointer to &lt;dsig:Signature/&gt; processing context.
+ * @tmpl:               the pointer to previously signed &lt;dsig:Signature/&gt; node.
+ * @changedNodes:       the list of nodes changed since @tmpl was signed (might be NULL).
+ *
+ * Re-signs the data as described in @tmpl node after the document was
+ * modified. The &lt;dsig:DigestValue/&gt; nodes in @tmpl are used as the
+ * stored digests from the previous signature if the previous
+ * &lt;dsig:SignatureValue/&gt; is valid for the current &lt;dsig:SignedInfo/&gt;
+ * and the signing key (otherwise, all the digests are re-calculated
+ * just like in #xmlSecDSigCtxSign): a &lt;dsig:Reference/&gt;
+ * from &lt;dsig:SignedInfo/&gt; keeps its digest (and its transforms are not
+ * executed) if none of the @changedNodes is within the referenced subtree
+ * or is an ancestor of it. All other references are re-calculated and then
+ * &lt;dsig:SignedInfo/&gt; is signed as usual.
+ *
+ * The @changedNodes list should contain all the nodes that were added
+ * or modified (including the elements with modified attributes or namespaces)
+ * and the parents of the removed nodes. An empty list means that nothing
+ * has changed. If @changedNodes is NULL then all the digests are
+ * re-calculated just like in #xmlSecDSigCtxSign.
+ *
+ * Only the same document references (URI="", URI="#xpointer(/)" or URI="#id")
+ * with canonicalization, enveloped signature and base64 transforms
+ * can keep the digest; references with any other URI or transform
+ * (e.g. XPath or XSLT) as well as references to the data inside @tmpl
+ * and &lt;dsig:Manifest/&gt; references are always re-calculated.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecDSigCtxSignIncremental(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr tmpl, xmlNodeSetPtr changedNodes) {
+    return(xmlSecDSigCtxSignImpl(dsigCtx, tmpl, changedNodes, NULL));
+}
+
+static int
+xmlSecDSigCtxSignImpl(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr tmpl, xmlNodeSetPtr changedNodes,
+                      xmlSecDSigSignProfilePtr profile) {
     xmlSecByte* outBuf;
     xmlSecSize outSize;
     int outLen;
@@ -296,7 +390,7 @@ xmlSecDSigCtxSign(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr tmpl) {
     xmlSecAddIDs(tmpl->doc, tmpl, xmlSecDSigIds);
 
     /* read signature template */
-    ret = xmlSecDSigCtxProcessSignatureNode(dsigCtx, tmpl);
+    ret = xmlSecDSigCtxProcessSignatureNode(dsigCtx, tmpl, changedNodes, profile);
     if(ret < 0) {
         xmlSecInternalError("xmlSecDSigCtxProcessSignatureNode", NULL);
         return(-1);
@@ -340,6 +434,11 @@ xmlSecDSigCtxSign(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr tmpl) {
  */
 int
 xmlSecDSigCtxVerify(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node) {
+    return(xmlSecDSigCtxVerifyImpl(dsigCtx, node, NULL));
+}
+
+static int
+xmlSecDSigCtxVerifyImpl(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node, xmlSecDSigSignProfilePtr profile) {
     int ret;
 
     xmlSecAssert2(dsigCtx != NULL, -1);
@@ -352,7 +451,7 @@ xmlSecDSigCtxVerify(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node) {
     xmlSecAddIDs(node->doc, node, xmlSecDSigIds);
 
     /* read signature info */
-    ret = xmlSecDSigCtxProcessSignatureNode(dsigCtx, node);
+    ret = xmlSecDSigCtxProcessSignatureNode(dsigCtx, node, NULL, profile);
     if(ret < 0) {
         xmlSecInternalError("xmlSecDSigCtxProcessSignatureNode", NULL);
         return(-1);
@@ -451,7 +550,8 @@ xmlSecDSigCtxMarkAsFailed(xmlSecDSigCtxPtr dsigCtx, xmlSecDSigFailureReason fail
  *
  */
 static int
-xmlSecDSigCtxProcessSignatureNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node) {
+xmlSecDSigCtxProcessSignatureNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node, xmlNodeSetPtr changedNodes,
+                                  xmlSecDSigSignProfilePtr profile) {
     xmlSecTransformDataType firstType;
     xmlNodePtr signedInfoNode = NULL;
     xmlNodePtr keyInfoNode = NULL;
@@ -521,7 +621,7 @@ xmlSecDSigCtxProcessSignatureNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node) {
     }
 
     /* now validated all the references and prepare transform */
-    ret = xmlSecDSigCtxProcessSignedInfoNode(dsigCtx, signedInfoNode, &firstReferenceNode);
+    ret = xmlSecDSigCtxProcessSignedInfoNode(dsigCtx, signedInfoNode, &firstReferenceNode, profile);
     if(ret < 0) {
         xmlSecInternalError("xmlSecDSigCtxProcessSignedInfoNode", NULL);
         return(-1);
@@ -540,8 +640,20 @@ xmlSecDSigCtxProcessSignatureNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node) {
     /* as the result, we should have a key */
     xmlSecAssert2(dsigCtx->signKey != NULL, -1);
 
+    /* incremental signing: the stored digests can be kept only if they were
+     * signed with the same key before (i.e. the previous signature is valid) */
+    if(changedNodes != NULL) {
+        ret = xmlSecDSigCtxCheckPreviousSignature(dsigCtx, signedInfoNode);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecDSigCtxCheckPreviousSignature", NULL);
+            return(-1);
+        } else if(ret == 0) {
+            changedNodes = NULL;
+        }
+    }
+
     /* now actually process references and calculate digests */
-    ret = xmlSecDSigCtxProcessReferences(dsigCtx, firstReferenceNode);
+    ret = xmlSecDSigCtxProcessReferences(dsigCtx, firstReferenceNode, changedNodes, profile);
     if(ret < 0) {
         xmlSecInternalError("xmlSecDSigCtxProcessReferences", NULL);
         return(-1);
@@ -629,7 +741,8 @@ xmlSecDSigCtxProcessSignatureNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node) {
  *
  */
 static int
-xmlSecDSigCtxProcessSignedInfoNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node, xmlNodePtr * firstReferenceNode) {
+xmlSecDSigCtxProcessSignedInfoNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node, xmlNodePtr * firstReferenceNode,
+                                   xmlSecDSigSignProfilePtr profile) {
     xmlSecSize refNodesCount = 0;
     xmlNodePtr cur;
 
@@ -645,8 +758,13 @@ xmlSecDSigCtxProcessSignedInfoNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node, xm
     /* first node is required CanonicalizationMethod. */
     cur = xmlSecGetNextElementNode(node->children);
     if((cur != NULL) && (xmlSecCheckNodeName(cur, xmlSecNodeCanonicalizationMethod, xmlSecDSigNs))) {
-        dsigCtx->c14nMethod = xmlSecTransformCtxNodeRead(&(dsigCtx->transformCtx),
+        if(profile != NULL) {
+            dsigCtx->c14nMethod = xmlSecTransformCtxNodeReadById(&(dsigCtx->transformCtx),
+                                        cur, profile->c14nMethodId);
+        } else {
+            dsigCtx->c14nMethod = xmlSecTransformCtxNodeRead(&(dsigCtx->transformCtx),
                                         cur, xmlSecTransformUsageC14NMethod);
+        }
         if(dsigCtx->c14nMethod == NULL) {
             xmlSecInternalError2("xmlSecTransformCtxNodeRead", NULL,
                                 "node=%s", xmlSecErrorsSafeString(xmlSecNodeGetName(cur)));
@@ -685,8 +803,13 @@ xmlSecDSigCtxProcessSignedInfoNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node, xm
     /* next node is required SignatureMethod. */
     cur = xmlSecGetNextElementNode( ((cur != NULL) ? cur->next : node->children) );
     if((cur != NULL) && (xmlSecCheckNodeName(cur, xmlSecNodeSignatureMethod, xmlSecDSigNs))) {
-        dsigCtx->signMethod = xmlSecTransformCtxNodeRead(&(dsigCtx->transformCtx),
+        if(profile != NULL) {
+            dsigCtx->signMethod = xmlSecTransformCtxNodeReadById(&(dsigCtx->transformCtx),
+                                        cur, profile->signMethodId);
+        } else {
+            dsigCtx->signMethod = xmlSecTransformCtxNodeRead(&(dsigCtx->transformCtx),
                                         cur, xmlSecTransformUsageSignatureMethod);
+        }
         if(dsigCtx->signMethod == NULL) {
             xmlSecInternalError("xmlSecTransformCtxNodeRead",
                                 xmlSecNodeGetName(cur));
@@ -742,8 +865,11 @@ xmlSecDSigCtxProcessSignedInfoNode(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr node, xm
 
 
 static int
-xmlSecDSigCtxProcessReferences(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr firstReferenceNode) {
+xmlSecDSigCtxProcessReferences(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr firstReferenceNode, xmlNodeSetPtr changedNodes,
+                               xmlSecDSigSignProfilePtr profile) {
     xmlSecDSigReferenceCtxPtr dsigRefCtx;
+    xmlSecDSigSignProfileReferencePtr profileRef = NULL;
+    xmlSecSize pos = 0;
     xmlNodePtr cur;
     int ret;
 
@@ -753,7 +879,10 @@ xmlSecDSigCtxProcessReferences(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr firstReferen
     xmlSecAssert2(xmlSecPtrListGetSize(&(dsigCtx->signedInfoReferences)) == 0, -1);
     xmlSecAssert2(firstReferenceNode != NULL, -1);
 
-    /* process references */
+    /* process references: each reference is digested by its own transforms
+     * chain, one after another (the references are not batched, the crypto
+     * backends don't have multi-buffer digests; the digests fetch cache in the
+     * OpenSSL backend reduces the fixed per reference cost instead) */
     for(cur = firstReferenceNode; (cur != NULL); cur = xmlSecGetNextElementNode(cur->next)) {
         /* already checked but we trust none */
         if(!xmlSecCheckNodeName(cur, xmlSecNodeReference, xmlSecDSigNs)) {
@@ -761,6 +890,18 @@ xmlSecDSigCtxProcessReferences(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr firstReferen
             return(-1);
         }
 
+        /* the template must match the profile */
+        if(profile != NULL) {
+            if(pos >= xmlSecPtrListGetSize(&(profile->references))) {
+                xmlSecOtherError2(XMLSEC_ERRORS_R_INVALID_DATA, NULL,
+                    "too many references for the profile, pos=" XMLSEC_SIZE_FMT, pos);
+                return(-1);
+            }
+            profileRef = (xmlSecDSigSignProfileReferencePtr)xmlSecPtrListGetItem(&(profile->references), pos);
+            xmlSecAssert2(profileRef != NULL, -1);
+        }
+        ++pos;
+
         /* create reference */
         dsigRefCtx = xmlSecDSigReferenceCtxCreate(dsigCtx, xmlSecDSigReferenceOriginSignedInfo);
         if(dsigRefCtx == NULL) {
@@ -777,9 +918,9 @@ xmlSecDSigCtxProcessReferences(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr firstReferen
         }
 
         /* process */
-        ret = xmlSecDSigReferenceCtxProcessNode(dsigRefCtx, cur);
+        ret = xmlSecDSigReferenceCtxProcessNodeImpl(dsigRefCtx, cur, changedNodes, profileRef);
         if(ret < 0) {
-            xmlSecInternalError("xmlSecDSigReferenceCtxProcessNode",
+            xmlSecInternalError("xmlSecDSigReferenceCtxProcessNodeImpl",
                                 xmlSecNodeGetName(cur));
             return(-1);
         }
@@ -791,6 +932,12 @@ xmlSecDSigCtxProcessReferences(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr firstReferen
         }
     }
 
+    if((profile != NULL) && (pos != xmlSecPtrListGetSize(&(profile->references)))) {
+        xmlSecOtherError2(XMLSEC_ERRORS_R_INVALID_DATA, NULL,
+            "not enough references for the profile, size=" XMLSEC_SIZE_FMT, pos);
+        return(-1);
+    }
+
     /* done */
     return(0);
 }
@@ -1283,6 +1430,12 @@ xmlSecDSigReferenceCtxInitialize(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlSecDSi
     if((dsigCtx->flags & XMLSEC_DSIG_FLAGS_USE_VISA3D_HACK) != 0) {
         dsigRefCtx->transformCtx.flags |= XMLSEC_TRANSFORMCTX_FLAGS_USE_VISA3D_HACK;
     }
+    if((dsigCtx->transformCtx.flags & XMLSEC_TRANSFORMCTX_FLAGS_USE_LIBXML2_C14N) != 0) {
+        dsigRefCtx->transformCtx.flags |= XMLSEC_TRANSFORMCTX_FLAGS_USE_LIBXML2_C14N;
+    }
+    if((dsigCtx->transformCtx.flags & XMLSEC_TRANSFORMCTX_FLAGS_ADAPTIVE_CHUNK_SIZE) != 0) {
+        dsigRefCtx->transformCtx.flags |= XMLSEC_TRANSFORMCTX_FLAGS_ADAPTIVE_CHUNK_SIZE;
+    }
     return(0);
 }
 
@@ -1350,6 +1503,14 @@ xmlSecDSigReferenceCtxGetPreDigestBuffer(xmlSecDSigReferenceCtxPtr dsigRefCtx) {
  */
 int
 xmlSecDSigReferenceCtxProcessNode(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodePtr node) {
+    return(xmlSecDSigReferenceCtxProcessNodeImpl(dsigRefCtx, node, NULL, NULL));
+}
+
+static int
+xmlSecDSigReferenceCtxProcessNodeImpl(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodePtr node,
+                                      xmlNodeSetPtr changedNodes,
+                                      xmlSecDSigSignProfileReferencePtr profileRef) {
+    xmlSecDSigReferenceCtxPtr sameRefCtx;
     xmlSecTransformCtxPtr transformCtx;
     xmlNodePtr digestValueNode;
     xmlNodePtr cur;
@@ -1381,12 +1542,20 @@ xmlSecDSigReferenceCtxProcessNode(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodeP
     /* first is optional Transforms node */
     cur  = xmlSecGetNextElementNode(node->children);
     if((cur != NULL) && (xmlSecCheckNodeName(cur, xmlSecNodeTransforms, xmlSecDSigNs))) {
-        ret = xmlSecTransformCtxNodesListRead(transformCtx,
-                                        cur, xmlSecTransformUsageDSigTransform);
-        if(ret < 0) {
-            xmlSecInternalError2("xmlSecTransformCtxNodesListRead", NULL,
-                                 "node=%s", xmlSecErrorsSafeString(xmlSecNodeGetName(cur)));
-            return(-1);
+        if(profileRef != NULL) {
+            ret = xmlSecDSigSignProfileReferenceReadTransforms(profileRef, transformCtx, cur);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecDSigSignProfileReferenceReadTransforms", NULL);
+                return(-1);
+            }
+        } else {
+            ret = xmlSecTransformCtxNodesListRead(transformCtx,
+                                            cur, xmlSecTransformUsageDSigTransform);
+            if(ret < 0) {
+                xmlSecInternalError2("xmlSecTransformCtxNodesListRead", NULL,
+                                     "node=%s", xmlSecErrorsSafeString(xmlSecNodeGetName(cur)));
+                return(-1);
+            }
         }
 
         cur = xmlSecGetNextElementNode(cur->next);
@@ -1410,8 +1579,13 @@ xmlSecDSigReferenceCtxProcessNode(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodeP
 
     /* next node is required DigestMethod. */
     if((cur != NULL) && (xmlSecCheckNodeName(cur, xmlSecNodeDigestMethod, xmlSecDSigNs))) {
-        dsigRefCtx->digestMethod = xmlSecTransformCtxNodeRead(&(dsigRefCtx->transformCtx),
+        if(profileRef != NULL) {
+            dsigRefCtx->digestMethod = xmlSecTransformCtxNodeReadById(&(dsigRefCtx->transformCtx),
+                                        cur, profileRef->digestMethodId);
+        } else {
+            dsigRefCtx->digestMethod = xmlSecTransformCtxNodeRead(&(dsigRefCtx->transformCtx),
                                         cur, xmlSecTransformUsageDigestMethod);
+        }
         if(dsigRefCtx->digestMethod == NULL) {
             xmlSecInternalError("xmlSecTransformCtxNodeRead",
                                 xmlSecNodeGetName(cur));
@@ -1453,26 +1627,53 @@ xmlSecDSigReferenceCtxProcessNode(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodeP
         return(-1);
     }
 
-    /* if we need to write result to xml node then we need base64 encode result */
-    if(dsigRefCtx->dsigCtx->operation == xmlSecTransformOperationSign) {
-        xmlSecTransformPtr base64Encode;
-
-        /* we need to add base64 encode transform */
-        base64Encode = xmlSecTransformCtxCreateAndAppend(transformCtx, xmlSecTransformBase64Id);
-        if(base64Encode == NULL) {
-            xmlSecInternalError("xmlSecTransformCtxCreateAndAppend", NULL);
+    /* incremental signing: keep the previous digest if the data didn't change */
+    if(changedNodes != NULL) {
+        ret = xmlSecDSigReferenceCtxCanKeepDigest(dsigRefCtx, node, digestValueNode, changedNodes);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecDSigReferenceCtxCanKeepDigest", NULL);
             return(-1);
+        } else if(ret == 1) {
+            /* DigestValue node is not touched and there is no result */
+            dsigRefCtx->status = xmlSecDSigStatusSucceeded;
+            return(0);
         }
-        base64Encode->operation = xmlSecTransformOperationEncode;
     }
 
-    /* finally get transforms results */
-    ret = xmlSecTransformCtxExecute(transformCtx, node->doc);
-    if(ret < 0) {
-        xmlSecInternalError("xmlSecTransformCtxExecute", NULL);
-        return(-1);
+    /* a previous reference already digested exactly the same data: fork its
+     * digest state instead of running the transforms again */
+    sameRefCtx = xmlSecDSigReferenceCtxFindSameData(dsigRefCtx, node);
+    if(sameRefCtx != NULL) {
+        ret = xmlSecTransformCopyState(dsigRefCtx->digestMethod, sameRefCtx->digestMethod);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformCopyState", NULL);
+            return(-1);
+        }
+        /* the verification result is per reference */
+        dsigRefCtx->digestMethod->status = xmlSecTransformStatusFinished;
+        dsigRefCtx->result = sameRefCtx->result;
+    } else {
+        /* if we need to write result to xml node then we need base64 encode result */
+        if(dsigRefCtx->dsigCtx->operation == xmlSecTransformOperationSign) {
+            xmlSecTransformPtr base64Encode;
+
+            /* we need to add base64 encode transform */
+            base64Encode = xmlSecTransformCtxCreateAndAppend(transformCtx, xmlSecTransformBase64Id);
+            if(base64Encode == NULL) {
+                xmlSecInternalError("xmlSecTransformCtxCreateAndAppend", NULL);
+                return(-1);
+            }
+            base64Encode->operation = xmlSecTransformOperationEncode;
+        }
+
+        /* finally get transforms results */
+        ret = xmlSecTransformCtxExecute(transformCtx, node->doc);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformCtxExecute", NULL);
+            return(-1);
+        }
+        dsigRefCtx->result = transformCtx->result;
     }
-    dsigRefCtx->result = transformCtx->result;
 
     if(dsigRefCtx->dsigCtx->operation == xmlSecTransformOperationSign) {
         xmlSecByte* outBuf;
@@ -1512,6 +1713,405 @@ xmlSecDSigReferenceCtxProcessNode(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodeP
     return(0);
 }
 
+/* checks if @node is @ancestor or one of its descendants */
+static int
+xmlSecDSigIsNodeInSubtree(xmlNodePtr ancestor, xmlNodePtr node) {
+    xmlSecAssert2(ancestor != NULL, 0);
+
+    /* namespace nodes from XPath node sets store the parent in the next pointer */
+    if((node != NULL) && (node->type == XML_NAMESPACE_DECL)) {
+        node = (xmlNodePtr)((xmlNsPtr)node)->next;
+    }
+    for(; node != NULL; node = node->parent) {
+        if(node == ancestor) {
+            return(1);
+        }
+    }
+    return(0);
+}
+
+/* returns the root of the subtree referenced by a same document URI or NULL */
+static xmlNodePtr
+xmlSecDSigReferenceCtxGetTargetNode(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlDocPtr doc) {
+    const xmlChar* id;
+    xmlAttrPtr attr;
+
+    xmlSecAssert2(dsigRefCtx != NULL, NULL);
+    xmlSecAssert2(doc != NULL, NULL);
+
+    /* no URI: the data is provided by the application */
+    if(dsigRefCtx->uri == NULL) {
+        return(NULL);
+    }
+    if((xmlSecStrlen(dsigRefCtx->uri) == 0) || (xmlStrcmp(dsigRefCtx->uri, BAD_CAST "#xpointer(/)") == 0)) {
+        return((xmlNodePtr)doc);
+    }
+
+    /* only barename "#id" pointers, anything else might select arbitrary nodes */
+    if((dsigRefCtx->uri[0] != '#') || (xmlStrchr(dsigRefCtx->uri, '(') != NULL)) {
+        return(NULL);
+    }
+    id = dsigRefCtx->uri + 1;
+    attr = xmlGetID(doc, id);
+    if((attr == NULL) || (attr->parent == NULL) || (attr->parent->type != XML_ELEMENT_NODE)) {
+        return(NULL);
+    }
+    return(attr->parent);
+}
+
+/* checks if two <dsig:Transform/> nodes of the same transform have the same parameters */
+static int
+xmlSecDSigTransformNodesHaveSameParams(xmlSecTransformPtr transform1, xmlSecTransformPtr transform2) {
+    xmlNodePtr cur1, cur2;
+    xmlChar* prefixList1;
+    xmlChar* prefixList2;
+    int res;
+
+    xmlSecAssert2(transform1 != NULL, 0);
+    xmlSecAssert2(transform2 != NULL, 0);
+
+    /* transforms created from the URI or by the application */
+    if((transform1->hereNode == NULL) || (transform2->hereNode == NULL)) {
+        return(((transform1->hereNode == NULL) && (transform2->hereNode == NULL)) ? 1 : 0);
+    }
+    cur1 = xmlSecGetNextElementNode(transform1->hereNode->children);
+    cur2 = xmlSecGetNextElementNode(transform2->hereNode->children);
+    if((cur1 == NULL) && (cur2 == NULL)) {
+        return(1);
+    }
+
+    /* the only parameters we compare: exc-c14n InclusiveNamespaces PrefixList,
+     * anything else (e.g. XPath expressions using here()) might depend on the node */
+    if((cur1 == NULL) || (cur2 == NULL) ||
+       (xmlSecGetNextElementNode(cur1->next) != NULL) ||
+       (xmlSecGetNextElementNode(cur2->next) != NULL) ||
+       (!xmlSecTransformCheckId(transform1, xmlSecTransformExclC14NId) &&
+        !xmlSecTransformCheckId(transform1, xmlSecTransformExclC14NWithCommentsId)) ||
+       !xmlSecCheckNodeName(cur1, xmlSecNodeInclusiveNamespaces, xmlSecNsExcC14N) ||
+       !xmlSecCheckNodeName(cur2, xmlSecNodeInclusiveNamespaces, xmlSecNsExcC14N)) {
+        return(0);
+    }
+    prefixList1 = xmlGetProp(cur1, xmlSecAttrPrefixList);
+    prefixList2 = xmlGetProp(cur2, xmlSecAttrPrefixList);
+    res = xmlStrEqual(prefixList1, prefixList2);
+    if(prefixList1 != NULL) {
+        xmlFree(prefixList1);
+    }
+    if(prefixList2 != NULL) {
+        xmlFree(prefixList2);
+    }
+    return(res);
+}
+
+/* checks if the <dsig:Reference/> transforms (including the digest method) are the same */
+static int
+xmlSecDSigReferenceCtxHasSameTransforms(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlSecDSigReferenceCtxPtr other) {
+    xmlSecTransformPtr cur1, cur2;
+
+    xmlSecAssert2(dsigRefCtx != NULL, 0);
+    xmlSecAssert2(other != NULL, 0);
+
+    if(!xmlStrEqual(dsigRefCtx->uri, other->uri)) {
+        return(0);
+    }
+    for(cur1 = dsigRefCtx->transformCtx.first, cur2 = other->transformCtx.first;
+            (cur1 != NULL) && (cur2 != NULL) && (cur1 != dsigRefCtx->digestMethod) && (cur2 != other->digestMethod);
+            cur1 = cur1->next, cur2 = cur2->next) {
+        if(cur1->id != cur2->id) {
+            return(0);
+        }
+        /* the "#id" XPointer transform is created from the (same) URI */
+        if((cur1 == dsigRefCtx->transformCtx.first) && xmlSecTransformCheckId(cur1, xmlSecTransformXPointerId) &&
+           (dsigRefCtx->uri != NULL) && (dsigRefCtx->uri[0] == '#') && (xmlStrchr(dsigRefCtx->uri, '(') == NULL)) {
+            continue;
+        }
+        if(xmlSecDSigTransformNodesHaveSameParams(cur1, cur2) != 1) {
+            return(0);
+        }
+    }
+    return(((cur1 == dsigRefCtx->digestMethod) && (cur2 == other->digestMethod) &&
+            (cur1 != NULL) && (cur2 != NULL) && (cur1->id == cur2->id)) ? 1 : 0);
+}
+
+/*
+ * Finds a previously processed <dsig:Reference/> in the same list that digested
+ * the same data with the same digest method: same URI and the same transforms.
+ * Returns NULL if there is none (or the digest has to be calculated anyway).
+ */
+static xmlSecDSigReferenceCtxPtr
+xmlSecDSigReferenceCtxFindSameData(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodePtr node) {
+    xmlSecDSigReferenceCtxPtr other;
+    xmlSecPtrListPtr refs;
+    xmlNodePtr targetNode;
+    xmlNodePtr signatureNode;
+    xmlSecTransformPtr transform;
+    int hasEnveloped = 0;
+    xmlSecSize ii, size;
+
+    xmlSecAssert2(dsigRefCtx != NULL, NULL);
+    xmlSecAssert2(dsigRefCtx->dsigCtx != NULL, NULL);
+    xmlSecAssert2(dsigRefCtx->digestMethod != NULL, NULL);
+    xmlSecAssert2(node != NULL, NULL);
+
+    /* the data is provided by the application or has to be stored */
+    if((dsigRefCtx->uri == NULL) || (dsigRefCtx->preDigestMemBufMethod != NULL) ||
+       (dsigRefCtx->digestMethod->id->copyState == NULL)) {
+        return(NULL);
+    }
+
+    /* when signing, the digests written so far change the <dsig:Signature/> node:
+     * only share data that doesn't include it */
+    if(dsigRefCtx->dsigCtx->operation == xmlSecTransformOperationSign) {
+        targetNode = xmlSecDSigReferenceCtxGetTargetNode(dsigRefCtx, node->doc);
+        signatureNode = xmlSecFindParent(node, xmlSecNodeSignature, xmlSecDSigNs);
+        if((targetNode == NULL) && (dsigRefCtx->uri[0] == '#')) {
+            /* complex XPointer */
+            return(NULL);
+        }
+        if((targetNode != NULL) && (signatureNode != NULL)) {
+            for(transform = dsigRefCtx->transformCtx.first; transform != NULL; transform = transform->next) {
+                if(xmlSecTransformCheckId(transform, xmlSecTransformEnvelopedId)) {
+                    hasEnveloped = 1;
+                }
+            }
+            if(xmlSecDSigIsNodeInSubtree(signatureNode, targetNode) == 1) {
+                return(NULL);
+            }
+            if((hasEnveloped == 0) && (xmlSecDSigIsNodeInSubtree(targetNode, signatureNode) == 1)) {
+                return(NULL);
+            }
+        }
+    }
+
+    refs = (dsigRefCtx->origin == xmlSecDSigReferenceOriginSignedInfo) ?
+            &(dsigRefCtx->dsigCtx->signedInfoReferences) :
+            &(dsigRefCtx->dsigCtx->manifestReferences);
+    size = xmlSecPtrListGetSize(refs);
+    for(ii = 0; ii < size; ++ii) {
+        other = (xmlSecDSigReferenceCtxPtr)xmlSecPtrListGetItem(refs, ii);
+        if(other == dsigRefCtx) {
+            break;
+        }
+        if((other == NULL) || (other->digestMethod == NULL) || (other->preDigestMemBufMethod != NULL)) {
+            continue;
+        }
+        /* the digest was calculated (and not kept from the previous signature) */
+        if((other->digestMethod->status != xmlSecTransformStatusFinished) &&
+           (other->digestMethod->status != xmlSecTransformStatusOk) &&
+           (other->digestMethod->status != xmlSecTransformStatusFail)) {
+            continue;
+        }
+        if(xmlSecDSigReferenceCtxHasSameTransforms(dsigRefCtx, other) == 1) {
+            return(other);
+        }
+    }
+    return(NULL);
+}
+
+/*
+ * Returns 1 if the <dsig:Reference/> digest from the previous signature
+ * is still valid, 0 if it needs to be re-calculated or a negative value
+ * if an error occurs.
+ */
+static int
+xmlSecDSigReferenceCtxCanKeepDigest(xmlSecDSigReferenceCtxPtr dsigRefCtx, xmlNodePtr node,
+                                    xmlNodePtr digestValueNode, xmlNodeSetPtr changedNodes) {
+    xmlSecTransformPtr transform;
+    xmlNodePtr targetNode;
+    xmlNodePtr signatureNode;
+    xmlChar* digestValue;
+    int hasEnveloped = 0;
+    int ii;
+
+    xmlSecAssert2(dsigRefCtx != NULL, -1);
+    xmlSecAssert2(dsigRefCtx->dsigCtx != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+    xmlSecAssert2(node->doc != NULL, -1);
+    xmlSecAssert2(digestValueNode != NULL, -1);
+    xmlSecAssert2(changedNodes != NULL, -1);
+
+    /* only SignedInfo references when signing, manifests are always re-calculated */
+    if((dsigRefCtx->dsigCtx->operation != xmlSecTransformOperationSign) ||
+       (dsigRefCtx->origin != xmlSecDSigReferenceOriginSignedInfo) ||
+       (dsigRefCtx->preDigestMemBufMethod != NULL)) {
+        return(0);
+    }
+
+    /* do we have the previous digest? */
+    digestValue = xmlNodeGetContent(digestValueNode);
+    if(digestValue == NULL) {
+        return(0);
+    } else if(xmlSecIsEmptyString(digestValue) == 1) {
+        xmlFree(digestValue);
+        return(0);
+    }
+    xmlFree(digestValue);
+
+    /* the result of these transforms depends only on the referenced subtree
+     * and its ancestors (the "#id" XPointer transform is created from the URI) */
+    for(transform = dsigRefCtx->transformCtx.first; transform != NULL; transform = transform->next) {
+        if(transform == dsigRefCtx->digestMethod) {
+            continue;
+        } else if(xmlSecTransformCheckId(transform, xmlSecTransformEnvelopedId)) {
+            hasEnveloped = 1;
+        } else if((transform == dsigRefCtx->transformCtx.first) &&
+                  xmlSecTransformCheckId(transform, xmlSecTransformXPointerId) &&
+                  (dsigRefCtx->uri != NULL) && (dsigRefCtx->uri[0] == '#') &&
+                  (xmlStrchr(dsigRefCtx->uri, '(') == NULL)) {
+            continue;
+        } else if(!xmlSecTransformCheckId(transform, xmlSecTransformInclC14NId) &&
+                  !xmlSecTransformCheckId(transform, xmlSecTransformInclC14NWithCommentsId) &&
+                  !xmlSecTransformCheckId(transform, xmlSecTransformInclC14N11Id) &&
+                  !xmlSecTransformCheckId(transform, xmlSecTransformInclC14N11WithCommentsId) &&
+                  !xmlSecTransformCheckId(transform, xmlSecTransformExclC14NId) &&
+                  !xmlSecTransformCheckId(transform, xmlSecTransformExclC14NWithCommentsId) &&
+                  !xmlSecTransformCheckId(transform, xmlSecTransformRemoveXmlTagsC14NId) &&
+                  !xmlSecTransformCheckId(transform, xmlSecTransformBase64Id)) {
+            return(0);
+        }
+    }
+
+    /* find the referenced subtree */
+    targetNode = xmlSecDSigReferenceCtxGetTargetNode(dsigRefCtx, node->doc);
+    if(targetNode == NULL) {
+        return(0);
+    }
+
+    /* the Signature node itself is modified by signing */
+    signatureNode = xmlSecFindParent(node, xmlSecNodeSignature, xmlSecDSigNs);
+    if(signatureNode == NULL) {
+        return(0);
+    }
+    if(xmlSecDSigIsNodeInSubtree(signatureNode, targetNode) == 1) {
+        return(0);
+    }
+    if((hasEnveloped == 0) && (xmlSecDSigIsNodeInSubtree(targetNode, signatureNode) == 1)) {
+        return(0);
+    }
+
+    /* changes in the subtree change the data, changes in the ancestors
+     * might change inherited namespaces and xml:* attributes */
+    for(ii = 0; ii < changedNodes->nodeNr; ++ii) {
+        xmlNodePtr cur = changedNodes->nodeTab[ii];
+
+        if(cur == NULL) {
+            continue;
+        }
+        if((xmlSecDSigIsNodeInSubtree(targetNode, cur) == 1) ||
+           (xmlSecDSigIsNodeInSubtree(cur, targetNode) == 1)) {
+            return(0);
+        }
+    }
+
+    /* nothing changed */
+    return(1);
+}
+
+/*
+ * Verifies the &lt;dsig:SignatureValue/&gt; from the previous signature over the
+ * current &lt;dsig:SignedInfo/&gt; with the signing key. Returns 1 if it is valid
+ * (and thus the &lt;dsig:DigestValue/&gt; nodes were calculated by the previous
+ * signing), 0 if it is not (or it is empty) or a negative value if an error occurs.
+ */
+static int
+xmlSecDSigCtxCheckPreviousSignature(xmlSecDSigCtxPtr dsigCtx, xmlNodePtr signedInfoNode) {
+    xmlSecTransformCtx transformCtx;
+    xmlSecTransformPtr c14nMethod;
+    xmlSecTransformPtr signMethod;
+    xmlSecNodeSetPtr nodeset;
+    xmlChar* signValue;
+    xmlNodePtr cur;
+    int res = -1;
+    int ret;
+
+    xmlSecAssert2(dsigCtx != NULL, -1);
+    xmlSecAssert2(dsigCtx->operation == xmlSecTransformOperationSign, -1);
+    xmlSecAssert2(dsigCtx->c14nMethod != NULL, -1);
+    xmlSecAssert2(dsigCtx->signMethod != NULL, -1);
+    xmlSecAssert2(dsigCtx->signKey != NULL, -1);
+    xmlSecAssert2(dsigCtx->signValueNode != NULL, -1);
+    xmlSecAssert2(signedInfoNode != NULL, -1);
+
+    /* do we have the previous signature? */
+    signValue = xmlNodeGetContent(dsigCtx->signValueNode);
+    if(signValue == NULL) {
+        return(0);
+    } else if(xmlSecIsEmptyString(signValue) == 1) {
+        xmlFree(signValue);
+        return(0);
+    }
+    xmlFree(signValue);
+
+    ret = xmlSecTransformCtxInitialize(&transformCtx);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecTransformCtxInitialize", NULL);
+        return(-1);
+    }
+    ret = xmlSecTransformCtxCopyUserPref(&transformCtx, &(dsigCtx->transformCtx));
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecTransformCtxCopyUserPref", NULL);
+        goto done;
+    }
+
+    /* the same c14n and signature methods as in the SignedInfo */
+    cur = xmlSecGetNextElementNode(signedInfoNode->children);
+    if((cur != NULL) && (xmlSecCheckNodeName(cur, xmlSecNodeCanonicalizationMethod, xmlSecDSigNs))) {
+        c14nMethod = xmlSecTransformCtxNodeReadById(&transformCtx, cur, dsigCtx->c14nMethod->id);
+        cur = xmlSecGetNextElementNode(cur->next);
+    } else {
+        c14nMethod = xmlSecTransformCtxCreateAndAppend(&transformCtx, dsigCtx->c14nMethod->id);
+    }
+    if(c14nMethod == NULL) {
+        xmlSecInternalError("xmlSecTransformCtxNodeReadById",
+                            xmlSecTransformGetName(dsigCtx->c14nMethod));
+        goto done;
+    }
+    if((cur == NULL) || (!xmlSecCheckNodeName(cur, xmlSecNodeSignatureMethod, xmlSecDSigNs))) {
+        xmlSecInvalidNodeError(cur, xmlSecNodeSignatureMethod, NULL);
+        goto done;
+    }
+
+    signMethod = xmlSecTransformCtxNodeReadById(&transformCtx, cur, dsigCtx->signMethod->id);
+    if(signMethod == NULL) {
+        xmlSecInternalError("xmlSecTransformCtxNodeReadById",
+                            xmlSecTransformGetName(dsigCtx->signMethod));
+        goto done;
+    }
+    signMethod->operation = xmlSecTransformOperationVerify;
+
+    ret = xmlSecTransformSetKey(signMethod, dsigCtx->signKey);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecTransformSetKey",
+                            xmlSecTransformGetName(signMethod));
+        goto done;
+    }
+
+    nodeset = xmlSecNodeSetGetChildren(signedInfoNode->doc, signedInfoNode, 1, 0);
+    if(nodeset == NULL) {
+        xmlSecInternalError("xmlSecNodeSetGetChildren(signedInfoNode)", NULL);
+        goto done;
+    }
+    ret = xmlSecTransformCtxXmlExecute(&transformCtx, nodeset);
+    xmlSecNodeSetDestroy(nodeset);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecTransformCtxXmlExecute", NULL);
+        goto done;
+    }
+
+    ret = xmlSecTransformVerifyNodeContent(signMethod, dsigCtx->signValueNode, &transformCtx);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecTransformVerifyNodeContent", NULL);
+        goto done;
+    }
+
+    /* success */
+    res = (signMethod->status == xmlSecTransformStatusOk) ? 1 : 0;
+
+done:
+    xmlSecTransformCtxFinalize(&transformCtx);
+    return(res);
+}
+
 /**
  * xmlSecDSigReferenceCtxDebugDump:
  * @dsigRefCtx:         the pointer to &lt;dsig:Reference/&gt; element processing context.
@@ -1666,4 +2266,518 @@ xmlSecDSigReferenceCtxListGetKlass(void) {
     return(&xmlSecDSigReferenceCtxListKlass);
 }
 
+/**************************************************************************
+ *
+ * xmlSecDSigSignProfile
+ *
+ *************************************************************************/
+static xmlSecDSigSignProfileReferencePtr
+xmlSecDSigSignProfileReferenceCreate(void) {
+    xmlSecDSigSignProfileReferencePtr profileRef;
+    int ret;
+
+    profileRef = (xmlSecDSigSignProfileReferencePtr) xmlMalloc(sizeof(xmlSecDSigSignProfileReference));
+    if(profileRef == NULL) {
+        xmlSecMallocError(sizeof(xmlSecDSigSignProfileReference), NULL);
+        return(NULL);
+    }
+    memset(profileRef, 0, sizeof(xmlSecDSigSignProfileReference));
+
+    ret = xmlSecPtrListInitialize(&(profileRef->transforms), xmlSecTransformIdListId);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInitialize(xmlSecTransformIdListId)", NULL);
+        xmlFree(profileRef);
+        return(NULL);
+    }
+    return(profileRef);
+}
+
+static void
+xmlSecDSigSignProfileReferenceDestroy(xmlSecDSigSignProfileReferencePtr profileRef) {
+    xmlSecAssert(profileRef != NULL);
+
+    xmlSecPtrListFinalize(&(profileRef->transforms));
+    memset(profileRef, 0, sizeof(xmlSecDSigSignProfileReference));
+    xmlFree(profileRef);
+}
+
+static xmlSecPtrListKlass xmlSecDSigSignProfileReferenceListKlass = {
+    BAD_CAST "dsig-sign-profile-reference-list",
+    NULL,                                                                   /* xmlSecPtrDuplicateItemMethod duplicateItem; */
+    (xmlSecPtrDestroyItemMethod)xmlSecDSigSignProfileReferenceDestroy,      /* xmlSecPtrDestroyItemMethod destroyItem; */
+    NULL,                                                                   /* xmlSecPtrDebugDumpItemMethod debugDumpItem; */
+    NULL,                                                                   /* xmlSecPtrDebugDumpItemMethod debugXmlDumpItem; */
+};
+
+/* reads the Algorithm attribute of the @node and finds the matching transform */
+static xmlSecTransformId
+xmlSecDSigSignProfileReadAlgorithm(xmlNodePtr node, xmlSecTransformUsage usage) {
+    xmlSecTransformId id;
+    xmlChar *href;
+
+    xmlSecAssert2(node != NULL, xmlSecTransformIdUnknown);
+
+    href = xmlGetProp(node, xmlSecAttrAlgorithm);
+    if(href == NULL) {
+        xmlSecInvalidNodeAttributeError(node, xmlSecAttrAlgorithm, NULL, "empty");
+        return(xmlSecTransformIdUnknown);
+    }
+
+    id = xmlSecTransformIdListFindByHref(xmlSecTransformIdsGet(), href, usage);
+    if(id == xmlSecTransformIdUnknown) {
+        xmlSecInternalError2("xmlSecTransformIdListFindByHref", NULL,
+                             "href=%s", xmlSecErrorsSafeString(href));
+        xmlFree(href);
+        return(xmlSecTransformIdUnknown);
+    }
+
+    xmlFree(href);
+    return(id);
+}
+
+static int
+xmlSecDSigSignProfileReadReference(xmlSecDSigSignProfilePtr profile, xmlNodePtr node) {
+    xmlSecDSigSignProfileReferencePtr profileRef;
+    xmlSecTransformId id;
+    xmlNodePtr cur, transformNode;
+    int ret;
+
+    xmlSecAssert2(profile != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    profileRef = xmlSecDSigSignProfileReferenceCreate();
+    if(profileRef == NULL) {
+        xmlSecInternalError("xmlSecDSigSignProfileReferenceCreate", NULL);
+        return(-1);
+    }
+    ret = xmlSecPtrListAdd(&(profile->references), profileRef);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListAdd", NULL);
+        xmlSecDSigSignProfileReferenceDestroy(profileRef);
+        return(-1);
+    }
+
+    /* first is optional Transforms node */
+    cur  = xmlSecGetNextElementNode(node->children);
+    if((cur != NULL) && (xmlSecCheckNodeName(cur, xmlSecNodeTransforms, xmlSecDSigNs))) {
+        transformNode = xmlSecGetNextElementNode(cur->children);
+        while((transformNode != NULL) && xmlSecCheckNodeName(transformNode, xmlSecNodeTransform, xmlSecDSigNs)) {
+            id = xmlSecDSigSignProfileReadAlgorithm(transformNode, xmlSecTransformUsageDSigTransform);
+            if(id == xmlSecTransformIdUnknown) {
+                xmlSecInternalError("xmlSecDSigSignProfileReadAlgorithm", NULL);
+                return(-1);
+            }
+            ret = xmlSecPtrListAdd(&(profileRef->transforms), (void*)id);
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecPtrListAdd", xmlSecTransformKlassGetName(id));
+                return(-1);
+            }
+            transformNode = xmlSecGetNextElementNode(transformNode->next);
+        }
+        if(transformNode != NULL) {
+            xmlSecUnexpectedNodeError(transformNode, NULL);
+            return(-1);
+        }
+        cur = xmlSecGetNextElementNode(cur->next);
+    }
+
+    /* next node is required DigestMethod */
+    if((cur == NULL) || (!xmlSecCheckNodeName(cur, xmlSecNodeDigestMethod, xmlSecDSigNs))) {
+        xmlSecInvalidNodeError(cur, xmlSecNodeDigestMethod, NULL);
+        return(-1);
+    }
+    profileRef->digestMethodId = xmlSecDSigSignProfileReadAlgorithm(cur, xmlSecTransformUsageDigestMethod);
+    if(profileRef->digestMethodId == xmlSecTransformIdUnknown) {
+        xmlSecInternalError("xmlSecDSigSignProfileReadAlgorithm", NULL);
+        return(-1);
+    }
+
+    return(0);
+}
+
+/**
+ * xmlSecDSigSignProfileCreate:
+ * @tmpl:               the pointer to &lt;dsig:Signature/&gt; node with signature template.
+ *
+ * Creates the signing profile: the @tmpl is copied and parsed once,
+ * the canonicalization, signature, digest and reference transforms
+ * algorithms are resolved and stored in the profile. The profile is not
+ * changed after creation and can be used to sign any number of documents
+ * (including from multiple threads) with #xmlSecDSigSignProfileInstantiate
+ * and #xmlSecDSigCtxSignWithProfile functions, or to verify the signatures
+ * of the same shape with #xmlSecDSigCtxVerifyWithProfile function (in this
+ * case @tmpl can also be a signed sample message). The caller is responsible
+ * for destroying the profile with #xmlSecDSigSignProfileDestroy function.
+ *
+ * Returns: pointer to newly allocated profile or NULL if an error occurs.
+ */
+xmlSecDSigSignProfilePtr
+xmlSecDSigSignProfileCreate(xmlNodePtr tmpl) {
+    xmlSecDSigSignProfilePtr profile;
+    xmlNodePtr signedInfoNode;
+    xmlNodePtr root;
+    xmlNodePtr cur;
+    int ret;
+
+    xmlSecAssert2(tmpl != NULL, NULL);
+
+    if(!xmlSecCheckNodeName(tmpl, xmlSecNodeSignature, xmlSecDSigNs)) {
+        xmlSecInvalidNodeError(tmpl, xmlSecNodeSignature, NULL);
+        return(NULL);
+    }
+
+    profile = (xmlSecDSigSignProfilePtr) xmlMalloc(sizeof(xmlSecDSigSignProfile));
+    if(profile == NULL) {
+        xmlSecMallocError(sizeof(xmlSecDSigSignProfile), NULL);
+        return(NULL);
+    }
+    memset(profile, 0, sizeof(xmlSecDSigSignProfile));
+
+    ret = xmlSecPtrListInitialize(&(profile->references), &xmlSecDSigSignProfileReferenceListKlass);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInitialize", NULL);
+        xmlFree(profile);
+        return(NULL);
+    }
+
+    /* copy the template */
+    profile->doc = xmlNewDoc(BAD_CAST "1.0");
+    if(profile->doc == NULL) {
+        xmlSecXmlError("xmlNewDoc", NULL);
+        xmlSecDSigSignProfileDestroy(profile);
+        return(NULL);
+    }
+    root = xmlDocCopyNode(tmpl, profile->doc, 1);
+    if(root == NULL) {
+        xmlSecXmlError("xmlDocCopyNode", NULL);
+        xmlSecDSigSignProfileDestroy(profile);
+        return(NULL);
+    }
+    xmlDocSetRootElement(profile->doc, root);
+
+    /* first node is required SignedInfo */
+    signedInfoNode = xmlSecGetNextElementNode(root->children);
+    if((signedInfoNode == NULL) || (!xmlSecCheckNodeName(signedInfoNode, xmlSecNodeSignedInfo, xmlSecDSigNs))) {
+        xmlSecInvalidNodeError(signedInfoNode, xmlSecNodeSignedInfo, NULL);
+        xmlSecDSigSignProfileDestroy(profile);
+        return(NULL);
+    }
+
+    /* required CanonicalizationMethod and SignatureMethod nodes */
+    cur = xmlSecGetNextElementNode(signedInfoNode->children);
+    if((cur == NULL) || (!xmlSecCheckNodeName(cur, xmlSecNodeCanonicalizationMethod, xmlSecDSigNs))) {
+        xmlSecInvalidNodeError(cur, xmlSecNodeCanonicalizationMethod, NULL);
+        xmlSecDSigSignProfileDestroy(profile);
+        return(NULL);
+    }
+    profile->c14nMethodId = xmlSecDSigSignProfileReadAlgorithm(cur, xmlSecTransformUsageC14NMethod);
+    if(profile->c14nMethodId == xmlSecTransformIdUnknown) {
+        xmlSecInternalError("xmlSecDSigSignProfileReadAlgorithm", NULL);
+        xmlSecDSigSignProfileDestroy(profile);
+        return(NULL);
+    }
+
+    cur = xmlSecGetNextElementNode(cur->next);
+    if((cur == NULL) || (!xmlSecCheckNodeName(cur, xmlSecNodeSignatureMethod, xmlSecDSigNs))) {
+        xmlSecInvalidNodeError(cur, xmlSecNodeSignatureMethod, NULL);
+        xmlSecDSigSignProfileDestroy(profile);
+        return(NULL);
+    }
+    profile->signMethodId = xmlSecDSigSignProfileReadAlgorithm(cur, xmlSecTransformUsageSignatureMethod);
+    if(profile->signMethodId == xmlSecTransformIdUnknown) {
+        xmlSecInternalError("xmlSecDSigSignProfileReadAlgorithm", NULL);
+        xmlSecDSigSignProfileDestroy(profile);
+        return(NULL);
+    }
+
+    /* References */
+    cur = xmlSecGetNextElementNode(cur->next);
+    while((cur != NULL) && (xmlSecCheckNodeName(cur, xmlSecNodeReference, xmlSecDSigNs))) {
+        ret = xmlSecDSigSignProfileReadReference(profile, cur);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecDSigSignProfileReadReference", NULL);
+            xmlSecDSigSignProfileDestroy(profile);
+            return(NULL);
+        }
+        cur = xmlSecGetNextElementNode(cur->next);
+    }
+    if(cur != NULL) {
+        xmlSecUnexpectedNodeError(cur, NULL);
+        xmlSecDSigSignProfileDestroy(profile);
+        return(NULL);
+    }
+
+    return(profile);
+}
+
+/**
+ * xmlSecDSigSignProfileDestroy:
+ * @profile:            the pointer to signing profile.
+ *
+ * Destroys the signing profile created with #xmlSecDSigSignProfileCreate
+ * function.
+ */
+void
+xmlSecDSigSignProfileDestroy(xmlSecDSigSignProfilePtr profile) {
+    xmlSecAssert(profile != NULL);
+
+    xmlSecPtrListFinalize(&(profile->references));
+    if(profile->doc != NULL) {
+        xmlFreeDoc(profile->doc);
+    }
+    memset(profile, 0, sizeof(xmlSecDSigSignProfile));
+    xmlFree(profile);
+}
+
+/**
+ * xmlSecDSigSignProfileInstantiate:
+ * @profile:            the pointer to signing profile.
+ * @parent:             the pointer to the parent node for the new signature.
+ *
+ * Adds a copy of the profile's &lt;dsig:Signature/&gt; template as the last
+ * child of the @parent node. The returned node should be signed
+ * with #xmlSecDSigCtxSignWithProfile function.
+ *
+ * Returns: pointer to the new &lt;dsig:Signature/&gt; node or NULL if an error occurs.
+ */
+xmlNodePtr
+xmlSecDSigSignProfileInstantiate(xmlSecDSigSignProfilePtr profile, xmlNodePtr parent) {
+    xmlNodePtr root;
+    xmlNodePtr node;
+
+    xmlSecAssert2(profile != NULL, NULL);
+    xmlSecAssert2(profile->doc != NULL, NULL);
+    xmlSecAssert2(parent != NULL, NULL);
+    xmlSecAssert2(parent->doc != NULL, NULL);
+
+    root = xmlDocGetRootElement(profile->doc);
+    xmlSecAssert2(root != NULL, NULL);
+
+    node = xmlDocCopyNode(root, parent->doc, 1);
+    if(node == NULL) {
+        xmlSecXmlError("xmlDocCopyNode", NULL);
+        return(NULL);
+    }
+    if(xmlAddChild(parent, node) == NULL) {
+        xmlSecXmlError("xmlAddChild", NULL);
+        xmlFreeNode(node);
+        return(NULL);
+    }
+    return(node);
+}
+
+/**
+ * xmlSecDSigCtxSignWithProfile:
+ * @dsigCtx:            the pointer to &lt;dsig:Signature/&gt; processing context.
+ * @profile:            the pointer to signing profile.
+ * @tmpl:               the pointer to &lt;dsig:Signature/&gt; node created with
+ *                      #xmlSecDSigSignProfileInstantiate function.
+ *
+ * Signs the data as described in @tmpl node using the algorithms resolved
+ * in the @profile: same as #xmlSecDSigCtxSign but without looking up the
+ * transforms by the Algorithm attributes. If the @tmpl node does not have
+ * exactly the same shape as the @profile (the same algorithms for
+ * canonicalization, signature, each reference transform and digest) then
+ * the @tmpl is processed the same way as in #xmlSecDSigCtxSign function.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecDSigCtxSignWithProfile(xmlSecDSigCtxPtr dsigCtx, xmlSecDSigSignProfilePtr profile, xmlNodePtr tmpl) {
+    int ret;
+
+    xmlSecAssert2(profile != NULL, -1);
+    xmlSecAssert2(tmpl != NULL, -1);
+
+    ret = xmlSecDSigSignProfileMatch(profile, tmpl);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecDSigSignProfileMatch", NULL);
+        return(-1);
+    }
+    return(xmlSecDSigCtxSignImpl(dsigCtx, tmpl, NULL, (ret == 1) ? profile : NULL));
+}
+
+/**
+ * xmlSecDSigCtxVerifyWithProfile:
+ * @dsigCtx:            the pointer to &lt;dsig:Signature/&gt; processing context.
+ * @profile:            the pointer to signing profile.
+ * @node:               the pointer with &lt;dsig:Signature/&gt; node.
+ *
+ * Validates signature in the @node. If the &lt;dsig:SignedInfo/&gt; in the @node
+ * has exactly the same shape as the @profile (the same algorithms for
+ * canonicalization, signature, each reference transform and digest) then
+ * the transforms are created directly from the @profile without looking up
+ * the Algorithm attributes in the list of all known transforms. Otherwise,
+ * the @node is processed the same way as in #xmlSecDSigCtxVerify function.
+ * In both cases the result is the same as with #xmlSecDSigCtxVerify
+ * (including the enabled transforms checks).
+ *
+ * Returns: 0 on success (check #status member of @dsigCtx to get
+ * signature verification result) or a negative value if an error occurs.
+ */
+int
+xmlSecDSigCtxVerifyWithProfile(xmlSecDSigCtxPtr dsigCtx, xmlSecDSigSignProfilePtr profile, xmlNodePtr node) {
+    int ret;
+
+    xmlSecAssert2(profile != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    ret = xmlSecDSigSignProfileMatch(profile, node);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecDSigSignProfileMatch", NULL);
+        return(-1);
+    }
+    return(xmlSecDSigCtxVerifyImpl(dsigCtx, node, (ret == 1) ? profile : NULL));
+}
+
+/* returns 1 if the Algorithm attribute of the @node is the @id href, 0 otherwise */
+static int
+xmlSecDSigSignProfileMatchAlgorithm(xmlNodePtr node, xmlSecTransformId id) {
+    xmlChar *href;
+    int res;
+
+    xmlSecAssert2(node != NULL, -1);
+    xmlSecAssert2(id != xmlSecTransformIdUnknown, -1);
+
+    href = xmlGetProp(node, xmlSecAttrAlgorithm);
+    if(href == NULL) {
+        return(0);
+    }
+    res = xmlStrEqual(href, id->href);
+    xmlFree(href);
+    return(res);
+}
+
+/*
+ * Checks that the &lt;dsig:SignedInfo/&gt; in the &lt;dsig:Signature/&gt; @node
+ * has exactly the same shape as the @profile: returns 1 if it does, 0 if it
+ * does not or a negative value if an error occurs.
+ */
+static int
+xmlSecDSigSignProfileMatch(xmlSecDSigSignProfilePtr profile, xmlNodePtr node) {
+    xmlSecDSigSignProfileReferencePtr profileRef;
+    xmlSecTransformId id;
+    xmlSecSize pos, transformsPos, transformsSize;
+    xmlSecSize size;
+    xmlNodePtr cur, refNode, transformNode;
+
+    xmlSecAssert2(profile != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    if(!xmlSecCheckNodeName(node, xmlSecNodeSignature, xmlSecDSigNs)) {
+        return(0);
+    }
+
+    cur = xmlSecGetNextElementNode(node->children);
+    if((cur == NULL) || (!xmlSecCheckNodeName(cur, xmlSecNodeSignedInfo, xmlSecDSigNs))) {
+        return(0);
+    }
+
+    cur = xmlSecGetNextElementNode(cur->children);
+    if((cur == NULL) || (!xmlSecCheckNodeName(cur, xmlSecNodeCanonicalizationMethod, xmlSecDSigNs)) ||
+       (xmlSecDSigSignProfileMatchAlgorithm(cur, profile->c14nMethodId) != 1)) {
+        return(0);
+    }
+
+    cur = xmlSecGetNextElementNode(cur->next);
+    if((cur == NULL) || (!xmlSecCheckNodeName(cur, xmlSecNodeSignatureMethod, xmlSecDSigNs)) ||
+       (xmlSecDSigSignProfileMatchAlgorithm(cur, profile->signMethodId) != 1)) {
+        return(0);
+    }
+
+    size = xmlSecPtrListGetSize(&(profile->references));
+    for(pos = 0, cur = xmlSecGetNextElementNode(cur->next); pos < size; ++pos, cur = xmlSecGetNextElementNode(cur->next)) {
+        if((cur == NULL) || (!xmlSecCheckNodeName(cur, xmlSecNodeReference, xmlSecDSigNs))) {
+            return(0);
+        }
+        profileRef = (xmlSecDSigSignProfileReferencePtr)xmlSecPtrListGetItem(&(profile->references), pos);
+        xmlSecAssert2(profileRef != NULL, -1);
+
+        refNode = xmlSecGetNextElementNode(cur->children);
+        transformsPos = 0;
+        transformsSize = xmlSecPtrListGetSize(&(profileRef->transforms));
+        if((refNode != NULL) && (xmlSecCheckNodeName(refNode, xmlSecNodeTransforms, xmlSecDSigNs))) {
+            transformNode = xmlSecGetNextElementNode(refNode->children);
+            while(transformNode != NULL) {
+                if((transformsPos >= transformsSize) ||
+                   (!xmlSecCheckNodeName(transformNode, xmlSecNodeTransform, xmlSecDSigNs))) {
+                    return(0);
+                }
+                id = (xmlSecTransformId)xmlSecPtrListGetItem(&(profileRef->transforms), transformsPos);
+                xmlSecAssert2(id != xmlSecTransformIdUnknown, -1);
+                if(xmlSecDSigSignProfileMatchAlgorithm(transformNode, id) != 1) {
+                    return(0);
+                }
+                ++transformsPos;
+                transformNode = xmlSecGetNextElementNode(transformNode->next);
+            }
+            refNode = xmlSecGetNextElementNode(refNode->next);
+        }
+        if(transformsPos != transformsSize) {
+            return(0);
+        }
+
+        if((refNode == NULL) || (!xmlSecCheckNodeName(refNode, xmlSecNodeDigestMethod, xmlSecDSigNs)) ||
+           (xmlSecDSigSignProfileMatchAlgorithm(refNode, profileRef->digestMethodId) != 1)) {
+            return(0);
+        }
+    }
+
+    /* no more references */
+    if(cur != NULL) {
+        return(0);
+    }
+    return(1);
+}
+
+static int
+xmlSecDSigSignProfileReferenceReadTransforms(xmlSecDSigSignProfileReferencePtr profileRef,
+                                             xmlSecTransformCtxPtr transformCtx,
+                                             xmlNodePtr node) {
+    xmlSecTransformPtr transform;
+    xmlSecTransformId id;
+    xmlSecSize pos = 0;
+    xmlNodePtr cur;
+
+    xmlSecAssert2(profileRef != NULL, -1);
+    xmlSecAssert2(transformCtx != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    cur = xmlSecGetNextElementNode(node->children);
+    while((cur != NULL) && xmlSecCheckNodeName(cur, xmlSecNodeTransform, xmlSecDSigNs)) {
+        if(pos >= xmlSecPtrListGetSize(&(profileRef->transforms))) {
+            xmlSecOtherError2(XMLSEC_ERRORS_R_INVALID_DATA, NULL,
+                "too many transforms for the profile, pos=" XMLSEC_SIZE_FMT, pos);
+            return(-1);
+        }
+        id = (xmlSecTransformId)xmlSecPtrListGetItem(&(profileRef->transforms), pos);
+        xmlSecAssert2(id != xmlSecTransformIdUnknown, -1);
+        if(xmlSecDSigSignProfileMatchAlgorithm(cur, id) != 1) {
+            xmlSecInvalidNodeAttributeError(cur, xmlSecAttrAlgorithm,
+                xmlSecTransformKlassGetName(id), "does not match the profile");
+            return(-1);
+        }
+        ++pos;
+
+        transform = xmlSecTransformCtxNodeReadById(transformCtx, cur, id);
+        if(transform == NULL) {
+            xmlSecInternalError("xmlSecTransformCtxNodeReadById",
+                                xmlSecTransformKlassGetName(id));
+            return(-1);
+        }
+        cur = xmlSecGetNextElementNode(cur->next);
+    }
+
+    if(cur != NULL) {
+        xmlSecUnexpectedNodeError(cur, NULL);
+        return(-1);
+    }
+    if(pos != xmlSecPtrListGetSize(&(profileRef->transforms))) {
+        xmlSecOtherError2(XMLSEC_ERRORS_R_INVALID_DATA, NULL,
+            "not enough transforms for the profile, size=" XMLSEC_SIZE_FMT, pos);
+        return(-1);
+    }
+    return(0);
+}
+
 #endif /* XMLSEC_NO_XMLDSIG */
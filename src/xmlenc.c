@@ -32,11 +32,14 @@
 #include <xmlsec/keys.h>
 #include <xmlsec/keysmngr.h>
 #include <xmlsec/transforms.h>
+#include <xmlsec/membuf.h>
 #include <xmlsec/keyinfo.h>
+#include <xmlsec/parser.h>
 #include <xmlsec/xmlenc.h>
 #include <xmlsec/errors.h>
 
 #include "cast_helpers.h"
+#include "parallel_helpers.h"
 
 static int      xmlSecEncCtxEncDataNodeRead             (xmlSecEncCtxPtr encCtx,
                                                          xmlNodePtr node);
@@ -45,6 +48,9 @@ static int      xmlSecEncCtxCipherDataNodeRead          (xmlSecEncCtxPtr encCtx,
                                                          xmlNodePtr node);
 static int      xmlSecEncCtxCipherReferenceNodeRead     (xmlSecEncCtxPtr encCtx,
                                                          xmlNodePtr node);
+static int      xmlSecEncCtxDecryptExecute              (xmlSecEncCtxPtr encCtx,
+                                                         xmlNodePtr node,
+                                                         xmlOutputBufferPtr output);
 
 static void     xmlSecEncCtxMarkAsFailed                (xmlSecEncCtxPtr encCtx,
                                                          xmlSecEncFailureReason failureReason);
@@ -330,38 +336,15 @@ xmlSecEncCtxBinaryEncrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl,
     return(0);
 }
 
-/**
- * xmlSecEncCtxXmlEncrypt:
- * @encCtx:             the pointer to &lt;enc:EncryptedData/&gt; processing context.
- * @tmpl:               the pointer to &lt;enc:EncryptedData/&gt; template node.
- * @node:               the pointer to node for encryption.
- *
- * Encrypts @node according to template @tmpl. If requested, @node is replaced
- * with result &lt;enc:EncryptedData/&gt; node.
- *
- * Returns: 0 on success or a negative value if an error occurs.
- */
-int
-xmlSecEncCtxXmlEncrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl, xmlNodePtr node) {
+/* serializes and encrypts @node (or its content), the result is in encCtx->result */
+static int
+xmlSecEncCtxXmlEncryptNodeData(xmlSecEncCtxPtr encCtx, xmlNodePtr node) {
     xmlOutputBufferPtr output;
     int ret;
 
     xmlSecAssert2(encCtx != NULL, -1);
     xmlSecAssert2(encCtx->result == NULL, -1);
-    xmlSecAssert2(tmpl != NULL, -1);
     xmlSecAssert2(node != NULL, -1);
-    xmlSecAssert2(node->doc != NULL, -1);
-
-    /* initialize context and add ID atributes to the list of known ids */
-    encCtx->operation = xmlSecTransformOperationEncrypt;
-    xmlSecAddIDs(tmpl->doc, tmpl, xmlSecEncIds);
-
-    /* read the template and set encryption method, key, etc. */
-    ret = xmlSecEncCtxEncDataNodeRead(encCtx, tmpl);
-    if(ret < 0) {
-        xmlSecInternalError("xmlSecEncCtxEncDataNodeRead", NULL);
-        return(-1);
-    }
 
     ret = xmlSecTransformCtxPrepare(&(encCtx->transformCtx), xmlSecTransformDataTypeBin);
     if(ret < 0) {
@@ -406,90 +389,88 @@ xmlSecEncCtxXmlEncrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl, xmlNodePtr node)
     encCtx->result = encCtx->transformCtx.result;
     xmlSecAssert2(encCtx->result != NULL, -1);
 
-    ret = xmlSecEncCtxEncDataNodeWrite(encCtx);
-    if(ret < 0) {
-        xmlSecInternalError("xmlSecEncCtxEncDataNodeWrite", NULL);
-        return(-1);
-    }
+    return(0);
+}
+
+/* replaces @node (or its content) with @encDataNode, the replaced nodes are returned in @replaced if not NULL */
+static int
+xmlSecEncCtxXmlEncryptReplaceNode(xmlSecEncCtxPtr encCtx, xmlNodePtr node, xmlNodePtr encDataNode,
+                                  xmlNodePtr* replaced) {
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+    xmlSecAssert2(encDataNode != NULL, -1);
 
-    /* now we need to update our original document */
     if((encCtx->type != NULL) && xmlStrEqual(encCtx->type, xmlSecTypeEncElement)) {
         /* check if we need to return the replaced node */
-        if((encCtx->flags & XMLSEC_ENC_RETURN_REPLACED_NODE) != 0) {
-            ret = xmlSecReplaceNodeAndReturn(node, tmpl, &(encCtx->replacedNodeList));
+        if(replaced != NULL) {
+            ret = xmlSecReplaceNodeAndReturn(node, encDataNode, replaced);
             if(ret < 0) {
                 xmlSecInternalError("xmlSecReplaceNodeAndReturn",
                                     xmlSecNodeGetName(node));
                 return(-1);
             }
         } else {
-            ret = xmlSecReplaceNode(node, tmpl);
+            ret = xmlSecReplaceNode(node, encDataNode);
             if(ret < 0) {
                 xmlSecInternalError("xmlSecReplaceNode",
                                     xmlSecNodeGetName(node));
                 return(-1);
             }
         }
-        encCtx->resultReplaced = 1;
     } else if((encCtx->type != NULL) && xmlStrEqual(encCtx->type, xmlSecTypeEncContent)) {
         /* check if we need to return the replaced node */
-        if((encCtx->flags & XMLSEC_ENC_RETURN_REPLACED_NODE) != 0) {
-            ret = xmlSecReplaceContentAndReturn(node, tmpl, &(encCtx->replacedNodeList));
+        if(replaced != NULL) {
+            ret = xmlSecReplaceContentAndReturn(node, encDataNode, replaced);
             if(ret < 0) {
                 xmlSecInternalError("xmlSecReplaceContentAndReturn",
                                     xmlSecNodeGetName(node));
                 return(-1);
             }
         } else {
-            ret = xmlSecReplaceContent(node, tmpl);
+            ret = xmlSecReplaceContent(node, encDataNode);
             if(ret < 0) {
                 xmlSecInternalError("xmlSecReplaceContent",
                                     xmlSecNodeGetName(node));
                 return(-1);
             }
         }
-        encCtx->resultReplaced = 1;
     } else {
         /* we should've caught this error before */
         xmlSecInvalidStringTypeError("encryption type", encCtx->type,
                 "supported encryption type", NULL);
         return(-1);
     }
-    /* done */
+
     return(0);
 }
 
 /**
- * xmlSecEncCtxUriEncrypt:
+ * xmlSecEncCtxXmlEncrypt:
  * @encCtx:             the pointer to &lt;enc:EncryptedData/&gt; processing context.
  * @tmpl:               the pointer to &lt;enc:EncryptedData/&gt; template node.
- * @uri:                the URI.
+ * @node:               the pointer to node for encryption.
  *
- * Encrypts data from @uri according to template @tmpl.
+ * Encrypts @node according to template @tmpl. If requested, @node is replaced
+ * with result &lt;enc:EncryptedData/&gt; node.
  *
  * Returns: 0 on success or a negative value if an error occurs.
  */
 int
-xmlSecEncCtxUriEncrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl, const xmlChar *uri) {
+xmlSecEncCtxXmlEncrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl, xmlNodePtr node) {
     int ret;
 
     xmlSecAssert2(encCtx != NULL, -1);
     xmlSecAssert2(encCtx->result == NULL, -1);
     xmlSecAssert2(tmpl != NULL, -1);
-    xmlSecAssert2(uri != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+    xmlSecAssert2(node->doc != NULL, -1);
 
     /* initialize context and add ID atributes to the list of known ids */
     encCtx->operation = xmlSecTransformOperationEncrypt;
     xmlSecAddIDs(tmpl->doc, tmpl, xmlSecEncIds);
 
-    /* we need to add input uri transform first */
-    ret = xmlSecTransformCtxSetUri(&(encCtx->transformCtx), uri, tmpl);
-    if(ret < 0) {
-        xmlSecInternalError2("xmlSecTransformCtxSetUri", NULL,
-                             "uri=%s", xmlSecErrorsSafeString(uri));
-        return(-1);
-    }
-
     /* read the template and set encryption method, key, etc. */
     ret = xmlSecEncCtxEncDataNodeRead(encCtx, tmpl);
     if(ret < 0) {
@@ -497,147 +478,643 @@ xmlSecEncCtxUriEncrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl, const xmlChar *u
         return(-1);
     }
 
-    /* encrypt the data */
-    ret = xmlSecTransformCtxExecute(&(encCtx->transformCtx), tmpl->doc);
+    ret = xmlSecEncCtxXmlEncryptNodeData(encCtx, node);
     if(ret < 0) {
-        xmlSecInternalError("xmlSecTransformCtxExecute", NULL);
+        xmlSecInternalError("xmlSecEncCtxXmlEncryptNodeData", NULL);
         return(-1);
     }
 
-    encCtx->result = encCtx->transformCtx.result;
-    xmlSecAssert2(encCtx->result != NULL, -1);
-
     ret = xmlSecEncCtxEncDataNodeWrite(encCtx);
     if(ret < 0) {
         xmlSecInternalError("xmlSecEncCtxEncDataNodeWrite", NULL);
         return(-1);
     }
 
+    /* now we need to update our original document */
+    ret = xmlSecEncCtxXmlEncryptReplaceNode(encCtx, node, tmpl,
+        ((encCtx->flags & XMLSEC_ENC_RETURN_REPLACED_NODE) != 0) ? &(encCtx->replacedNodeList) : NULL);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxXmlEncryptReplaceNode", NULL);
+        return(-1);
+    }
+    encCtx->resultReplaced = 1;
+
+    /* done */
     return(0);
 }
 
-/**
- * xmlSecEncCtxDecrypt:
- * @encCtx:             the pointer to &lt;enc:EncryptedData/&gt; processing context.
- * @node:               the pointer to &lt;enc:EncryptedData/&gt; node.
+/**************************************************************************
  *
- * Decrypts @node and if necessary replaces @node with decrypted data.
+ * Encrypting many nodes with the same template and key:
  *
- * Returns: 0 on success or a negative value if an error occurs.
- */
-int
-xmlSecEncCtxDecrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr node) {
-    xmlSecBufferPtr buffer;
+ * 1) Read the template and write &lt;dsig:KeyInfo/&gt; node once (e.g. encrypt
+ *    the session key with &lt;enc:EncryptedKey/&gt; only once), copy
+ *    the template for each node.
+ * 2) Serialize and encrypt the nodes in parallel.
+ * 3) Put the encrypted data into the document in the nodes order.
+ *
+ *************************************************************************/
+typedef struct _xmlSecEncCtxEncryptAllItem {
+    xmlNodePtr                  node;
+    xmlNodePtr                  encDataNode;
+    xmlSecEncCtxPtr             encCtx;
+} xmlSecEncCtxEncryptAllItem, *xmlSecEncCtxEncryptAllItemPtr;
+
+static void
+xmlSecEncCtxEncryptAllItemDestroy(xmlSecEncCtxEncryptAllItemPtr item) {
+    xmlSecAssert(item != NULL);
+
+    if(item->encCtx != NULL) {
+        xmlSecEncCtxDestroy(item->encCtx);
+    }
+    if(item->encDataNode != NULL) {
+        xmlFreeNode(item->encDataNode);
+    }
+    memset(item, 0, sizeof(xmlSecEncCtxEncryptAllItem));
+    xmlFree(item);
+}
+
+static xmlSecPtrListKlass xmlSecEncCtxEncryptAllItemsListKlass = {
+    BAD_CAST "enc-encrypt-all-items-list",
+    NULL,                                                           /* xmlSecPtrDuplicateItemMethod duplicateItem; */
+    (xmlSecPtrDestroyItemMethod)xmlSecEncCtxEncryptAllItemDestroy,  /* xmlSecPtrDestroyItemMethod destroyItem; */
+    NULL,                                                           /* xmlSecPtrDebugDumpItemMethod debugDumpItem; */
+    NULL,                                                           /* xmlSecPtrDebugDumpItemMethod debugXmlDumpItem; */
+};
+#define xmlSecEncCtxEncryptAllItemsListId       (&xmlSecEncCtxEncryptAllItemsListKlass)
+
+/* the template copies can't have the same ids */
+static void
+xmlSecEncCtxRemoveIds(xmlNodePtr node) {
+    xmlNodePtr cur;
+    xmlAttrPtr attr;
+    xmlSecSize ii;
+
+    xmlSecAssert(node != NULL);
+
+    for(ii = 0; xmlSecEncIds[ii] != NULL; ++ii) {
+        attr = xmlHasProp(node, xmlSecEncIds[ii]);
+        if(attr != NULL) {
+            xmlRemoveProp(attr);
+        }
+    }
+    for(cur = xmlSecGetNextElementNode(node->children); cur != NULL; cur = xmlSecGetNextElementNode(cur->next)) {
+        xmlSecEncCtxRemoveIds(cur);
+    }
+}
+
+static int
+xmlSecEncCtxEncryptAllItemRead(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl, xmlSecEncCtxEncryptAllItemPtr item) {
     int ret;
 
     xmlSecAssert2(encCtx != NULL, -1);
-    xmlSecAssert2(node != NULL, -1);
+    xmlSecAssert2(encCtx->encKey != NULL, -1);
+    xmlSecAssert2(tmpl != NULL, -1);
+    xmlSecAssert2(item != NULL, -1);
+    xmlSecAssert2(item->node != NULL, -1);
+    xmlSecAssert2(item->encDataNode == NULL, -1);
+    xmlSecAssert2(item->encCtx == NULL, -1);
+
+    item->encDataNode = xmlDocCopyNode(tmpl, item->node->doc, 1);
+    if(item->encDataNode == NULL) {
+        xmlSecXmlError("xmlDocCopyNode", NULL);
+        return(-1);
+    }
+    xmlSecEncCtxRemoveIds(item->encDataNode);
 
-    /* decrypt */
-    buffer = xmlSecEncCtxDecryptToBuffer(encCtx, node);
-    if(buffer == NULL) {
-        xmlSecInternalError("xmlSecEncCtxDecryptToBuffer", NULL);
+    item->encCtx = xmlSecEncCtxCreate(encCtx->keyInfoReadCtx.keysMngr);
+    if(item->encCtx == NULL) {
+        xmlSecInternalError("xmlSecEncCtxCreate", NULL);
+        return(-1);
+    }
+    ret = xmlSecEncCtxCopyUserPref(item->encCtx, encCtx);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxCopyUserPref", NULL);
+        return(-1);
+    }
+    item->encCtx->operation = xmlSecTransformOperationEncrypt;
+    item->encCtx->encKey = xmlSecKeyDuplicate(encCtx->encKey);
+    if(item->encCtx->encKey == NULL) {
+        xmlSecInternalError("xmlSecKeyDuplicate", NULL);
         return(-1);
     }
 
-    /* replace original node if requested */
-    if((encCtx->type != NULL) && xmlStrEqual(encCtx->type, xmlSecTypeEncElement)) {
-        /* check if we need to return the replaced node */
-        if((encCtx->flags & XMLSEC_ENC_RETURN_REPLACED_NODE) != 0) {
-                ret = xmlSecReplaceNodeBufferAndReturn(node, xmlSecBufferGetData(buffer),  xmlSecBufferGetSize(buffer), &(encCtx->replacedNodeList));
-                if(ret < 0) {
-                    xmlSecInternalError("xmlSecReplaceNodeBufferAndReturn",
-                                        xmlSecNodeGetName(node));
-                    return(-1);
-                }
-        } else {
-                ret = xmlSecReplaceNodeBuffer(node, xmlSecBufferGetData(buffer),  xmlSecBufferGetSize(buffer));
-                if(ret < 0) {
-                    xmlSecInternalError("xmlSecReplaceNodeBuffer",
-                                        xmlSecNodeGetName(node));
-                    return(-1);
-                }
-        }
+    ret = xmlSecEncCtxEncDataNodeRead(item->encCtx, item->encDataNode);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxEncDataNodeRead", NULL);
+        return(-1);
+    }
+    xmlSecAssert2(item->encCtx->cipherValueNode != NULL, -1);
 
-        encCtx->resultReplaced = 1;
-    } else if((encCtx->type != NULL) && xmlStrEqual(encCtx->type, xmlSecTypeEncContent)) {
-        /* replace the node with the buffer */
+    return(0);
+}
 
-        /* check if we need to return the replaced node */
-        if((encCtx->flags & XMLSEC_ENC_RETURN_REPLACED_NODE) != 0) {
-                ret = xmlSecReplaceNodeBufferAndReturn(node, xmlSecBufferGetData(buffer), xmlSecBufferGetSize(buffer), &(encCtx->replacedNodeList));
-                if(ret < 0) {
-                    xmlSecInternalError("xmlSecReplaceNodeBufferAndReturn",
-                                        xmlSecNodeGetName(node));
-                    return(-1);
-                }
-        } else {
-            ret = xmlSecReplaceNodeBuffer(node, xmlSecBufferGetData(buffer), xmlSecBufferGetSize(buffer));
-                if(ret < 0) {
-                    xmlSecInternalError("xmlSecReplaceNodeBuffer",
-                                        xmlSecNodeGetName(node));
-                    return(-1);
-                }
+static int
+xmlSecEncCtxEncryptAllTask(void* data, xmlSecSize pos) {
+    xmlSecPtrListPtr items = (xmlSecPtrListPtr)data;
+    xmlSecEncCtxEncryptAllItemPtr item;
+    int ret;
+
+    xmlSecAssert2(items != NULL, -1);
+
+    item = (xmlSecEncCtxEncryptAllItemPtr)xmlSecPtrListGetItem(items, pos);
+    xmlSecAssert2(item != NULL, -1);
+    xmlSecAssert2(item->encCtx != NULL, -1);
+
+    ret = xmlSecEncCtxXmlEncryptNodeData(item->encCtx, item->node);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxXmlEncryptNodeData", NULL);
+        return(-1);
+    }
+    return(0);
+}
+
+static int
+xmlSecEncCtxEncryptAllNodeCmp(const void* a, const void* b) {
+    xmlNodePtr na = *(const xmlNodePtr*)a;
+    xmlNodePtr nb = *(const xmlNodePtr*)b;
+
+    if(na == nb) {
+        return(0);
+    }
+    return((na < nb) ? -1 : 1);
+}
+
+/* the nodes are replaced in the document thus none of them can be
+ * a duplicate or an ancestor of another one */
+static int
+xmlSecEncCtxEncryptAllCheckNodes(xmlNodePtr* nodes, xmlSecSize nodesSize) {
+    xmlNodePtr* sorted;
+    xmlNodePtr cur;
+    xmlSecSize ii;
+    int res = -1;
+
+    if(nodesSize <= 1) {
+        return(0);
+    }
+    xmlSecAssert2(nodes != NULL, -1);
+
+    sorted = (xmlNodePtr*)xmlMalloc(sizeof(xmlNodePtr) * nodesSize);
+    if(sorted == NULL) {
+        xmlSecMallocError(sizeof(xmlNodePtr) * nodesSize, NULL);
+        return(-1);
+    }
+    memcpy(sorted, nodes, sizeof(xmlNodePtr) * nodesSize);
+    qsort(sorted, nodesSize, sizeof(xmlNodePtr), xmlSecEncCtxEncryptAllNodeCmp);
+
+    for(ii = 0; ii < nodesSize; ++ii) {
+        if((ii > 0) && (sorted[ii - 1] == sorted[ii])) {
+            xmlSecOtherError2(XMLSEC_ERRORS_R_INVALID_DATA, NULL,
+                "duplicate node; node=%s", xmlSecErrorsSafeString(xmlSecNodeGetName(sorted[ii])));
+            goto done;
+        }
+        for(cur = sorted[ii]->parent; cur != NULL; cur = cur->parent) {
+            if(bsearch(&cur, sorted, nodesSize, sizeof(xmlNodePtr), xmlSecEncCtxEncryptAllNodeCmp) != NULL) {
+                xmlSecOtherError3(XMLSEC_ERRORS_R_INVALID_DATA, NULL,
+                    "overlapping nodes; node=%s; ancestor=%s",
+                    xmlSecErrorsSafeString(xmlSecNodeGetName(sorted[ii])),
+                    xmlSecErrorsSafeString(xmlSecNodeGetName(cur)));
+                goto done;
+            }
         }
-        encCtx->resultReplaced = 1;
     }
 
-    return(0);
+    /* success */
+    res = 0;
+
+done:
+    xmlFree(sorted);
+    return(res);
+}
+
+/* appends @replaced list to the encCtx->replacedNodeList, @last is the current list tail */
+static void
+xmlSecEncCtxAppendReplacedNodes(xmlSecEncCtxPtr encCtx, xmlNodePtr* last, xmlNodePtr replaced) {
+    xmlSecAssert(encCtx != NULL);
+    xmlSecAssert(last != NULL);
+
+    if(replaced == NULL) {
+        return;
+    }
+    if((*last) != NULL) {
+        (*last)->next = replaced;
+        replaced->prev = (*last);
+    } else {
+        encCtx->replacedNodeList = replaced;
+    }
+    for((*last) = replaced; (*last)->next != NULL; (*last) = (*last)->next);
 }
 
 /**
- * xmlSecEncCtxDecryptToBuffer:
- * @encCtx:             the pointer to encryption processing context.
- * @node:               the pointer to &lt;enc:EncryptedData/&gt; node.
+ * xmlSecEncCtxXmlEncryptAll:
+ * @encCtx:             the pointer to &lt;enc:EncryptedData/&gt; processing context.
+ * @tmpl:               the pointer to &lt;enc:EncryptedData/&gt; template node.
+ * @nodes:              the nodes to encrypt.
+ * @threadsNum:         the max number of threads used to encrypt the data
+ *                      (0 or 1 to encrypt everything in the current thread).
  *
- * Decrypts @node data to the result.
+ * Encrypts all the @nodes according to template @tmpl with the same key
+ * and replaces them (or their content) with the &lt;enc:EncryptedData/&gt;
+ * nodes. The &lt;dsig:KeyInfo/&gt; node in the template is written only once
+ * (e.g. the session key is encrypted once) and then copied, along with the rest
+ * of the template, for each node; the Id attributes are not copied. The nodes
+ * are serialized and encrypted in up to @threadsNum threads, the document is
+ * updated after all the nodes were encrypted. The @tmpl node itself is not
+ * added to the document.
  *
- * Returns: a buffer with key on success or NULL if an error occurs.
+ * The nodes must not overlap (i.e. none of the nodes can be a duplicate or
+ * an ancestor of another node), otherwise the function fails without
+ * changing the document. The encrypted data is always stored in
+ * the &lt;enc:CipherValue/&gt; node. If XMLSEC_ENC_RETURN_REPLACED_NODE flag
+ * is set then the replaced nodes are returned in the replacedNodeList.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
  */
-xmlSecBufferPtr
-xmlSecEncCtxDecryptToBuffer(xmlSecEncCtxPtr encCtx, xmlNodePtr node) {
-    xmlSecBufferPtr res = NULL;
-    xmlChar* data = NULL;
+int
+xmlSecEncCtxXmlEncryptAll(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl, xmlNodeSetPtr nodes, xmlSecSize threadsNum) {
+    xmlSecPtrList items;
+    xmlSecEncCtxEncryptAllItemPtr item;
+    xmlNodePtr replaced;
+    xmlNodePtr replacedLast = NULL;
+    xmlSecSize ii, size;
+    int len;
+    int res = -1;
     int ret;
 
-    xmlSecAssert2(encCtx != NULL, NULL);
-    xmlSecAssert2(encCtx->result == NULL, NULL);
-    xmlSecAssert2(node != NULL, NULL);
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(encCtx->result == NULL, -1);
+    xmlSecAssert2(tmpl != NULL, -1);
+    xmlSecAssert2(nodes != NULL, -1);
+
+    ret = xmlSecPtrListInitialize(&items, xmlSecEncCtxEncryptAllItemsListId);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInitialize", NULL);
+        return(-1);
+    }
 
     /* initialize context and add ID atributes to the list of known ids */
-    encCtx->operation = xmlSecTransformOperationDecrypt;
-    xmlSecAddIDs(node->doc, node, xmlSecEncIds);
+    encCtx->operation = xmlSecTransformOperationEncrypt;
+    xmlSecAddIDs(tmpl->doc, tmpl, xmlSecEncIds);
 
-    ret = xmlSecEncCtxEncDataNodeRead(encCtx, node);
+    /* read the template and set encryption method, key, etc. */
+    ret = xmlSecEncCtxEncDataNodeRead(encCtx, tmpl);
     if(ret < 0) {
         xmlSecInternalError("xmlSecEncCtxEncDataNodeRead", NULL);
         goto done;
     }
+    if(encCtx->cipherValueNode == NULL) {
+        xmlSecNodeNotFoundError("xmlSecEncCtxEncDataNodeRead", tmpl, xmlSecNodeCipherValue, NULL);
+        goto done;
+    }
+    if((encCtx->type == NULL) || (!xmlStrEqual(encCtx->type, xmlSecTypeEncElement) && !xmlStrEqual(encCtx->type, xmlSecTypeEncContent))) {
+        xmlSecInvalidStringTypeError("encryption type", encCtx->type,
+                "supported encryption type", NULL);
+        goto done;
+    }
 
-    /* decrypt the data */
-    if(encCtx->cipherValueNode != NULL) {
-        data = xmlNodeGetContent(encCtx->cipherValueNode);
-        if(data == NULL) {
-            xmlSecInvalidNodeContentError(encCtx->cipherValueNode, NULL, "empty");
+    /* write the key info once for all the nodes */
+    if(encCtx->keyInfoNode != NULL) {
+        ret = xmlSecKeyInfoNodeWrite(encCtx->keyInfoNode, encCtx->encKey, &(encCtx->keyInfoWriteCtx));
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecKeyInfoNodeWrite", NULL);
             goto done;
         }
+    }
 
-        ret = xmlSecTransformCtxBinaryExecute(&(encCtx->transformCtx), data, xmlSecStrlen(data));
-        if(ret < 0) {
-            xmlSecInternalError("xmlSecTransformCtxBinaryExecute", NULL);
+    /* check the nodes before changing anything */
+    XMLSEC_SAFE_CAST_INT_TO_SIZE(nodes->nodeNr, size, goto done, NULL);
+    for(ii = 0; ii < size; ++ii) {
+        if((nodes->nodeTab[ii] == NULL) || (nodes->nodeTab[ii]->type != XML_ELEMENT_NODE)) {
+            xmlSecInvalidDataError("only element nodes can be encrypted", NULL);
             goto done;
         }
-    } else {
-        ret = xmlSecTransformCtxExecute(&(encCtx->transformCtx), node->doc);
+    }
+    ret = xmlSecEncCtxEncryptAllCheckNodes(nodes->nodeTab, size);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxEncryptAllCheckNodes", NULL);
+        goto done;
+    }
+
+    /* copy the template for each node */
+    for(ii = 0; ii < size; ++ii) {
+
+        item = (xmlSecEncCtxEncryptAllItemPtr)xmlMalloc(sizeof(xmlSecEncCtxEncryptAllItem));
+        if(item == NULL) {
+            xmlSecMallocError(sizeof(xmlSecEncCtxEncryptAllItem), NULL);
+            goto done;
+        }
+        memset(item, 0, sizeof(xmlSecEncCtxEncryptAllItem));
+        item->node = nodes->nodeTab[ii];
+
+        ret = xmlSecPtrListAdd(&items, item);
         if(ret < 0) {
-            xmlSecInternalError("xmlSecTransformCtxExecute", NULL);
+            xmlSecInternalError("xmlSecPtrListAdd", NULL);
+            xmlSecEncCtxEncryptAllItemDestroy(item);
+            goto done;
+        }
+
+        ret = xmlSecEncCtxEncryptAllItemRead(encCtx, tmpl, item);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecEncCtxEncryptAllItemRead",
+                                xmlSecNodeGetName(item->node));
+            goto done;
+        }
+    }
+
+    /* encrypt */
+    ret = xmlSecParallelRun(xmlSecEncCtxEncryptAllTask, &items, size, threadsNum);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecParallelRun", NULL);
+        goto done;
+    }
+
+    /* and finally update the document */
+    for(ii = 0; ii < size; ++ii) {
+        item = (xmlSecEncCtxEncryptAllItemPtr)xmlSecPtrListGetItem(&items, ii);
+        if((item == NULL) || (item->encCtx == NULL) || (item->encCtx->result == NULL) || (item->encCtx->cipherValueNode == NULL)) {
+            xmlSecInternalError("xmlSecPtrListGetItem", NULL);
             goto done;
         }
+
+        /* the key info was already written, just set the data */
+        XMLSEC_SAFE_CAST_SIZE_TO_INT(xmlSecBufferGetSize(item->encCtx->result), len, goto done, NULL);
+        xmlNodeSetContentLen(item->encCtx->cipherValueNode, xmlSecBufferGetData(item->encCtx->result), len);
+
+        replaced = NULL;
+        ret = xmlSecEncCtxXmlEncryptReplaceNode(item->encCtx, item->node, item->encDataNode,
+            ((encCtx->flags & XMLSEC_ENC_RETURN_REPLACED_NODE) != 0) ? &replaced : NULL);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecEncCtxXmlEncryptReplaceNode",
+                                xmlSecNodeGetName(item->node));
+            goto done;
+        }
+        xmlSecEncCtxAppendReplacedNodes(encCtx, &replacedLast, replaced);
+        item->encDataNode = NULL; /* owned by the document now */
+        encCtx->resultReplaced = 1;
+    }
+
+    /* success */
+    res = 0;
+
+done:
+    xmlSecPtrListFinalize(&items);
+    return(res);
+}
+
+/**
+ * xmlSecEncCtxUriEncrypt:
+ * @encCtx:             the pointer to &lt;enc:EncryptedData/&gt; processing context.
+ * @tmpl:               the pointer to &lt;enc:EncryptedData/&gt; template node.
+ * @uri:                the URI.
+ *
+ * Encrypts data from @uri according to template @tmpl.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecEncCtxUriEncrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr tmpl, const xmlChar *uri) {
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(encCtx->result == NULL, -1);
+    xmlSecAssert2(tmpl != NULL, -1);
+    xmlSecAssert2(uri != NULL, -1);
+
+    /* initialize context and add ID atributes to the list of known ids */
+    encCtx->operation = xmlSecTransformOperationEncrypt;
+    xmlSecAddIDs(tmpl->doc, tmpl, xmlSecEncIds);
+
+    /* we need to add input uri transform first */
+    ret = xmlSecTransformCtxSetUri(&(encCtx->transformCtx), uri, tmpl);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecTransformCtxSetUri", NULL,
+                             "uri=%s", xmlSecErrorsSafeString(uri));
+        return(-1);
+    }
+
+    /* read the template and set encryption method, key, etc. */
+    ret = xmlSecEncCtxEncDataNodeRead(encCtx, tmpl);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxEncDataNodeRead", NULL);
+        return(-1);
+    }
+
+    /* encrypt the data */
+    ret = xmlSecTransformCtxExecute(&(encCtx->transformCtx), tmpl->doc);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecTransformCtxExecute", NULL);
+        return(-1);
+    }
+
+    encCtx->result = encCtx->transformCtx.result;
+    xmlSecAssert2(encCtx->result != NULL, -1);
+
+    ret = xmlSecEncCtxEncDataNodeWrite(encCtx);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxEncDataNodeWrite", NULL);
+        return(-1);
+    }
+
+    return(0);
+}
+
+/**
+ * xmlSecEncCtxDecrypt:
+ * @encCtx:             the pointer to &lt;enc:EncryptedData/&gt; processing context.
+ * @node:               the pointer to &lt;enc:EncryptedData/&gt; node.
+ *
+ * Decrypts @node and if necessary replaces @node with decrypted data.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecEncCtxDecrypt(xmlSecEncCtxPtr encCtx, xmlNodePtr node) {
+    xmlSecBufferPtr buffer;
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    /* decrypt */
+    buffer = xmlSecEncCtxDecryptToBuffer(encCtx, node);
+    if(buffer == NULL) {
+        xmlSecInternalError("xmlSecEncCtxDecryptToBuffer", NULL);
+        return(-1);
+    }
+
+    /* replace original node if requested */
+    if((encCtx->type != NULL) && xmlStrEqual(encCtx->type, xmlSecTypeEncElement)) {
+        /* check if we need to return the replaced node */
+        if((encCtx->flags & XMLSEC_ENC_RETURN_REPLACED_NODE) != 0) {
+                ret = xmlSecReplaceNodeBufferAndReturn(node, xmlSecBufferGetData(buffer),  xmlSecBufferGetSize(buffer), &(encCtx->replacedNodeList));
+                if(ret < 0) {
+                    xmlSecInternalError("xmlSecReplaceNodeBufferAndReturn",
+                                        xmlSecNodeGetName(node));
+                    return(-1);
+                }
+        } else {
+                ret = xmlSecReplaceNodeBuffer(node, xmlSecBufferGetData(buffer),  xmlSecBufferGetSize(buffer));
+                if(ret < 0) {
+                    xmlSecInternalError("xmlSecReplaceNodeBuffer",
+                                        xmlSecNodeGetName(node));
+                    return(-1);
+                }
+        }
+
+        encCtx->resultReplaced = 1;
+    } else if((encCtx->type != NULL) && xmlStrEqual(encCtx->type, xmlSecTypeEncContent)) {
+        /* replace the node with the buffer */
+
+        /* check if we need to return the replaced node */
+        if((encCtx->flags & XMLSEC_ENC_RETURN_REPLACED_NODE) != 0) {
+                ret = xmlSecReplaceNodeBufferAndReturn(node, xmlSecBufferGetData(buffer), xmlSecBufferGetSize(buffer), &(encCtx->replacedNodeList));
+                if(ret < 0) {
+                    xmlSecInternalError("xmlSecReplaceNodeBufferAndReturn",
+                                        xmlSecNodeGetName(node));
+                    return(-1);
+                }
+        } else {
+            ret = xmlSecReplaceNodeBuffer(node, xmlSecBufferGetData(buffer), xmlSecBufferGetSize(buffer));
+                if(ret < 0) {
+                    xmlSecInternalError("xmlSecReplaceNodeBuffer",
+                                        xmlSecNodeGetName(node));
+                    return(-1);
+                }
+        }
+        encCtx->resultReplaced = 1;
+    }
+
+    return(0);
+}
+
+/**
+ * xmlSecEncCtxDecryptToBuffer:
+ * @encCtx:             the pointer to encryption processing context.
+ * @node:               the pointer to &lt;enc:EncryptedData/&gt; node.
+ *
+ * Decrypts @node data to the result.
+ *
+ * Returns: a buffer with key on success or NULL if an error occurs.
+ */
+xmlSecBufferPtr
+xmlSecEncCtxDecryptToBuffer(xmlSecEncCtxPtr encCtx, xmlNodePtr node) {
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, NULL);
+    xmlSecAssert2(encCtx->result == NULL, NULL);
+    xmlSecAssert2(node != NULL, NULL);
+
+    ret = xmlSecEncCtxDecryptExecute(encCtx, node, NULL);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxDecryptExecute", NULL);
+        return(NULL);
     }
 
     /* success  */
-    res = encCtx->result = encCtx->transformCtx.result;
+    encCtx->result = encCtx->transformCtx.result;
     xmlSecAssert2(encCtx->result != NULL, NULL);
+    return(encCtx->result);
+}
+
+/**
+ * xmlSecEncCtxDecryptToOutputBuffer:
+ * @encCtx:             the pointer to encryption processing context.
+ * @node:               the pointer to &lt;enc:EncryptedData/&gt; node.
+ * @output:             the LibXML2 output buffer (e.g. file, file descriptor
+ *                      or IO callbacks).
+ *
+ * Decrypts @node data and writes it directly to @output instead of storing
+ * it in the context's result. The &lt;enc:CipherReference/&gt; data is read,
+ * decrypted and written in chunks so the memory usage doesn't depend on the
+ * data size. The @node is not replaced and the caller is responsible for
+ * closing @output.
+ *
+ * Some data might be already written to @output when an error occurs (e.g.
+ * AEAD decrypted data is released before the tag is verified if
+ * #XMLSEC_TRANSFORMCTX_FLAGS_AEAD_STREAMING flag is set), the caller
+ * MUST discard (or roll back) the output in this case.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecEncCtxDecryptToOutputBuffer(xmlSecEncCtxPtr encCtx, xmlNodePtr node, xmlOutputBufferPtr output) {
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(encCtx->result == NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+    xmlSecAssert2(output != NULL, -1);
+
+    ret = xmlSecEncCtxDecryptExecute(encCtx, node, output);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxDecryptExecute", NULL);
+        return(-1);
+    }
+
+    /* success  */
+    return(0);
+}
+
+/* reads the node and executes the transforms chain; if @output is not NULL
+ * then the decrypted data is written to it and not stored in the result */
+static int
+xmlSecEncCtxDecryptExecute(xmlSecEncCtxPtr encCtx, xmlNodePtr node, xmlOutputBufferPtr output) {
+    xmlSecTransformPtr outputTransform;
+    xmlChar* data = NULL;
+    int res = -1;
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+
+    /* initialize context and add ID atributes to the list of known ids */
+    encCtx->operation = xmlSecTransformOperationDecrypt;
+    xmlSecAddIDs(node->doc, node, xmlSecEncIds);
+
+    ret = xmlSecEncCtxEncDataNodeRead(encCtx, node);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxEncDataNodeRead", NULL);
+        goto done;
+    }
+
+    /* the output buffer transform consumes all the data, nothing goes to the result */
+    if(output != NULL) {
+        outputTransform = xmlSecTransformCtxCreateAndAppend(&(encCtx->transformCtx), xmlSecTransformOutputBufId);
+        if(outputTransform == NULL) {
+            xmlSecInternalError("xmlSecTransformCtxCreateAndAppend(xmlSecTransformOutputBufId)", NULL);
+            goto done;
+        }
+        ret = xmlSecTransformOutputBufSetOutput(outputTransform, output);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformOutputBufSetOutput",
+                                xmlSecTransformGetName(outputTransform));
+            goto done;
+        }
+    }
+
+    /* decrypt the data */
+    if(encCtx->cipherValueNode != NULL) {
+        data = xmlNodeGetContent(encCtx->cipherValueNode);
+        if(data == NULL) {
+            xmlSecInvalidNodeContentError(encCtx->cipherValueNode, NULL, "empty");
+            goto done;
+        }
+
+        ret = xmlSecTransformCtxBinaryExecute(&(encCtx->transformCtx), data, xmlSecStrlen(data));
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformCtxBinaryExecute", NULL);
+            goto done;
+        }
+    } else {
+        ret = xmlSecTransformCtxExecute(&(encCtx->transformCtx), node->doc);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformCtxExecute", NULL);
+            goto done;
+        }
+    }
+
+    /* success  */
+    res = 0;
 
 done:
     if(data != NULL) {
@@ -646,6 +1123,518 @@ done:
     return(res);
 }
 
+/**************************************************************************
+ *
+ * Decrypting all &lt;enc:EncryptedData/&gt; nodes in the document:
+ *
+ * 1) Find all the nodes and read them one by one. The keys are resolved
+ *    at this step and the keys for nodes with the same &lt;enc:EncryptionMethod/&gt;
+ *    algorithm and &lt;dsig:KeyInfo/&gt; node content are resolved only once.
+ * 2) Decrypt CipherValue payloads in parallel: base64 decoding and cipher
+ *    don't touch the document or the keys manager.
+ * 3) Parse the decrypted data for all the nodes.
+ * 4) Replace the nodes with the parsed data in the document order: nothing
+ *    can fail at this step thus the document is either fully updated or
+ *    not changed at all.
+ *
+ *************************************************************************/
+typedef struct _xmlSecEncCtxDecryptAllItem {
+    xmlNodePtr                  node;
+    xmlSecEncCtxPtr             encCtx;
+    xmlChar*                    cipherValue;
+    xmlNodePtr                  decrypted;
+} xmlSecEncCtxDecryptAllItem, *xmlSecEncCtxDecryptAllItemPtr;
+
+static void
+xmlSecEncCtxDecryptAllItemDestroy(xmlSecEncCtxDecryptAllItemPtr item) {
+    xmlSecAssert(item != NULL);
+
+    if(item->encCtx != NULL) {
+        xmlSecEncCtxDestroy(item->encCtx);
+    }
+    if(item->cipherValue != NULL) {
+        xmlFree(item->cipherValue);
+    }
+    if(item->decrypted != NULL) {
+        xmlFreeNodeList(item->decrypted);
+    }
+    memset(item, 0, sizeof(xmlSecEncCtxDecryptAllItem));
+    xmlFree(item);
+}
+
+static xmlSecPtrListKlass xmlSecEncCtxDecryptAllItemsListKlass = {
+    BAD_CAST "enc-decrypt-all-items-list",
+    NULL,                                                           /* xmlSecPtrDuplicateItemMethod duplicateItem; */
+    (xmlSecPtrDestroyItemMethod)xmlSecEncCtxDecryptAllItemDestroy,  /* xmlSecPtrDestroyItemMethod destroyItem; */
+    NULL,                                                           /* xmlSecPtrDebugDumpItemMethod debugDumpItem; */
+    NULL,                                                           /* xmlSecPtrDebugDumpItemMethod debugXmlDumpItem; */
+};
+#define xmlSecEncCtxDecryptAllItemsListId       (&xmlSecEncCtxDecryptAllItemsListKlass)
+
+typedef struct _xmlSecEncCtxSharedKey {
+    xmlChar*                    name;
+    xmlSecKeyPtr                key;
+} xmlSecEncCtxSharedKey, *xmlSecEncCtxSharedKeyPtr;
+
+static void
+xmlSecEncCtxSharedKeyDestroy(xmlSecEncCtxSharedKeyPtr sharedKey) {
+    xmlSecAssert(sharedKey != NULL);
+
+    if(sharedKey->name != NULL) {
+        xmlFree(sharedKey->name);
+    }
+    if(sharedKey->key != NULL) {
+        xmlSecKeyDestroy(sharedKey->key);
+    }
+    memset(sharedKey, 0, sizeof(xmlSecEncCtxSharedKey));
+    xmlFree(sharedKey);
+}
+
+static xmlSecPtrListKlass xmlSecEncCtxSharedKeysListKlass = {
+    BAD_CAST "enc-shared-keys-list",
+    NULL,                                                           /* xmlSecPtrDuplicateItemMethod duplicateItem; */
+    (xmlSecPtrDestroyItemMethod)xmlSecEncCtxSharedKeyDestroy,       /* xmlSecPtrDestroyItemMethod destroyItem; */
+    NULL,                                                           /* xmlSecPtrDebugDumpItemMethod debugDumpItem; */
+    NULL,                                                           /* xmlSecPtrDebugDumpItemMethod debugXmlDumpItem; */
+};
+#define xmlSecEncCtxSharedKeysListId            (&xmlSecEncCtxSharedKeysListKlass)
+
+/* the key is determined by the encryption algorithm and the <dsig:KeyInfo/> node */
+static xmlChar*
+xmlSecEncCtxGetSharedKeyName(xmlNodePtr node) {
+    xmlNodePtr cur;
+    xmlBufferPtr buffer;
+    xmlChar* algorithm;
+    xmlChar* res;
+
+    xmlSecAssert2(node != NULL, NULL);
+
+    buffer = xmlBufferCreate();
+    if(buffer == NULL) {
+        xmlSecXmlError("xmlBufferCreate", NULL);
+        return(NULL);
+    }
+
+    cur = xmlSecGetNextElementNode(node->children);
+    if((cur != NULL) && (xmlSecCheckNodeName(cur, xmlSecNodeEncryptionMethod, xmlSecEncNs))) {
+        algorithm = xmlGetProp(cur, xmlSecAttrAlgorithm);
+        if(algorithm != NULL) {
+            xmlBufferCat(buffer, algorithm);
+            xmlFree(algorithm);
+        }
+        cur = xmlSecGetNextElementNode(cur->next);
+    }
+    xmlBufferCCat(buffer, "\n");
+    if((cur != NULL) && (xmlSecCheckNodeName(cur, xmlSecNodeKeyInfo, xmlSecDSigNs))) {
+        xmlNodeDump(buffer, cur->doc, cur, 0, 0);
+    }
+
+    res = xmlStrdup(xmlBufferContent(buffer));
+    if(res == NULL) {
+        xmlSecStrdupError(xmlBufferContent(buffer), NULL);
+        xmlBufferFree(buffer);
+        return(NULL);
+    }
+    xmlBufferFree(buffer);
+    return(res);
+}
+
+static xmlSecEncCtxSharedKeyPtr
+xmlSecEncCtxSharedKeysFind(xmlSecPtrListPtr sharedKeys, const xmlChar* name) {
+    xmlSecEncCtxSharedKeyPtr sharedKey;
+    xmlSecSize ii, size;
+
+    xmlSecAssert2(sharedKeys != NULL, NULL);
+    xmlSecAssert2(name != NULL, NULL);
+
+    size = xmlSecPtrListGetSize(sharedKeys);
+    for(ii = 0; ii < size; ++ii) {
+        sharedKey = (xmlSecEncCtxSharedKeyPtr)xmlSecPtrListGetItem(sharedKeys, ii);
+        if((sharedKey != NULL) && xmlStrEqual(sharedKey->name, name)) {
+            return(sharedKey);
+        }
+    }
+    return(NULL);
+}
+
+static int
+xmlSecEncCtxSharedKeysAdd(xmlSecPtrListPtr sharedKeys, xmlChar* name, xmlSecKeyPtr key) {
+    xmlSecEncCtxSharedKeyPtr sharedKey;
+    int ret;
+
+    xmlSecAssert2(sharedKeys != NULL, -1);
+    xmlSecAssert2(name != NULL, -1);
+    xmlSecAssert2(key != NULL, -1);
+
+    sharedKey = (xmlSecEncCtxSharedKeyPtr)xmlMalloc(sizeof(xmlSecEncCtxSharedKey));
+    if(sharedKey == NULL) {
+        xmlSecMallocError(sizeof(xmlSecEncCtxSharedKey), NULL);
+        return(-1);
+    }
+    memset(sharedKey, 0, sizeof(xmlSecEncCtxSharedKey));
+
+    sharedKey->key = xmlSecKeyDuplicate(key);
+    if(sharedKey->key == NULL) {
+        xmlSecInternalError("xmlSecKeyDuplicate", NULL);
+        xmlSecEncCtxSharedKeyDestroy(sharedKey);
+        return(-1);
+    }
+
+    ret = xmlSecPtrListAdd(sharedKeys, sharedKey);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListAdd", NULL);
+        xmlSecEncCtxSharedKeyDestroy(sharedKey);
+        return(-1);
+    }
+
+    /* take ownership of the name only when everything else succeeded */
+    sharedKey->name = name;
+    return(0);
+}
+
+static int
+xmlSecEncCtxDecryptAllFindNodes(xmlNodePtr node, xmlSecPtrListPtr items) {
+    xmlSecEncCtxDecryptAllItemPtr item;
+    xmlNodePtr cur;
+    xmlChar* type;
+    int ret;
+
+    xmlSecAssert2(node != NULL, -1);
+    xmlSecAssert2(items != NULL, -1);
+
+    for(cur = xmlSecGetNextElementNode(node->children); cur != NULL; cur = xmlSecGetNextElementNode(cur->next)) {
+        if(!xmlSecCheckNodeName(cur, xmlSecNodeEncryptedData, xmlSecEncNs)) {
+            ret = xmlSecEncCtxDecryptAllFindNodes(cur, items);
+            if(ret < 0) {
+                return(-1);
+            }
+            continue;
+        }
+
+        /* only XML element or content could be put back into the document */
+        type = xmlGetProp(cur, xmlSecAttrType);
+        if((type == NULL) || (!xmlStrEqual(type, xmlSecTypeEncElement) && !xmlStrEqual(type, xmlSecTypeEncContent))) {
+            if(type != NULL) {
+                xmlFree(type);
+            }
+            continue;
+        }
+        xmlFree(type);
+
+        item = (xmlSecEncCtxDecryptAllItemPtr)xmlMalloc(sizeof(xmlSecEncCtxDecryptAllItem));
+        if(item == NULL) {
+            xmlSecMallocError(sizeof(xmlSecEncCtxDecryptAllItem), NULL);
+            return(-1);
+        }
+        memset(item, 0, sizeof(xmlSecEncCtxDecryptAllItem));
+        item->node = cur;
+
+        ret = xmlSecPtrListAdd(items, item);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecPtrListAdd", NULL);
+            xmlSecEncCtxDecryptAllItemDestroy(item);
+            return(-1);
+        }
+    }
+    return(0);
+}
+
+static int
+xmlSecEncCtxDecryptAllItemRead(xmlSecEncCtxPtr encCtx, xmlSecEncCtxDecryptAllItemPtr item,
+                               xmlSecPtrListPtr sharedKeys) {
+    xmlSecEncCtxSharedKeyPtr sharedKey;
+    xmlChar* sharedKeyName = NULL;
+    int res = -1;
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(item != NULL, -1);
+    xmlSecAssert2(item->node != NULL, -1);
+    xmlSecAssert2(item->encCtx == NULL, -1);
+    xmlSecAssert2(sharedKeys != NULL, -1);
+
+    item->encCtx = xmlSecEncCtxCreate(encCtx->keyInfoReadCtx.keysMngr);
+    if(item->encCtx == NULL) {
+        xmlSecInternalError("xmlSecEncCtxCreate", NULL);
+        goto done;
+    }
+    ret = xmlSecEncCtxCopyUserPref(item->encCtx, encCtx);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxCopyUserPref", NULL);
+        goto done;
+    }
+    item->encCtx->mode = xmlEncCtxModeEncryptedData;
+    item->encCtx->operation = xmlSecTransformOperationDecrypt;
+
+    /* use the application key or the key we already resolved for the same KeyInfo */
+    if(encCtx->encKey != NULL) {
+        item->encCtx->encKey = xmlSecKeyDuplicate(encCtx->encKey);
+        if(item->encCtx->encKey == NULL) {
+            xmlSecInternalError("xmlSecKeyDuplicate", NULL);
+            goto done;
+        }
+    } else {
+        sharedKeyName = xmlSecEncCtxGetSharedKeyName(item->node);
+        if(sharedKeyName == NULL) {
+            xmlSecInternalError("xmlSecEncCtxGetSharedKeyName", NULL);
+            goto done;
+        }
+        sharedKey = xmlSecEncCtxSharedKeysFind(sharedKeys, sharedKeyName);
+        if(sharedKey != NULL) {
+            item->encCtx->encKey = xmlSecKeyDuplicate(sharedKey->key);
+            if(item->encCtx->encKey == NULL) {
+                xmlSecInternalError("xmlSecKeyDuplicate", NULL);
+                goto done;
+            }
+            xmlFree(sharedKeyName);
+            sharedKeyName = NULL;
+        }
+    }
+
+    ret = xmlSecEncCtxEncDataNodeRead(item->encCtx, item->node);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxEncDataNodeRead", NULL);
+        xmlSecEncCtxMarkAsFailed(encCtx, item->encCtx->failureReason);
+        goto done;
+    }
+
+    /* remember the new key for the next nodes */
+    if(sharedKeyName != NULL) {
+        ret = xmlSecEncCtxSharedKeysAdd(sharedKeys, sharedKeyName, item->encCtx->encKey);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecEncCtxSharedKeysAdd", NULL);
+            goto done;
+        }
+        sharedKeyName = NULL; /* owned by sharedKeys now */
+    }
+
+    if(item->encCtx->cipherValueNode != NULL) {
+        /* read the data now, no DOM access from the worker threads */
+        item->cipherValue = xmlNodeGetContent(item->encCtx->cipherValueNode);
+        if(item->cipherValue == NULL) {
+            xmlSecInvalidNodeContentError(item->encCtx->cipherValueNode, NULL, "empty");
+            goto done;
+        }
+    } else {
+        /* CipherReference might need the document or IO callbacks, do it right here */
+        ret = xmlSecTransformCtxExecute(&(item->encCtx->transformCtx), item->node->doc);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecTransformCtxExecute", NULL);
+            goto done;
+        }
+        item->encCtx->result = item->encCtx->transformCtx.result;
+    }
+
+    /* success */
+    res = 0;
+
+done:
+    if(sharedKeyName != NULL) {
+        xmlFree(sharedKeyName);
+    }
+    return(res);
+}
+
+static int
+xmlSecEncCtxDecryptAllTask(void* data, xmlSecSize pos) {
+    xmlSecPtrListPtr items = (xmlSecPtrListPtr)data;
+    xmlSecEncCtxDecryptAllItemPtr item;
+    int ret;
+
+    xmlSecAssert2(items != NULL, -1);
+
+    item = (xmlSecEncCtxDecryptAllItemPtr)xmlSecPtrListGetItem(items, pos);
+    xmlSecAssert2(item != NULL, -1);
+    xmlSecAssert2(item->encCtx != NULL, -1);
+
+    if(item->encCtx->result != NULL) {
+        /* already done */
+        return(0);
+    }
+    xmlSecAssert2(item->cipherValue != NULL, -1);
+
+    ret = xmlSecTransformCtxBinaryExecute(&(item->encCtx->transformCtx), item->cipherValue, xmlSecStrlen(item->cipherValue));
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecTransformCtxBinaryExecute", NULL);
+        return(-1);
+    }
+    item->encCtx->result = item->encCtx->transformCtx.result;
+    xmlSecAssert2(item->encCtx->result != NULL, -1);
+
+    return(0);
+}
+
+/* parses the decrypted data in the context of the node's parent (see xmlSecReplaceNodeBuffer) */
+static int
+xmlSecEncCtxDecryptAllItemParse(xmlSecEncCtxDecryptAllItemPtr item) {
+    const xmlChar *oldenc;
+    xmlParserErrors err;
+    int len;
+
+    xmlSecAssert2(item != NULL, -1);
+    xmlSecAssert2(item->node != NULL, -1);
+    xmlSecAssert2(item->node->parent != NULL, -1);
+    xmlSecAssert2(item->node->doc != NULL, -1);
+    xmlSecAssert2(item->encCtx != NULL, -1);
+    xmlSecAssert2(item->encCtx->result != NULL, -1);
+    xmlSecAssert2(item->decrypted == NULL, -1);
+
+    XMLSEC_SAFE_CAST_SIZE_TO_INT(xmlSecBufferGetSize(item->encCtx->result), len, return(-1), NULL);
+    oldenc = item->node->doc->encoding;
+    item->node->doc->encoding = NULL;
+    err = xmlParseInNodeContext(item->node->parent, (const char*)xmlSecBufferGetData(item->encCtx->result),
+        len, xmlSecParserGetDefaultOptions(), &(item->decrypted));
+    item->node->doc->encoding = oldenc;
+    if(err != XML_ERR_OK) {
+        xmlSecXmlError("xmlParseInNodeContext", NULL);
+        return(-1);
+    }
+    return(0);
+}
+
+/* puts the parsed data in place of the node, can't fail */
+static void
+xmlSecEncCtxDecryptAllItemReplace(xmlSecEncCtxDecryptAllItemPtr item, xmlNodePtr* replaced) {
+    xmlNodePtr cur, next;
+
+    xmlSecAssert(item != NULL);
+    xmlSecAssert(item->node != NULL);
+
+    for(cur = item->decrypted; cur != NULL; cur = next) {
+        next = cur->next;
+        xmlAddPrevSibling(item->node, cur);
+    }
+    item->decrypted = NULL;
+
+    xmlUnlinkNode(item->node);
+    if(replaced != NULL) {
+        (*replaced) = item->node;
+    } else {
+        xmlFreeNode(item->node);
+    }
+    item->node = NULL;
+}
+
+/**
+ * xmlSecEncCtxDecryptAll:
+ * @encCtx:             the pointer to encryption processing context.
+ * @node:               the pointer to the root of the subtree to decrypt.
+ * @threadsNum:         the max number of threads used to decrypt the data
+ *                      (0 or 1 to decrypt everything in the current thread).
+ *
+ * Finds all &lt;enc:EncryptedData/&gt; nodes with Element or Content type
+ * under @node, decrypts them and replaces them with the decrypted data.
+ * The keys are resolved only once for the nodes with the same encryption
+ * algorithm and &lt;dsig:KeyInfo/&gt; node, the decryption itself is done
+ * in up to @threadsNum threads. The document is modified only if all the nodes
+ * were decrypted and the decrypted data was parsed successfully. The decrypted data is not searched for more
+ * &lt;enc:EncryptedData/&gt; nodes.
+ *
+ * The @encCtx context provides the keys manager, the user preferences and,
+ * optionally, the key (#encKey) for all the nodes. If XMLSEC_ENC_RETURN_REPLACED_NODE
+ * flag is set then the replaced nodes are returned in the replacedNodeList
+ * linked through the next pointer in the document order.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecEncCtxDecryptAll(xmlSecEncCtxPtr encCtx, xmlNodePtr node, xmlSecSize threadsNum) {
+    xmlSecPtrList items;
+    xmlSecPtrList sharedKeys;
+    xmlSecEncCtxDecryptAllItemPtr item;
+    xmlNodePtr replacedNode;
+    xmlNodePtr replacedNodeLast = NULL;
+    xmlSecSize ii, size;
+    int res = -1;
+    int ret;
+
+    xmlSecAssert2(encCtx != NULL, -1);
+    xmlSecAssert2(encCtx->result == NULL, -1);
+    xmlSecAssert2(node != NULL, -1);
+    xmlSecAssert2(node->doc != NULL, -1);
+
+    ret = xmlSecPtrListInitialize(&items, xmlSecEncCtxDecryptAllItemsListId);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInitialize(items)", NULL);
+        return(-1);
+    }
+    ret = xmlSecPtrListInitialize(&sharedKeys, xmlSecEncCtxSharedKeysListId);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecPtrListInitialize(sharedKeys)", NULL);
+        xmlSecPtrListFinalize(&items);
+        return(-1);
+    }
+
+    /* find and read all the nodes, resolve the keys */
+    encCtx->operation = xmlSecTransformOperationDecrypt;
+    xmlSecAddIDs(node->doc, node, xmlSecEncIds);
+
+    ret = xmlSecEncCtxDecryptAllFindNodes(node, &items);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecEncCtxDecryptAllFindNodes", NULL);
+        goto done;
+    }
+    size = xmlSecPtrListGetSize(&items);
+    for(ii = 0; ii < size; ++ii) {
+        item = (xmlSecEncCtxDecryptAllItemPtr)xmlSecPtrListGetItem(&items, ii);
+        if(item == NULL) {
+            xmlSecInternalError("xmlSecPtrListGetItem", NULL);
+            goto done;
+        }
+
+        ret = xmlSecEncCtxDecryptAllItemRead(encCtx, item, &sharedKeys);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecEncCtxDecryptAllItemRead",
+                                xmlSecNodeGetName(item->node));
+            goto done;
+        }
+    }
+
+    /* decrypt */
+    ret = xmlSecParallelRun(xmlSecEncCtxDecryptAllTask, &items, size, threadsNum);
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecParallelRun", NULL);
+        goto done;
+    }
+
+    /* parse the decrypted data before changing the document */
+    for(ii = 0; ii < size; ++ii) {
+        item = (xmlSecEncCtxDecryptAllItemPtr)xmlSecPtrListGetItem(&items, ii);
+        if((item == NULL) || (item->encCtx == NULL) || (item->encCtx->result == NULL)) {
+            xmlSecInternalError("xmlSecPtrListGetItem", NULL);
+            goto done;
+        }
+
+        ret = xmlSecEncCtxDecryptAllItemParse(item);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecEncCtxDecryptAllItemParse",
+                                xmlSecNodeGetName(item->node));
+            goto done;
+        }
+    }
+
+    /* and finally update the document in the document order */
+    for(ii = 0; ii < size; ++ii) {
+        item = (xmlSecEncCtxDecryptAllItemPtr)xmlSecPtrListGetItem(&items, ii);
+        if((encCtx->flags & XMLSEC_ENC_RETURN_REPLACED_NODE) != 0) {
+            replacedNode = NULL;
+            xmlSecEncCtxDecryptAllItemReplace(item, &replacedNode);
+            xmlSecEncCtxAppendReplacedNodes(encCtx, &replacedNodeLast, replacedNode);
+        } else {
+            xmlSecEncCtxDecryptAllItemReplace(item, NULL);
+        }
+        encCtx->resultReplaced = 1;
+    }
+
+    /* success */
+    res = 0;
+
+done:
+    xmlSecPtrListFinalize(&sharedKeys);
+    xmlSecPtrListFinalize(&items);
+    return(res);
+}
+
 static int
 xmlSecEncCtxEncDataNodeRead(xmlSecEncCtxPtr encCtx, xmlNodePtr node) {
     xmlNodePtr cur;
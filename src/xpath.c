@@ -404,11 +404,39 @@ xmlSecTransformXPathFinalize(xmlSecTransformPtr transform) {
     xmlSecPtrListFinalize(dataList);
 }
 
+/* nodes sets with a few explicit nodes (e.g. XPointer id() results) are
+ * cheap to check directly, numbering the whole document is not */
+#define XMLSEC_XPATH_MATERIALIZE_NODES_MIN      16
+
+static int
+xmlSecTransformXPathNeedsMaterialize(xmlSecNodeSetPtr nset) {
+    xmlSecNodeSetPtr cur;
+    int nodesNum = 0;
+
+    xmlSecAssert2(nset != NULL, 0);
+
+    cur = nset;
+    do {
+        if(cur->type == xmlSecNodeSetList) {
+            return(1);
+        }
+        if(cur->nodes != NULL) {
+            nodesNum += xmlXPathNodeSetGetLength(cur->nodes);
+            if(nodesNum >= XMLSEC_XPATH_MATERIALIZE_NODES_MIN) {
+                return(1);
+            }
+        }
+        cur = cur->next;
+    } while(cur != nset);
+    return(0);
+}
+
 static int
 xmlSecTransformXPathExecute(xmlSecTransformPtr transform, int last,
                             xmlSecTransformCtxPtr transformCtx) {
     xmlSecPtrListPtr dataList;
     xmlDocPtr doc;
+    int ret;
 
     xmlSecAssert2(xmlSecTransformXPathCheckId(transform), -1);
     xmlSecAssert2(transform->hereNode != NULL, -1);
@@ -430,6 +458,18 @@ xmlSecTransformXPathExecute(xmlSecTransformPtr transform, int last,
                             xmlSecTransformGetName(transform));
         return(-1);
     }
+
+    /* XPath results are lists of nodes sets with explicit nodes combined with
+     * set operations, evaluate them once for the whole document instead of
+     * walking the list and scanning the nodes for each node */
+    if(xmlSecTransformXPathNeedsMaterialize(transform->outNodes)) {
+        ret = xmlSecNodeSetMaterialize(transform->outNodes);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecNodeSetMaterialize",
+                                xmlSecTransformGetName(transform));
+            return(-1);
+        }
+    }
     return(0);
 }
 
@@ -482,9 +482,10 @@ xmlSecXslProcess(xmlSecXsltCtxPtr ctx, xmlSecBufferPtr in, xmlSecBufferPtr out)
         goto done;
     }
 
-    output = xmlSecBufferCreateOutputBuffer(out);
+    /* the result is usually about the size of the input */
+    output = xmlSecBufferCreateOutputBufferWithSizeHint(out, xmlSecBufferGetSize(in));
     if(output == NULL) {
-        xmlSecInternalError("xmlSecBufferCreateOutputBuffer", NULL);
+        xmlSecInternalError("xmlSecBufferCreateOutputBufferWithSizeHint", NULL);
         goto done;
     }
 
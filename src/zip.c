@@ -0,0 +1,936 @@
+/*
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * Simple ZIP archive reader: only the central directory is loaded in
+ * memory, the entries data is read (and inflated) on demand.
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2024 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#include "globals.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libxml/tree.h>
+
+#ifndef XMLSEC_NO_ZLIB
+#include <zlib.h>
+#endif /* XMLSEC_NO_ZLIB */
+
+#include <xmlsec/xmlsec.h>
+#include <xmlsec/errors.h>
+#include <xmlsec/private.h>
+
+#include "cast_helpers.h"
+#include "zip_helpers.h"
+
+/**************************************************************************
+ *
+ * ZIP format (https://pkware.cachefly.net/webdocs/casestudies/APPNOTE.TXT):
+ * the archive ends with the "end of central directory" record (optionally
+ * preceded by the ZIP64 locator and record) that points to the central
+ * directory with one header per entry. Each header points to the local
+ * file header followed by the entry data.
+ *
+ * Not supported: multi-disk archives and encrypted entries.
+ *
+ *************************************************************************/
+#define XMLSEC_ZIP_EOCD_SIGNATURE               0x06054b50UL
+#define XMLSEC_ZIP_EOCD_SIZE                    22
+#define XMLSEC_ZIP_EOCD_MAX_COMMENT_SIZE        0xFFFF
+#define XMLSEC_ZIP64_LOCATOR_SIGNATURE          0x07064b50UL
+#define XMLSEC_ZIP64_LOCATOR_SIZE               20
+#define XMLSEC_ZIP64_EOCD_SIGNATURE             0x06064b50UL
+#define XMLSEC_ZIP64_EOCD_SIZE                  56
+#define XMLSEC_ZIP64_EXTRA_ID                   0x0001
+#define XMLSEC_ZIP_CD_HEADER_SIGNATURE          0x02014b50UL
+#define XMLSEC_ZIP_CD_HEADER_SIZE               46
+#define XMLSEC_ZIP_LOCAL_HEADER_SIGNATURE       0x04034b50UL
+#define XMLSEC_ZIP_LOCAL_HEADER_SIZE            30
+
+#define XMLSEC_ZIP_FLAGS_ENCRYPTED              0x0001
+#define XMLSEC_ZIP_METHOD_STORED                0
+#define XMLSEC_ZIP_METHOD_DEFLATED              8
+#define XMLSEC_ZIP_DEFLATE_MAX_RATIO            1032
+
+#define XMLSEC_ZIP_UINT16_MAX                   0xFFFFU
+#define XMLSEC_ZIP_UINT32_MAX                   0xFFFFFFFFUL
+
+#define XMLSEC_ZIP_INPUT_BUFFER_SIZE            16384
+
+struct _xmlSecZipArchive {
+    char*               filename;
+    xmlSecSize          fileSize;
+    xmlSecZipEntryPtr   entries;
+    xmlSecSize          entriesNum;
+    xmlSecZipEntryPtr*  sorted;
+#ifdef XMLSEC_NO_ZLIB
+    unsigned long       crcTable[256];
+#endif /* XMLSEC_NO_ZLIB */
+};
+
+struct _xmlSecZipReader {
+    xmlSecZipArchivePtr zip;
+    xmlSecZipEntryPtr   entry;
+    FILE*               file;
+    xmlSecSize          inLeft;
+    xmlSecSize          outSize;
+    unsigned long       crc32;
+    int                 done;
+#ifndef XMLSEC_NO_ZLIB
+    z_stream            strm;
+    int                 strmInitialized;
+    xmlSecByte          inBuf[XMLSEC_ZIP_INPUT_BUFFER_SIZE];
+#endif /* XMLSEC_NO_ZLIB */
+};
+
+static unsigned int
+xmlSecZipGetUInt16(const xmlSecByte* p) {
+    return(((unsigned int)p[0]) | (((unsigned int)p[1]) << 8));
+}
+
+static unsigned long
+xmlSecZipGetUInt32(const xmlSecByte* p) {
+    return(((unsigned long)p[0]) | (((unsigned long)p[1]) << 8) |
+           (((unsigned long)p[2]) << 16) | (((unsigned long)p[3]) << 24));
+}
+
+static int
+xmlSecZipGetSize32(const xmlSecByte* p, xmlSecSize* res) {
+    unsigned long val;
+
+    val = xmlSecZipGetUInt32(p);
+    XMLSEC_SAFE_CAST_ULONG_TO_SIZE(val, (*res), return(-1), NULL);
+    return(0);
+}
+
+static int
+xmlSecZipGetSize64(const xmlSecByte* p, xmlSecSize* res) {
+    xmlSecSize val = 0;
+    int ii;
+
+    for(ii = 7; ii >= 0; --ii) {
+        if((val >> (8 * sizeof(xmlSecSize) - 8)) != 0) {
+            xmlSecInvalidDataError("ZIP64 value is too large", NULL);
+            return(-1);
+        }
+        val = (val << 8) | p[ii];
+    }
+    (*res) = val;
+    return(0);
+}
+
+static int
+xmlSecZipFileRead(FILE* file, xmlSecSize offset, xmlSecByte* buf, xmlSecSize size) {
+    long pos;
+
+    XMLSEC_SAFE_CAST_SIZE_TO_LONG(offset, pos, return(-1), NULL);
+    if(fseek(file, pos, SEEK_SET) != 0) {
+        xmlSecIOError("fseek", NULL, NULL);
+        return(-1);
+    }
+    if((size > 0) && (fread(buf, 1, size, file) != size)) {
+        xmlSecIOError("fread", NULL, NULL);
+        return(-1);
+    }
+    return(0);
+}
+
+#ifdef XMLSEC_NO_ZLIB
+static void
+xmlSecZipCrc32InitTable(unsigned long* table) {
+    unsigned long crc;
+    unsigned int ii, jj;
+
+    for(ii = 0; ii < 256; ++ii) {
+        crc = ii;
+        for(jj = 0; jj < 8; ++jj) {
+            crc = ((crc & 1) != 0) ? (0xEDB88320UL ^ (crc >> 1)) : (crc >> 1);
+        }
+        table[ii] = crc;
+    }
+}
+#endif /* XMLSEC_NO_ZLIB */
+
+static int
+xmlSecZipCrc32Update(xmlSecZipArchivePtr zip, unsigned long* crc, const xmlSecByte* buf, xmlSecSize size) {
+#ifndef XMLSEC_NO_ZLIB
+    uInt len;
+
+    UNREFERENCED_PARAMETER(zip);
+
+    XMLSEC_SAFE_CAST_SIZE_TO_UINT(size, len, return(-1), NULL);
+    (*crc) = crc32((*crc), buf, len);
+#else  /* XMLSEC_NO_ZLIB */
+    unsigned long val = (*crc) ^ XMLSEC_ZIP_UINT32_MAX;
+    xmlSecSize ii;
+
+    for(ii = 0; ii < size; ++ii) {
+        val = zip->crcTable[(val ^ buf[ii]) & 0xFF] ^ (val >> 8);
+    }
+    (*crc) = val ^ XMLSEC_ZIP_UINT32_MAX;
+#endif /* XMLSEC_NO_ZLIB */
+    return(0);
+}
+
+/**************************************************************************
+ *
+ * Archive
+ *
+ *************************************************************************/
+static int
+xmlSecZipEntryCmp(const void* a, const void* b) {
+    return(xmlStrcasecmp((*(const xmlSecZipEntryPtr*)a)->name, (*(const xmlSecZipEntryPtr*)b)->name));
+}
+
+/* finds the central directory */
+static int
+xmlSecZipArchiveReadEnd(xmlSecZipArchivePtr zip, FILE* file, xmlSecSize* cdOffset,
+                        xmlSecSize* cdSize, xmlSecSize* entriesNum) {
+    xmlSecByte* buf;
+    xmlSecSize bufSize, bufOffset, pos;
+    xmlSecByte zip64[XMLSEC_ZIP64_EOCD_SIZE];
+    xmlSecSize zip64Offset;
+    const xmlSecByte* eocd = NULL;
+    int res = -1;
+
+    xmlSecAssert2(zip != NULL, -1);
+    xmlSecAssert2(file != NULL, -1);
+    xmlSecAssert2(cdOffset != NULL, -1);
+    xmlSecAssert2(cdSize != NULL, -1);
+    xmlSecAssert2(entriesNum != NULL, -1);
+
+    if(zip->fileSize < XMLSEC_ZIP_EOCD_SIZE) {
+        xmlSecInvalidDataError("ZIP archive is too small", NULL);
+        return(-1);
+    }
+
+    /* the end of central directory record is followed by the comment */
+    bufSize = XMLSEC_ZIP_EOCD_SIZE + XMLSEC_ZIP_EOCD_MAX_COMMENT_SIZE + XMLSEC_ZIP64_LOCATOR_SIZE;
+    if(bufSize > zip->fileSize) {
+        bufSize = zip->fileSize;
+    }
+    bufOffset = zip->fileSize - bufSize;
+    buf = (xmlSecByte*)xmlMalloc(bufSize);
+    if(buf == NULL) {
+        xmlSecMallocError(bufSize, NULL);
+        return(-1);
+    }
+    if(xmlSecZipFileRead(file, bufOffset, buf, bufSize) < 0) {
+        xmlSecInternalError("xmlSecZipFileRead", NULL);
+        goto done;
+    }
+
+    pos = bufSize - XMLSEC_ZIP_EOCD_SIZE + 1;
+    while(pos > 0) {
+        --pos;
+        if((xmlSecZipGetUInt32(buf + pos) == XMLSEC_ZIP_EOCD_SIGNATURE) &&
+           (pos + XMLSEC_ZIP_EOCD_SIZE + xmlSecZipGetUInt16(buf + pos + 20) <= bufSize)) {
+            eocd = buf + pos;
+            break;
+        }
+    }
+    if(eocd == NULL) {
+        xmlSecInvalidDataError("ZIP end of central directory record is not found", NULL);
+        goto done;
+    }
+    if((xmlSecZipGetUInt16(eocd + 4) != 0) || (xmlSecZipGetUInt16(eocd + 6) != 0)) {
+        xmlSecNotImplementedError("multi-disk ZIP archives");
+        goto done;
+    }
+    (*entriesNum) = xmlSecZipGetUInt16(eocd + 10);
+    if((xmlSecZipGetSize32(eocd + 12, cdSize) < 0) || (xmlSecZipGetSize32(eocd + 16, cdOffset) < 0)) {
+        xmlSecInternalError("xmlSecZipGetSize32", NULL);
+        goto done;
+    }
+
+    /* ZIP64 */
+    if(((*entriesNum) == XMLSEC_ZIP_UINT16_MAX) ||
+       (xmlSecZipGetUInt32(eocd + 12) == XMLSEC_ZIP_UINT32_MAX) ||
+       (xmlSecZipGetUInt32(eocd + 16) == XMLSEC_ZIP_UINT32_MAX))
+    {
+        if((pos < XMLSEC_ZIP64_LOCATOR_SIZE) ||
+           (xmlSecZipGetUInt32(eocd - XMLSEC_ZIP64_LOCATOR_SIZE) != XMLSEC_ZIP64_LOCATOR_SIGNATURE)) {
+            xmlSecInvalidDataError("ZIP64 end of central directory locator is not found", NULL);
+            goto done;
+        }
+        if(xmlSecZipGetSize64(eocd - XMLSEC_ZIP64_LOCATOR_SIZE + 8, &zip64Offset) < 0) {
+            xmlSecInternalError("xmlSecZipGetSize64", NULL);
+            goto done;
+        }
+        if((zip64Offset > zip->fileSize) || (zip->fileSize - zip64Offset < sizeof(zip64)) ||
+           (xmlSecZipFileRead(file, zip64Offset, zip64, sizeof(zip64)) < 0) ||
+           (xmlSecZipGetUInt32(zip64) != XMLSEC_ZIP64_EOCD_SIGNATURE)) {
+            xmlSecInvalidDataError("ZIP64 end of central directory record is invalid", NULL);
+            goto done;
+        }
+        if((xmlSecZipGetSize64(zip64 + 32, entriesNum) < 0) ||
+           (xmlSecZipGetSize64(zip64 + 40, cdSize) < 0) ||
+           (xmlSecZipGetSize64(zip64 + 48, cdOffset) < 0)) {
+            xmlSecInternalError("xmlSecZipGetSize64", NULL);
+            goto done;
+        }
+    }
+
+    if(((*cdOffset) > zip->fileSize) || ((*cdSize) > zip->fileSize - (*cdOffset)) ||
+       ((*entriesNum) > (*cdSize) / XMLSEC_ZIP_CD_HEADER_SIZE)) {
+        xmlSecInvalidDataError("ZIP central directory is invalid", NULL);
+        goto done;
+    }
+
+    /* success */
+    res = 0;
+
+done:
+    xmlFree(buf);
+    return(res);
+}
+
+/* reads the ZIP64 extended information extra field */
+static int
+xmlSecZipEntryReadZip64Extra(xmlSecZipEntryPtr entry, const xmlSecByte* extra, xmlSecSize extraSize,
+                             int needSize, int needCompressedSize, int needOffset) {
+    xmlSecSize id, size, pos;
+
+    xmlSecAssert2(entry != NULL, -1);
+
+    while(extraSize >= 4) {
+        id = xmlSecZipGetUInt16(extra);
+        size = xmlSecZipGetUInt16(extra + 2);
+        if(size > extraSize - 4) {
+            break;
+        }
+        if(id == XMLSEC_ZIP64_EXTRA_ID) {
+            pos = 4;
+            if(needSize) {
+                if((pos + 8 > size + 4) || (xmlSecZipGetSize64(extra + pos, &(entry->size)) < 0)) {
+                    break;
+                }
+                pos += 8;
+            }
+            if(needCompressedSize) {
+                if((pos + 8 > size + 4) || (xmlSecZipGetSize64(extra + pos, &(entry->compressedSize)) < 0)) {
+                    break;
+                }
+                pos += 8;
+            }
+            if(needOffset) {
+                if((pos + 8 > size + 4) || (xmlSecZipGetSize64(extra + pos, &(entry->offset)) < 0)) {
+                    break;
+                }
+            }
+            return(0);
+        }
+        extra += 4 + size;
+        extraSize -= 4 + size;
+    }
+
+    xmlSecInvalidDataError("ZIP64 extra field is not found or invalid", NULL);
+    return(-1);
+}
+
+static int
+xmlSecZipArchiveReadCentralDirectory(xmlSecZipArchivePtr zip, const xmlSecByte* cd,
+                                     xmlSecSize cdSize, xmlSecSize entriesNum) {
+    xmlSecZipEntryPtr entry;
+    xmlSecSize nameLen, extraLen, commentLen;
+    xmlSecSize ii, pos = 0;
+    int nameLenInt;
+    int ret;
+
+    xmlSecAssert2(zip != NULL, -1);
+    xmlSecAssert2(zip->entries == NULL, -1);
+    xmlSecAssert2(cd != NULL, -1);
+
+    if(entriesNum == 0) {
+        return(0);
+    }
+
+    zip->entries = (xmlSecZipEntryPtr)xmlMalloc(sizeof(xmlSecZipEntry) * entriesNum);
+    if(zip->entries == NULL) {
+        xmlSecMallocError(sizeof(xmlSecZipEntry) * entriesNum, NULL);
+        return(-1);
+    }
+    memset(zip->entries, 0, sizeof(xmlSecZipEntry) * entriesNum);
+
+    for(ii = 0; ii < entriesNum; ++ii) {
+        if((cdSize - pos < XMLSEC_ZIP_CD_HEADER_SIZE) ||
+           (xmlSecZipGetUInt32(cd + pos) != XMLSEC_ZIP_CD_HEADER_SIGNATURE)) {
+            xmlSecInvalidDataError("ZIP central directory header is invalid", NULL);
+            return(-1);
+        }
+
+        entry = &(zip->entries[ii]);
+        entry->flags  = xmlSecZipGetUInt16(cd + pos + 8);
+        entry->method = xmlSecZipGetUInt16(cd + pos + 10);
+        entry->crc32  = xmlSecZipGetUInt32(cd + pos + 16);
+        nameLen       = xmlSecZipGetUInt16(cd + pos + 28);
+        extraLen      = xmlSecZipGetUInt16(cd + pos + 30);
+        commentLen    = xmlSecZipGetUInt16(cd + pos + 32);
+        if((xmlSecZipGetSize32(cd + pos + 20, &(entry->compressedSize)) < 0) ||
+           (xmlSecZipGetSize32(cd + pos + 24, &(entry->size)) < 0) ||
+           (xmlSecZipGetSize32(cd + pos + 42, &(entry->offset)) < 0)) {
+            xmlSecInternalError("xmlSecZipGetSize32", NULL);
+            return(-1);
+        }
+        if(cdSize - pos - XMLSEC_ZIP_CD_HEADER_SIZE < nameLen + extraLen + commentLen) {
+            xmlSecInvalidDataError("ZIP central directory header is truncated", NULL);
+            return(-1);
+        }
+
+        if((xmlSecZipGetUInt32(cd + pos + 20) == XMLSEC_ZIP_UINT32_MAX) ||
+           (xmlSecZipGetUInt32(cd + pos + 24) == XMLSEC_ZIP_UINT32_MAX) ||
+           (xmlSecZipGetUInt32(cd + pos + 42) == XMLSEC_ZIP_UINT32_MAX))
+        {
+            ret = xmlSecZipEntryReadZip64Extra(entry,
+                cd + pos + XMLSEC_ZIP_CD_HEADER_SIZE + nameLen, extraLen,
+                (xmlSecZipGetUInt32(cd + pos + 24) == XMLSEC_ZIP_UINT32_MAX),
+                (xmlSecZipGetUInt32(cd + pos + 20) == XMLSEC_ZIP_UINT32_MAX),
+                (xmlSecZipGetUInt32(cd + pos + 42) == XMLSEC_ZIP_UINT32_MAX));
+            if(ret < 0) {
+                xmlSecInternalError("xmlSecZipEntryReadZip64Extra", NULL);
+                return(-1);
+            }
+        }
+
+        XMLSEC_SAFE_CAST_SIZE_TO_INT(nameLen, nameLenInt, return(-1), NULL);
+        entry->name = xmlStrndup(cd + pos + XMLSEC_ZIP_CD_HEADER_SIZE, nameLenInt);
+        if(entry->name == NULL) {
+            xmlSecStrdupError(cd + pos + XMLSEC_ZIP_CD_HEADER_SIZE, NULL);
+            return(-1);
+        }
+        if(xmlStrlen(entry->name) != nameLenInt) {
+            xmlSecInvalidDataError("ZIP entry name has zero byte", NULL);
+            return(-1);
+        }
+
+        pos += XMLSEC_ZIP_CD_HEADER_SIZE + nameLen + extraLen + commentLen;
+        ++(zip->entriesNum);
+    }
+
+    /* sort entries by name for lookups */
+    zip->sorted = (xmlSecZipEntryPtr*)xmlMalloc(sizeof(xmlSecZipEntryPtr) * zip->entriesNum);
+    if(zip->sorted == NULL) {
+        xmlSecMallocError(sizeof(xmlSecZipEntryPtr) * zip->entriesNum, NULL);
+        return(-1);
+    }
+    for(ii = 0; ii < zip->entriesNum; ++ii) {
+        zip->sorted[ii] = &(zip->entries[ii]);
+    }
+    qsort(zip->sorted, zip->entriesNum, sizeof(xmlSecZipEntryPtr), xmlSecZipEntryCmp);
+
+    /* the lookups are case-insensitive thus the names that differ only
+     * in case are duplicates too */
+    for(ii = 1; ii < zip->entriesNum; ++ii) {
+        if(xmlStrcasecmp(zip->sorted[ii - 1]->name, zip->sorted[ii]->name) == 0) {
+            xmlSecOtherError2(XMLSEC_ERRORS_R_INVALID_DATA, NULL,
+                "duplicate ZIP entry name; name=%s", xmlSecErrorsSafeString(zip->sorted[ii]->name));
+            return(-1);
+        }
+    }
+    return(0);
+}
+
+/**
+ * xmlSecZipArchiveOpen:
+ * @filename:           the ZIP archive filename.
+ *
+ * Opens the ZIP archive and reads its central directory. The entries
+ * data is not read until #xmlSecZipReaderCreate is called.
+ *
+ * Returns: the pointer to the archive or NULL if an error occurs.
+ */
+xmlSecZipArchivePtr
+xmlSecZipArchiveOpen(const char* filename) {
+    xmlSecZipArchivePtr zip = NULL;
+    xmlSecByte* cd = NULL;
+    xmlSecSize cdOffset = 0, cdSize = 0, entriesNum = 0;
+    FILE* file;
+    long pos;
+    int ret;
+
+    xmlSecAssert2(filename != NULL, NULL);
+
+    file = fopen(filename, "rb");
+    if(file == NULL) {
+        xmlSecIOError("fopen", filename, NULL);
+        return(NULL);
+    }
+
+    zip = (xmlSecZipArchivePtr)xmlMalloc(sizeof(xmlSecZipArchive));
+    if(zip == NULL) {
+        xmlSecMallocError(sizeof(xmlSecZipArchive), NULL);
+        goto error;
+    }
+    memset(zip, 0, sizeof(xmlSecZipArchive));
+#ifdef XMLSEC_NO_ZLIB
+    xmlSecZipCrc32InitTable(zip->crcTable);
+#endif /* XMLSEC_NO_ZLIB */
+
+    zip->filename = (char*)xmlStrdup(BAD_CAST filename);
+    if(zip->filename == NULL) {
+        xmlSecStrdupError(BAD_CAST filename, NULL);
+        goto error;
+    }
+
+    if(fseek(file, 0, SEEK_END) != 0) {
+        xmlSecIOError("fseek", filename, NULL);
+        goto error;
+    }
+    pos = ftell(file);
+    if(pos < 0) {
+        xmlSecIOError("ftell", filename, NULL);
+        goto error;
+    }
+    XMLSEC_SAFE_CAST_LONG_TO_SIZE(pos, zip->fileSize, goto error, NULL);
+
+    ret = xmlSecZipArchiveReadEnd(zip, file, &cdOffset, &cdSize, &entriesNum);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecZipArchiveReadEnd", NULL,
+            "filename=%s", xmlSecErrorsSafeString(filename));
+        goto error;
+    }
+
+    if(cdSize > 0) {
+        cd = (xmlSecByte*)xmlMalloc(cdSize);
+        if(cd == NULL) {
+            xmlSecMallocError(cdSize, NULL);
+            goto error;
+        }
+        ret = xmlSecZipFileRead(file, cdOffset, cd, cdSize);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecZipFileRead", NULL);
+            goto error;
+        }
+    }
+    ret = xmlSecZipArchiveReadCentralDirectory(zip, cd, cdSize, entriesNum);
+    if(ret < 0) {
+        xmlSecInternalError2("xmlSecZipArchiveReadCentralDirectory", NULL,
+            "filename=%s", xmlSecErrorsSafeString(filename));
+        goto error;
+    }
+
+    if(cd != NULL) {
+        xmlFree(cd);
+    }
+    fclose(file);
+    return(zip);
+
+error:
+    if(cd != NULL) {
+        xmlFree(cd);
+    }
+    if(zip != NULL) {
+        xmlSecZipArchiveClose(zip);
+    }
+    fclose(file);
+    return(NULL);
+}
+
+/**
+ * xmlSecZipArchiveClose:
+ * @zip:                the pointer to ZIP archive.
+ *
+ * Closes the ZIP archive. All the readers for the archive entries
+ * should be destroyed before.
+ */
+void
+xmlSecZipArchiveClose(xmlSecZipArchivePtr zip) {
+    xmlSecSize ii;
+
+    xmlSecAssert(zip != NULL);
+
+    if(zip->entries != NULL) {
+        for(ii = 0; ii < zip->entriesNum; ++ii) {
+            if(zip->entries[ii].name != NULL) {
+                xmlFree(zip->entries[ii].name);
+            }
+        }
+        xmlFree(zip->entries);
+    }
+    if(zip->sorted != NULL) {
+        xmlFree(zip->sorted);
+    }
+    if(zip->filename != NULL) {
+        xmlFree(zip->filename);
+    }
+    memset(zip, 0, sizeof(xmlSecZipArchive));
+    xmlFree(zip);
+}
+
+/**
+ * xmlSecZipArchiveGetSize:
+ * @zip:                the pointer to ZIP archive.
+ *
+ * Gets the number of entries in the archive.
+ *
+ * Returns: the number of entries in the archive.
+ */
+xmlSecSize
+xmlSecZipArchiveGetSize(xmlSecZipArchivePtr zip) {
+    xmlSecAssert2(zip != NULL, 0);
+    return(zip->entriesNum);
+}
+
+/**
+ * xmlSecZipArchiveGetEntry:
+ * @zip:                the pointer to ZIP archive.
+ * @pos:                the entry position.
+ *
+ * Gets the entry at @pos in the central directory order.
+ *
+ * Returns: the entry or NULL if an error occurs.
+ */
+xmlSecZipEntryPtr
+xmlSecZipArchiveGetEntry(xmlSecZipArchivePtr zip, xmlSecSize pos) {
+    xmlSecAssert2(zip != NULL, NULL);
+    xmlSecAssert2(pos < zip->entriesNum, NULL);
+
+    return(&(zip->entries[pos]));
+}
+
+/**
+ * xmlSecZipArchiveFindEntry:
+ * @zip:                the pointer to ZIP archive.
+ * @name:               the entry name.
+ *
+ * Finds the entry with @name (ASCII case-insensitive).
+ *
+ * Returns: the entry or NULL if it is not found.
+ */
+xmlSecZipEntryPtr
+xmlSecZipArchiveFindEntry(xmlSecZipArchivePtr zip, const xmlChar* name) {
+    xmlSecSize lo, hi, mid;
+    int ret;
+
+    xmlSecAssert2(zip != NULL, NULL);
+    xmlSecAssert2(name != NULL, NULL);
+
+    lo = 0;
+    hi = zip->entriesNum;
+    while(lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        ret = xmlStrcasecmp(zip->sorted[mid]->name, name);
+        if(ret == 0) {
+            return(zip->sorted[mid]);
+        } else if(ret < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return(NULL);
+}
+
+/**
+ * xmlSecZipEntryGetSizeHint:
+ * @entry:              the archive entry.
+ *
+ * Gets the @entry uncompressed size from the central directory if it is
+ * consistent with the compressed data size: the stored entries sizes should
+ * match and deflate can't compress the data more than 1032 times. The result
+ * can be used only as a hint: the actual data size is checked by the reader.
+ *
+ * Returns: the declared uncompressed size or 0 if it is not consistent.
+ */
+xmlSecSize
+xmlSecZipEntryGetSizeHint(xmlSecZipEntryPtr entry) {
+    xmlSecAssert2(entry != NULL, 0);
+
+    switch(entry->method) {
+    case XMLSEC_ZIP_METHOD_STORED:
+        if(entry->compressedSize != entry->size) {
+            return(0);
+        }
+        return(entry->size);
+    case XMLSEC_ZIP_METHOD_DEFLATED:
+        if((entry->size == 0) || ((entry->size - 1) / XMLSEC_ZIP_DEFLATE_MAX_RATIO >= entry->compressedSize)) {
+            return(0);
+        }
+        return(entry->size);
+    default:
+        return(0);
+    }
+}
+
+/**************************************************************************
+ *
+ * Entry reader
+ *
+ *************************************************************************/
+/**
+ * xmlSecZipReaderCreate:
+ * @zip:                the pointer to ZIP archive.
+ * @entry:              the archive entry.
+ *
+ * Creates the reader for the @entry data. The reader has its own file
+ * handle thus the readers for different entries can be used from
+ * different threads.
+ *
+ * Returns: the pointer to the reader or NULL if an error occurs.
+ */
+xmlSecZipReaderPtr
+xmlSecZipReaderCreate(xmlSecZipArchivePtr zip, xmlSecZipEntryPtr entry) {
+    xmlSecZipReaderPtr reader;
+    xmlSecByte header[XMLSEC_ZIP_LOCAL_HEADER_SIZE];
+    xmlSecByte* name = NULL;
+    xmlSecSize nameLen, dataOffset;
+    long pos;
+    int ret;
+
+    xmlSecAssert2(zip != NULL, NULL);
+    xmlSecAssert2(zip->filename != NULL, NULL);
+    xmlSecAssert2(entry != NULL, NULL);
+
+    if((entry->flags & XMLSEC_ZIP_FLAGS_ENCRYPTED) != 0) {
+        xmlSecNotImplementedError("encrypted ZIP entries");
+        return(NULL);
+    }
+    switch(entry->method) {
+    case XMLSEC_ZIP_METHOD_STORED:
+        if(entry->compressedSize != entry->size) {
+            xmlSecInvalidSizeError("ZIP stored entry size", entry->compressedSize, entry->size, NULL);
+            return(NULL);
+        }
+        break;
+#ifndef XMLSEC_NO_ZLIB
+    case XMLSEC_ZIP_METHOD_DEFLATED:
+        break;
+#endif /* XMLSEC_NO_ZLIB */
+    default:
+        xmlSecOtherError2(XMLSEC_ERRORS_R_NOT_IMPLEMENTED, NULL,
+            "ZIP compression method=%u", entry->method);
+        return(NULL);
+    }
+
+    reader = (xmlSecZipReaderPtr)xmlMalloc(sizeof(xmlSecZipReader));
+    if(reader == NULL) {
+        xmlSecMallocError(sizeof(xmlSecZipReader), NULL);
+        return(NULL);
+    }
+    memset(reader, 0, sizeof(xmlSecZipReader));
+    reader->zip    = zip;
+    reader->entry  = entry;
+    reader->inLeft = entry->compressedSize;
+
+    reader->file = fopen(zip->filename, "rb");
+    if(reader->file == NULL) {
+        xmlSecIOError("fopen", zip->filename, NULL);
+        goto error;
+    }
+
+    /* skip the local file header: the extra fields might be different
+     * from the central directory but the name should be the same */
+    if((entry->offset > zip->fileSize) || (zip->fileSize - entry->offset < sizeof(header))) {
+        xmlSecInvalidDataError("ZIP local file header offset is invalid", NULL);
+        goto error;
+    }
+    ret = xmlSecZipFileRead(reader->file, entry->offset, header, sizeof(header));
+    if((ret < 0) || (xmlSecZipGetUInt32(header) != XMLSEC_ZIP_LOCAL_HEADER_SIGNATURE)) {
+        xmlSecInvalidDataError("ZIP local file header is invalid", NULL);
+        goto error;
+    }
+    nameLen = xmlSecZipGetUInt16(header + 26);
+    if((nameLen != xmlSecStrlen(entry->name)) || (zip->fileSize - entry->offset - sizeof(header) < nameLen)) {
+        xmlSecOtherError2(XMLSEC_ERRORS_R_INVALID_DATA, NULL,
+            "ZIP local file header name mismatch; name=%s", xmlSecErrorsSafeString(entry->name));
+        goto error;
+    }
+    if(nameLen > 0) {
+        name = (xmlSecByte*)xmlMalloc(nameLen);
+        if(name == NULL) {
+            xmlSecMallocError(nameLen, NULL);
+            goto error;
+        }
+        ret = xmlSecZipFileRead(reader->file, entry->offset + sizeof(header), name, nameLen);
+        if((ret < 0) || (memcmp(name, entry->name, nameLen) != 0)) {
+            xmlSecOtherError2(XMLSEC_ERRORS_R_INVALID_DATA, NULL,
+                "ZIP local file header name mismatch; name=%s", xmlSecErrorsSafeString(entry->name));
+            goto error;
+        }
+        xmlFree(name);
+        name = NULL;
+    }
+    dataOffset = entry->offset + sizeof(header) + nameLen + xmlSecZipGetUInt16(header + 28);
+    if((dataOffset > zip->fileSize) || (zip->fileSize - dataOffset < entry->compressedSize)) {
+        xmlSecInvalidDataError("ZIP entry data is truncated", NULL);
+        goto error;
+    }
+    XMLSEC_SAFE_CAST_SIZE_TO_LONG(dataOffset, pos, goto error, NULL);
+    if(fseek(reader->file, pos, SEEK_SET) != 0) {
+        xmlSecIOError("fseek", zip->filename, NULL);
+        goto error;
+    }
+
+#ifndef XMLSEC_NO_ZLIB
+    if(entry->method == XMLSEC_ZIP_METHOD_DEFLATED) {
+        /* raw deflate data without zlib header */
+        ret = inflateInit2(&(reader->strm), -MAX_WBITS);
+        if(ret != Z_OK) {
+            xmlSecInternalError2("inflateInit2", NULL, "ret=%d", ret);
+            goto error;
+        }
+        reader->strmInitialized = 1;
+    }
+#endif /* XMLSEC_NO_ZLIB */
+
+    return(reader);
+
+error:
+    if(name != NULL) {
+        xmlFree(name);
+    }
+    xmlSecZipReaderDestroy(reader);
+    return(NULL);
+}
+
+/**
+ * xmlSecZipReaderDestroy:
+ * @reader:             the pointer to ZIP entry reader.
+ *
+ * Destroys the reader.
+ */
+void
+xmlSecZipReaderDestroy(xmlSecZipReaderPtr reader) {
+    xmlSecAssert(reader != NULL);
+
+#ifndef XMLSEC_NO_ZLIB
+    if(reader->strmInitialized) {
+        inflateEnd(&(reader->strm));
+    }
+#endif /* XMLSEC_NO_ZLIB */
+    if(reader->file != NULL) {
+        fclose(reader->file);
+    }
+    memset(reader, 0, sizeof(xmlSecZipReader));
+    xmlFree(reader);
+}
+
+#ifndef XMLSEC_NO_ZLIB
+static int
+xmlSecZipReaderInflate(xmlSecZipReaderPtr reader, xmlSecByte* buf, xmlSecSize bufSize, xmlSecSize* readSize) {
+    xmlSecSize inSize;
+    uInt len;
+    int ret;
+
+    xmlSecAssert2(reader != NULL, -1);
+    xmlSecAssert2(reader->strmInitialized, -1);
+    xmlSecAssert2(buf != NULL, -1);
+    xmlSecAssert2(readSize != NULL, -1);
+
+    if(bufSize > UINT_MAX) {
+        bufSize = UINT_MAX;
+    }
+    XMLSEC_SAFE_CAST_SIZE_TO_UINT(bufSize, len, return(-1), NULL);
+    reader->strm.next_out  = buf;
+    reader->strm.avail_out = len;
+
+    while(reader->strm.avail_out > 0) {
+        if((reader->strm.avail_in == 0) && (reader->inLeft > 0)) {
+            inSize = (reader->inLeft < sizeof(reader->inBuf)) ? reader->inLeft : sizeof(reader->inBuf);
+            if(fread(reader->inBuf, 1, inSize, reader->file) != inSize) {
+                xmlSecIOError("fread", reader->zip->filename, NULL);
+                return(-1);
+            }
+            reader->inLeft -= inSize;
+            XMLSEC_SAFE_CAST_SIZE_TO_UINT(inSize, reader->strm.avail_in, return(-1), NULL);
+            reader->strm.next_in = reader->inBuf;
+        }
+
+        ret = inflate(&(reader->strm), Z_NO_FLUSH);
+        if(ret == Z_STREAM_END) {
+            reader->done = 1;
+            break;
+        } else if(ret != Z_OK) {
+            xmlSecInternalError3("inflate", NULL, "ret=%d; name=%s",
+                ret, xmlSecErrorsSafeString(reader->entry->name));
+            return(-1);
+        }
+    }
+
+    (*readSize) = bufSize - reader->strm.avail_out;
+    return(0);
+}
+#endif /* XMLSEC_NO_ZLIB */
+
+/**
+ * xmlSecZipReaderRead:
+ * @reader:             the pointer to ZIP entry reader.
+ * @buf:                the output buffer.
+ * @bufSize:            the output buffer size.
+ * @readSize:           the pointer to the returned data size (0 at the end of data).
+ *
+ * Reads up to @bufSize bytes of the (uncompressed) entry data. At the end
+ * of data, the data size and CRC-32 are checked against the central directory.
+ *
+ * Returns: 0 on success or a negative value if an error occurs.
+ */
+int
+xmlSecZipReaderRead(xmlSecZipReaderPtr reader, xmlSecByte* buf, xmlSecSize bufSize, xmlSecSize* readSize) {
+    int ret;
+
+    xmlSecAssert2(reader != NULL, -1);
+    xmlSecAssert2(reader->entry != NULL, -1);
+    xmlSecAssert2(reader->file != NULL, -1);
+    xmlSecAssert2(buf != NULL, -1);
+    xmlSecAssert2(bufSize > 0, -1);
+    xmlSecAssert2(readSize != NULL, -1);
+
+    (*readSize) = 0;
+    if(reader->done) {
+        return(0);
+    }
+
+    if(reader->entry->method == XMLSEC_ZIP_METHOD_STORED) {
+        (*readSize) = (reader->inLeft < bufSize) ? reader->inLeft : bufSize;
+        if(((*readSize) > 0) && (fread(buf, 1, (*readSize), reader->file) != (*readSize))) {
+            xmlSecIOError("fread", reader->zip->filename, NULL);
+            return(-1);
+        }
+        reader->inLeft -= (*readSize);
+        if(reader->inLeft == 0) {
+            reader->done = 1;
+        }
+    } else {
+#ifndef XMLSEC_NO_ZLIB
+        ret = xmlSecZipReaderInflate(reader, buf, bufSize, readSize);
+        if(ret < 0) {
+            xmlSecInternalError("xmlSecZipReaderInflate", NULL);
+            return(-1);
+        }
+#else  /* XMLSEC_NO_ZLIB */
+        xmlSecNotImplementedError("ZIP deflate compression");
+        return(-1);
+#endif /* XMLSEC_NO_ZLIB */
+    }
+
+    ret = xmlSecZipCrc32Update(reader->zip, &(reader->crc32), buf, (*readSize));
+    if(ret < 0) {
+        xmlSecInternalError("xmlSecZipCrc32Update", NULL);
+        return(-1);
+    }
+    reader->outSize += (*readSize);
+    if(reader->outSize > reader->entry->size) {
+        xmlSecInvalidSizeMoreThanError("ZIP entry data size", reader->outSize, reader->entry->size, NULL);
+        return(-1);
+    }
+
+    if(reader->done) {
+        if(reader->outSize != reader->entry->size) {
+            xmlSecInvalidSizeError("ZIP entry data size", reader->outSize, reader->entry->size, NULL);
+            return(-1);
+        }
+        if(reader->crc32 != reader->entry->crc32) {
+            xmlSecOtherError2(XMLSEC_ERRORS_R_INVALID_DATA, NULL,
+                "ZIP entry CRC-32 mismatch; name=%s", xmlSecErrorsSafeString(reader->entry->name));
+            return(-1);
+        }
+    }
+    return(0);
+}
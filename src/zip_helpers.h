@@ -0,0 +1,77 @@
+/*
+ * XML Security Library (http://www.aleksey.com/xmlsec).
+ *
+ * THIS IS A PRIVATE XMLSEC HEADER FILE
+ * DON'T USE IT IN YOUR APPLICATION
+ *
+ * Simple ZIP archive reader.
+ *
+ * This is free software; see Copyright file in the source
+ * distribution for preciese wording.
+ *
+ * Copyright (C) 2002-2024 Aleksey Sanin <aleksey@aleksey.com>. All Rights Reserved.
+ */
+#ifndef __XMLSEC_ZIP_HELPERS_H__
+#define __XMLSEC_ZIP_HELPERS_H__
+
+#ifndef XMLSEC_PRIVATE
+#error "zip_helpers.h file contains private xmlsec definitions and should not be used outside xmlsec or xmlsec-$crypto libraries"
+#endif /* XMLSEC_PRIVATE */
+
+#include <libxml/tree.h>
+
+#include <xmlsec/xmlsec.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct _xmlSecZipArchive        xmlSecZipArchive, *xmlSecZipArchivePtr;
+typedef struct _xmlSecZipReader         xmlSecZipReader, *xmlSecZipReaderPtr;
+
+/**
+ * xmlSecZipEntry:
+ * @name:               the entry name (as stored in the archive).
+ * @method:             the compression method (0 for stored or 8 for deflated).
+ * @flags:              the general purpose flags.
+ * @crc32:              the CRC-32 of the uncompressed data.
+ * @compressedSize:     the compressed data size.
+ * @size:               the uncompressed data size.
+ * @offset:             the local file header offset.
+ *
+ * The ZIP archive entry from the central directory.
+ */
+typedef struct _xmlSecZipEntry {
+    xmlChar*            name;
+    unsigned int        method;
+    unsigned int        flags;
+    unsigned long       crc32;
+    xmlSecSize          compressedSize;
+    xmlSecSize          size;
+    xmlSecSize          offset;
+} xmlSecZipEntry, *xmlSecZipEntryPtr;
+
+xmlSecZipArchivePtr     xmlSecZipArchiveOpen            (const char* filename);
+void                    xmlSecZipArchiveClose           (xmlSecZipArchivePtr zip);
+xmlSecSize              xmlSecZipArchiveGetSize         (xmlSecZipArchivePtr zip);
+xmlSecZipEntryPtr       xmlSecZipArchiveGetEntry        (xmlSecZipArchivePtr zip,
+                                                         xmlSecSize pos);
+xmlSecZipEntryPtr       xmlSecZipArchiveFindEntry       (xmlSecZipArchivePtr zip,
+                                                         const xmlChar* name);
+xmlSecSize              xmlSecZipEntryGetSizeHint       (xmlSecZipEntryPtr entry);
+
+/* the readers for different entries (even from the same archive)
+ * can be used from different threads at the same time */
+xmlSecZipReaderPtr      xmlSecZipReaderCreate           (xmlSecZipArchivePtr zip,
+                                                         xmlSecZipEntryPtr entry);
+void                    xmlSecZipReaderDestroy          (xmlSecZipReaderPtr reader);
+int                     xmlSecZipReaderRead             (xmlSecZipReaderPtr reader,
+                                                         xmlSecByte* buf,
+                                                         xmlSecSize bufSize,
+                                                         xmlSecSize* readSize);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __XMLSEC_ZIP_HELPERS_H__ */
@@ -657,6 +657,126 @@ execDSigTest $res_success \
     "--hmackey:mykey $topfolder/keys/hmackey.bin" \
     "--hmackey:mykey $topfolder/keys/hmackey.bin"
 
+# the template is a previously signed document with modified "item2" element
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/incremental-sha256-hmac-sha256" \
+    "exc-c14n sha256 hmac-sha256" \
+    "hmac" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin --changed-id item2" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin"
+
+# the template has a stale DigestValue for "item3": the previous SignatureValue
+# doesn't match the SignedInfo and all the digests are re-calculated
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/incremental-stale-sha256-hmac-sha256" \
+    "exc-c14n sha256 hmac-sha256" \
+    "hmac" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin --changed-id item2" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin"
+
+# References with the same URI, transforms and digest method share the digest
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/shared-digest-sha256-hmac-sha256" \
+    "enveloped-signature exc-c14n sha256 sha512 hmac-sha256" \
+    "hmac" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin"
+
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloping-large-text-sha256-hmac-sha256" \
+    "sha256 hmac-sha256" \
+    "hmac" \
+    "--lax-key-search --hmackey $topfolder/keys/hmackey.bin" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin"
+
+# text and attribute values longer than the chunk size are pushed to
+# the digest and HMAC with xmlSecTransformPushBinV(): the results must
+# be the same as above
+extra_message="(vectored push)"
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloping-large-text-sha256-hmac-sha256" \
+    "sha256 hmac-sha256" \
+    "hmac" \
+    "--lax-key-search --hmackey $topfolder/keys/hmackey.bin --transform-binary-chunk-size 32" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin --transform-binary-chunk-size 32" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin"
+
+# detached signatures over local files of different sizes (85 bytes, 54KB and 342KB)
+# with fixed and adaptive (from the file size) binary chunk sizes: "make perfcheck"
+# repeats the verification and the timings are written to the log file
+for chunk_file_size in small medium large ; do
+    for chunk_size_option in "--transform-binary-chunk-size 4096" "--transform-binary-chunk-size 65536" "--transform-adaptive-chunk-size" ; do
+        extra_message="($chunk_size_option)"
+        execDSigTest $res_success \
+            "aleksey-xmldsig-01" \
+            "detached-sha256-hmac-sha256-$chunk_file_size-file" \
+            "sha256 hmac-sha256" \
+            "hmac" \
+            "--lax-key-search --hmackey $topfolder/keys/hmackey.bin $chunk_size_option" \
+            "--hmackey:mykey $topfolder/keys/hmackey.bin $chunk_size_option" \
+            "--hmackey:mykey $topfolder/keys/hmackey.bin"
+    done
+done
+
+extra_message="(sign profile)"
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloping-sha256-hmac-sha256" \
+    "sha256 hmac-sha256" \
+    "hmac" \
+    "--lax-key-search --hmackey $topfolder/keys/hmackey.bin" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin --sign-profile" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin"
+
+extra_message="(sign profile file)"
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloping-sha256-hmac-sha256" \
+    "sha256 hmac-sha256" \
+    "hmac" \
+    "--lax-key-search --hmackey $topfolder/keys/hmackey.bin" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin --sign-profile-file $topfolder/aleksey-xmldsig-01/enveloping-sha256-hmac-sha256.tmpl" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin"
+
+extra_message="(sign profile file mismatch)"
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloping-sha256-hmac-sha256-64" \
+    "sha256 hmac-sha256" \
+    "hmac" \
+    "--lax-key-search --hmackey $topfolder/keys/hmackey.bin" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin --sign-profile-file $topfolder/aleksey-xmldsig-01/enveloped-sha1-rsa-sha1.tmpl" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin"
+
+extra_message="(verify profile)"
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloping-sha256-hmac-sha256" \
+    "sha256 hmac-sha256" \
+    "hmac" \
+    "--lax-key-search --hmackey $topfolder/keys/hmackey.bin --verify-profile $topfolder/aleksey-xmldsig-01/enveloping-sha256-hmac-sha256.tmpl" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin --verify-profile $topfolder/aleksey-xmldsig-01/enveloping-sha256-hmac-sha256.tmpl"
+
+extra_message="(verify profile mismatch)"
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloping-sha256-hmac-sha256" \
+    "sha256 hmac-sha256 sha384 hmac-sha384" \
+    "hmac" \
+    "--lax-key-search --hmackey $topfolder/keys/hmackey.bin --verify-profile $topfolder/aleksey-xmldsig-01/enveloping-sha384-hmac-sha384.tmpl" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin --verify-profile $topfolder/aleksey-xmldsig-01/enveloping-sha384-hmac-sha384.tmpl"
+
 execDSigTest $res_success \
     "" \
     "aleksey-xmldsig-01/enveloping-sha384-hmac-sha384" \
@@ -747,6 +867,54 @@ execDSigTest $res_success \
     "$priv_key_option:mykey $topfolder/keys/rsakey$priv_key_suffix.$priv_key_format --pwd secret123" \
     "--trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509"
 
+# 2000 relationships and 200 SourceIds: this is also the Relationship transform
+# benchmark, "make perfcheck-crypto-<crypto>" prints the verification time
+execDSigTest $res_success \
+    "aleksey-xmldsig-01" \
+    "enveloping-sha256-rsa-sha256-relationship-large" \
+    "sha256 rsa-sha256 relationship" \
+    "rsa x509" \
+    "--trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509" \
+    "$priv_key_option:mykey $topfolder/keys/rsakey$priv_key_suffix.$priv_key_format --pwd secret123" \
+    "--trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509"
+
+execDSigTest $res_success \
+    "aleksey-xmldsig-01" \
+    "opc-package-sha256-rsa-sha256" \
+    "sha256 rsa-sha256 relationship" \
+    "rsa x509" \
+    "--trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509 --opc-package opc-package.docx --threads 4" \
+    "$priv_key_option:mykey $topfolder/keys/rsakey$priv_key_suffix.$priv_key_format --pwd secret123 --opc-package opc-package.docx --threads 4" \
+    "--trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509 --opc-package opc-package.docx --threads 4"
+
+execDSigTest $res_fail \
+    "aleksey-xmldsig-01" \
+    "opc-package-sha256-rsa-sha256" \
+    "sha256 rsa-sha256 relationship" \
+    "rsa x509" \
+    "--trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509 --opc-package opc-package-bad.docx --threads 4"
+
+execDSigTest $res_fail \
+    "aleksey-xmldsig-01" \
+    "opc-package-sha256-rsa-sha256" \
+    "sha256 rsa-sha256 relationship" \
+    "rsa x509" \
+    "--trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509 --opc-package opc-package-duplicate.docx"
+
+execDSigTest $res_fail \
+    "aleksey-xmldsig-01" \
+    "opc-package-sha256-rsa-sha256" \
+    "sha256 rsa-sha256 relationship" \
+    "rsa x509" \
+    "--trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509 --opc-package opc-package-bad-name.docx"
+
+execDSigTest $res_fail \
+    "aleksey-xmldsig-01" \
+    "opc-package-sha256-rsa-sha256" \
+    "sha256 rsa-sha256 relationship" \
+    "rsa x509" \
+    "--trusted-$cert_format $topfolder/keys/cacert.$cert_format --enabled-key-data x509 --opc-package opc-package-bad-size.docx"
+
 execDSigTest $res_success \
     "" \
     "aleksey-xmldsig-01/enveloping-sha384-rsa-sha384" \
@@ -979,6 +1147,31 @@ execDSigTest $res_success \
     "$priv_key_option:largersakey $topfolder/keys/largersakey.$priv_key_format --pwd secret123" \
     "$priv_key_option:largersakey $topfolder/keys/largersakey.$priv_key_format --pwd secret123"
 
+extra_message="(sign profile)"
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloped-sha1-rsa-sha1" \
+    "sha1 rsa-sha1" \
+    "" \
+    "$priv_key_option:mykey $topfolder/keys/largersakey.$priv_key_format --pwd secret123" \
+    "$priv_key_option:largersakey $topfolder/keys/largersakey.$priv_key_format --pwd secret123 --sign-profile" \
+    "$priv_key_option:largersakey $topfolder/keys/largersakey.$priv_key_format --pwd secret123"
+
+# nss imports the pkcs12 key into the db (with the "largersakey" nickname) when
+# verifying the existing signature, the new signature is created and verified
+# with the keys found in the db (the second run hits the keys store cache)
+if [ "z$crypto" = "znss" ] ; then
+    extra_message="(nss db key lookup)"
+    execDSigTest $res_success \
+        "" \
+        "aleksey-xmldsig-01/enveloped-sha1-rsa-sha1" \
+        "sha1 rsa-sha1" \
+        "" \
+        "$priv_key_option:mykey $topfolder/keys/largersakey.$priv_key_format --pwd secret123" \
+        "--repeat 2" \
+        "--repeat 2"
+fi
+
 execDSigTest $res_success \
     "" \
     "aleksey-xmldsig-01/enveloped-sha224-ecdsa-sha224" \
@@ -1476,6 +1669,21 @@ execDSigTest $res_success \
     "--lax-key-search $priv_key_option:mykey $topfolder/keys/dsakey.$priv_key_format --pwd secret123 $url_map_xml_stylesheet_2005"\
     "--trusted-$cert_format $topfolder/keys/cacert.$cert_format --trusted-$cert_format $topfolder/keys/ca2cert.$cert_format $url_map_xml_stylesheet_2005"
 
+# same with the RetrievalMethod results cache: the cert is read once and re-used
+# (memcheck and perfcheck already pass --repeat in $xmlsec_params)
+if [ -z "$DEBUG_MEMORY" -a -z "$PERF_TEST" ] ; then
+    retrieval_cache_repeat="--repeat 3"
+else
+    retrieval_cache_repeat=""
+fi
+extra_message="(retrieval cache)"
+execDSigTest $res_success \
+    "" \
+    "merlin-xmldsig-twenty-three/signature-retrievalmethod-rawx509crt" \
+    "sha1 dsa-sha1" \
+    "dsa x509" \
+    "--retrieval-cache $retrieval_cache_repeat --trusted-$cert_format $topfolder/merlin-xmldsig-twenty-three/certs/ca.$cert_format --untrusted-$cert_format $topfolder/merlin-xmldsig-twenty-three/certs/nemain.$cert_format --verification-gmt-time 2005-01-01+10:00:00 $url_map_xml_stylesheet_2005"
+
 execDSigTest $res_success \
     "" \
     "merlin-xmldsig-twenty-three/signature" \
@@ -1647,6 +1855,14 @@ execDSigTest $res_success \
     "hmac" \
     "--lax-key-search --hmackey certs/hmackey.bin  $url_map_rfc3161"
 
+extra_message="(adaptive chunk size)"
+execDSigTest $res_success \
+    "phaos-xmldsig-three" \
+    "signature-hmac-sha1-40-c14n-comments-detached" \
+    "c14n-with-comments sha1 hmac-sha1" \
+    "hmac" \
+    "--transform-adaptive-chunk-size --lax-key-search --hmackey certs/hmackey.bin $url_map_rfc3161"
+
 execDSigTest $res_success \
     "phaos-xmldsig-three" \
     "signature-hmac-sha1-40-exclusive-c14n-comments-detached" \
@@ -1800,6 +2016,78 @@ execDSigTest $res_fail \
     "rsa x509" \
     "--trusted-$cert_format certs/rsa-ca-cert.$cert_format"
 
+##########################################################################
+#
+# C14N: the XMLSec canonicalization engine output must be the same
+# as LibXML2 xmlC14NExecute() output (the digests in the vectors file
+# were calculated with --transform-libxml2-c14n)
+#
+##########################################################################
+execDSigTest $res_success \
+    "" \
+    "aleksey-xmldsig-01/enveloped-c14n-vectors-sha256-hmac-sha256" \
+    "enveloped-signature xpath xpath2 c14n c14n-with-comments c14n11 c14n11-with-comments exc-c14n exc-c14n-with-comments sha256 hmac-sha256" \
+    "hmac" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin"
+
+execC14NTest \
+    "" \
+    "aleksey-xmldsig-01/enveloped-c14n-vectors-sha256-hmac-sha256" \
+    "enveloped-signature xpath xpath2 c14n c14n-with-comments c14n11 c14n11-with-comments exc-c14n exc-c14n-with-comments sha256 hmac-sha256" \
+    "--hmackey:mykey $topfolder/keys/hmackey.bin"
+
+execC14NTest \
+    "" \
+    "merlin-c14n-three/signature" \
+    "c14n c14n-with-comments exc-c14n exc-c14n-with-comments xpath sha1 dsa-sha1" \
+    "--enabled-key-data key-value,dsa"
+
+execC14NTest \
+    "" \
+    "merlin-exc-c14n-one/exc-signature" \
+    "exc-c14n sha1 dsa-sha1" \
+    "--enabled-key-data key-value,key-name,dsa"
+
+execC14NTest \
+    "" \
+    "merlin-xpath-filter2-three/sign-xfdl" \
+    "enveloped-signature xpath2 sha1 dsa-sha1" \
+    "--enabled-key-data key-value,dsa"
+
+execC14NTest \
+    "" \
+    "merlin-xpath-filter2-three/sign-spec" \
+    "enveloped-signature xpath2 sha1 dsa-sha1" \
+    "--enabled-key-data key-value,dsa"
+
+execC14NTest \
+    "xmldsig2ed-tests" \
+    "defCan-1" \
+    "c14n11 sha1 hmac-sha1" \
+    "--lax-key-search --hmackey $topfolder/keys/hmackey.bin"
+
+for c14n_xpointer_test in 1 2 3 4 5 6 ; do
+    execC14NTest \
+        "xmldsig2ed-tests" \
+        "xpointer-$c14n_xpointer_test-SUN" \
+        "c14n11 xpointer sha1 hmac-sha1" \
+        "--lax-key-search --hmackey $topfolder/keys/hmackey.bin"
+done
+
+execC14NTest \
+    "phaos-xmldsig-three" \
+    "signature-hmac-sha1-40-exclusive-c14n-comments-detached" \
+    "exc-c14n-with-comments sha1 hmac-sha1" \
+    "--lax-key-search --hmackey certs/hmackey.bin $url_map_rfc3161"
+
+execC14NTest \
+    "phaos-xmldsig-three" \
+    "signature-hmac-sha1-exclusive-c14n-enveloped" \
+    "enveloped-signature exc-c14n sha1 hmac-sha1" \
+    "--lax-key-search --hmackey certs/hmackey.bin"
+
 ##########################################################################
 #
 # test dynamic signature
@@ -48,6 +48,39 @@ execEncTest $res_success \
     "--aeskey:mykey $topfolder/xmlenc11-interop-2012/xenc11-example-AES128-GCM.key --binary-data $topfolder/xmlenc11-interop-2012/xenc11-example-AES128-GCM.data" \
     "--aeskey:mykey $topfolder/xmlenc11-interop-2012/xenc11-example-AES128-GCM.key"
 
+extra_message="(aead streaming)"
+execEncTest $res_success \
+    "" \
+    "xmlenc11-interop-2012/xenc11-example-AES128-GCM" \
+    "aes128-gcm" \
+    "" \
+    "--aead-streaming --lax-key-search --aeskey $topfolder/xmlenc11-interop-2012/xenc11-example-AES128-GCM.key"
+
+extra_message="(aead streaming, cipher reference)"
+execEncTest $res_success \
+    "aleksey-xmlenc-01" \
+    "enc-aes128gcm-keyname-ref" \
+    "aes128-gcm" \
+    "" \
+    "--keys-file $topfolder/keys/keys.xml --aead-streaming --stream-output --transform-binary-chunk-size 1024"
+
+extra_message="Negative test: AEAD streaming output is removed on bad tag"
+execEncNoOutputTest \
+    "aleksey-xmlenc-01" \
+    "enc-aes128gcm-keyname-ref-bad-tag" \
+    "aes128-gcm" \
+    "--keys-file $topfolder/keys/keys.xml --aead-streaming --stream-output --transform-binary-chunk-size 1024"
+
+extra_message="(adaptive chunk size)"
+execEncTest $res_success \
+    "" \
+    "xmlenc11-interop-2012/xenc11-example-AES128-GCM" \
+    "aes128-gcm" \
+    "" \
+    "--transform-adaptive-chunk-size --lax-key-search --aeskey $topfolder/xmlenc11-interop-2012/xenc11-example-AES128-GCM.key" \
+    "--transform-adaptive-chunk-size --aeskey:mykey $topfolder/xmlenc11-interop-2012/xenc11-example-AES128-GCM.key --binary-data $topfolder/xmlenc11-interop-2012/xenc11-example-AES128-GCM.data" \
+    "--transform-adaptive-chunk-size --aeskey:mykey $topfolder/xmlenc11-interop-2012/xenc11-example-AES128-GCM.key"
+
 
 # Advanced RSA OAEP modes:
 # - MSCrypto only supports SHA1 for digest and mgf1
@@ -509,6 +542,14 @@ execEncTest $res_success \
     "--keys-file $topfolder/keys/keys.xml"
 
 
+extra_message="(stream output)"
+execEncTest $res_success \
+    "" \
+    "aleksey-xmlenc-01/enc-aes192cbc-keyname-ref" \
+    "aes192-cbc" \
+    "" \
+    "--keys-file $topfolder/keys/keys.xml --stream-output"
+
 extra_message="Negative test: all cipher references are disabled"
 execEncTest $res_fail \
     "" \
@@ -926,6 +967,26 @@ execEncTest $res_success \
     "" \
     "--keys-file $topfolder/merlin-xmlenc-five/keys.xml"
 
+# encrypt / decrypt all the nodes in the document, the shared key is encrypted / resolved only once
+extra_message="(encrypt all / decrypt all)"
+execEncTest $res_success \
+    "" \
+    "aleksey-xmlenc-01/enc-element-aes256-cbc-kw-aes256-shared-key" \
+    "aes256-cbc kw-aes256" \
+    "" \
+    "--keys-file $topfolder/merlin-xmlenc-five/keys.xml --decrypt-all --threads 4" \
+    "--keys-file $topfolder/merlin-xmlenc-five/keys.xml --session-key aes-256 --xml-data $topfolder/aleksey-xmlenc-01/enc-element-aes256-cbc-kw-aes256-shared-key.data --node-name urn:example:po:Item --encrypt-all --threads 4" \
+    "--keys-file $topfolder/merlin-xmlenc-five/keys.xml --decrypt-all --threads 4"
+
+extra_message="Negative test: encrypt all with overlapping nodes"
+execEncTest $res_fail \
+    "" \
+    "aleksey-xmlenc-01/enc-element-aes256-cbc-kw-aes256-shared-key" \
+    "aes256-cbc kw-aes256" \
+    "" \
+    "" \
+    "--keys-file $topfolder/merlin-xmlenc-five/keys.xml --session-key aes-256 --xml-data $topfolder/aleksey-xmlenc-01/enc-element-overlapping-nodes.data --node-name urn:example:po:Item --encrypt-all --threads 4"
+
 
 #merlin-xmlenc-five/encrypt-element-aes256-cbc-carried-kw-aes256.xml
 #merlin-xmlenc-five/decryption-transform-except.xml
@@ -276,6 +276,14 @@ printCheckStatus() {
     return "$check_res"
 }
 
+printPerfRes() {
+    # with PERF_TEST the xmlsec app repeats the operation and prints
+    # the total time to stderr (i.e. to the current log) if it succeeds
+    if [ -n "$PERF_TEST" -a "z$expected_res" = "z$res_success" ]; then
+        grep "Executed .* tests in .* msec" $curlogfile | tail -1 | sed 's/.*Executed/        Executed/'
+    fi
+}
+
 extra_message=""
 
 #
@@ -607,6 +615,8 @@ execDSigTest() {
         printRes $expected_res $?
         if [ $? -ne 0 ]; then
             failures=`expr $failures + 1`
+        else
+            printPerfRes
         fi
     fi
 
@@ -640,6 +650,89 @@ execDSigTest() {
     tearDownTest
 }
 
+#
+# C14N test function: the data before digest and signature calculation
+# (i.e. the canonicalization results) produced by the XMLSec C14N engine
+# must be byte-for-byte the same as produced by LibXML2 xmlC14NExecute()
+#
+execC14NTest() {
+    folder="$1"
+    filename="$2"
+    req_transforms="$3"
+    params1="$4"
+    failures=0
+
+    if [ -n "$XMLSEC_TEST_NAME" -a "$XMLSEC_TEST_NAME" != "$filename" ]; then
+        return
+    fi
+
+    # prepare
+    setupTest
+
+    # starting test
+    if [ -n "$folder" ] ; then
+        cd $topfolder/$folder
+        full_file=$filename
+        echo "Test: $folder/$filename $extra_message"
+        echo "Test: $folder/$filename in folder " `pwd` " $extra_message -- c14n" > $curlogfile
+    else
+        full_file=$topfolder/$filename
+        echo "Test: $filename $extra_message"
+        echo "Test: $folder/$filename $extra_message -- c14n" > $curlogfile
+    fi
+    extra_message=""
+
+    # check transforms
+    if [ -n "$req_transforms" ] ; then
+        printf "    Checking required transforms                         "
+        echo "$extra_vars $xmlsec_app check-transforms $xmlsec_params --crypto-config $crypto_config $req_transforms" >> $curlogfile
+        $xmlsec_app check-transforms $xmlsec_params --crypto-config $crypto_config $req_transforms >> $curlogfile 2>> $curlogfile
+        printCheckStatus $?
+        res=$?
+        if [ $res -ne 0 ]; then
+            cat $curlogfile >> $logfile
+            tearDownTest
+            return
+        fi
+    fi
+
+    # run tests
+    printf "    Compare C14N with LibXML2 C14N                       "
+    rm -f $tmpfile $tmpfile.2 $tmpfile.3
+    echo "$extra_vars $VALGRIND $xmlsec_app verify --X509-skip-strict-checks --store-references --store-signatures $xmlsec_params --crypto-config $crypto_config $params1 $full_file.xml" >> $curlogfile
+    $VALGRIND $xmlsec_app verify --X509-skip-strict-checks --store-references --store-signatures $xmlsec_params --crypto-config $crypto_config $params1 $full_file.xml > $tmpfile.3 2>> $curlogfile
+    res=$?
+    if [ $res -eq 0 ]; then
+        sed -n '/^== Pre[A-Za-z]* data - start buffer:$/,/^== Pre[A-Za-z]* data - end buffer$/p' $tmpfile.3 > $tmpfile
+        echo "$extra_vars $VALGRIND $xmlsec_app verify --X509-skip-strict-checks --store-references --store-signatures --transform-libxml2-c14n $xmlsec_params --crypto-config $crypto_config $params1 $full_file.xml" >> $curlogfile
+        $VALGRIND $xmlsec_app verify --X509-skip-strict-checks --store-references --store-signatures --transform-libxml2-c14n $xmlsec_params --crypto-config $crypto_config $params1 $full_file.xml > $tmpfile.3 2>> $curlogfile
+        res=$?
+    fi
+    if [ $res -eq 0 ]; then
+        sed -n '/^== Pre[A-Za-z]* data - start buffer:$/,/^== Pre[A-Za-z]* data - end buffer$/p' $tmpfile.3 > $tmpfile.2
+        if [ -s $tmpfile ]; then
+            diff $diff_param $tmpfile.2 $tmpfile >> $curlogfile 2>> $curlogfile
+            res=$?
+        else
+            echo "=== no canonicalized data found" >> $curlogfile
+            res=1
+        fi
+    fi
+    printRes $res_success $res
+    if [ $? -ne 0 ]; then
+        failures=`expr $failures + 1`
+    fi
+
+    # save logs
+    cat $curlogfile >> $logfile
+    if [ $failures -ne 0 ] ; then
+        cat $curlogfile >> $failedlogfile
+    fi
+
+    # cleanup
+    tearDownTest
+}
+
 #
 # Enc test function
 #
@@ -730,6 +823,8 @@ execEncTest() {
         fi
     	if [ $? -ne 0 ]; then
             failures=`expr $failures + 1`
+        else
+            printPerfRes
     	fi
     fi
 
@@ -738,7 +833,7 @@ execEncTest() {
         printf "    Encrypt document                                     "
         echo "$extra_vars $VALGRIND $xmlsec_app encrypt $xmlsec_params --crypto-config $crypto_config $params2 --output $tmpfile $full_file.tmpl" >>  $curlogfile
         $VALGRIND $xmlsec_app encrypt $xmlsec_params --crypto-config $crypto_config $params2 --output $tmpfile $full_file.tmpl >> $curlogfile 2>> $curlogfile
-        printRes $res_success $?
+        printRes $expected_res $?
         if [ $? -ne 0 ]; then
             failures=`expr $failures + 1`
         fi
@@ -775,6 +870,71 @@ execEncTest() {
     tearDownTest
 }
 
+#
+# Encryption test function: the decryption is expected to fail and
+# the (partially written) output file should be removed
+#
+execEncNoOutputTest() {
+    folder="$1"
+    filename="$2"
+    req_transforms="$3"
+    params1="$4"
+    failures=0
+
+    if [ -n "$XMLSEC_TEST_NAME" -a "$XMLSEC_TEST_NAME" != "$filename" ]; then
+        return
+    fi
+
+    # prepare
+    setupTest
+
+    # starting test
+    cd $topfolder/$folder
+    full_file=$filename
+    echo "Test: $folder/$filename $extra_message"
+    echo "Test: $folder/$filename in folder " `pwd` " $extra_message -- no output" > $curlogfile
+    extra_message=""
+
+    # check transforms
+    if [ -n "$req_transforms" ] ; then
+        printf "    Checking required transforms                         "
+        echo "$extra_vars $xmlsec_app check-transforms $xmlsec_params  --crypto-config $crypto_config $req_transforms" >> $curlogfile
+        $xmlsec_app check-transforms $xmlsec_params  --crypto-config $crypto_config $req_transforms >> $curlogfile 2>> $curlogfile
+        printCheckStatus $?
+        res=$?
+        if [ $res -ne 0 ]; then
+            cat $curlogfile >> $logfile
+            tearDownTest
+            return
+        fi
+    fi
+
+    # run test
+    rm -f $tmpfile
+    printf "    Decrypt existing document (no output)                "
+    echo "$extra_vars $VALGRIND $xmlsec_app decrypt $xmlsec_params --crypto-config $crypto_config $params1 --output $tmpfile $full_file.xml" >>  $curlogfile
+    $VALGRIND $xmlsec_app decrypt $xmlsec_params --crypto-config $crypto_config $params1 --output $tmpfile $full_file.xml >> $curlogfile 2>> $curlogfile
+    res=$?
+    echo "=== TEST RESULT: $res; output file exists: `test -e $tmpfile && echo yes || echo no`" >> $curlogfile
+    if [ $res -ne 0 -a ! -e $tmpfile ]; then
+        printRes $res_success 0
+    else
+        printRes $res_success 1
+    fi
+    if [ $? -ne 0 ]; then
+        failures=`expr $failures + 1`
+    fi
+
+    # save logs
+    cat $curlogfile >> $logfile
+    if [ $failures -ne 0 ] ; then
+        cat $curlogfile >> $failedlogfile
+    fi
+
+    # cleanup
+    tearDownTest
+}
+
 # prepare
 rm -rf $tmpfile $tmpfile.2 $tmpfile.3
 
@@ -50,6 +50,7 @@ var withMSCrypto = 0;
 var withMSCng = 0;
 var withLibXSLT = 1;
 var withIconv = 1;
+var withZlib = 0; /* disable zlib (compressed OPC package parts) by default */
 var withFTP = 0; /* disable ftp by default */
 var withHTTP = 0; /* disable http by default */
 var withGost = 0;
@@ -121,6 +122,7 @@ function usage()
 	txt += "              (\"" + withCrypto + "\");\n"
  	txt += "  xslt:       LibXSLT is used (" + (withLibXSLT? "yes" : "no")  + ")\n";
  	txt += "  iconv:      Use the iconv library (" + (withIconv? "yes" : "no")  + ")\n";
+ 	txt += "  zlib:       Use the zlib library (" + (withZlib? "yes" : "no")  + ")\n";
 	txt += "  ftp:        Enable FTP support (" + (withFTP ? "yes" : "no") + ")\n";
 	txt += "  http:       Enable HTTP support (" + (withHTTP ? "yes" : "no") + ")\n";
 	txt += "  rsa-pkcs15: Enable RSA PKCS#1.5 key transport (" + (withRsaPkcs15 ? "yes" : "no") + ")\n";
@@ -197,6 +199,7 @@ function discoverVersion()
 	vf.WriteLine("WITH_MSCNG=" + withMSCng);
 	vf.WriteLine("WITH_LIBXSLT=" + (withLibXSLT ? "1" : "0"));
 	vf.WriteLine("WITH_ICONV=" + (withIconv ? "1" : "0"));
+	vf.WriteLine("WITH_ZLIB=" + (withZlib ? "1" : "0"));
 	vf.WriteLine("WITH_FTP=" + (withFTP ? "1" : "0"));
 	vf.WriteLine("WITH_HTTP=" + (withHTTP ? "1" : "0"));
 	vf.WriteLine("WITH_GOST=" + (withGost ? "1" : "0"));
@@ -336,6 +339,8 @@ for (i = 0; (i < WScript.Arguments.length) && (error == 0); i++) {
 			withLibXSLT = strToBool(arg.substring(opt.length + 1, arg.length));
 		else if (opt == "iconv")
 			withIconv = strToBool(arg.substring(opt.length + 1, arg.length));
+		else if (opt == "zlib")
+			withZlib = strToBool(arg.substring(opt.length + 1, arg.length));
 		else if (opt == "ftp")
 			withFTP = strToBool(arg.substring(opt.length + 1, arg.length));
 		else if (opt == "http")
@@ -488,6 +493,7 @@ txtOut += "        Use MSCrypto: " + boolToStr(withMSCrypto) + "\n";
 txtOut += "           Use MSCng: " + boolToStr(withMSCng) + "\n";
 txtOut += "         Use LibXSLT: " + boolToStr(withLibXSLT) + "\n";
 txtOut += "           Use iconv: " + boolToStr(withIconv) + "\n";
+txtOut += "            Use zlib: " + boolToStr(withZlib) + "\n";
 txtOut += " Enable RSA PKCS#1.5: " + boolToStr(withRsaPkcs15) + "\n";
 txtOut += "         Enable GOST: " + boolToStr(withGost) + "\n";
 txtOut += "Enable legacy crypto: " + boolToStr(withLegacyCrypto) + "\n";